@@ -1,60 +1,101 @@
-﻿#include <windows.h> //работа с окнами и графикой
-#include <vector> // для хранения точек кругов и крестов
+﻿#define NOMINMAX  // иначе макросы min/max ломают <random>
+#include <windows.h> //работа с окнами и графикой
+#include <windowsx.h> // GET_X_LPARAM для координат со знаком
 #include <ctime> //для генерации случайных цветов
+#include <cstdio> // snprintf для строк журнала
 #include <shellapi.h> // Для CommandLineToArgvW
 #include <string>
-#include <sstream>
-#include <fstream>
-#include <iostream>
-
-#define DEFAULT_GRID_SIZE 50  // Размер сетки по умолчанию
+#include <memory>
+#include <vector>
+#include "Board.h" // поле с упакованными клетками
+#include "BoardSnapshot.h" // двоичный снимок поля
+#include "MoveJournal.h" // журнал ходов между снимками
+#include "BoardHistory.h" // отмена и повтор ходов
+#include "SharedBoard.h" // общее поле для нескольких экземпляров
+#include "ServerSession.h" // партия на сервере 3lab-server в своем потоке
+#include "SettingsStore.h" // чтение и запись settings.ini четырьмя способами
+#include "SettingsCache.h" // двоичный кэш settings.ini для быстрого запуска
+#include "SettingsWatcher.h" // перечитывание settings.ini на лету
+#include "Renderer.h" // рисование сетки и меток с кэшем перьев
+#include "Viewport.h" // сдвиг и масштаб бесконечного поля
+#include "GdiDevice.h" // вывод сцены через GDI
+#include "TiledRenderer.h" // параллельная отрисовка больших окон по плиткам
+#include "Profiler.h" // замеры времени кадра, ввода и ввода-вывода
+#include "FrameScheduler.h" // не больше одной перерисовки за кадр
+#include "GameController.h" // обработка ввода без привязки к окну
+#include "InputTrace.h" // запись трассы ввода
+#include "AiPlayer.h" // компьютерный соперник
+#include "Log.h" // журнал предупреждений и времени запуска
+#include "TaskRuntime.h" // фоновый поток для записи файлов
 
 // Прототипы функций
 LRESULT CALLBACK WindowProc(HWND, UINT, WPARAM, LPARAM);  // Обработчик сообщений окна
-void DrawGrid(HDC, int);  // Функция рисования сетки
-void DrawCircle(HDC, int, int, int);  // Функция рисования круга
-void DrawCross(HDC, int, int, int);  // Функция рисования креста
+void HandleInput(HWND, const InputEvent&);  // Передача события контроллеру
+void HandleAction(HWND, ControllerAction);  // Действия контроллера, которым нужно окно
+void StartAiSearch(HWND);  // Поиск хода компьютера в фоне
+std::uint8_t KeyModifiers();  // Зажатые Ctrl и Shift
+void RequestFrame(HWND);  // Планирование кадра
+void PresentFrame(HWND);  // Передача накопленных повреждений окну
+void DrawProfileOverlay(HDC);  // Вывод замеров поверх поля
+void ApplySettings(HWND, const Settings&, std::uint32_t);  // Применение измененных в settings.ini ключей
+void UpdateTitle(HWND);  // Итог партии в заголовке окна
+void Notify(const std::wstring&);  // Предупреждение в окне и в журнале
+void DrawNotices(HDC, const Rect&);  // Вывод предупреждений поверх поля
+void LogStartupTime();  // Время от запуска процесса до первого кадра
 
 // Глобальные переменные
-int cellSize = DEFAULT_GRID_SIZE;  // Размер ячейки сетки
-std::vector<POINT> circles;  // Вектор для хранения точек кругов
-std::vector<POINT> crosses;   // Вектор для хранения точек крестов
-HBRUSH bgBrush = (HBRUSH)CreateSolidBrush(RGB(0, 0, 255)); // Задний фон окна (синий цвет)
-COLORREF gridLineColor = RGB(255, 0, 0);  // Цвет линий сетки (красный)
-int wndWidth = 320, wndHeight = 240;  // Размеры окна
-
-
-//Стуктура конфига
-struct Settings {
-    int gridSize;
-    int windowWidth;
-    int windowHeight;
-    COLORREF backgroundColor;
-    COLORREF gridLineColor;
-};
+Board board;  // Бесконечное поле с кругами и крестами (индексируется по клеткам)
+MoveJournal journal;  // Ходы, сделанные после последнего снимка поля
+const UINT_PTR JournalTimerId = 1;  // Таймер групповой фиксации журнала
+SharedBoard sharedBoard;  // Общее поле (подключается аргументом shared)
+BoardHistory history;  // Отмена и повтор ходов этого запуска (только на локальном поле)
+const UINT_PTR SharedBoardTimerId = 2;  // Таймер опроса изменений других экземпляров
+ServerSession serverSession;  // Партия на сервере (подключается аргументом server) в своем потоке
+ServerUpdates serverUpdates;  // Новости сессии сервера (память переиспользуется)
+bool serverJoined = false;  // Подключение к партии сервера состоялось
+const UINT WM_SERVER_UPDATE = WM_APP + 4;  // Сессия сервера принесла новости
+bool profileOverlay = false;  // Показывать замеры поверх поля (F12)
+const UINT_PTR ProfileOverlayTimerId = 3;  // Таймер обновления замеров на экране
+FrameScheduler frameScheduler;  // Копит повреждения между кадрами
+FrameDamage frameDamage;  // Повреждения выводимого кадра (память переиспользуется)
+const UINT_PTR FrameTimerId = 4;  // Таймер отложенного кадра
+GdiDevice gdiDevice;  // Устройство вывода в окно
+Renderer renderer(gdiDevice);  // Рисует поле, хранит перья и кисти между кадрами
+ThreadPool renderPool;  // Потоки для отрисовки по плиткам
+TiledRenderer tiledRenderer(renderPool);  // Рисует большие окна в кадр в памяти
+Framebuffer frameBuffer;  // Кадр в памяти размером с клиентскую область
+GameController controller(board, renderer, frameScheduler);  // Ввод, вид поля и цвета
+bool traceRecording = false;  // Идет запись трассы ввода (F9)
+std::vector<InputEvent> recordedTrace;  // Записанные события
+SettingsWatcher settingsWatcher;  // Следит за settings.ini
+const UINT WM_SETTINGS_CHANGED = WM_APP + 1;  // Наблюдатель опубликовал новые настройки
+AiPlayer aiPlayer;  // Ищет ходы компьютера вне потока окна
+const UINT WM_AI_MOVE = WM_APP + 2;  // Компьютер нашел ход
+TaskRuntime tasks;  // Медленная работа (сброс журнала, сохранение при выходе) вне потока окна
+const UINT WM_TASKS_DONE = WM_APP + 3;  // Фоновые задачи вернули продолжения
+std::vector<std::wstring> notices;  // Предупреждения запуска, показываемые поверх поля
+const UINT_PTR NoticeTimerId = 5;  // Таймер, убирающий предупреждения
+const UINT NoticeShowMs = 10000;  // Сколько предупреждения видны на экране
+SettingsSource settingsSource = SettingsSource::Defaults;  // Откуда прочитаны настройки
+bool firstFramePainted = false;  // Время до первого кадра уже записано в журнал
+int cmdGridSize = 0;  // Размер клетки из командной строки (0 — берется из settings.ini)
+
 
 // Прототипы функций
-void ReadSettingsFromMemoryMapping(Settings& settings);
-void WriteSettingsToMemoryMapping(const Settings& settings);
-void ReadSettingsFromFile(Settings& settings);
-void WriteSettingsToFile(const Settings& settings);
-void ReadSettingsFromStream(Settings& settings);
-void WriteSettingsToStream(const Settings& settings);
-void ReadSettingsFromWinAPI(Settings& settings);
-void WriteSettingsToWinAPI(const Settings& settings);
+void ReportSettingsErrors(const SettingsParseResult& result);
 
 
 Settings settings;
 // Точка входа в программу
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine, int nCmdShow) {
     // 1️⃣ Устанавливаем значения по умолчанию
-    settings.gridSize = DEFAULT_GRID_SIZE;
-    settings.windowWidth = 320;
-    settings.windowHeight = 240;
-    settings.backgroundColor = RGB(0, 0, 255);
-    settings.gridLineColor = RGB(255, 0, 0);
+    settings = DefaultSettings();
+    OpenLog("3lab.log");  // Запуск не останавливается на диалогах: предупреждения идут в журнал и в окно
 
     int method = 1; // Метод по умолчанию
+    bool shared = false;  // Играть на общем поле вместе с другими экземплярами
+    bool server = false;  // Играть партию сервера 3lab-server как один из его клиентов
+    std::uint32_t serverGame = 0;  // Номер партии на сервере
 
     // 2️⃣ Парсим аргументы командной строки
     int argc;
@@ -68,23 +109,31 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine
             }
             else {
                 // Если метод некорректен, используем значение по умолчанию
-                MessageBox(NULL, L"Некорректный метод. Используется метод по умолчанию (1).", L"Ошибка", MB_OK | MB_ICONWARNING);
+                Notify(L"Некорректный метод. Используется метод по умолчанию (1).");
             }
         }
+        else if (argc > 1) {
+            LogLine("метод не задан, используется метод 1");
+        }
         else {
-            // Если аргументов нет, используем значения по умолчанию
-            MessageBox(NULL, L"Недостаточно аргументов, используем значения по умолчанию (размер ячеек 50, метод 1).", L"Информация", MB_OK | MB_ICONINFORMATION);
+            // Если аргументов нет, используем значения по умолчанию (обычный запуск, поэтому только в журнал)
+            LogLine("аргументов нет, используются размер ячеек из settings.ini и метод 1");
+        }
+
+        if (argc > 3) {
+            // Третий аргумент "shared" включает общее поле, "server" — партию на сервере (номер партии — четвертый)
+            shared = lstrcmpiW(argv[3], L"shared") == 0;
+            server = lstrcmpiW(argv[3], L"server") == 0;
+            if (server && argc > 4) serverGame = static_cast<std::uint32_t>(_wtoi(argv[4]));
         }
 
         if (argc > 1) {
             // Если есть аргумент, парсим размер сетки
-            int cmdGridSize = _wtoi(argv[1]);
-            if (cmdGridSize > 0) {
-                settings.gridSize = cmdGridSize;
-            }
-            else {
-                // Если размер сетки некорректен, используем значение по умолчанию
-                MessageBox(NULL, L"Некорректный размер сетки. Используется значение по умолчанию.", L"Ошибка", MB_OK | MB_ICONWARNING);
+            cmdGridSize = _wtoi(argv[1]);
+            if (cmdGridSize <= 0) {
+                // Если размер сетки некорректен, используем размер из settings.ini
+                cmdGridSize = 0;
+                Notify(L"Некорректный размер сетки. Используется размер из settings.ini.");
             }
         }
 
@@ -92,35 +141,63 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine
     }
     else {
         // Если не удалось получить аргументы, используем значения по умолчанию
-        MessageBox(NULL, L"Не удалось получить аргументы командной строки. Используются настройки по умолчанию.", L"Ошибка", MB_OK | MB_ICONWARNING);
-    
-    }
-
-    cellSize = settings.gridSize;
-    // 3️⃣ Читаем настройки в зависимости от метода
-    switch (method) {
-    case 1: ReadSettingsFromMemoryMapping(settings); break;
-    case 2: ReadSettingsFromFile(settings); break;
-    case 3: ReadSettingsFromStream(settings); break;
-    case 4: ReadSettingsFromWinAPI(settings); break;
-    default: ReadSettingsFromMemoryMapping(settings); break;
+        Notify(L"Не удалось получить аргументы командной строки. Используются настройки по умолчанию.");
+    }
+
+    // 3️⃣ Читаем настройки в зависимости от метода (если settings.ini не менялся — из двоичного кэша)
+    std::unique_ptr<SettingsStore> store = CreateSettingsStore(method);
+    SettingsParseResult parsed = LoadSettingsCached(*store, settings, &settingsSource);
+    ReportSettingsErrors(parsed);  // Некорректные ключи остаются со значениями по умолчанию
+    if (cmdGridSize > 0) settings.gridSize = cmdGridSize;  // Размер клетки из командной строки важнее файла
+
+    // Восстанавливаем поле из снимка, сохраненного при прошлом выходе (если он есть и не поврежден)
+    LoadBoardSnapshot("board.bin", board);
+    // Доигрываем ходы, сделанные после снимка (в том числе до аварийного завершения)
+    std::size_t replayed = MoveJournal::Replay("moves.journal", board);
+    journal.Open("moves.journal", replayed);
+
+    if (shared) {
+        if (sharedBoard.Open(SharedBoardName, SharedBoardCols, SharedBoardRows)) {
+            // Первый экземпляр выкладывает в общую память свое поле, остальные забирают общее
+            if (sharedBoard.Created()) {
+                board.ForEach([](int col, int row, Mark mark) { sharedBoard.Place(col, row, mark); });
+            }
+            sharedBoard.CopyTo(board);
+            // Метки вне общего поля CopyTo не трогает: они остаются в этом окне и попадут в снимок при выходе
+            std::size_t outside = 0;
+            board.ForEach([&outside](int col, int row, Mark) { outside += !sharedBoard.Contains(col, row); });
+            if (outside > 0) {
+                Notify(std::to_wstring(outside) + L" меток вне общего поля (клетки 0.." + std::to_wstring(SharedBoardCols - 1)
+                    + L") видны только в этом окне");
+            }
+        }
+        else {
+            Notify(L"Не удалось подключиться к общему полю. Используется локальное поле.");
+        }
     }
 
     // 4️⃣ Применяем настройки после загрузки
-    wndWidth = settings.windowWidth;
-    wndHeight = settings.windowHeight;
-    bgBrush = CreateSolidBrush(settings.backgroundColor);
-    gridLineColor = settings.gridLineColor;
+    controller.SetJournal(&journal);
+    controller.SetSharedBoard(&sharedBoard);
+    controller.SetServerSession(&serverSession);
+    if (!sharedBoard.IsOpen() && !server) {
+        history.Reset(board);  // Отменить можно только ходы, сделанные после загрузки
+        controller.SetHistory(&history);
+    }
+    controller.SetRandomSeed(static_cast<unsigned>(time(0)));
+    controller.Handle({ InputKind::Resize, 0, settings.windowWidth, settings.windowHeight, 0 });
+    controller.ApplySettings(settings);
+    controller.ResyncRules();  // Поле могло прийти из снимка, журнала или общей памяти
 
     // 5️⃣ Создание окна
     WNDCLASS wc = {};
     wc.lpfnWndProc = WindowProc;
     wc.hInstance = hInstance;
     wc.lpszClassName = L"GridAppClass";
-    wc.hbrBackground = bgBrush;
+    wc.hbrBackground = NULL;  // Фон заливает renderer в WM_PAINT
     RegisterClass(&wc);
 
-    RECT rc = { 0, 0, wndWidth, wndHeight };
+    RECT rc = { 0, 0, settings.windowWidth, settings.windowHeight };
     AdjustWindowRect(&rc, WS_OVERLAPPEDWINDOW, FALSE); // Учитываем рамки окна
     int adjustedWidth = rc.right - rc.left;
     int adjustedHeight = rc.bottom - rc.top;
@@ -131,7 +208,28 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine
         CW_USEDEFAULT, CW_USEDEFAULT, adjustedWidth, adjustedHeight,
         NULL, NULL, hInstance, NULL
     );
-
+    UpdateTitle(hwnd);  // Сохраненная партия могла быть уже решена
+    // Кадры выводим с частотой обновления экрана
+    DEVMODE mode = {};
+    mode.dmSize = sizeof(mode);
+    if (EnumDisplaySettings(NULL, ENUM_CURRENT_SETTINGS, &mode) && mode.dmDisplayFrequency > 1) {
+        frameScheduler.SetInterval(1000 / mode.dmDisplayFrequency);
+    }
+    tasks.Start([hwnd] { PostMessage(hwnd, WM_TASKS_DONE, 0, 0); });
+    SetTimer(hwnd, JournalTimerId, JournalCommitIntervalMs, NULL);  // Периодический сброс журнала на диск
+    if (!notices.empty()) {
+        SetTimer(hwnd, NoticeTimerId, NoticeShowMs, NULL);  // Предупреждения запуска видны несколько секунд
+    }
+    if (sharedBoard.IsOpen()) {
+        SetTimer(hwnd, SharedBoardTimerId, SharedBoardPollMs, NULL);  // Опрос счетчика версий общего поля
+    }
+    if (server) {
+        // Первый клиент партии выкладывает на сервер свое поле, остальные забирают партию сервера.
+        // Подключение, ходы и опрос идут в потоке сессии: окно рисует и принимает ввод, пока сервер отвечает
+        serverSession.Start(GameServerSocket, serverGame, board, [hwnd] { PostMessage(hwnd, WM_SERVER_UPDATE, 0, 0); });
+    }
+    // Правки settings.ini подхватываются без перезапуска: поток наблюдателя только будит окно
+    settingsWatcher.Start(store->Path(), settings, [hwnd] { PostMessage(hwnd, WM_SETTINGS_CHANGED, 0, 0); });
 
     // 6️⃣ Основной цикл обработки сообщений
     MSG msg = {};
@@ -140,137 +238,212 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine
         DispatchMessage(&msg);
     }
 
-    // 7️⃣ Перед выходом обновляем `settings`
-    settings.gridSize = cellSize;
-    settings.windowWidth = wndWidth;
-    settings.windowHeight = wndHeight;
-    settings.gridLineColor = gridLineColor;
-
-    // 8️⃣ Записываем настройки перед выходом
-    switch (method) {
-    case 1: WriteSettingsToMemoryMapping(settings); break;
-    case 2: WriteSettingsToFile(settings); break;
-    case 3: WriteSettingsToStream(settings); break;
-    case 4: WriteSettingsToWinAPI(settings); break;
-    default: WriteSettingsToMemoryMapping(settings); break;
-    }
+    settingsWatcher.Stop();
+
+    // 7️⃣ Перед выходом обновляем `settings`: масштаб, размер окна и цвета
+    settings = controller.CurrentSettings();
+
+    // 8️⃣ Записываем настройки перед выходом (в фоновом потоке, как и всю медленную запись)
+    SettingsStore* settingsStore = store.get();
+    tasks.Post([settingsStore, saved = settings] {
+        if (settingsStore->Save(saved)) {
+            UpdateSettingsCache(*settingsStore, saved);  // Следующий запуск прочитает кэш, а не текст
+        }
+        return TaskDone();
+    });
+    // Сохраняем поле вместе с настройками. Журнал нужен, только пока снимок не записан
+    journal.Commit();
+    tasks.Post([gridSize = settings.gridSize] {
+        bool saved = SaveBoardSnapshot("board.bin", board, gridSize);  // Окна уже нет, поле больше не меняется
+        return saved ? TaskDone([] { journal.Reset(); }) : TaskDone();  // Журналом владеет этот поток
+    });
+    tasks.Stop();  // Дожидается записи и выполняет продолжения
+    journal.Close();
+    CloseLog();
 
     return 0;
 }
 
 
 
-// Обработчик сообщений окна
+// Обработчик сообщений окна: переводит ввод в InputEvent, остальное делает GameController
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
 
     switch (uMsg) {
 
         // Обработка нажатия клавиш
-    case WM_KEYDOWN: {
-        // Если нажата клавиша ESC или комбинация Ctrl+Q, выходим из программы
-        if (wParam == VK_ESCAPE || (GetKeyState(VK_CONTROL) & 0x8000 && wParam == 'Q')) {
-            PostQuitMessage(0);  // Отправляем сообщение о завершении программы
-        }
-        // Если нажата клавиша Enter, меняем цвет фона окна на случайный
-        else if (wParam == VK_RETURN) {
-            srand((unsigned)time(0));
-            DeleteObject(bgBrush);
-
-            COLORREF newColor = RGB(rand() % 256, rand() % 256, rand() % 256);
-            bgBrush = CreateSolidBrush(newColor);
-            SetClassLongPtr(hwnd, GCLP_HBRBACKGROUND, (LONG_PTR)bgBrush);
-
-            settings.backgroundColor = newColor;  // Сразу сохраняем новый цвет
-
-            InvalidateRect(hwnd, NULL, TRUE);
-        }
-
-        // Если нажата комбинация Shift + C, открываем Блокнот
-        else if ((GetKeyState(VK_SHIFT) & 0x8000) && wParam == 'C') {
-            ShellExecute(NULL, L"open", L"notepad.exe", NULL, NULL, SW_SHOWNORMAL);  // Открываем notepad
-        }
+    case WM_KEYDOWN:
+        HandleInput(hwnd, { InputKind::Key, KeyModifiers(), 0, 0, static_cast<int>(wParam) });
         return 0;
-    }
 
-    // Обработка прокрутки колесика мыши
+    // Обработка прокрутки колесика мыши (цвет сетки, с Ctrl — масштаб)
     case WM_MOUSEWHEEL: {
-        int wheelDelta = GET_WHEEL_DELTA_WPARAM(wParam);  // Получаем направление прокрутки
-        // Изменяем цвет сетки в зависимости от прокрутки
-        int r = GetRValue(gridLineColor) + (wheelDelta > 0 ? 5 : -5);
-        int g = GetGValue(gridLineColor) + (wheelDelta > 0 ? 5 : -5);
-        int b = GetBValue(gridLineColor) + (wheelDelta > 0 ? 5 : -5);
-
-        // Ограничиваем значения от 0 до 255 для каждого компонента цвета
-        r = max(0, min(255, r));
-        g = max(0, min(255, g));
-        b = max(0, min(255, b));
-
-        gridLineColor = RGB(r, g, b);  // Обновляем цвет сетки
-        InvalidateRect(hwnd, NULL, TRUE);  // Перерисовываем окно
+        POINT pt = { GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam) };
+        ScreenToClient(hwnd, &pt);  // Для колесика координаты приходят экранные
+        std::uint8_t modifiers = (GET_KEYSTATE_WPARAM(wParam) & MK_CONTROL) ? ModControl : 0;
+        HandleInput(hwnd, { InputKind::Wheel, modifiers, pt.x, pt.y, GET_WHEEL_DELTA_WPARAM(wParam) });
         return 0;
     }
 
+    case WM_ERASEBKGND:  // Фон заливается вместе с остальным кадром в WM_PAINT
+        return 1;
+
     case WM_PAINT: {  // Обработка перерисовки окна
+        PROFILE_SCOPE("paint");
         PAINTSTRUCT ps;  // Структура для хранения информации о рисовании
         HDC hdc = BeginPaint(hwnd, &ps);  // Получаем контекст устройства для рисования
 
-        // Рисуем сетку
-        DrawGrid(hdc, cellSize);
+        RECT rect;
+        GetClientRect(hwnd, &rect);  // Получаем размеры окна для рисования сетки
+        Rect client = ToRect(rect);
+        Rect clip = ToRect(ps.rcPaint);
+
+        // Рисуем только фон, сетку и метки, попавшие в обновляемую область
+        if (client.right * client.bottom >= TiledPaintMinPixels) {
+            // Большое окно: плитки рисуются параллельно в кадр в памяти и выводятся одним копированием
+            if (frameBuffer.Width() != client.right || frameBuffer.Height() != client.bottom) {
+                frameBuffer.Resize(client.right, client.bottom);
+                clip = client;  // Новый кадр пуст, рисуем его целиком
+            }
+            tiledRenderer.SetBackgroundColor(renderer.BackgroundColor());
+            tiledRenderer.SetGridColor(renderer.GridColor());
+            tiledRenderer.SetHeatmap(renderer.Heatmap());
+            tiledRenderer.Paint(board, controller.View(), clip, frameBuffer);
+            BlitFramebuffer(hdc, frameBuffer, ToRect(ps.rcPaint));
+        }
+        else {
+            std::size_t objectsBefore = gdiDevice.ObjectsCreated();
+            gdiDevice.Attach(hdc);
+            renderer.Paint(board, controller.View(), client, clip);
+            gdiDevice.Detach();
+            PROFILE_VALUE("paint.gdi_objects", gdiDevice.ObjectsCreated() - objectsBefore);
+            (void)objectsBefore;  // Без замеров значение не используется
+        }
 
-        // Рисуем все круги, которые были добавлены
-        for (const auto& point : circles) {
-            DrawCircle(hdc, point.x, point.y, cellSize / 2);  // Рисуем каждый круг
+        if (profileOverlay) {
+            DrawProfileOverlay(hdc);
         }
-        // Рисуем все кресты
-        for (const auto& point : crosses) {
-            DrawCross(hdc, point.x, point.y, cellSize / 2);  // Рисуем каждый крест
+        if (!notices.empty()) {
+            DrawNotices(hdc, client);
         }
 
         EndPaint(hwnd, &ps);  // Завершаем рисование
+        if (!firstFramePainted) {
+            firstFramePainted = true;
+            LogStartupTime();
+        }
         return 0;
     }
 
-                 // Обработка кликов левой кнопкой мыши
-    case WM_LBUTTONDOWN: {
-        int x = LOWORD(lParam) / cellSize * cellSize + cellSize / 2;  // Вычисляем центр клетки по оси X
-        int y = HIWORD(lParam) / cellSize * cellSize + cellSize / 2;  // Вычисляем центр клетки по оси Y
+    // Левая кнопка ставит круг, правая — крест
+    case WM_LBUTTONDOWN:
+        HandleInput(hwnd, { InputKind::LeftDown, KeyModifiers(), GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam), 0 });
+        return 0;
+    case WM_RBUTTONDOWN:
+        HandleInput(hwnd, { InputKind::RightDown, KeyModifiers(), GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam), 0 });
+        return 0;
 
-        // Проверяем, не стоит ли уже крест в этой клетке
-        for (const auto& point : crosses) {
-            if (point.x == x && point.y == y) return 0;
-        }
+    case WM_SIZE:  // Новый размер клиентской области
+        HandleInput(hwnd, { InputKind::Resize, 0, LOWORD(lParam), HIWORD(lParam), 0 });
+        return 0;
 
-        circles.push_back({ x, y });  // Добавляем новый круг в список
-        InvalidateRect(hwnd, NULL, TRUE);  // Перерисовываем окно
+    // Перетаскивание поля средней кнопкой мыши
+    case WM_MBUTTONDOWN:
+        SetCapture(hwnd);  // Продолжаем получать движения мыши за пределами окна
+        HandleInput(hwnd, { InputKind::MiddleDown, KeyModifiers(), GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam), 0 });
+        return 0;
+    case WM_MOUSEMOVE:
+        if (GetCapture() == hwnd) {  // Без перетаскивания движения мыши ничего не меняют
+            HandleInput(hwnd, { InputKind::MouseMove, KeyModifiers(), GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam), 0 });
+        }
+        return 0;
+    case WM_MBUTTONUP:
+        ReleaseCapture();
+        HandleInput(hwnd, { InputKind::MiddleUp, KeyModifiers(), GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam), 0 });
+        return 0;
+    case WM_TIMER:
+        // Подошло время отложенного кадра
+        if (wParam == FrameTimerId) {
+            KillTimer(hwnd, FrameTimerId);
+            frameScheduler.TimerFired();
+            PresentFrame(hwnd);
+        }
+        // Групповая фиксация: ходы за последний период уходят на диск одним сбросом
+        else if (wParam == JournalTimerId) {
+            // Пачка уходит ОС сразу, а сброс на диск — в фоновом потоке, чтобы ввод не ждал fsync
+            if (journal.BeginCommit()) {
+                tasks.Post([] {
+                    journal.SyncToDisk();
+                    return TaskDone();
+                });
+            }
+        }
+        else if (wParam == SharedBoardTimerId) {
+            // Перерисовываем только клетки, измененные другими экземплярами (или всё, если отстали)
+            bool decided = false;
+            if (!sharedBoard.Poll(board, [&decided](int col, int row) {
+                    decided |= controller.RemoteChange(col, row) == ControllerAction::GameOver;
+                })) {
+                controller.ResyncRules();
+                controller.InvalidateAll();
+                decided = true;
+            }
+            if (decided) UpdateTitle(hwnd);
+            RequestFrame(hwnd);
+        }
+        else if (wParam == ProfileOverlayTimerId) {
+            controller.InvalidateAll();  // Обновляем цифры на экране
+            RequestFrame(hwnd);
+        }
+        else if (wParam == NoticeTimerId) {
+            KillTimer(hwnd, NoticeTimerId);
+            notices.clear();
+            controller.InvalidateAll();  // Стираем предупреждения с поля
+            RequestFrame(hwnd);
+        }
+        return 0;
+    case WM_TASKS_DONE:  // Фоновые задачи закончились: их продолжения выполняются здесь
+        tasks.Drain();
+        return 0;
+    case WM_SETTINGS_CHANGED: {  // settings.ini изменился на диске
+        std::uint32_t keys = settingsWatcher.TakeChangedKeys();
+        // Размер клетки из командной строки действует до выхода, правка файла его не перебивает
+        if (cmdGridSize > 0) keys &= ~SettingsKeyBit(SettingsKey::GridSize);
+        if (keys != 0) ApplySettings(hwnd, *settingsWatcher.Current(), keys);
         return 0;
     }
-
-     // Обработка кликов правой кнопкой мыши
-    case WM_RBUTTONDOWN: {
-        int x = LOWORD(lParam) / cellSize * cellSize + cellSize / 2;  // Вычисляем центр клетки по оси X
-        int y = HIWORD(lParam) / cellSize * cellSize + cellSize / 2;  // Вычисляем центр клетки по оси Y
-
-        // Проверяем, не стоит ли уже круг в этой клетке
-        for (const auto& point : circles) {
-            if (point.x == x && point.y == y) return 0;
+    case WM_SERVER_UPDATE: {  // Подключение к партии, откат непринятых ходов, ходы других клиентов
+        if (!serverSession.TakeUpdates(serverUpdates)) return 0;
+        serverJoined |= serverUpdates.joined;
+        HandleAction(hwnd, controller.ApplyServerUpdates(serverUpdates));
+        if (serverUpdates.lost) {
+            // Сервер не ответил или остановлен: дальше играем на локальном поле
+            serverSession.Stop();
+            Notify(serverJoined ? L"Связь с сервером партий потеряна. Игра продолжается на локальном поле."
+                : L"Не удалось подключиться к серверу партий. Используется локальное поле.");
+            SetTimer(hwnd, NoticeTimerId, NoticeShowMs, NULL);
+            controller.InvalidateAll();
         }
-
-        crosses.push_back({ x, y });  // Добавляем новый крест в список
-        InvalidateRect(hwnd, NULL, TRUE);  // Перерисовываем окно
+        RequestFrame(hwnd);
         return 0;
     }
-    case WM_SIZE: {
-        //if (wndWidth != 320 && wndHeight != 240) {
-        //    wndWidth = LOWORD(lParam);   // Новый размер ширины окна
-        //    wndHeight = HIWORD(lParam);  // Новый размер высоты окна
-        //}
-        //return 0;
-        wndWidth = LOWORD(lParam);   // Новый размер ширины окна
-        wndHeight = HIWORD(lParam);  // Новый размер высоты окна
+    case WM_AI_MOVE: {  // Поиск закончился: ход ставится уже в потоке окна
+        SearchResult move;
+        if (aiPlayer.TakeResult(move) && move.found) {
+            HandleAction(hwnd, controller.PlaceAiMove(move.col, move.row));
+            RequestFrame(hwnd);
+        }
         return 0;
     }
     case WM_DESTROY:  // Обработка закрытия окна
-        DeleteObject(bgBrush);  // Удаляем кисть фона
+        KillTimer(hwnd, JournalTimerId);
+        KillTimer(hwnd, SharedBoardTimerId);
+        KillTimer(hwnd, ProfileOverlayTimerId);
+        KillTimer(hwnd, FrameTimerId);
+        aiPlayer.Cancel();
+        serverSession.Stop();
+        if (traceRecording) SaveInputTrace("input.trace", recordedTrace);  // Недописанная трасса не теряется
+        renderer.ReleaseObjects();  // Удаляем перья и кисть фона
         PostQuitMessage(0);  // Отправляем сообщение о завершении программы
         return 0;
 
@@ -279,384 +452,186 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     }
 }
 
-// Функция для рисования сетки
-void DrawGrid(HDC hdc, int size) {
-    HPEN pen = CreatePen(PS_SOLID, 1, gridLineColor);  // Создаем перо для рисования
-    SelectObject(hdc, pen);  // Выбираем перо для рисования в контекст устройства
-
-    RECT rect;
-    GetClientRect(WindowFromDC(hdc), &rect);  // Получаем размеры окна для рисования сетки
-
-    // Рисуем вертикальные линии
-    for (int x = 0; x < rect.right; x += size) {
-        MoveToEx(hdc, x, 0, NULL);  // Перемещаем перо в начало линии
-        LineTo(hdc, x, rect.bottom);  // Рисуем вертикальную линию до низа окна
-    }
+// Передает событие контроллеру, выполняет то, что требует окна, и планирует кадр
+void HandleInput(HWND hwnd, const InputEvent& event) {
+    if (traceRecording) recordedTrace.push_back(event);
+    HandleAction(hwnd, controller.Handle(event));
+    RequestFrame(hwnd);
+}
 
-    // Рисуем горизонтальные линии
-    for (int y = 0; y < rect.bottom; y += size) {
-        MoveToEx(hdc, 0, y, NULL);  // Перемещаем перо в начало линии
-        LineTo(hdc, rect.right, y);  // Рисуем горизонтальную линию до конца окна
+// Выполняет то, что контроллер без окна сделать не может
+void HandleAction(HWND hwnd, ControllerAction action) {
+    switch (action) {
+    case ControllerAction::Quit:
+        PostQuitMessage(0);  // Отправляем сообщение о завершении программы
+        break;
+    case ControllerAction::GameOver:
+        UpdateTitle(hwnd);
+        break;
+    case ControllerAction::AiTurn:
+        StartAiSearch(hwnd);
+        break;
+    case ControllerAction::ToggleAi:
+        if (controller.AiTurn()) StartAiSearch(hwnd);  // Включили в очередь крестов — компьютер ходит сразу
+        else aiPlayer.Cancel();
+        UpdateTitle(hwnd);
+        break;
+    case ControllerAction::OpenNotepad:
+        ShellExecute(NULL, L"open", L"notepad.exe", NULL, NULL, SW_SHOWNORMAL);  // Открываем notepad
+        break;
+    case ControllerAction::ToggleTraceRecording:
+        // Трасса пишется в input.trace и воспроизводится без окна: 3lab-replay input.trace
+        traceRecording = !traceRecording;
+        if (traceRecording) recordedTrace.clear();
+        else SaveInputTrace("input.trace", recordedTrace);
+        break;
+#if PROFILING_ENABLED
+    case ControllerAction::DumpProfile:
+        DumpProfile("profile.json");
+        break;
+    case ControllerAction::ToggleProfileOverlay:
+        profileOverlay = !profileOverlay;
+        if (profileOverlay) SetTimer(hwnd, ProfileOverlayTimerId, 500, NULL);
+        else KillTimer(hwnd, ProfileOverlayTimerId);
+        break;
+#endif
+    default:
+        break;
     }
-
-    DeleteObject(pen);  // Удаляем перо
 }
 
-// Функция для рисования круга
-void DrawCircle(HDC hdc, int x, int y, int radius) {
-    HPEN pen = CreatePen(PS_SOLID, 2, RGB(0, 255, 0));  // Создаем перо для рисования круга (зеленое)
-    SelectObject(hdc, pen);  // Выбираем перо для рисования в контекст устройства
-
-    HBRUSH brush = (HBRUSH)GetStockObject(NULL_BRUSH);  // Используем прозрачную кисть для круга
-    SelectObject(hdc, brush);
-
-    Ellipse(hdc, x - radius, y - radius, x + radius, y + radius);  // Рисуем круг по заданным координатам и радиусу
-
-    DeleteObject(pen);  // Удаляем перо
+// Отдает позицию поиску. Окно продолжает обрабатывать сообщения, ход придет в WM_AI_MOVE
+void StartAiSearch(HWND hwnd) {
+    const Settings& current = controller.AppliedSettings();
+    SearchLimits limits;
+    limits.timeMs = current.aiTimeMs;
+    limits.threads = static_cast<unsigned>(current.aiThreads);  // 0 — по числу ядер
+    aiPlayer.Start(controller.AiSnapshot(), 1, limits, [hwnd] { PostMessage(hwnd, WM_AI_MOVE, 0, 0); });
 }
 
-// Функция для рисования креста
-void DrawCross(HDC hdc, int x, int y, int size) {
-    HPEN pen = CreatePen(PS_SOLID, 2, RGB(255, 255, 0));  // Создаем перо для рисования креста (желтое)
-    SelectObject(hdc, pen);  // Выбираем перо для рисования в контекст устройства
-
-    // Рисуем первую линию креста
-    MoveToEx(hdc, x - size / 2, y - size / 2, NULL);
-    LineTo(hdc, x + size / 2, y + size / 2);
-
-    // Рисуем вторую линию креста
-    MoveToEx(hdc, x + size / 2, y - size / 2, NULL);
-    LineTo(hdc, x - size / 2, y + size / 2);
-
-    DeleteObject(pen);  // Удаляем перо
+// Модификаторы, зажатые в момент события
+std::uint8_t KeyModifiers() {
+    std::uint8_t modifiers = 0;
+    if (GetKeyState(VK_CONTROL) & 0x8000) modifiers |= ModControl;
+    if (GetKeyState(VK_SHIFT) & 0x8000) modifiers |= ModShift;
+    return modifiers;
 }
 
-// Метод 1: Отображение файлов на память (CreateFileMapping / MapViewOfFile)
-void ReadSettingsFromMemoryMapping(Settings& settings) {
-    // Открываем файл settings.ini для чтения
-    HANDLE hFile = CreateFile(TEXT("settings.ini"), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (hFile == INVALID_HANDLE_VALUE) {
-        // Если файл не удалось открыть, используем значения по умолчанию
-        settings = { DEFAULT_GRID_SIZE, 320, 240, RGB(0, 0, 255), RGB(255, 0, 0) };
-        return;
+// Выводит кадр сразу, если с прошлого прошел интервал, иначе заводит таймер на остаток.
+// Решает планировщик (то же решение проверяет 3lab-replay --burst), окно только исполняет
+void RequestFrame(HWND hwnd) {
+    unsigned delay = 0;
+    switch (frameScheduler.RequestFrame(GetTickCount64(), delay)) {
+    case FrameAction::Present: PresentFrame(hwnd); break;
+    case FrameAction::ArmTimer: SetTimer(hwnd, FrameTimerId, delay, NULL); break;
+    default: break;
     }
+}
 
-    // Получаем размер файла
-    DWORD fileSize = GetFileSize(hFile, NULL);
-    if (fileSize == INVALID_FILE_SIZE || fileSize == 0) {
-        // Если размер файла некорректен, закрываем файл и используем значения по умолчанию
-        CloseHandle(hFile);
-        settings = { DEFAULT_GRID_SIZE, 320, 240, RGB(0, 0, 255), RGB(255, 0, 0) };
+// Передает окну повреждения, накопленные за интервал. WM_PAINT придет один на все
+void PresentFrame(HWND hwnd) {
+    if (!frameScheduler.TakeFrame(GetTickCount64(), frameDamage)) return;
+    if (frameDamage.full) {
+        InvalidateRect(hwnd, NULL, FALSE);
         return;
     }
-
-    // Создаем отображение файла в память
-    HANDLE hMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, fileSize, NULL);
-    if (!hMapping) {
-        // Если не удалось создать отображение, закрываем файл и используем значения по умолчанию
-        CloseHandle(hFile);
-        settings = { DEFAULT_GRID_SIZE, 320, 240, RGB(0, 0, 255), RGB(255, 0, 0) };
-        return;
+    if (frameDamage.scrollX != 0 || frameDamage.scrollY != 0) {
+        ScrollWindowEx(hwnd, frameDamage.scrollX, frameDamage.scrollY, NULL, NULL, NULL, NULL, SW_INVALIDATE);
     }
-
-    // Отображаем файл в память
-    LPVOID pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, fileSize);
-    if (!pData) {
-        // Если не удалось отобразить файл, закрываем отображение и файл, используем значения по умолчанию
-        CloseHandle(hMapping);
-        CloseHandle(hFile);
-        settings = { DEFAULT_GRID_SIZE, 320, 240, RGB(0, 0, 255), RGB(255, 0, 0) };
-        return;
-    }
-
-    // Преобразуем данные в строку
-    std::string content(static_cast<char*>(pData), fileSize);
-    std::stringstream ss(content);
-    std::string line;
-
-    // Читаем файл построчно и парсим настройки
-    while (std::getline(ss, line)) {
-        if (line.find("GridSize=") == 0) {
-            settings.gridSize = std::stoi(line.substr(9));
-        }
-        else if (line.find("WindowWidth=") == 0) {
-            settings.windowWidth = std::stoi(line.substr(12));
-        }
-        else if (line.find("WindowHeight=") == 0) {
-            settings.windowHeight = std::stoi(line.substr(13));
-        }
-        else if (line.find("BackgroundColor=") == 0) {
-            int r, g, b;
-            if (sscanf_s(line.substr(16).c_str(), "%d,%d,%d", &r, &g, &b) == 3) {
-                settings.backgroundColor = RGB(r, g, b);
-            }
-        }
-        else if (line.find("GridLineColor=") == 0) {
-            int r, g, b;
-            if (sscanf_s(line.substr(14).c_str(), "%d,%d,%d", &r, &g, &b) == 3) {
-                settings.gridLineColor = RGB(r, g, b);
-            }
-        }
+    for (const Rect& damage : frameDamage.rects) {
+        RECT rc = ToRECT(damage);
+        InvalidateRect(hwnd, &rc, FALSE);
     }
-
-    // Освобождаем ресурсы
-    UnmapViewOfFile(pData);
-    CloseHandle(hMapping);
-    CloseHandle(hFile);
 }
 
-void WriteSettingsToMemoryMapping(const Settings& settings) {
-    // Формируем строку с настройками
-    std::string data = "[Settings]\n";
-    data += "GridSize=" + std::to_string(settings.gridSize) + "\n";
-    data += "WindowWidth=" + std::to_string(settings.windowWidth) + "\n";
-    data += "WindowHeight=" + std::to_string(settings.windowHeight) + "\n";
-    data += "BackgroundColor=" + std::to_string(GetRValue(settings.backgroundColor)) + "," +
-        std::to_string(GetGValue(settings.backgroundColor)) + "," +
-        std::to_string(GetBValue(settings.backgroundColor)) + "\n";
-    data += "GridLineColor=" + std::to_string(GetRValue(settings.gridLineColor)) + "," +
-        std::to_string(GetGValue(settings.gridLineColor)) + "," +
-        std::to_string(GetBValue(settings.gridLineColor)) + "\n";
-
-    DWORD dataSize = static_cast<DWORD>(data.size());
-
-    // Открываем файл для записи (создаем новый или перезаписываем существующий)
-    HANDLE hFile = CreateFile(TEXT("settings.ini"), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (hFile == INVALID_HANDLE_VALUE) {
-        printf("Ошибка: не удалось открыть файл settings.ini. Код ошибки: %d\n", GetLastError());
-        return;
+// Выводит сводку замеров в левом верхнем углу окна (по строке на замер)
+void DrawProfileOverlay(HDC hdc) {
+    std::vector<ProfileStats> stats = CollectProfile();
+    int y = 4;
+    for (const ProfileStats& entry : stats) {
+        std::string line = FormatProfileStats(entry);
+        std::wstring text(line.begin(), line.end());  // Сводка состоит только из ASCII
+        TextOutW(hdc, 4, y, text.c_str(), static_cast<int>(text.size()));
+        y += 16;
     }
-
-    // Записываем данные в файл
-    DWORD bytesWritten;
-    BOOL success = WriteFile(hFile, data.c_str(), dataSize, &bytesWritten, NULL);
-    if (!success || bytesWritten != dataSize) {
-        printf("Ошибка: не удалось записать данные в файл. Код ошибки: %d\n", GetLastError());
-    }
-
-    // Закрываем файл
-    CloseHandle(hFile);
 }
 
-// Метод 2: Файловые переменные (fopen, fread, fwrite, fclose)
-void ReadSettingsFromFile(Settings& settings) {
-    // Открываем файл settings.ini для чтения
-    FILE* file = nullptr;
-    if (fopen_s(&file, "settings.ini", "r") != 0 || !file) {
-        // Если файл не удалось открыть, используем значения по умолчанию
-        settings = { DEFAULT_GRID_SIZE, 320, 240, RGB(0, 0, 255), RGB(255, 0, 0) };
-        return;
+// Применяет измененные в файле ключи и перерисовывает окно один раз
+void ApplySettings(HWND hwnd, const Settings& fresh, std::uint32_t keys) {
+    // Размер окна меняем, только если его поменяли в файле: размер, выбранный мышью, иначе сохраняется
+    if (keys & (SettingsKeyBit(SettingsKey::WindowWidth) | SettingsKeyBit(SettingsKey::WindowHeight))) {
+        RECT rc = { 0, 0, fresh.windowWidth, fresh.windowHeight };
+        AdjustWindowRect(&rc, WS_OVERLAPPEDWINDOW, FALSE);
+        SetWindowPos(hwnd, NULL, 0, 0, rc.right - rc.left, rc.bottom - rc.top, SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
     }
 
-    // Читаем файл построчно и парсим настройки
-    char line[256];
-    while (fgets(line, sizeof(line), file)) {
-        if (strstr(line, "GridSize=")) {
-            sscanf_s(line, "GridSize=%d", &settings.gridSize);
-        }
-        else if (strstr(line, "WindowWidth=")) {
-            sscanf_s(line, "WindowWidth=%d", &settings.windowWidth);
-        }
-        else if (strstr(line, "WindowHeight=")) {
-            sscanf_s(line, "WindowHeight=%d", &settings.windowHeight);
-        }
-        else if (strstr(line, "BackgroundColor=")) {
-            int r, g, b;
-            sscanf_s(line, "BackgroundColor=%d,%d,%d", &r, &g, &b);
-            settings.backgroundColor = RGB(r, g, b);
-        }
-        else if (strstr(line, "GridLineColor=")) {
-            int r, g, b;
-            sscanf_s(line, "GridLineColor=%d,%d,%d", &r, &g, &b);
-            settings.gridLineColor = RGB(r, g, b);
-        }
-    }
-
-    // Закрываем файл
-    fclose(file);
+    controller.ApplySettings(fresh, keys);  // Масштаб меняется относительно центра окна
+    RequestFrame(hwnd);
 }
 
-void WriteSettingsToFile(const Settings& settings) {
-    // Открываем файл settings.ini для записи
-    FILE* file = nullptr;
-    if (fopen_s(&file, "settings.ini", "w") != 0) {
-        return;
-    }
-
-    // Записываем настройки в файл
-    fprintf(file, "[Settings]\n");
-    fprintf(file, "GridSize=%d\n", settings.gridSize);
-    fprintf(file, "WindowWidth=%d\n", settings.windowWidth);
-    fprintf(file, "WindowHeight=%d\n", settings.windowHeight);
-    fprintf(file, "BackgroundColor=%d,%d,%d\n", GetRValue(settings.backgroundColor),
-        GetGValue(settings.backgroundColor), GetBValue(settings.backgroundColor));
-    fprintf(file, "GridLineColor=%d,%d,%d\n", GetRValue(settings.gridLineColor),
-        GetGValue(settings.gridLineColor), GetBValue(settings.gridLineColor));
-
-    // Закрываем файл
-    fclose(file);
+// Показывает итог партии в заголовке окна
+void UpdateTitle(HWND hwnd) {
+    std::wstring title = L"Circle & Crosses";
+    switch (controller.Outcome()) {
+    case GameOutcome::CircleWins: title += L" — победили круги"; break;
+    case GameOutcome::CrossWins: title += L" — победили кресты"; break;
+    case GameOutcome::Draw: title += L" — ничья"; break;
+    default: break;
+    }
+    if (controller.AiEnabled()) title += L" (кресты за компьютером)";
+    SetWindowText(hwnd, title.c_str());
 }
 
-// Метод 3: Потоки ввода-вывода (библиотека fstream в языке C++, объекты файловых потоков ofstream и ifstream)
-void ReadSettingsFromStream(Settings& settings) {
-    // Открываем файл settings.ini для чтения
-    std::ifstream file("settings.ini");
-    if (!file.is_open()) {
-        // Если файл не удалось открыть, используем значения по умолчанию
-        settings = { DEFAULT_GRID_SIZE, 320, 240, RGB(0, 0, 255), RGB(255, 0, 0) };
-        return;
+// Сообщает о ключах, которые не удалось прочитать из settings.ini
+void ReportSettingsErrors(const SettingsParseResult& result) {
+    for (int i = 0; i < SettingsKeyCount; ++i) {
+        if (result.errors[i] == SettingsError::None) continue;
+        std::string key = SettingsKeyName(static_cast<SettingsKey>(i));
+        std::string error = SettingsErrorText(result.errors[i]);
+        std::wstring text = L"settings.ini, ";
+        text.append(key.begin(), key.end());
+        text += L" (строка " + std::to_wstring(result.errorLines[i]) + L"): ";
+        text.append(error.begin(), error.end());
+        text += L", используется значение по умолчанию";
+        Notify(text);
     }
-
-    // Читаем файл построчно и парсим настройки
-    std::string line;
-    while (std::getline(file, line)) {
-        if (line.find("GridSize=") == 0) {
-            settings.gridSize = std::stoi(line.substr(9));
-        }
-        else if (line.find("WindowWidth=") == 0) {
-            settings.windowWidth = std::stoi(line.substr(12));
-        }
-        else if (line.find("WindowHeight=") == 0) {
-            settings.windowHeight = std::stoi(line.substr(13));
-        }
-        else if (line.find("BackgroundColor=") == 0) {
-            std::string color = line.substr(16);
-            int r, g, b;
-            if (sscanf_s(color.c_str(), "%d,%d,%d", &r, &g, &b) == 3) {
-                settings.backgroundColor = RGB(r, g, b);
-            }
-        }
-        else if (line.find("GridLineColor=") == 0) {
-            std::string color = line.substr(14);
-            int r, g, b;
-            if (sscanf_s(color.c_str(), "%d,%d,%d", &r, &g, &b) == 3) {
-                settings.gridLineColor = RGB(r, g, b);
-            }
-        }
-    }
-
-    // Закрываем файл
-    file.close();
 }
 
-void WriteSettingsToStream(const Settings& settings) {
-    // Открываем файл settings.ini для записи
-    std::ofstream file("settings.ini");
-    if (!file.is_open()) {
-        std::cerr << "Ошибка: не удалось открыть файл settings.ini для записи.\n";
-        return;
-    }
-
-    // Записываем настройки в файл
-    file << "[Settings]\n";
-    file << "GridSize=" << settings.gridSize << "\n";
-    file << "WindowWidth=" << settings.windowWidth << "\n";
-    file << "WindowHeight=" << settings.windowHeight << "\n";
-    file << "BackgroundColor="
-        << static_cast<int>(GetRValue(settings.backgroundColor)) << ","
-        << static_cast<int>(GetGValue(settings.backgroundColor)) << ","
-        << static_cast<int>(GetBValue(settings.backgroundColor)) << "\n";
-    file << "GridLineColor="
-        << static_cast<int>(GetRValue(settings.gridLineColor)) << ","
-        << static_cast<int>(GetGValue(settings.gridLineColor)) << ","
-        << static_cast<int>(GetBValue(settings.gridLineColor)) << "\n";
-
-    // Проверяем, успешно ли прошла запись
-    if (!file) {
-        std::cerr << "Ошибка записи в файл settings.ini\n";
+// Записывает предупреждение в журнал и показывает его поверх поля (вместо модального окна)
+void Notify(const std::wstring& text) {
+    int length = WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), NULL, 0, NULL, NULL);
+    std::string utf8(length > 0 ? length : 0, '\0');
+    if (length > 0) {
+        WideCharToMultiByte(CP_UTF8, 0, text.c_str(), static_cast<int>(text.size()), utf8.data(), length, NULL, NULL);
     }
-
-    // Закрываем файл
-    file.close();
+    LogLine(utf8);
+    notices.push_back(text);
 }
 
-// Метод 4: Файловые функции WinAPI
-void ReadSettingsFromWinAPI(Settings& settings) {
-    // Открываем файл settings.ini для чтения
-    HANDLE hFile = CreateFile(L"settings.ini", GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (hFile == INVALID_HANDLE_VALUE) {
-        // Если файл не удалось открыть, используем значения по умолчанию
-        settings = { DEFAULT_GRID_SIZE, 320, 240, RGB(0, 0, 255), RGB(255, 0, 0) };
-        return;
-    }
-
-    // Получаем размер файла
-    DWORD fileSize = GetFileSize(hFile, NULL);
-    if (fileSize == INVALID_FILE_SIZE) {
-        // Если размер файла некорректен, закрываем файл и используем значения по умолчанию
-        CloseHandle(hFile);
-        settings = { DEFAULT_GRID_SIZE, 320, 240, RGB(0, 0, 255), RGB(255, 0, 0) };
-        return;
-    }
-
-    // Выделяем буфер для чтения данных
-    char* buffer = new char[fileSize + 1];
-    DWORD bytesRead;
-    if (!ReadFile(hFile, buffer, fileSize, &bytesRead, NULL)) {
-        // Если не удалось прочитать файл, освобождаем буфер и закрываем файл, используем значения по умолчанию
-        delete[] buffer;
-        CloseHandle(hFile);
-        settings = { DEFAULT_GRID_SIZE, 320, 240, RGB(0, 0, 255), RGB(255, 0, 0) };
-        return;
-    }
-
-    // Добавляем завершающий нулевой символ
-    buffer[fileSize] = '\0';
-
-    // Парсим настройки из буфера
-    std::stringstream ss(buffer);
-    std::string line;
-    while (std::getline(ss, line)) {
-        if (line.find("GridSize=") == 0) {
-            settings.gridSize = std::stoi(line.substr(9));
-        }
-        else if (line.find("WindowWidth=") == 0) {
-            settings.windowWidth = std::stoi(line.substr(12));
-        }
-        else if (line.find("WindowHeight=") == 0) {
-            settings.windowHeight = std::stoi(line.substr(13));
-        }
-        else if (line.find("BackgroundColor=") == 0) {
-            std::string color = line.substr(16);
-            int r, g, b;
-            sscanf_s(color.c_str(), "%d,%d,%d", &r, &g, &b);
-            settings.backgroundColor = RGB(r, g, b);
-        }
-        else if (line.find("GridLineColor=") == 0) {
-            std::string color = line.substr(14);
-            int r, g, b;
-            sscanf_s(color.c_str(), "%d,%d,%d", &r, &g, &b);
-            settings.gridLineColor = RGB(r, g, b);
-        }
+// Предупреждения выводятся внизу окна, чтобы не закрывать замеры (F12)
+void DrawNotices(HDC hdc, const Rect& client) {
+    int y = client.bottom - 4 - 16 * static_cast<int>(notices.size());
+    for (const std::wstring& text : notices) {
+        TextOutW(hdc, 4, y, text.c_str(), static_cast<int>(text.size()));
+        y += 16;
     }
-
-    // Освобождаем буфер и закрываем файл
-    delete[] buffer;
-    CloseHandle(hFile);
 }
 
-void WriteSettingsToWinAPI(const Settings& settings) {
-    // Формируем строку с настройками
-    std::string data = "[Settings]\n";
-    data += "GridSize=" + std::to_string(settings.gridSize) + "\n";
-    data += "WindowWidth=" + std::to_string(settings.windowWidth) + "\n";
-    data += "WindowHeight=" + std::to_string(settings.windowHeight) + "\n";
-    data += "BackgroundColor=" + std::to_string(GetRValue(settings.backgroundColor)) + "," +
-        std::to_string(GetGValue(settings.backgroundColor)) + "," +
-        std::to_string(GetBValue(settings.backgroundColor)) + "\n";
-    data += "GridLineColor=" + std::to_string(GetRValue(settings.gridLineColor)) + "," +
-        std::to_string(GetGValue(settings.gridLineColor)) + "," +
-        std::to_string(GetBValue(settings.gridLineColor)) + "\n";
-
-    // Открываем файл для записи (создаем новый или перезаписываем существующий)
-    HANDLE hFile = CreateFile(L"settings.ini", GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (hFile == INVALID_HANDLE_VALUE) return;
-
-    // Записываем данные в файл
-    DWORD bytesWritten;
-    WriteFile(hFile, data.c_str(), data.size(), &bytesWritten, NULL);
-
-    // Закрываем файл
-    CloseHandle(hFile);
+// Пишет в журнал время от создания процесса до первого выведенного кадра
+void LogStartupTime() {
+    FILETIME created, exited, kernel, user, now;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return;
+    GetSystemTimePreciseAsFileTime(&now);
+    ULARGE_INTEGER start, end;
+    start.LowPart = created.dwLowDateTime;
+    start.HighPart = created.dwHighDateTime;
+    end.LowPart = now.dwLowDateTime;
+    end.HighPart = now.dwHighDateTime;
+    double ms = (end.QuadPart - start.QuadPart) / 10000.0;  // FILETIME — в сотнях наносекунд
+
+    const char* source = settingsSource == SettingsSource::Cache ? "кэш"
+        : settingsSource == SettingsSource::Text ? "settings.ini" : "по умолчанию";
+    char line[128];
+    snprintf(line, sizeof(line), "первый кадр через %.1f мс после запуска процесса (настройки: %s)", ms, source);
+    LogLine(line);
 }
-//Текст
\ No newline at end of file
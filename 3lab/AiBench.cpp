@@ -0,0 +1,144 @@
+﻿#include "AiBench.h"
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include "AiSearch.h"
+#include "Board.h"
+#include "ThreadPool.h"
+
+// Позиция набора: строки через '/', O — круг, X — крест, * — пустая клетка, куда правильно пойти
+struct AiSuiteCase {
+    const char* name;
+    int winLength;
+    int player;  // Кто ходит: 0 — круги, 1 — кресты
+    const char* diagram;
+};
+
+static const AiSuiteCase SuiteCases[] = {
+    { "win-row",          5, 1, ".........../..*XXXX*..../....O.O.O../......O...." },
+    { "win-diagonal",     5, 1, "*....../.X...../..X..../...X.../....X../.....*./OOO...." },
+    { "win-gap",          5, 1, "........./..XX*XX../.O..O.O../....O...." },
+    { "win-not-block",    5, 1, "XOOOO..../.*XXXX*../........." },
+    { "block-four",       5, 1, "XOOOO*..../...X.X..../.........." },
+    { "block-gap",        5, 1, "........./..OO*OO../.X...X.../....X...." },
+    { "block-open-three", 5, 1, ".........../...*OOO*.../....X....../......X...." },
+    { "open-four",        5, 1, "O.........O/.........../...*XXX*.../.........../O.........." },
+    { "four-three",       5, 1, "........../.....X..../.....X..../.OXXX*..../........../O......O.." },
+    { "circle-blocks",    5, 0, "OXXXX*..../..O..O..../.........." },
+    { "three-in-row",     3, 1, "....../.*XX*./.O..O./......" },
+};
+
+// Раскладывает схему на поле. Возвращает центр схемы
+static void LoadDiagram(const char* diagram, Board& board, std::vector<std::pair<int, int>>& answers, int& centerCol, int& centerRow) {
+    int col = 0, row = 0, width = 0;
+    for (const char* p = diagram; *p; ++p) {
+        if (*p == '/') {
+            ++row;
+            col = 0;
+            continue;
+        }
+        if (*p == 'O') board.Place(col, row, Mark::Circle);
+        else if (*p == 'X') board.Place(col, row, Mark::Cross);
+        else if (*p == '*') answers.emplace_back(col, row);
+        width = std::max(width, ++col);
+    }
+    centerCol = width / 2;
+    centerRow = (row + 1) / 2;
+}
+
+std::vector<AiSuiteResult> RunAiSuite(unsigned threads, int depth) {
+    std::unique_ptr<ThreadPool> pool(threads > 1 ? new ThreadPool(threads - 1) : nullptr);
+    SearchLimits limits;
+    limits.timeMs = 0;
+    limits.maxDepth = depth;
+    limits.threads = threads;
+
+    std::vector<AiSuiteResult> results;
+    for (const AiSuiteCase& test : SuiteCases) {
+        Board board;
+        std::vector<std::pair<int, int>> answers;
+        int centerCol, centerRow;
+        LoadDiagram(test.diagram, board, answers, centerCol, centerRow);
+
+        TranspositionTable table(1);  // Каждая позиция — с пустой таблицей, чтобы прогоны не зависели друг от друга
+        SearchResult found = SearchMove(AiPosition::Around(board, centerCol, centerRow, test.winLength), test.player,
+            limits, table, pool.get());
+
+        AiSuiteResult result;
+        result.name = test.name;
+        result.col = found.col;
+        result.row = found.row;
+        result.depth = found.depth;
+        result.score = found.score;
+        result.nodes = found.nodes;
+        for (const auto& answer : answers) {
+            if (found.found && answer.first == found.col && answer.second == found.row) result.passed = true;
+        }
+        results.push_back(result);
+    }
+    return results;
+}
+
+std::string FormatAiSuite(const std::vector<AiSuiteResult>& results) {
+    std::string text;
+    int passed = 0;
+    for (const AiSuiteResult& result : results) {
+        char line[160];
+        std::snprintf(line, sizeof(line), "%-18s %s  move %d,%d  depth %d  score %d  nodes %llu\n", result.name.c_str(),
+            result.passed ? "ok  " : "FAIL", result.col, result.row, result.depth, result.score,
+            static_cast<unsigned long long>(result.nodes));
+        text += line;
+        passed += result.passed ? 1 : 0;
+    }
+    char summary[64];
+    std::snprintf(summary, sizeof(summary), "%d of %zu positions solved\n", passed, results.size());
+    return text + summary;
+}
+
+// Середина партии гомоку без немедленных угроз
+static const char* MiddleGame =
+    "............../"
+    "......O......./"
+    "....X...X...../"
+    ".....OX.O...../"
+    "....X.O.X...../"
+    "...O...X.O..../"
+    "......O......./"
+    "..............";
+
+std::vector<AiScalingResult> MeasureAiScaling(int timeMs, unsigned maxThreads) {
+    Board board;
+    std::vector<std::pair<int, int>> unused;
+    int centerCol, centerRow;
+    LoadDiagram(MiddleGame, board, unused, centerCol, centerRow);
+    AiPosition position = AiPosition::Around(board, centerCol, centerRow, 5);
+
+    std::vector<AiScalingResult> results;
+    for (unsigned threads = 1; threads <= maxThreads; ++threads) {
+        ThreadPool pool(threads - 1);
+        TranspositionTable table;
+        SearchLimits limits;
+        limits.timeMs = timeMs;
+        limits.threads = threads;
+        SearchResult found = SearchMove(position, 1, limits, table, &pool);
+
+        AiScalingResult result;
+        result.threads = threads;
+        result.nodesPerSecond = found.NodesPerSecond();
+        result.depth = found.depth;
+        result.speedup = results.empty() ? 1.0 : result.nodesPerSecond / results[0].nodesPerSecond;
+        results.push_back(result);
+    }
+    return results;
+}
+
+std::string FormatAiScaling(const std::vector<AiScalingResult>& results) {
+    std::string text = "threads    nodes/s   speedup   depth\n";
+    for (const AiScalingResult& result : results) {
+        char line[96];
+        std::snprintf(line, sizeof(line), "%7u %10.0f %9.2f %7d\n", result.threads, result.nodesPerSecond, result.speedup, result.depth);
+        text += line;
+    }
+    return text;
+}
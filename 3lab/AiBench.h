@@ -0,0 +1,32 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Итог одной позиции набора
+struct AiSuiteResult {
+    std::string name;
+    bool passed = false;
+    int col = 0;  // Выбранный ход
+    int row = 0;
+    int depth = 0;
+    int score = 0;
+    std::uint64_t nodes = 0;
+};
+
+// Прогоняет набор позиций с известными ответами (выиграть сразу, закрыть четверку, открыть
+// четверку и т. п.). С одним потоком поиск ограничен только глубиной, и результат повторяется точно
+std::vector<AiSuiteResult> RunAiSuite(unsigned threads, int depth);
+std::string FormatAiSuite(const std::vector<AiSuiteResult>& results);
+
+// Скорость поиска на одном числе потоков
+struct AiScalingResult {
+    unsigned threads = 0;
+    double nodesPerSecond = 0;
+    double speedup = 0;  // Относительно одного потока
+    int depth = 0;       // Глубина, достигнутая за отведенное время
+};
+
+// Ищет ход в позиции середины партии timeMs миллисекунд на 1..maxThreads потоках
+std::vector<AiScalingResult> MeasureAiScaling(int timeMs, unsigned maxThreads);
+std::string FormatAiScaling(const std::vector<AiScalingResult>& results);
@@ -0,0 +1,78 @@
+﻿#include "AiPlayer.h"
+#include <utility>
+
+AiPlayer::AiPlayer() {
+    thread = std::thread(&AiPlayer::Run, this);  // Уже после того, как созданы все поля
+}
+
+AiPlayer::~AiPlayer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        cancel = true;
+    }
+    wakeup.notify_one();
+    thread.join();
+}
+
+void AiPlayer::Start(const AiPosition& position, int player, const SearchLimits& limits, ReadyCallback onReady) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++generation;
+        hasResult = false;
+        cancel = searching;  // Текущий поиск бросаем, новый начнется сразу после него
+        pending.reset(new Request{ position, player, limits, std::move(onReady) });
+    }
+    wakeup.notify_one();
+}
+
+void AiPlayer::Cancel() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++generation;
+    hasResult = false;
+    pending.reset();
+    cancel = searching;
+}
+
+bool AiPlayer::TakeResult(SearchResult& taken) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!hasResult) return false;
+    taken = result;
+    hasResult = false;
+    return true;
+}
+
+bool AiPlayer::Busy() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return searching || pending != nullptr || hasResult;
+}
+
+void AiPlayer::Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wakeup.wait(lock, [this] { return stopping || pending != nullptr; });
+        if (stopping) return;
+
+        std::unique_ptr<Request> request = std::move(pending);
+        std::uint64_t started = generation;
+        searching = true;
+        cancel = false;
+        lock.unlock();
+
+        // Пул пересоздается, только если поменялось число потоков в настройках
+        unsigned threads = request->limits.threads ? request->limits.threads : ThreadPool::DefaultWorkers() + 1;
+        if (threads > 1 && (!pool || pool->Concurrency() != threads)) pool.reset(new ThreadPool(threads - 1));
+        SearchLimits limits = request->limits;
+        limits.threads = threads;
+        SearchResult found = SearchMove(request->position, request->player, limits, table, threads > 1 ? pool.get() : nullptr, &cancel);
+
+        lock.lock();
+        searching = false;
+        if (generation != started) continue;  // Пока искали, позиция изменилась или поиск отменили
+        result = found;
+        hasResult = true;
+        lock.unlock();
+        if (request->onReady) request->onReady();
+        lock.lock();
+    }
+}
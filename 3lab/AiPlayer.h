@@ -0,0 +1,59 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "AiSearch.h"
+#include "ThreadPool.h"
+#include "TranspositionTable.h"
+
+// Компьютерный игрок: ищет ход в своем потоке, чтобы окно не ждало поиска. Окно отдает снимок
+// позиции, а о готовом ходе узнает из onReady (вызывается в потоке поиска — обычно это PostMessage)
+// и забирает его через TakeResult. Пул потоков поиска и таблица транспозиций живут между ходами
+class AiPlayer {
+public:
+    using ReadyCallback = std::function<void()>;
+
+    AiPlayer();
+    ~AiPlayer();
+
+    AiPlayer(const AiPlayer&) = delete;
+    AiPlayer& operator=(const AiPlayer&) = delete;
+
+    // Начинает искать ход игрока (0 — круги, 1 — кресты). Незаконченный прежний поиск отменяется
+    void Start(const AiPosition& position, int player, const SearchLimits& limits, ReadyCallback onReady);
+    // Отменяет поиск: его ход уже не будет выдан
+    void Cancel();
+    // Забирает найденный ход. false, если хода еще нет
+    bool TakeResult(SearchResult& result);
+    // Идет поиск или есть невыданный ход
+    bool Busy() const;
+
+private:
+    struct Request {
+        AiPosition position;
+        int player;
+        SearchLimits limits;
+        ReadyCallback onReady;
+    };
+
+    void Run();
+
+    std::thread thread;
+    mutable std::mutex mutex;
+    std::condition_variable wakeup;
+    std::unique_ptr<Request> pending;  // Запрос, который поток еще не взял
+    bool searching = false;
+    bool hasResult = false;
+    bool stopping = false;
+    std::uint64_t generation = 0;      // Растет с каждым Start и Cancel: ход старого поиска не выдается
+    std::atomic<bool> cancel{ false };
+    SearchResult result;
+
+    // Используются только потоком поиска
+    std::unique_ptr<ThreadPool> pool;
+    TranspositionTable table;
+};
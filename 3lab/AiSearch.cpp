@@ -0,0 +1,373 @@
+﻿#include "AiSearch.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include "Bits.h"
+#include "ThreadPool.h"
+
+const int MaxRootMoves = 32;   // Сколько лучших по эвристике ходов смотрим в корне
+const int MaxInnerMoves = 14;  // и во внутренних узлах
+const int TimeCheckNodes = 1024;
+const int Infinity = AiWinScore + 1;
+
+// Номера линий и позиции клеток на них (считаются один раз)
+struct CellLines {
+    std::uint8_t line[4][AiCells];
+    std::uint8_t bit[4][AiCells];
+
+    CellLines() {
+        for (int cell = 0; cell < AiCells; ++cell) {
+            int col = cell % AiBoardSize, row = cell / AiBoardSize;
+            line[0][cell] = static_cast<std::uint8_t>(row);                                        // Строки
+            line[1][cell] = static_cast<std::uint8_t>(AiBoardSize + col);                          // Столбцы
+            line[2][cell] = static_cast<std::uint8_t>(2 * AiBoardSize + col - row + AiBoardSize - 1);  // Вниз-вправо
+            line[3][cell] = static_cast<std::uint8_t>(4 * AiBoardSize - 1 + col + row);            // Вверх-вправо
+            bit[0][cell] = static_cast<std::uint8_t>(col);
+            bit[1][cell] = static_cast<std::uint8_t>(row);
+            bit[2][cell] = static_cast<std::uint8_t>(col);
+            bit[3][cell] = static_cast<std::uint8_t>(col);
+        }
+    }
+};
+
+static const CellLines& Lines() {
+    static const CellLines lines;
+    return lines;
+}
+
+// Ключи Зобриста: по ключу на игрока и клетку и ключ очереди хода. Генератор с постоянным
+// зерном — хэши одинаковы от запуска к запуску
+struct ZobristKeys {
+    std::uint64_t cells[2][AiCells];
+    std::uint64_t side;
+
+    ZobristKeys() {
+        std::uint64_t state = 0x3C6EF372FE94F82Bull;
+        auto next = [&state] {
+            std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);  // splitmix64
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        };
+        for (auto& player : cells) {
+            for (std::uint64_t& key : player) key = next();
+        }
+        side = next();
+    }
+};
+
+static const ZobristKeys& Zobrist() {
+    static const ZobristKeys keys;
+    return keys;
+}
+
+AiPosition::AiPosition(int originCol, int originRow, int winLength)
+    : originCol(originCol), originRow(originRow), winLength(std::max(MinWinLength, std::min(MaxWinLength, winLength))) {
+    // Вес окна растет примерно вдесятеро на каждую метку, которой не хватает до линии
+    static const int ByMissing[] = { 0, 5000, 400, 40, 6, 2 };
+    for (int count = 0; count <= this->winLength; ++count) {
+        int missing = this->winLength - count;
+        weights[count] = count == 0 ? 0 : (missing < 6 ? ByMissing[missing] : 1);
+    }
+    weights[this->winLength] = 0;  // Собранная линия — конец партии, а не оценка
+
+    auto starts = [this](int lo, int hi) {
+        int last = hi - this->winLength + 1;
+        if (last < lo) return std::uint64_t(0);
+        return ((std::uint64_t(1) << (last + 1)) - 1) & ~((std::uint64_t(1) << lo) - 1);
+    };
+    for (int i = 0; i < AiBoardSize; ++i) {
+        validStarts[i] = starts(0, AiBoardSize - 1);
+        validStarts[AiBoardSize + i] = starts(0, AiBoardSize - 1);
+    }
+    for (int k = 0; k < 2 * AiBoardSize - 1; ++k) {
+        int diff = k - (AiBoardSize - 1);  // col - row
+        validStarts[2 * AiBoardSize + k] = starts(std::max(0, diff), std::min(AiBoardSize - 1, AiBoardSize - 1 + diff));
+        validStarts[4 * AiBoardSize - 1 + k] = starts(std::max(0, k - (AiBoardSize - 1)), std::min(AiBoardSize - 1, k));
+    }
+    history.reserve(AiCells);
+}
+
+AiPosition AiPosition::Around(const Board& board, int centerCol, int centerRow, int winLength) {
+    AiPosition position(centerCol - AiBoardSize / 2, centerRow - AiBoardSize / 2, winLength);
+    board.ForEachIn(position.originCol, position.originRow, position.originCol + AiBoardSize, position.originRow + AiBoardSize,
+        [&position](int col, int row, Mark mark) { position.Place(position.CellOf(col, row), mark == Mark::Circle ? 0 : 1); });
+    position.history.clear();  // Метки поля отменять не нужно
+    return position;
+}
+
+int AiPosition::CellOf(int col, int row) const {
+    long long c = static_cast<long long>(col) - originCol;
+    long long r = static_cast<long long>(row) - originRow;
+    if (c < 0 || r < 0 || c >= AiBoardSize || r >= AiBoardSize) return -1;
+    return static_cast<int>(r * AiBoardSize + c);
+}
+
+void AiPosition::Delta(int cell, int player, int& ownGain, int& oppLoss, bool& wins) const {
+    const CellLines& cl = Lines();
+    const std::uint64_t window = (std::uint64_t(1) << winLength) - 1;
+    ownGain = 0;
+    oppLoss = 0;
+    wins = false;
+    for (int d = 0; d < 4; ++d) {
+        int line = cl.line[d][cell];
+        int bit = cl.bit[d][cell];
+        std::uint64_t own = lines[player][line];
+        std::uint64_t opp = lines[player ^ 1][line];
+        // Окна, содержащие клетку: начала от bit - N + 1 до bit
+        int first = bit - winLength + 1;
+        std::uint64_t around = first >= 0 ? window << first : (std::uint64_t(1) << (bit + 1)) - 1;
+        for (std::uint64_t starts = validStarts[line] & around; starts; starts &= starts - 1) {
+            std::uint64_t mask = window << CountTrailingZeros(starts);
+            int mine = static_cast<int>(PopCount(own & mask));
+            int theirs = static_cast<int>(PopCount(opp & mask));
+            if (theirs == 0) {
+                if (mine + 1 == winLength) wins = true;
+                ownGain += weights[mine + 1] - weights[mine];
+            }
+            else if (mine == 0) {
+                oppLoss += weights[theirs];  // Это окно сопернику больше не собрать
+            }
+        }
+    }
+}
+
+int AiPosition::Gain(int cell, int player, bool& wins) const {
+    int ownGain, oppLoss;
+    Delta(cell, player, ownGain, oppLoss, wins);
+    return ownGain + oppLoss;
+}
+
+bool AiPosition::Place(int cell, int player) {
+    int ownGain, oppLoss;
+    bool wins;
+    Delta(cell, player, ownGain, oppLoss, wins);
+    score[player] += ownGain;
+    score[player ^ 1] -= oppLoss;
+
+    const CellLines& cl = Lines();
+    for (int d = 0; d < 4; ++d) lines[player][cl.line[d][cell]] |= std::uint64_t(1) << cl.bit[d][cell];
+    occupied[cell / AiBoardSize] |= std::uint32_t(1) << (cell % AiBoardSize);
+    hash ^= Zobrist().cells[player][cell];
+    ++marks;
+    history.push_back({ static_cast<std::uint16_t>(cell), static_cast<std::uint8_t>(player), ownGain, oppLoss });
+    return wins;
+}
+
+void AiPosition::Undo() {
+    UndoEntry last = history.back();
+    history.pop_back();
+    int cell = last.cell, player = last.player;
+    score[player] -= last.ownGain;
+    score[player ^ 1] += last.oppLoss;
+
+    const CellLines& cl = Lines();
+    for (int d = 0; d < 4; ++d) lines[player][cl.line[d][cell]] &= ~(std::uint64_t(1) << cl.bit[d][cell]);
+    occupied[cell / AiBoardSize] &= ~(std::uint32_t(1) << (cell % AiBoardSize));
+    hash ^= Zobrist().cells[player][cell];
+    --marks;
+}
+
+int AiPosition::Candidates(std::uint16_t* cells) const {
+    // Соседство строится на битах строк: метки растягиваются на две клетки вбок, строки — на две вверх и вниз
+    std::uint64_t spread[AiBoardSize];
+    for (int row = 0; row < AiBoardSize; ++row) {
+        std::uint64_t x = occupied[row];
+        spread[row] = x | (x << 1) | (x << 2) | (x >> 1) | (x >> 2);
+    }
+    int count = 0;
+    for (int row = 0; row < AiBoardSize; ++row) {
+        std::uint64_t near = 0;
+        for (int r = std::max(0, row - 2); r <= std::min(AiBoardSize - 1, row + 2); ++r) near |= spread[r];
+        near &= ~static_cast<std::uint64_t>(occupied[row]) & 0xFFFFFFFFull;
+        for (; near; near &= near - 1) cells[count++] = static_cast<std::uint16_t>(row * AiBoardSize + CountTrailingZeros(near));
+    }
+    return count;
+}
+
+// Оценки побед зависят от глубины узла, а в таблице хранятся относительно него самого
+static bool IsWinScore(int score) { return score > AiWinScore - 1000 || score < -AiWinScore + 1000; }
+static int ScoreToTable(int score, int ply) { return score > AiWinScore - 1000 ? score + ply : (score < -AiWinScore + 1000 ? score - ply : score); }
+static int ScoreFromTable(int score, int ply) { return score > AiWinScore - 1000 ? score - ply : (score < -AiWinScore + 1000 ? score + ply : score); }
+
+// Общее для потоков одного поиска
+struct SearchShared {
+    explicit SearchShared(TranspositionTable& table) : table(table) {}
+
+    TranspositionTable& table;
+    std::atomic<bool> stop{ false };
+    const std::atomic<bool>* cancel = nullptr;
+    std::chrono::steady_clock::time_point deadline;
+    bool timed = false;
+};
+
+// Поиск в одном потоке: своя копия позиции, общая таблица
+class SearchThread {
+public:
+    SearchThread(const AiPosition& position, SearchShared& shared) : position(position), shared(shared) {}
+
+    void Run(int player, int startDepth, int maxDepth);
+
+    std::uint64_t nodes = 0;
+    int completedDepth = 0;
+    int completedScore = 0;
+    int completedMove = -1;
+
+private:
+    int Negamax(int depth, int alpha, int beta, int ply, int player);
+    bool ShouldStop();
+
+    AiPosition position;
+    SearchShared& shared;
+    int rootMove = -1;
+};
+
+bool SearchThread::ShouldStop() {
+    if (shared.stop.load(std::memory_order_relaxed)) return true;
+    if (++nodes % TimeCheckNodes != 0) return false;
+    if (shared.cancel && shared.cancel->load(std::memory_order_relaxed)) {
+        shared.stop = true;
+        return true;
+    }
+    // Первая итерация доводится до конца в любом случае, чтобы был хотя бы какой-то ход
+    if (shared.timed && completedDepth > 0 && std::chrono::steady_clock::now() >= shared.deadline) {
+        shared.stop = true;
+        return true;
+    }
+    return false;
+}
+
+void SearchThread::Run(int player, int startDepth, int maxDepth) {
+    for (int depth = startDepth; depth <= maxDepth; ++depth) {
+        int score = Negamax(depth, -Infinity, Infinity, 0, player);
+        if (shared.stop.load(std::memory_order_relaxed)) break;  // Итерация прервана — не в счет
+        completedDepth = depth;
+        completedScore = score;
+        completedMove = rootMove;
+        if (IsWinScore(score)) break;  // Исход уже форсирован
+    }
+}
+
+int SearchThread::Negamax(int depth, int alpha, int beta, int ply, int player) {
+    if (ply > 0 && ShouldStop()) return 0;
+
+    std::uint64_t key = position.Hash() ^ (player ? Zobrist().side : 0);
+    TtEntry entry;
+    int ttMove = -1;
+    if (shared.table.Probe(key, entry)) {
+        ttMove = entry.move;
+        int score = ScoreFromTable(entry.score, ply);
+        if (ply > 0 && entry.depth >= depth) {
+            if (entry.bound == TtBound::Exact) return score;
+            if (entry.bound == TtBound::Lower) alpha = std::max(alpha, score);
+            if (entry.bound == TtBound::Upper) beta = std::min(beta, score);
+            if (alpha >= beta) return score;
+        }
+    }
+    if (depth == 0) return position.Evaluate(player);
+
+    std::uint16_t cells[AiCells];
+    int keys[AiCells];
+    int count = position.Candidates(cells);
+    if (count == 0) return position.Evaluate(player);
+
+    // Эвристика порядка: своя выгода плюс то, что ход отнимает у соперника (он бы туда и пошел)
+    int opponentWins = 0;
+    for (int i = 0; i < count; ++i) {
+        bool wins, blocks;
+        int attack = position.Gain(cells[i], player, wins);
+        if (wins) {
+            if (ply == 0) rootMove = cells[i];
+            return AiWinScore - ply - 1;  // Линия собирается сразу
+        }
+        int defence = position.Gain(cells[i], player ^ 1, blocks);
+        keys[i] = attack + defence + (cells[i] == ttMove ? Infinity : 0);
+        if (blocks) {
+            keys[i] += Infinity;
+            ++opponentWins;
+        }
+    }
+    // Если соперник собирает линию следующим ходом, закрывать его клетку нужно обязательно
+    int limit = opponentWins > 0 ? opponentWins : std::min(count, ply == 0 ? MaxRootMoves : MaxInnerMoves);
+    std::uint16_t order[AiCells];
+    for (int i = 0; i < count; ++i) order[i] = static_cast<std::uint16_t>(i);
+    std::partial_sort(order, order + limit, order + count, [&keys, &cells](std::uint16_t a, std::uint16_t b) {
+        return keys[a] != keys[b] ? keys[a] > keys[b] : cells[a] < cells[b];
+    });
+
+    int alphaStart = alpha;
+    int best = -Infinity;
+    int bestMove = -1;  // Первый же ход станет лучшим: его оценка больше -Infinity
+    for (int i = 0; i < limit; ++i) {
+        int cell = cells[order[i]];
+        position.Place(cell, player);
+        int score = -Negamax(depth - 1, -beta, -alpha, ply + 1, player ^ 1);
+        position.Undo();
+        if (shared.stop.load(std::memory_order_relaxed)) return 0;
+        if (score > best) {
+            best = score;
+            bestMove = cell;
+            if (ply == 0) rootMove = cell;
+        }
+        alpha = std::max(alpha, score);
+        if (alpha >= beta) break;
+    }
+
+    entry.score = ScoreToTable(best, ply);
+    entry.move = static_cast<std::uint16_t>(bestMove);
+    entry.depth = static_cast<std::int8_t>(std::min(depth, 127));
+    entry.bound = best <= alphaStart ? TtBound::Upper : (best >= beta ? TtBound::Lower : TtBound::Exact);
+    shared.table.Store(key, entry);
+    return best;
+}
+
+SearchResult SearchMove(const AiPosition& position, int player, const SearchLimits& limits,
+    TranspositionTable& table, ThreadPool* pool, const std::atomic<bool>* cancel) {
+    auto start = std::chrono::steady_clock::now();
+    SearchResult result;
+
+    std::uint16_t cells[AiCells];
+    if (position.Candidates(cells) == 0) {
+        // Меток рядом нет — ходим в центр окна
+        int center = (AiBoardSize / 2) * AiBoardSize + AiBoardSize / 2;
+        if (position.IsEmpty(center)) {
+            result.found = true;
+            result.col = position.ColOf(center);
+            result.row = position.RowOf(center);
+        }
+        return result;
+    }
+
+    SearchShared shared(table);
+    shared.cancel = cancel;
+    shared.timed = limits.timeMs > 0;
+    shared.deadline = start + std::chrono::milliseconds(limits.timeMs);
+    table.NewSearch();
+
+    int maxDepth = std::max(1, std::min(limits.maxDepth, 127));
+    unsigned threads = pool ? std::max(1u, std::min(limits.threads, pool->Concurrency())) : 1;
+    std::vector<SearchThread> searchers(threads, SearchThread(position, shared));
+    auto run = [&](std::size_t index) {
+        // Помощники начинают через одну глубину, чтобы не повторять главный поток шаг в шаг
+        searchers[index].Run(player, 1 + static_cast<int>(index & 1), maxDepth);
+        if (index == 0) shared.stop = true;  // Главный поток закончил — остальным пора
+    };
+    if (threads > 1) pool->ParallelFor(threads, run);
+    else run(0);
+
+    // Берется самая глубокая завершенная итерация, при равенстве — главного потока
+    const SearchThread* best = &searchers[0];
+    for (const SearchThread& searcher : searchers) {
+        if (searcher.completedDepth > best->completedDepth && searcher.completedMove >= 0) best = &searcher;
+        result.nodes += searcher.nodes;
+    }
+    if (best->completedMove >= 0) {
+        result.found = true;
+        result.col = position.ColOf(best->completedMove);
+        result.row = position.RowOf(best->completedMove);
+        result.score = best->completedScore;
+        result.depth = best->completedDepth;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
@@ -0,0 +1,100 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "Board.h"
+#include "GameRules.h"
+#include "TranspositionTable.h"
+
+class ThreadPool;
+
+const int AiBoardSize = 32;                   // Сторона окна поиска, клеток
+const int AiCells = AiBoardSize * AiBoardSize;
+const int AiLineCount = 6 * AiBoardSize - 2;  // Строки, столбцы и диагонали обоих направлений
+const int AiWinScore = 1000000;               // Оценка выигранной позиции (минус полуходы до победы)
+const int DefaultAiTimeMs = 1000;
+
+// Ограничения поиска одного хода
+struct SearchLimits {
+    int timeMs = DefaultAiTimeMs;  // 0 — без ограничения по времени, решает maxDepth
+    int maxDepth = 32;             // Предельная глубина итеративного углубления, полуходов
+    unsigned threads = 1;          // Потоков поиска (не больше, чем в пуле)
+};
+
+// Выбранный ход и статистика поиска
+struct SearchResult {
+    bool found = false;
+    int col = 0;    // Клетка поля
+    int row = 0;
+    int score = 0;  // С точки зрения ходящего
+    int depth = 0;  // Последняя полностью просчитанная глубина
+    std::uint64_t nodes = 0;
+    double seconds = 0;
+
+    double NodesPerSecond() const { return seconds > 0 ? nodes / seconds : 0; }
+};
+
+// Позиция для поиска: окно AiBoardSize x AiBoardSize вокруг места игры. Как в GameRules,
+// каждая строка, столбец и диагональ окна — слово на игрока, поэтому ход стоит четыре OR,
+// а его ценность считается по окнам из N клеток через PopCount. Оценка ведется
+// инкрементально: у каждого игрока сумма весов окон, где есть только его метки
+// (чем меньше не хватает до линии, тем больше вес). Хэш Зобриста обновляется тем же ходом
+class AiPosition {
+public:
+    AiPosition(int originCol, int originRow, int winLength);
+    // Окно с центром в (centerCol, centerRow) и метками поля, попавшими в него
+    static AiPosition Around(const Board& board, int centerCol, int centerRow, int winLength);
+
+    // Ставит метку игрока (0 — круги, 1 — кресты) в пустую клетку окна. Возвращает true, если собрана линия
+    bool Place(int cell, int player);
+    // Отменяет последний Place
+    void Undo();
+
+    bool IsEmpty(int cell) const { return !((occupied[cell / AiBoardSize] >> (cell % AiBoardSize)) & 1); }
+    int Marks() const { return marks; }
+    int WinLength() const { return winLength; }
+    std::uint64_t Hash() const { return hash; }
+
+    // Оценка позиции с точки зрения игрока
+    int Evaluate(int player) const { return score[player] - score[player ^ 1]; }
+    // Насколько ход игрока в клетку улучшит его оценку (свои окна растут, окна соперника гибнут).
+    // wins — ход собирает линию
+    int Gain(int cell, int player, bool& wins) const;
+    // Пустые клетки не дальше двух от какой-либо метки. Возвращает их число
+    int Candidates(std::uint16_t* cells) const;
+
+    // Клетка окна по координатам поля или -1, если клетка вне окна
+    int CellOf(int col, int row) const;
+    int ColOf(int cell) const { return originCol + cell % AiBoardSize; }
+    int RowOf(int cell) const { return originRow + cell / AiBoardSize; }
+
+private:
+    struct UndoEntry {
+        std::uint16_t cell;
+        std::uint8_t player;
+        std::int32_t ownGain;   // На сколько выросла оценка игрока
+        std::int32_t oppLoss;   // На сколько упала оценка соперника
+    };
+
+    void Delta(int cell, int player, int& ownGain, int& oppLoss, bool& wins) const;
+
+    int originCol;
+    int originRow;
+    int winLength;
+    int weights[MaxWinLength + 1];          // Вес окна по числу меток в нем
+    std::uint64_t lines[2][AiLineCount] = {};
+    std::uint64_t validStarts[AiLineCount];  // Начала окон, целиком лежащих на линии
+    std::uint32_t occupied[AiBoardSize] = {};  // Занятые клетки по строкам
+    int score[2] = {};
+    int marks = 0;
+    std::uint64_t hash = 0;
+    std::vector<UndoEntry> history;
+};
+
+// Ищет ход игрока альфа-бета поиском с итеративным углублением. С пулом поиск идет в нескольких
+// потоках сразу (Lazy SMP): каждый ведет свое углубление по общей таблице транспозиций, и оценки,
+// найденные одним, отсекают ветви остальным. С одним потоком и timeMs = 0 результат детерминирован.
+// cancel — внешний запрос прервать поиск (может быть nullptr)
+SearchResult SearchMove(const AiPosition& position, int player, const SearchLimits& limits,
+    TranspositionTable& table, ThreadPool* pool = nullptr, const std::atomic<bool>* cancel = nullptr);
@@ -0,0 +1,16 @@
+﻿#pragma once
+#include <string>
+
+// Запись "временный файл + переименование": файл на диске всегда либо старый, либо новый целиком,
+// даже если программа упала посреди записи
+
+// Имя временного файла, в который пишется новая версия path
+inline std::string TempPathFor(const std::string& path) {
+    return path + ".tmp";
+}
+
+// Сбрасывает содержимое файла на диск (FlushFileBuffers / fsync)
+bool SyncFile(const std::string& path);
+
+// Атомарно заменяет path файлом temp (MoveFileEx / rename). При ошибке temp удаляется
+bool AtomicReplace(const std::string& temp, const std::string& path);
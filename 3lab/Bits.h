@@ -0,0 +1,60 @@
+﻿#pragma once
+#include <cstdint>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+// Операции над 64-битными словами. Поиск крайнего бита идет через BSF/BSR или встроенные
+// функции GCC, если они есть, иначе — через переносимые замены (результат одинаковый)
+
+// Число единичных битов (SWAR)
+inline std::uint32_t PopCount(std::uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<std::uint32_t>((x * 0x0101010101010101ULL) >> 56);
+}
+
+// Число нулей в младших разрядах (64 для нуля). Младший единичный бит умножается на последовательность де Брёйна
+inline int CountTrailingZeros(std::uint64_t x) {
+    if (x == 0) return 64;
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return static_cast<int>(index);
+#else
+    static const int table[64] = {
+        0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,
+        62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,
+        63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+        46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6,
+    };
+    return table[((x & (0 - x)) * 0x03F79D71B4CB0A89ULL) >> 58];
+#endif
+}
+
+// Число нулей в старших разрядах (64 для нуля): размазываем старший бит вниз и считаем единицы
+inline int CountLeadingZeros(std::uint64_t x) {
+    if (x == 0) return 64;
+#if defined(__GNUC__)
+    return __builtin_clzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return 63 - static_cast<int>(index);
+#else
+    x |= x >> 1;
+    x |= x >> 2;
+    x |= x >> 4;
+    x |= x >> 8;
+    x |= x >> 16;
+    x |= x >> 32;
+    return 64 - static_cast<int>(PopCount(x));
+#endif
+}
+
+// Длина непрерывной серии единиц в младших / старших разрядах
+inline int CountTrailingOnes(std::uint64_t x) { return CountTrailingZeros(~x); }
+inline int CountLeadingOnes(std::uint64_t x) { return CountLeadingZeros(~x); }
@@ -0,0 +1,126 @@
+﻿#include "Board.h"
+#include <algorithm>
+#include "Bits.h"
+
+// Слово участка, в котором лежит клетка, и сдвиг ее пары битов
+static int WordIndex(int col, int row) {
+    return (row & (Board::ChunkSize - 1)) * BoardChunk::RowWords + (col & (Board::ChunkSize - 1)) / Board::CellsPerWord;
+}
+
+static int BitShift(int col) {
+    return (col & (Board::CellsPerWord - 1)) * 2;  // & дает верный остаток и для отрицательных координат
+}
+
+bool Board::Place(int col, int row, Mark mark) {
+    if (mark == Mark::Empty) return false;
+
+    BoardChunk& chunk = chunks[ChunkKey(ChunkOf(col), ChunkOf(row))];  // Участок создается при первой метке
+    std::uint64_t& word = chunk.words[WordIndex(col, row)];
+    int shift = BitShift(col);
+    if ((word >> shift) & 3) return false;  // Клетка уже занята
+
+    word |= static_cast<std::uint64_t>(mark) << shift;
+    if (mark == Mark::Circle) {
+        ++chunk.circles;
+        ++circleCount;
+    } else {
+        ++chunk.crosses;
+        ++crossCount;
+    }
+    return true;
+}
+
+Mark Board::Get(int col, int row) const {
+    const BoardChunk* chunk = FindChunk(ChunkOf(col), ChunkOf(row));
+    if (!chunk) return Mark::Empty;
+    return static_cast<Mark>((chunk->words[WordIndex(col, row)] >> BitShift(col)) & 3);
+}
+
+bool Board::Clear(int col, int row) {
+    auto it = chunks.find(ChunkKey(ChunkOf(col), ChunkOf(row)));
+    if (it == chunks.end()) return false;
+
+    BoardChunk& chunk = it->second;
+    std::uint64_t& word = chunk.words[WordIndex(col, row)];
+    int shift = BitShift(col);
+    Mark old = static_cast<Mark>((word >> shift) & 3);
+    if (old == Mark::Empty) return false;
+
+    word &= ~(std::uint64_t(3) << shift);
+    if (old == Mark::Circle) {
+        --chunk.circles;
+        --circleCount;
+    } else {
+        --chunk.crosses;
+        --crossCount;
+    }
+    if (chunk.Marks() == 0) chunks.erase(it);  // Пустой участок память не держит
+    return true;
+}
+
+void Board::ClearAll() {
+    chunks.clear();
+    circleCount = 0;
+    crossCount = 0;
+}
+
+std::size_t Board::Count(Mark mark) const {
+    switch (mark) {
+    case Mark::Circle: return circleCount;
+    case Mark::Cross: return crossCount;
+    default: return 0;
+    }
+}
+
+void Board::AssignChunk(int chunkCol, int chunkRow, const std::uint64_t* words) {
+    std::uint32_t circles = 0, crosses = 0;
+    for (int i = 0; i < BoardChunk::Words; ++i) {
+        circles += PopCount(words[i] & 0x5555555555555555ULL);  // Mark::Circle — младший бит пары
+        crosses += PopCount(words[i] & 0xAAAAAAAAAAAAAAAAULL);  // Mark::Cross — старший бит пары
+    }
+
+    std::uint64_t key = ChunkKey(chunkCol, chunkRow);
+    auto it = chunks.find(key);
+    if (it != chunks.end()) {
+        circleCount -= it->second.circles;
+        crossCount -= it->second.crosses;
+        if (circles + crosses == 0) chunks.erase(it);
+    }
+    if (circles + crosses == 0) return;
+
+    BoardChunk& chunk = chunks[key];
+    std::copy_n(words, BoardChunk::Words, chunk.words);
+    chunk.circles = circles;
+    chunk.crosses = crosses;
+    circleCount += circles;
+    crossCount += crosses;
+}
+
+std::uint64_t Board::Word(int wordCol, int row) const {
+    int col = wordCol * CellsPerWord;
+    const BoardChunk* chunk = FindChunk(ChunkOf(col), ChunkOf(row));
+    return chunk ? chunk->words[WordIndex(col, row)] : 0;
+}
+
+void Board::AssignWord(int wordCol, int row, std::uint64_t word) {
+    int col = wordCol * CellsPerWord;
+    std::uint64_t key = ChunkKey(ChunkOf(col), ChunkOf(row));
+    auto it = chunks.find(key);
+    if (it == chunks.end()) {
+        if (word == 0) return;
+        it = chunks.emplace(key, BoardChunk()).first;
+    }
+
+    BoardChunk& chunk = it->second;
+    std::uint64_t& old = chunk.words[WordIndex(col, row)];
+    std::uint32_t oldCircles = PopCount(old & 0x5555555555555555ULL);
+    std::uint32_t oldCrosses = PopCount(old & 0xAAAAAAAAAAAAAAAAULL);
+    std::uint32_t circles = PopCount(word & 0x5555555555555555ULL);
+    std::uint32_t crosses = PopCount(word & 0xAAAAAAAAAAAAAAAAULL);
+    old = word;
+    chunk.circles = chunk.circles - oldCircles + circles;
+    chunk.crosses = chunk.crosses - oldCrosses + crosses;
+    circleCount = circleCount - oldCircles + circles;
+    crossCount = crossCount - oldCrosses + crosses;
+    if (chunk.Marks() == 0) chunks.erase(it);
+}
@@ -0,0 +1,156 @@
+﻿#pragma once
+#include <cstdint> // для фиксированных целых типов
+#include <cstddef>
+#include <unordered_map>  // для хранения участков поля
+
+// Содержимое клетки поля (2 бита на клетку)
+enum class Mark : std::uint8_t {
+    Empty = 0,   // Пустая клетка
+    Circle = 1,  // Круг
+    Cross = 2,   // Крест
+};
+
+// Участок поля ChunkSize x ChunkSize клеток, упакованных по 2 бита (строка — ChunkRowWords слов)
+struct BoardChunk {
+    static constexpr int Size = 64;                    // Клеток по стороне
+    static constexpr int CellsPerWord = 32;            // 64 бита / 2 бита на клетку
+    static constexpr int RowWords = Size / CellsPerWord;
+    static constexpr int Words = Size * RowWords;
+
+    std::uint64_t words[Words] = {};
+    std::uint32_t circles = 0;  // Число кругов на участке
+    std::uint32_t crosses = 0;  // Число крестов на участке
+
+    std::uint32_t Marks() const { return circles + crosses; }
+};
+
+// Бесконечное поле кругов и крестов. Клетки адресуются знаковыми координатами и хранятся
+// участками 64x64, которые выделяются при первой метке и освобождаются, когда опустеют,
+// поэтому память растет только с занятой областью. Постановка, проверка и очистка клетки — O(1)
+class Board {
+public:
+    static constexpr int ChunkSize = BoardChunk::Size;
+    static constexpr int ChunkShift = 6;  // log2(ChunkSize)
+    static constexpr int CellsPerWord = BoardChunk::CellsPerWord;
+
+    // Ставит метку в пустую клетку. Возвращает false, если клетка занята
+    bool Place(int col, int row, Mark mark);
+    // Возвращает содержимое клетки
+    Mark Get(int col, int row) const;
+    // Очищает клетку. Возвращает false, если она уже была пустой
+    bool Clear(int col, int row);
+    // Очищает всё поле
+    void ClearAll();
+
+    // Число кругов или крестов на поле (пустых клеток у бесконечного поля не счесть, для Empty — 0)
+    std::size_t Count(Mark mark) const;
+    // Число выделенных участков
+    std::size_t ChunkCount() const { return chunks.size(); }
+
+    // Координата участка, в который попадает клетка (деление с округлением вниз)
+    static int ChunkOf(int cell) { return cell >> ChunkShift; }
+
+    // Участок по его координатам или nullptr, если на нем нет меток
+    const BoardChunk* FindChunk(int chunkCol, int chunkRow) const {
+        auto it = chunks.find(ChunkKey(chunkCol, chunkRow));
+        return it != chunks.end() ? &it->second : nullptr;
+    }
+
+    // Обходит все непустые участки: f(chunkCol, chunkRow, chunk). Порядок не определен
+    template <typename F>
+    void ForEachChunk(F&& f) const {
+        for (const auto& entry : chunks) {
+            f(KeyCol(entry.first), KeyRow(entry.first), entry.second);
+        }
+    }
+
+    // Обходит участки, пересекающие [chunkCol0, chunkCol1) x [chunkRow0, chunkRow1): f(chunkCol, chunkRow, chunk).
+    // Стоимость — меньшее из площади запроса в участках и числа занятых участков
+    template <typename F>
+    void ForEachChunkIn(int chunkCol0, int chunkRow0, int chunkCol1, int chunkRow1, F&& f) const {
+        if (chunkCol0 >= chunkCol1 || chunkRow0 >= chunkRow1) return;
+        std::uint64_t area = static_cast<std::uint64_t>(chunkCol1 - chunkCol0) * static_cast<std::uint64_t>(chunkRow1 - chunkRow0);
+        if (area > chunks.size()) {
+            ForEachChunk([&](int chunkCol, int chunkRow, const BoardChunk& chunk) {
+                if (chunkCol >= chunkCol0 && chunkCol < chunkCol1 && chunkRow >= chunkRow0 && chunkRow < chunkRow1) {
+                    f(chunkCol, chunkRow, chunk);
+                }
+            });
+            return;
+        }
+        for (int chunkRow = chunkRow0; chunkRow < chunkRow1; ++chunkRow) {
+            for (int chunkCol = chunkCol0; chunkCol < chunkCol1; ++chunkCol) {
+                if (const BoardChunk* chunk = FindChunk(chunkCol, chunkRow)) f(chunkCol, chunkRow, *chunk);
+            }
+        }
+    }
+
+    // Обходит все занятые клетки: f(col, row, mark). Пустые слова пропускаются целиком
+    template <typename F>
+    void ForEach(F&& f) const {
+        ForEachChunk([&](int chunkCol, int chunkRow, const BoardChunk& chunk) {
+            ForEachInChunk(chunkCol, chunkRow, chunk, 0, 0, ChunkSize, ChunkSize, f);
+        });
+    }
+
+    // Обходит занятые клетки в прямоугольнике [col0, col1) x [row0, row1): f(col, row, mark).
+    // Просматриваются только участки, пересекающие прямоугольник
+    template <typename F>
+    void ForEachIn(int col0, int row0, int col1, int row1, F&& f) const {
+        if (col0 >= col1 || row0 >= row1) return;
+        ForEachChunkIn(ChunkOf(col0), ChunkOf(row0), ChunkOf(col1 - 1) + 1, ChunkOf(row1 - 1) + 1,
+            [&](int chunkCol, int chunkRow, const BoardChunk& chunk) {
+                int baseCol = chunkCol * ChunkSize;
+                int baseRow = chunkRow * ChunkSize;
+                int localCol0 = col0 > baseCol ? col0 - baseCol : 0;
+                int localRow0 = row0 > baseRow ? row0 - baseRow : 0;
+                int localCol1 = col1 - baseCol < ChunkSize ? col1 - baseCol : ChunkSize;
+                int localRow1 = row1 - baseRow < ChunkSize ? row1 - baseRow : ChunkSize;
+                ForEachInChunk(chunkCol, chunkRow, chunk, localCol0, localRow0, localCol1, localRow1, f);
+            });
+    }
+
+    // Заменяет участок готовыми упакованными словами (BoardChunk::Words штук, одно копирование без разбора).
+    // Используется для двоичных снимков поля
+    void AssignChunk(int chunkCol, int chunkRow, const std::uint64_t* words);
+
+    // Упакованное слово строки row с клетками [wordCol * CellsPerWord, (wordCol + 1) * CellsPerWord)
+    std::uint64_t Word(int wordCol, int row) const;
+    // Заменяет такое слово целиком (используется историей ходов для перехода между версиями)
+    void AssignWord(int wordCol, int row, std::uint64_t word);
+
+private:
+    // Ключ участка: строка в старших 32 битах, столбец в младших
+    static std::uint64_t ChunkKey(int chunkCol, int chunkRow) {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(chunkRow)) << 32) | static_cast<std::uint32_t>(chunkCol);
+    }
+    static int KeyCol(std::uint64_t key) { return static_cast<std::int32_t>(static_cast<std::uint32_t>(key)); }
+    static int KeyRow(std::uint64_t key) { return static_cast<std::int32_t>(static_cast<std::uint32_t>(key >> 32)); }
+
+    // Обходит занятые клетки участка в локальном прямоугольнике [localCol0, localCol1) x [localRow0, localRow1)
+    template <typename F>
+    static void ForEachInChunk(int chunkCol, int chunkRow, const BoardChunk& chunk,
+        int localCol0, int localRow0, int localCol1, int localRow1, F& f) {
+        int baseCol = chunkCol * ChunkSize;
+        int baseRow = chunkRow * ChunkSize;
+        int w0 = localCol0 / CellsPerWord;
+        int w1 = (localCol1 - 1) / CellsPerWord;
+        for (int row = localRow0; row < localRow1; ++row) {
+            const std::uint64_t* line = &chunk.words[row * BoardChunk::RowWords];
+            for (int w = w0; w <= w1; ++w) {
+                std::uint64_t word = line[w];
+                int first = w * CellsPerWord;
+                for (int i = 0; word != 0; ++i, word >>= 2) {
+                    int col = first + i;
+                    if ((word & 3) && col >= localCol0 && col < localCol1) {
+                        f(baseCol + col, baseRow + row, static_cast<Mark>(word & 3));
+                    }
+                }
+            }
+        }
+    }
+
+    std::unordered_map<std::uint64_t, BoardChunk> chunks;  // Непустые участки по ключу ChunkKey
+    std::size_t circleCount = 0;  // Число кругов на поле
+    std::size_t crossCount = 0;   // Число крестов на поле
+};
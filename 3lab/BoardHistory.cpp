@@ -0,0 +1,354 @@
+﻿#include "BoardHistory.h"
+#include <algorithm>
+#include <new>
+#include "Bits.h"
+
+static const int WordShift = 5;        // log2(Board::CellsPerWord)
+static const int IndexBits = 7;        // Номер слова в участке: BoardChunk::Words = 128
+static const int ChunkBits = 26;       // Координата участка: 32 - Board::ChunkShift
+static const std::uint64_t ChunkMask = (std::uint64_t(1) << ChunkBits) - 1;
+
+// Узел дерева. За заголовком лежат count ячеек: у листа (shift == 0) — слова поля,
+// у внутреннего узла — потомки. Узел неизменяем, пока на него больше одной ссылки
+struct BoardHistory::Node {
+    std::uint64_t prefix;   // key >> (shift + 4) у всех ключей поддерева
+    std::uint32_t refs;     // Корни и родители, которые на него ссылаются
+    std::uint16_t bitmap;   // Какие из 16 значений четверки бит заняты
+    std::uint8_t shift;     // Разряд четверки бит, по которой ветвится узел
+    std::uint8_t count;     // PopCount(bitmap)
+
+    union Slot {
+        Node* child;
+        std::uint64_t word;
+    };
+    Slot* Slots() { return reinterpret_cast<Slot*>(this + 1); }
+    const Slot* Slots() const { return reinterpret_cast<const Slot*>(this + 1); }
+};
+
+// Ключ без разрядов ниже shift + 4 (для shift 60 — всегда 0)
+static std::uint64_t High(std::uint64_t key, int shift) {
+    return shift + 4 >= 64 ? 0 : key >> (shift + 4);
+}
+
+static int Nibble(std::uint64_t key, int shift) {
+    return static_cast<int>((key >> shift) & 15);
+}
+
+// Номер ячейки для значения nibble среди занятых
+static int SlotIndex(std::uint16_t bitmap, int nibble) {
+    return static_cast<int>(PopCount(bitmap & ((1u << nibble) - 1)));
+}
+
+BoardHistory::BoardHistory(int checkpointMoves) : checkpointMoves(checkpointMoves > 0 ? checkpointMoves : 1) {
+    roots.push_back(nullptr);
+}
+
+BoardHistory::~BoardHistory() {
+    for (Node* root : roots) Release(root);
+}
+
+// Ключ слова: строка участка, столбец участка, номер слова в участке. Слова одного участка
+// идут в дереве подряд, поэтому переход между версиями меняет поле целыми участками
+static std::uint64_t ChunkWordKey(int chunkCol, int chunkRow, int index) {
+    return ((static_cast<std::uint64_t>(static_cast<std::uint32_t>(chunkRow)) & ChunkMask) << (ChunkBits + IndexBits))
+        | ((static_cast<std::uint64_t>(static_cast<std::uint32_t>(chunkCol)) & ChunkMask) << IndexBits)
+        | static_cast<std::uint64_t>(index);
+}
+
+// Координата участка из ChunkBits разрядов ключа (со знаком)
+static int KeyChunk(std::uint64_t bits) {
+    return static_cast<int>(static_cast<std::int64_t>(bits << (64 - ChunkBits)) >> (64 - ChunkBits));
+}
+
+std::uint64_t BoardHistory::WordKey(int col, int row) {
+    int index = (row & (Board::ChunkSize - 1)) * BoardChunk::RowWords + (col & (Board::ChunkSize - 1)) / Board::CellsPerWord;
+    return ChunkWordKey(Board::ChunkOf(col), Board::ChunkOf(row), index);
+}
+
+BoardHistory::Node* BoardHistory::NewNode(std::uint64_t prefix, int shift, std::uint16_t bitmap, int count) {
+    std::size_t bytes = sizeof(Node) + count * sizeof(Node::Slot);
+    Node* node = static_cast<Node*>(::operator new(bytes));
+    node->prefix = prefix;
+    node->refs = 1;
+    node->bitmap = bitmap;
+    node->shift = static_cast<std::uint8_t>(shift);
+    node->count = static_cast<std::uint8_t>(count);
+    ++nodeCount;
+    nodeBytes += bytes;
+    return node;
+}
+
+BoardHistory::Node* BoardHistory::NewLeaf(std::uint64_t key, std::uint64_t word) {
+    Node* leaf = NewNode(High(key, 0), 0, static_cast<std::uint16_t>(1u << Nibble(key, 0)), 1);
+    leaf->Slots()[0].word = word;
+    return leaf;
+}
+
+// Копия узла (с пустой ячейкой под insertNibble, если он не -1). Потомки делятся с оригиналом
+BoardHistory::Node* BoardHistory::Clone(const Node* node, int insertNibble) {
+    std::uint16_t bitmap = node->bitmap;
+    int gap = -1;
+    if (insertNibble >= 0) {
+        gap = SlotIndex(bitmap, insertNibble);
+        bitmap = static_cast<std::uint16_t>(bitmap | (1u << insertNibble));
+    }
+    Node* copy = NewNode(node->prefix, node->shift, bitmap, node->count + (gap >= 0));
+    for (int i = 0, j = 0; i < node->count; ++i, ++j) {
+        if (j == gap) ++j;
+        copy->Slots()[j] = node->Slots()[i];
+        if (node->shift != 0) ++copy->Slots()[j].child->refs;
+    }
+    return copy;
+}
+
+void BoardHistory::Release(Node* node) {
+    if (!node || --node->refs != 0) return;
+    if (node->shift != 0) {
+        for (int i = 0; i < node->count; ++i) Release(node->Slots()[i].child);
+    }
+    --nodeCount;
+    nodeBytes -= sizeof(Node) + node->count * sizeof(Node::Slot);
+    ::operator delete(node);
+}
+
+// Записывает слово в дерево. Забирает ссылку на node и возвращает ссылку на новый корень поддерева.
+// Узлы, на которые ссылается только этот путь, меняются на месте, общие с другими версиями — копируются
+BoardHistory::Node* BoardHistory::Set(Node* node, std::uint64_t key, std::uint64_t word) {
+    if (!node) return NewLeaf(key, word);
+
+    if (High(key, node->shift) != node->prefix) {
+        // Ключ вне поддерева: новый узел ветвится по старшей четверке, в которой они расходятся
+        std::uint64_t first = node->prefix << (node->shift + 4);
+        int shift = (63 - CountLeadingZeros(key ^ first)) & ~3;
+        int a = Nibble(key, shift);
+        int b = Nibble(first, shift);
+        Node* branch = NewNode(High(key, shift), shift, static_cast<std::uint16_t>((1u << a) | (1u << b)), 2);
+        branch->Slots()[a < b ? 0 : 1].child = NewLeaf(key, word);
+        branch->Slots()[a < b ? 1 : 0].child = node;
+        return branch;
+    }
+
+    int nibble = Nibble(key, node->shift);
+    if (!(node->bitmap & (1u << nibble))) {
+        Node* copy = Clone(node, nibble);
+        Release(node);
+        Node::Slot& slot = copy->Slots()[SlotIndex(copy->bitmap, nibble)];
+        if (copy->shift == 0) slot.word = word;
+        else slot.child = NewLeaf(key, word);
+        return copy;
+    }
+
+    if (node->refs > 1) {
+        Node* copy = Clone(node, -1);
+        Release(node);
+        node = copy;
+    }
+    Node::Slot& slot = node->Slots()[SlotIndex(node->bitmap, nibble)];
+    if (node->shift == 0) slot.word = word;
+    else slot.child = Set(slot.child, key, word);
+    return node;
+}
+
+std::uint64_t BoardHistory::Find(const Node* node, std::uint64_t key) {
+    while (node && High(key, node->shift) == node->prefix) {
+        int nibble = Nibble(key, node->shift);
+        if (!(node->bitmap & (1u << nibble))) return 0;
+        const Node::Slot& slot = node->Slots()[SlotIndex(node->bitmap, nibble)];
+        if (node->shift == 0) return slot.word;
+        node = slot.child;
+    }
+    return 0;
+}
+
+// Обходит все слова поддерева: f(key, word)
+template <typename F>
+void BoardHistory::ForEachWord(const Node* node, F& f) {
+    if (!node) return;
+    for (std::uint32_t bits = node->bitmap, i = 0; bits != 0; bits &= bits - 1, ++i) {
+        int nibble = CountTrailingZeros(bits);
+        if (node->shift == 0) f((node->prefix << 4) | static_cast<std::uint64_t>(nibble), node->Slots()[i].word);
+        else ForEachWord(node->Slots()[i].child, f);
+    }
+}
+
+// Обходит слова, которые различаются в двух деревьях: f(key, before, after).
+// Общие поддеревья (один и тот же узел) пропускаются целиком
+template <typename F>
+void BoardHistory::Diff(const Node* from, const Node* to, F& f) {
+    if (from == to) return;
+    if (!from || !to) {
+        auto emit = [&](std::uint64_t key, std::uint64_t word) { from ? f(key, word, 0) : f(key, 0, word); };
+        ForEachWord(from ? from : to, emit);
+        return;
+    }
+
+    if (from->shift == to->shift && from->prefix == to->prefix) {
+        for (std::uint32_t bits = from->bitmap | to->bitmap; bits != 0; bits &= bits - 1) {
+            int nibble = CountTrailingZeros(bits);
+            const Node::Slot* a = from->bitmap & (1u << nibble) ? &from->Slots()[SlotIndex(from->bitmap, nibble)] : nullptr;
+            const Node::Slot* b = to->bitmap & (1u << nibble) ? &to->Slots()[SlotIndex(to->bitmap, nibble)] : nullptr;
+            if (from->shift == 0) {
+                std::uint64_t before = a ? a->word : 0;
+                std::uint64_t after = b ? b->word : 0;
+                if (before != after) f((from->prefix << 4) | static_cast<std::uint64_t>(nibble), before, after);
+            }
+            else {
+                Diff(a ? a->child : nullptr, b ? b->child : nullptr, f);
+            }
+        }
+        return;
+    }
+
+    // Меньшее поддерево может целиком лежать в одной ячейке большего
+    const Node* outer = from->shift > to->shift ? from : to;
+    const Node* inner = outer == from ? to : from;
+    std::uint64_t first = inner->prefix << (inner->shift + 4);
+    if (High(first, outer->shift) != outer->prefix) {
+        Diff(from, nullptr, f);
+        Diff(nullptr, to, f);
+        return;
+    }
+    int innerNibble = Nibble(first, outer->shift);
+    bool matched = false;
+    for (std::uint32_t bits = outer->bitmap, i = 0; bits != 0; bits &= bits - 1, ++i) {
+        const Node* child = outer->Slots()[i].child;
+        const Node* other = CountTrailingZeros(bits) == innerNibble ? inner : nullptr;
+        matched |= other != nullptr;
+        if (outer == from) Diff(child, other, f);
+        else Diff(other, child, f);
+    }
+    if (!matched) {
+        if (outer == from) Diff(nullptr, inner, f);
+        else Diff(inner, nullptr, f);
+    }
+}
+
+void BoardHistory::Reset(const Board& board) {
+    for (Node* root : roots) Release(root);
+    roots.clear();
+    moves.clear();
+    position = 0;
+
+    Node* root = nullptr;
+    board.ForEachChunk([&](int chunkCol, int chunkRow, const BoardChunk& chunk) {
+        for (int i = 0; i < BoardChunk::Words; ++i) {
+            if (chunk.words[i] != 0) root = Set(root, ChunkWordKey(chunkCol, chunkRow, i), chunk.words[i]);
+        }
+    });
+    roots.push_back(root);
+}
+
+void BoardHistory::Record(int col, int row, Mark mark) {
+    if (position < moves.size()) {
+        // Новый ход после отмены: отмененная ветка больше недостижима
+        moves.resize(position);
+        while (roots.size() > position / checkpointMoves + 1) {
+            Release(roots.back());
+            roots.pop_back();
+        }
+    }
+    moves.push_back({ col, row, mark });
+    ++position;
+    if (moves.size() % checkpointMoves == 0) Checkpoint();
+}
+
+void BoardHistory::Checkpoint() {
+    Node* root = roots.back();
+    if (root) ++root->refs;  // Прошлая версия остается: ее узлы на пути скопируются
+    for (std::size_t i = moves.size() - checkpointMoves; i < moves.size(); ++i) {
+        const HistoryMove& move = moves[i];
+        std::uint64_t key = WordKey(move.col, move.row);
+        std::uint64_t bit = static_cast<std::uint64_t>(move.mark) << ((move.col & (Board::CellsPerWord - 1)) * 2);
+        root = Set(root, key, Find(root, key) | bit);
+    }
+    roots.push_back(root);
+}
+
+void BoardHistory::ApplyMove(const HistoryMove& move, bool place, Board& board, std::vector<HistoryChange>* changes) {
+    int wordCol = move.col >> WordShift;
+    int shift = (move.col & (Board::CellsPerWord - 1)) * 2;
+    std::uint64_t before = board.Word(wordCol, move.row);
+    std::uint64_t after = before & ~(std::uint64_t(3) << shift);
+    if (place) after |= static_cast<std::uint64_t>(move.mark) << shift;
+    board.AssignWord(wordCol, move.row, after);
+    if (changes) changes->push_back({ wordCol, move.row, before, after });
+}
+
+void BoardHistory::Jump(std::size_t version, Board& board, std::vector<HistoryChange>* changes) {
+    if (version > moves.size()) version = moves.size();
+    std::size_t from = position / checkpointMoves;
+    std::size_t to = version / checkpointMoves;
+    // Ход из списка дешевле пути по дереву, зато дерево меняет каждое слово поля не больше
+    // одного раза: пока ходов меньше, чем слов в участках поля, их быстрее снять или поставить по одному
+    std::size_t distance = version > position ? version - position : position - version;
+    if (from != to && distance > board.ChunkCount() * BoardChunk::Words) {
+        // Снимаем ходы после своей версии дерева, переходим к версии цели, затем ставим ходы до цели
+        while (position > from * checkpointMoves) ApplyMove(moves[--position], false, board, changes);
+
+        // Слова участка приходят подряд. Немного слов пишем в поле по одному, а если участок
+        // меняется сильнее — собираем его целиком и отдаем полю одним AssignChunk
+        const int SparseWords = 8;
+        std::uint64_t words[BoardChunk::Words];
+        int sparseIndex[SparseWords];
+        int sparseCount = 0;
+        bool whole = false;
+        int chunkCol = 0, chunkRow = 0;
+        std::uint64_t pendingChunk = ~std::uint64_t(0);
+        auto flush = [&]() {
+            if (whole) board.AssignChunk(chunkCol, chunkRow, words);
+            for (int i = 0; !whole && i < sparseCount; ++i) {
+                int index = sparseIndex[i];
+                board.AssignWord(chunkCol * BoardChunk::RowWords + index % BoardChunk::RowWords,
+                    chunkRow * Board::ChunkSize + index / BoardChunk::RowWords, words[index]);
+            }
+            sparseCount = 0;
+            whole = false;
+        };
+        auto assign = [&](std::uint64_t key, std::uint64_t before, std::uint64_t after) {
+            std::uint64_t chunkKey = key >> IndexBits;
+            if (chunkKey != pendingChunk) {
+                flush();
+                pendingChunk = chunkKey;
+                chunkCol = KeyChunk(chunkKey);
+                chunkRow = KeyChunk(chunkKey >> ChunkBits);
+            }
+            int index = static_cast<int>(key & ((1u << IndexBits) - 1));
+            if (!whole && sparseCount == SparseWords) {
+                std::uint64_t sparse[SparseWords];
+                for (int i = 0; i < SparseWords; ++i) sparse[i] = words[sparseIndex[i]];
+                const BoardChunk* chunk = board.FindChunk(chunkCol, chunkRow);
+                if (chunk) std::copy_n(chunk->words, BoardChunk::Words, words);
+                else std::fill_n(words, BoardChunk::Words, std::uint64_t(0));
+                for (int i = 0; i < SparseWords; ++i) words[sparseIndex[i]] = sparse[i];
+                whole = true;
+            }
+            if (!whole) sparseIndex[sparseCount++] = index;
+            words[index] = after;
+            if (changes) {
+                int row = chunkRow * Board::ChunkSize + index / BoardChunk::RowWords;
+                int wordCol = chunkCol * BoardChunk::RowWords + index % BoardChunk::RowWords;
+                changes->push_back({ wordCol, row, before, after });
+            }
+        };
+        Diff(roots[from], roots[to], assign);
+        flush();
+        position = to * checkpointMoves;
+    }
+    while (position < version) ApplyMove(moves[position++], true, board, changes);
+    while (position > version) ApplyMove(moves[--position], false, board, changes);
+}
+
+Mark BoardHistory::Get(std::size_t version, int col, int row) const {
+    if (version > moves.size()) version = moves.size();
+    std::size_t checkpoint = version / checkpointMoves;
+    std::uint64_t word = Find(roots[checkpoint], WordKey(col, row));
+    Mark mark = static_cast<Mark>((word >> ((col & (Board::CellsPerWord - 1)) * 2)) & 3);
+    for (std::size_t i = checkpoint * checkpointMoves; i < version; ++i) {
+        if (moves[i].col == col && moves[i].row == row) mark = moves[i].mark;
+    }
+    return mark;
+}
+
+std::size_t BoardHistory::MemoryBytes() const {
+    return nodeBytes + moves.capacity() * sizeof(HistoryMove) + roots.capacity() * sizeof(Node*);
+}
@@ -0,0 +1,98 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Board.h"
+
+const int HistoryCheckpointMoves = 16;  // Через сколько ходов сохраняется версия дерева
+
+// Изменение одного слова поля (32 клетки строки, начиная с wordCol * Board::CellsPerWord)
+struct HistoryChange {
+    int wordCol;
+    int row;
+    std::uint64_t before;
+    std::uint64_t after;
+};
+
+// Обходит клетки, которые изменение затронуло: f(col, row, before, after)
+template <typename F>
+void ForEachChangedCell(const HistoryChange& change, F&& f) {
+    std::uint64_t diff = change.before ^ change.after;
+    for (int i = 0; diff != 0; ++i, diff >>= 2) {
+        if (diff & 3) {
+            int shift = i * 2;
+            f(change.wordCol * Board::CellsPerWord + i, change.row,
+                static_cast<Mark>((change.before >> shift) & 3), static_cast<Mark>((change.after >> shift) & 3));
+        }
+    }
+}
+
+// Ход, записанный в историю
+struct HistoryMove {
+    std::int32_t col;
+    std::int32_t row;
+    Mark mark;
+};
+
+// История ходов для отмены и повтора. Версии поля хранятся в неизменяемом сжатом префиксном
+// дереве (по 16 потомков в узле): ключ — участок и номер слова в нем, лист — упакованное слово
+// из 32 клеток, как в Board. Новая версия копирует только путь от корня до измененного слова —
+// O(log n) узлов, всё остальное делится с предыдущими версиями. Корень сохраняется раз в
+// HistoryCheckpointMoves ходов, ходы между ними лежат списком по 12 байт. Близкий переход
+// снимает или ставит ходы из списка, дальний сравнивает два корня, пропуская общие поддеревья:
+// его стоимость ограничена числом изменившихся слов, а не числом ходов между версиями.
+// Клетку любой версии можно прочитать без перехода за O(log n + HistoryCheckpointMoves)
+class BoardHistory {
+public:
+    explicit BoardHistory(int checkpointMoves = HistoryCheckpointMoves);
+    ~BoardHistory();
+
+    BoardHistory(const BoardHistory&) = delete;
+    BoardHistory& operator=(const BoardHistory&) = delete;
+
+    // Начинает историю заново: версия 0 — текущее поле (после снимка, журнала или общего поля)
+    void Reset(const Board& board);
+    // Ход уже поставлен на поле. Отмененные ходы после текущей версии забываются
+    void Record(int col, int row, Mark mark);
+
+    // Приводит поле к версии version (0..Size()). Измененные слова дописываются в changes, если он задан
+    void Jump(std::size_t version, Board& board, std::vector<HistoryChange>* changes = nullptr);
+    bool CanUndo() const { return position > 0; }
+    bool CanRedo() const { return position < moves.size(); }
+
+    // Клетка в любой версии без перехода к ней
+    Mark Get(std::size_t version, int col, int row) const;
+
+    std::size_t Size() const { return moves.size(); }  // Ходов в истории
+    std::size_t Position() const { return position; }  // Сколько из них сейчас на поле
+    const HistoryMove& Move(std::size_t index) const { return moves[index]; }
+
+    std::size_t Nodes() const { return nodeCount; }
+    // Память под узлы всех версий, список ходов и корни
+    std::size_t MemoryBytes() const;
+
+private:
+    struct Node;
+
+    static std::uint64_t WordKey(int col, int row);
+    Node* NewLeaf(std::uint64_t key, std::uint64_t word);
+    Node* NewNode(std::uint64_t prefix, int shift, std::uint16_t bitmap, int count);
+    Node* Clone(const Node* node, int insertNibble);
+    void Release(Node* node);
+    Node* Set(Node* node, std::uint64_t key, std::uint64_t word);
+    static std::uint64_t Find(const Node* node, std::uint64_t key);
+    template <typename F> static void ForEachWord(const Node* node, F& f);
+    template <typename F> static void Diff(const Node* from, const Node* to, F& f);
+
+    // Ставит или снимает ход прямо на поле
+    void ApplyMove(const HistoryMove& move, bool place, Board& board, std::vector<HistoryChange>* changes);
+    // Сохраняет корень после последнего полного отрезка ходов
+    void Checkpoint();
+
+    int checkpointMoves;
+    std::vector<HistoryMove> moves;
+    std::vector<Node*> roots;   // roots[i] — дерево после i * checkpointMoves ходов
+    std::size_t position = 0;
+    std::size_t nodeCount = 0;
+    std::size_t nodeBytes = 0;
+};
@@ -0,0 +1,103 @@
+﻿#include "BoardSnapshot.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "AtomicFile.h"
+#include "Hash.h"
+
+static const char SnapshotMagic[4] = { 'C', 'C', 'B', 'S' };
+
+// Порядок участков в файле: по строке, затем по столбцу
+static bool ChunkBefore(const BoardSnapshotChunk& chunk, std::pair<int, int> rowCol) {
+    return std::make_pair(chunk.chunkRow, chunk.chunkCol) < rowCol;
+}
+
+bool BoardSnapshotView::Open(const char* path) {
+    if (!file.OpenRead(path) || file.Size() < sizeof(BoardSnapshotHeader)) {
+        file.Close();
+        return false;
+    }
+
+    const BoardSnapshotHeader& header = Header();
+    bool valid = std::memcmp(header.magic, SnapshotMagic, sizeof(SnapshotMagic)) == 0
+        && header.version == BoardSnapshotVersion
+        && header.headerSize == sizeof(BoardSnapshotHeader)
+        && header.chunkSize == Board::ChunkSize
+        && header.chunkWords == BoardChunk::Words
+        && header.payloadBytes == static_cast<std::uint64_t>(header.chunkCount) * sizeof(BoardSnapshotChunk)
+        && header.payloadBytes <= file.Size() - sizeof(BoardSnapshotHeader)
+        && Hash64(Chunks(), static_cast<std::size_t>(header.payloadBytes)) == header.checksum;
+    if (!valid) file.Close();
+    return valid;
+}
+
+Mark BoardSnapshotView::Get(int col, int row) const {
+    const BoardSnapshotChunk* begin = Chunks();
+    const BoardSnapshotChunk* end = begin + Header().chunkCount;
+    std::pair<int, int> key(Board::ChunkOf(row), Board::ChunkOf(col));
+    const BoardSnapshotChunk* chunk = std::lower_bound(begin, end, key, ChunkBefore);
+    if (chunk == end || chunk->chunkRow != key.first || chunk->chunkCol != key.second) return Mark::Empty;
+
+    int localCol = col & (Board::ChunkSize - 1);
+    int localRow = row & (Board::ChunkSize - 1);
+    std::uint64_t word = chunk->words[localRow * BoardChunk::RowWords + localCol / Board::CellsPerWord];
+    return static_cast<Mark>((word >> ((localCol % Board::CellsPerWord) * 2)) & 3);
+}
+
+bool SaveBoardSnapshot(const char* path, const Board& board, int gridSize) {
+    // Участки пишутся в порядке (строка, столбец), чтобы снимок можно было искать двоичным поиском
+    std::vector<std::pair<int, int>> order;
+    order.reserve(board.ChunkCount());
+    board.ForEachChunk([&](int chunkCol, int chunkRow, const BoardChunk&) { order.emplace_back(chunkRow, chunkCol); });
+    std::sort(order.begin(), order.end());
+
+    BoardSnapshotHeader header = {};
+    std::memcpy(header.magic, SnapshotMagic, sizeof(SnapshotMagic));
+    header.version = BoardSnapshotVersion;
+    header.headerSize = sizeof(BoardSnapshotHeader);
+    header.gridSize = gridSize;
+    header.chunkSize = Board::ChunkSize;
+    header.chunkCount = static_cast<std::uint32_t>(order.size());
+    header.chunkWords = BoardChunk::Words;
+    header.circles = board.Count(Mark::Circle);
+    header.crosses = board.Count(Mark::Cross);
+    header.payloadBytes = order.size() * sizeof(BoardSnapshotChunk);
+
+    // Пишем во временный файл и подменяем им старый снимок только после сброса на диск
+    std::string temp = TempPathFor(path);
+    MappedFile file;
+    if (!file.Create(temp.c_str(), sizeof(header) + static_cast<std::size_t>(header.payloadBytes))) return false;
+    BoardSnapshotChunk* records = reinterpret_cast<BoardSnapshotChunk*>(file.MutableData() + sizeof(header));
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        records[i].chunkCol = order[i].second;
+        records[i].chunkRow = order[i].first;
+        std::memcpy(records[i].words, board.FindChunk(order[i].second, order[i].first)->words, sizeof(records[i].words));
+    }
+    header.checksum = Hash64(records, static_cast<std::size_t>(header.payloadBytes));
+    std::memcpy(file.MutableData(), &header, sizeof(header));
+
+    bool flushed = file.Flush();
+    file.Close();
+    if (!flushed) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return AtomicReplace(temp, path);
+}
+
+bool LoadBoardSnapshot(const char* path, Board& board, int* gridSize) {
+    BoardSnapshotView view;
+    if (!view.Open(path)) return false;
+
+    const BoardSnapshotHeader& header = view.Header();
+    board.ClearAll();
+    for (std::uint32_t i = 0; i < header.chunkCount; ++i) {
+        const BoardSnapshotChunk& chunk = view.Chunks()[i];
+        board.AssignChunk(chunk.chunkCol, chunk.chunkRow, chunk.words);
+    }
+    if (gridSize) *gridSize = header.gridSize;
+    return true;
+}
@@ -0,0 +1,57 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Board.h"
+#include "MappedFile.h"
+
+// Двоичный снимок поля. Файл — это заголовок и сразу за ним непустые участки поля
+// в той же раскладке, что и в BoardChunk (64 строки по 2 64-битных слова, little-endian),
+// отсортированные по строке и столбцу участка. Поэтому снимок можно отобразить в память
+// и читать клетки прямо из файла
+struct BoardSnapshotHeader {
+    char magic[4];              // "CCBS"
+    std::uint32_t version;      // Версия формата (BoardSnapshotVersion)
+    std::uint32_t headerSize;   // sizeof(BoardSnapshotHeader), данные начинаются сразу после
+    std::int32_t gridSize;      // Размер клетки в пикселях на момент сохранения
+    std::int32_t chunkSize;     // Сторона участка в клетках (Board::ChunkSize)
+    std::uint32_t chunkCount;   // Число участков в файле
+    std::uint32_t chunkWords;   // Слов в участке (BoardChunk::Words)
+    std::uint32_t reserved;
+    std::uint64_t circles;      // Число кругов
+    std::uint64_t crosses;      // Число крестов
+    std::uint64_t payloadBytes; // Размер записей участков в байтах
+    std::uint64_t checksum;     // Hash64 записей участков
+};
+static_assert(sizeof(BoardSnapshotHeader) == 64, "заголовок снимка должен иметь фиксированный размер");
+
+// Запись одного участка
+struct BoardSnapshotChunk {
+    std::int32_t chunkCol;
+    std::int32_t chunkRow;
+    std::uint64_t words[BoardChunk::Words];
+};
+
+// Версия 2: участки бесконечного поля. Снимки других версий не загружаются
+const std::uint32_t BoardSnapshotVersion = 2;
+
+// Отображенный в память снимок: заголовок и клетки читаются прямо из файла
+class BoardSnapshotView {
+public:
+    // Открывает и проверяет снимок (сигнатура, версия, размеры, контрольная сумма)
+    bool Open(const char* path);
+    void Close() { file.Close(); }
+
+    const BoardSnapshotHeader& Header() const { return *reinterpret_cast<const BoardSnapshotHeader*>(file.Data()); }
+    const BoardSnapshotChunk* Chunks() const { return reinterpret_cast<const BoardSnapshotChunk*>(file.Data() + sizeof(BoardSnapshotHeader)); }
+    // Содержимое клетки (участок ищется двоичным поиском)
+    Mark Get(int col, int row) const;
+
+private:
+    MappedFile file;
+};
+
+// Сохраняет поле в снимок, записывая его через отображение файла в память.
+// Снимок пишется во временный файл и атомарно подменяет старый, поэтому сбой не оставит его битым
+bool SaveBoardSnapshot(const char* path, const Board& board, int gridSize);
+// Загружает снимок в поле. gridSize (если не nullptr) получает сохраненный размер клетки
+bool LoadBoardSnapshot(const char* path, Board& board, int* gridSize = nullptr);
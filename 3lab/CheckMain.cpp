@@ -0,0 +1,70 @@
+﻿// Проверки без окна: по одной на запуск, код возврата 1 при нарушении. Их запускает ctest.
+//   3lab-check                 — список проверок
+//   3lab-check <name> [args]   — одна проверка
+// В Windows-сборку окна этот файл не входит: у нее своя точка входа wWinMain
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Checks.h"
+
+struct CheckEntry {
+    const char* name;
+    const char* usage;  // Аргументы после имени
+    CheckResult (*run)(const std::vector<std::string>& args);
+};
+
+static const CheckEntry Checks[] = {
+    { "cell-damage", "", [](const std::vector<std::string>&) { return CheckCellDamage(); } },
+    { "object-churn", "", [](const std::vector<std::string>&) { return CheckObjectChurn(); } },
+    { "rules-remove", "[games]", [](const std::vector<std::string>& args) {
+        return CheckRulesRemove(args.empty() ? 40 : std::atoi(args[0].c_str()));
+    } },
+    { "settings-long-lines", "", [](const std::vector<std::string>&) { return CheckSettingsLongLines(); } },
+    { "settings-skipped-write", "", [](const std::vector<std::string>&) { return CheckSettingsSkippedWrite(); } },
+    { "settings-cache-same-stamp", "", [](const std::vector<std::string>&) { return CheckSettingsCacheSameStamp(); } },
+    { "settings-reload-burst", "[replaces]", [](const std::vector<std::string>& args) {
+        return CheckSettingsReloadBurst(args.empty() ? 20 : std::atoi(args[0].c_str()));
+    } },
+    { "settings-reload-keys", "", [](const std::vector<std::string>&) { return CheckSettingsReloadKeys(); } },
+#ifndef _WIN32
+    { "shared-board-stress", "[processes cells]", [](const std::vector<std::string>& args) {
+        return CheckSharedBoardStress(args.size() > 0 ? std::atoi(args[0].c_str()) : 4, args.size() > 1 ? std::atoi(args[1].c_str()) : 4000);
+    } },
+    { "shared-board-stale", "", [](const std::vector<std::string>&) { return CheckSharedBoardStale(); } },
+#endif
+#ifdef __linux__
+    { "server-game-limit", "", [](const std::vector<std::string>&) { return CheckServerGameLimit(); } },
+    { "server-join-rejects", "", [](const std::vector<std::string>&) { return CheckServerJoinRejects(); } },
+    { "server-backpressure", "[requests]", [](const std::vector<std::string>& args) {
+        return CheckServerBackpressure(args.empty() ? 2000 : std::atoi(args[0].c_str()));
+    } },
+    { "server-client-timeout", "", [](const std::vector<std::string>&) { return CheckServerClientTimeout(); } },
+#endif
+    { "golden-image", "<reference.ppm> [--update]", [](const std::vector<std::string>& args) {
+        if (args.empty()) {
+            CheckResult result;
+            result.Expect(false, "reference path missing");
+            return result;
+        }
+        return CheckGoldenImage(args[0], args.size() > 1 && args[1] == "--update");
+    } },
+};
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <check> [args]\nchecks:\n", argv[0]);
+        for (const CheckEntry& check : Checks) std::fprintf(stderr, "  %s %s\n", check.name, check.usage);
+        return 2;
+    }
+    for (const CheckEntry& check : Checks) {
+        if (std::string_view(argv[1]) != check.name) continue;
+        CheckResult result = check.run(std::vector<std::string>(argv + 2, argv + argc));
+        std::fputs(result.report.c_str(), stdout);
+        std::printf("%s %s\n", result.passed ? "ok" : "FAILED", check.name);
+        return result.passed ? 0 : 1;
+    }
+    std::fprintf(stderr, "unknown check %s\n", argv[1]);
+    return 2;
+}
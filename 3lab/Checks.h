@@ -0,0 +1,62 @@
+﻿#pragma once
+#include <string>
+
+// Итог проверки без окна: что измерено и где условие не выполнилось
+struct CheckResult {
+    bool passed = true;
+    std::string report;  // Строки с числами проверки, нарушения — с префиксом FAIL
+
+    void Note(const std::string& line) { report += line + "\n"; }
+    // Записывает нарушение, если condition ложно
+    void Expect(bool condition, const std::string& what) {
+        if (condition) return;
+        passed = false;
+        report += "FAIL " + what + "\n";
+    }
+};
+
+// games случайных партий на поле 15x15 и на бесконечном: после каждого снятия метки (в обратном порядке
+// и вразброс) GameRules::Remove дает те же собранные окна, живые окна и решенность, что и Rebuild
+CheckResult CheckRulesRemove(int games);
+// Кадр после клика по одной клетке (clip = CellDamageRect) стоит одно и то же малое число команд
+// устройства на поле с 10 и со 100 тысячами меток
+CheckResult CheckCellDamage();
+// Кадры без изменений не создают перьев и кистей, смена цвета фона или сетки создает ровно один объект,
+// ReleaseObjects удаляет все созданные
+CheckResult CheckObjectChurn();
+// Сцена из трех панелей (сетка с метками, тепловая карта, плитки плотности), нарисованная SoftwareDevice,
+// совпадает с эталоном reference попиксельно. update — переснять эталон вместо сравнения
+CheckResult CheckGoldenImage(const std::string& reference, bool update);
+// Все четыре способа чтения settings.ini дают то же, что ParseSettings, на файле со строками
+// длиннее буферов чтения: длинная строка не распадается на части, номера строк ошибок верны
+CheckResult CheckSettingsLongLines();
+// Повторный Save тех же настроек любым способом не пишет файл: SkippedWrites()==1, время изменения то же
+CheckResult CheckSettingsSkippedWrite();
+// Переписанный settings.ini с прежними размером и временем изменения не читается из устаревшего кэша
+CheckResult CheckSettingsCacheSameStamp();
+// replaces быстрых атомарных замен settings.ini подряд SettingsWatcher перечитывает один раз, после паузы дребезга
+CheckResult CheckSettingsReloadBurst(int replaces);
+// Правка одного ключа settings.ini применяется одна: масштаб колесиком и размер клетки из командной строки остаются
+CheckResult CheckSettingsReloadKeys();
+
+#ifndef _WIN32
+// processes процессов (fork) одновременно ставят метки в одни и те же cells клеток общего поля: каждая клетка
+// достается ровно одному, зеркала читателей совпадают с полем, кольцо изменений отдает каждое изменение
+// один раз или сообщает об отставании, последний отключившийся удаляет общую память
+CheckResult CheckSharedBoardStress(int processes, int cells);
+// Общая память, создатель которой умер до конца инициализации, удаляется и создается заново
+CheckResult CheckSharedBoardStale();
+#endif
+
+#ifdef __linux__
+// Проверки сервера партий (epoll, только Linux; собираются в 3lab-check вместе с GameServer.cpp).
+// Ход в новую партию сверх предела GameEngine получает NoRoom, ходы в заведенные партии проходят
+CheckResult CheckServerGameLimit();
+// Join убирает из локального поля ходы, которые сервер не принял
+CheckResult CheckServerJoinRejects();
+// Клиент шлет requests запросов и не читает ответы: неотправленные ответы сервера не растут сверх предела,
+// а когда клиент начинает читать, сервер отвечает на все
+CheckResult CheckServerBackpressure(int requests);
+// Place против сервера, который не отвечает, завершается ошибкой за GameClientTimeoutMs
+CheckResult CheckServerClientTimeout();
+#endif
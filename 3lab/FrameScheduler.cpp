@@ -0,0 +1,84 @@
+﻿#include "FrameScheduler.h"
+#include <algorithm>
+#include <utility>
+
+// Прямоугольники пересекаются или касаются сторонами (тогда их выгодно слить)
+static bool Touches(const Rect& a, const Rect& b) {
+    return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+static Rect Union(const Rect& a, const Rect& b) {
+    return { std::min(a.left, b.left), std::min(a.top, b.top), std::max(a.right, b.right), std::max(a.bottom, b.bottom) };
+}
+
+void FrameScheduler::Invalidate(const Rect& rect) {
+    ++requests;
+    if (pending.full || rect.IsEmpty()) return;
+
+    // Сливаем с соседями, пока объединение задевает еще кого-то
+    Rect merged = rect;
+    std::vector<Rect>& rects = pending.rects;
+    for (std::size_t i = 0; i < rects.size();) {
+        if (Touches(rects[i], merged)) {
+            merged = Union(rects[i], merged);
+            rects[i] = rects.back();
+            rects.pop_back();
+            i = 0;
+        }
+        else {
+            ++i;
+        }
+    }
+    rects.push_back(merged);
+
+    // Слишком дробные повреждения заменяем одним охватывающим прямоугольником
+    if (rects.size() > MaxDamageRects) {
+        Rect bounds = rects[0];
+        for (const Rect& r : rects) bounds = Union(bounds, r);
+        rects.assign(1, bounds);
+    }
+}
+
+void FrameScheduler::InvalidateAll() {
+    ++requests;
+    pending.full = true;
+    pending.scrollX = pending.scrollY = 0;  // Перерисовка всего окна делает сдвиг ненужным
+    pending.rects.clear();
+}
+
+void FrameScheduler::Scroll(int dx, int dy) {
+    ++requests;
+    if (pending.full || (dx == 0 && dy == 0)) return;
+    pending.scrollX += dx;
+    pending.scrollY += dy;
+    for (Rect& r : pending.rects) {
+        r.left += dx;
+        r.right += dx;
+        r.top += dy;
+        r.bottom += dy;
+    }
+}
+
+unsigned FrameScheduler::DelayUntilFrame(std::uint64_t nowMs) const {
+    if (!presented || nowMs >= lastFrameMs + interval) return 0;
+    return static_cast<unsigned>(lastFrameMs + interval - nowMs);
+}
+
+FrameAction FrameScheduler::RequestFrame(std::uint64_t nowMs, unsigned& delayMs) {
+    delayMs = 0;
+    if (timerArmed || !Dirty()) return FrameAction::None;
+    delayMs = DelayUntilFrame(nowMs);
+    if (delayMs == 0) return FrameAction::Present;
+    timerArmed = true;
+    return FrameAction::ArmTimer;
+}
+
+bool FrameScheduler::TakeFrame(std::uint64_t nowMs, FrameDamage& damage) {
+    damage.Reset();
+    if (pending.Empty()) return false;
+    std::swap(damage, pending);
+    presented = true;
+    lastFrameMs = nowMs;
+    ++frames;
+    return true;
+}
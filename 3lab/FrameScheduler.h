@@ -0,0 +1,75 @@
+﻿#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "Graphics.h"
+
+const unsigned DefaultFrameIntervalMs = 16;  // Интервал кадра при 60 Гц, если частоту экрана узнать не удалось
+const std::size_t MaxDamageRects = 8;         // Больше прямоугольников сливаются в один охватывающий
+
+// Повреждения, накопленные между кадрами
+struct FrameDamage {
+    bool full = false;         // Перерисовать всё окно
+    int scrollX = 0;           // Суммарный сдвиг содержимого с прошлого кадра
+    int scrollY = 0;
+    std::vector<Rect> rects;   // Непересекающиеся области в координатах после сдвига
+
+    bool Empty() const { return !full && scrollX == 0 && scrollY == 0 && rects.empty(); }
+    void Reset() {
+        full = false;
+        scrollX = scrollY = 0;
+        rects.clear();  // Память вектора остается для следующего кадра
+    }
+};
+
+// Что окну сделать после запроса кадра
+enum class FrameAction {
+    None,      // Выводить нечего или таймер кадра уже взведен
+    Present,   // Вывести кадр сейчас
+    ArmTimer,  // Завести таймер кадра на delayMs
+};
+
+// Планировщик кадров. Обработчики ввода только отмечают, что изменилось, а окно
+// перерисовывается не чаще одного раза за интервал кадра: все повреждения за интервал
+// сливаются, и пачка из сотен событий стоит одного вывода. Время передается снаружи,
+// поэтому планировщик не зависит от Win32
+class FrameScheduler {
+public:
+    explicit FrameScheduler(unsigned intervalMs = DefaultFrameIntervalMs) : interval(intervalMs ? intervalMs : 1) {}
+
+    void SetInterval(unsigned intervalMs) { interval = intervalMs ? intervalMs : 1; }
+    unsigned Interval() const { return interval; }
+
+    // Отмечает область, которую надо перерисовать
+    void Invalidate(const Rect& rect);
+    // Отмечает для перерисовки всё окно
+    void InvalidateAll();
+    // Содержимое окна сдвинулось на (dx, dy): уже отмеченные области сдвигаются вместе с ним
+    void Scroll(int dx, int dy);
+
+    bool Dirty() const { return !pending.Empty(); }
+
+    // Сколько миллисекунд ждать до следующего кадра (0 — можно выводить сейчас)
+    unsigned DelayUntilFrame(std::uint64_t nowMs) const;
+    // Решает, выводить кадр сейчас или завести таймер на остаток интервала. Пока таймер
+    // взведен, запросы только копят повреждения. При ArmTimer в delayMs — задержка таймера
+    FrameAction RequestFrame(std::uint64_t nowMs, unsigned& delayMs);
+    // Таймер кадра сработал или снят: следующий RequestFrame снова решает сам
+    void TimerFired() { timerArmed = false; }
+    bool TimerArmed() const { return timerArmed; }
+    // Забирает накопленные повреждения в damage и запоминает время кадра.
+    // Возвращает false, если выводить нечего
+    bool TakeFrame(std::uint64_t nowMs, FrameDamage& damage);
+
+    std::uint64_t Requests() const { return requests; }  // Сколько раз просили перерисовку
+    std::uint64_t Frames() const { return frames; }      // Сколько кадров выдано
+
+private:
+    FrameDamage pending;
+    unsigned interval;
+    bool presented = false;        // Был ли уже хоть один кадр
+    bool timerArmed = false;       // Отложенный кадр уже запланирован
+    std::uint64_t lastFrameMs = 0;
+    std::uint64_t requests = 0;
+    std::uint64_t frames = 0;
+};
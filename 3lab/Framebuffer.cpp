@@ -0,0 +1,99 @@
+﻿#include "Framebuffer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRAMEBUFFER_SSE2 1
+#endif
+
+void FillPixels(std::uint32_t* dst, std::size_t count, std::uint32_t value) {
+#ifdef FRAMEBUFFER_SSE2
+    // Доходим до адреса, кратного 16 байтам, затем пишем по 16 пикселей за итерацию
+    while (count > 0 && (reinterpret_cast<std::uintptr_t>(dst) & 15) != 0) {
+        *dst++ = value;
+        --count;
+    }
+    __m128i v = _mm_set1_epi32(static_cast<int>(value));
+    for (; count >= 16; count -= 16, dst += 16) {
+        _mm_store_si128(reinterpret_cast<__m128i*>(dst), v);
+        _mm_store_si128(reinterpret_cast<__m128i*>(dst + 4), v);
+        _mm_store_si128(reinterpret_cast<__m128i*>(dst + 8), v);
+        _mm_store_si128(reinterpret_cast<__m128i*>(dst + 12), v);
+    }
+    for (; count >= 4; count -= 4, dst += 4) {
+        _mm_store_si128(reinterpret_cast<__m128i*>(dst), v);
+    }
+#endif
+    // Хвост (или весь отрезок без SSE2); компилятор векторизует этот цикл сам
+    std::fill_n(dst, count, value);
+}
+
+Framebuffer::Framebuffer(int width, int height) {
+    Resize(width, height);
+}
+
+void Framebuffer::Resize(int newWidth, int newHeight) {
+    width = std::max(0, newWidth);
+    height = std::max(0, newHeight);
+    pixels.assign(static_cast<std::size_t>(width) * height, 0);
+}
+
+std::size_t Framebuffer::Fill(const Rect& rect, std::uint32_t value) {
+    int left = std::max(0, rect.left);
+    int top = std::max(0, rect.top);
+    int right = std::min(width, rect.right);
+    int bottom = std::min(height, rect.bottom);
+    if (left >= right || top >= bottom) return 0;
+
+    std::size_t span = static_cast<std::size_t>(right - left);
+    if (left == 0 && right == width) {
+        // Полные строки лежат подряд — одна заливка на весь прямоугольник
+        FillPixels(Row(top), span * (bottom - top), value);
+    }
+    else {
+        for (int y = top; y < bottom; ++y) {
+            FillPixels(Row(y) + left, span, value);
+        }
+    }
+    return span * (bottom - top);
+}
+
+void Framebuffer::Scroll(int dx, int dy) {
+    if (dx <= -width || dx >= width || dy <= -height || dy >= height) return;  // Ничего не остается на экране
+    std::size_t span = static_cast<std::size_t>(width - std::abs(dx));
+    int srcX = dx < 0 ? -dx : 0;
+    int dstX = dx > 0 ? dx : 0;
+    // При сдвиге вниз строки копируются снизу вверх, чтобы не затереть еще не скопированные
+    if (dy > 0) {
+        for (int y = height - 1; y >= dy; --y) {
+            std::memmove(Row(y) + dstX, Row(y - dy) + srcX, span * sizeof(std::uint32_t));
+        }
+    }
+    else {
+        for (int y = 0; y < height + dy; ++y) {
+            std::memmove(Row(y) + dstX, Row(y - dy) + srcX, span * sizeof(std::uint32_t));
+        }
+    }
+}
+
+bool Framebuffer::WritePpm(const char* path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    file << "P6\n" << width << " " << height << "\n255\n";
+
+    std::vector<char> line(static_cast<std::size_t>(width) * 3);
+    for (int y = 0; y < height; ++y) {
+        const std::uint32_t* src = Row(y);
+        for (int x = 0; x < width; ++x) {
+            line[x * 3 + 0] = static_cast<char>((src[x] >> 16) & 0xFF);
+            line[x * 3 + 1] = static_cast<char>((src[x] >> 8) & 0xFF);
+            line[x * 3 + 2] = static_cast<char>(src[x] & 0xFF);
+        }
+        file.write(line.data(), static_cast<std::streamsize>(line.size()));
+    }
+    return static_cast<bool>(file);
+}
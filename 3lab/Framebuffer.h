@@ -0,0 +1,45 @@
+﻿#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "Graphics.h"
+
+// Заполняет count пикселей значением value (SSE2, если доступно)
+void FillPixels(std::uint32_t* dst, std::size_t count, std::uint32_t value);
+
+// Кадр в памяти: 32 бита на пиксель в формате 0x00RRGGBB (как 32-битный DIB),
+// строки идут сверху вниз без выравнивания
+class Framebuffer {
+public:
+    Framebuffer() = default;
+    Framebuffer(int width, int height);
+
+    void Resize(int width, int height);
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+    std::uint32_t* Row(int y) { return &pixels[static_cast<std::size_t>(y) * width]; }
+    const std::uint32_t* Row(int y) const { return &pixels[static_cast<std::size_t>(y) * width]; }
+    const std::uint32_t* Data() const { return pixels.data(); }
+    std::uint32_t Pixel(int x, int y) const { return Row(y)[x]; }
+
+    // Заливает прямоугольник (обрезается по границам кадра). Возвращает число записанных пикселей
+    std::size_t Fill(const Rect& rect, std::uint32_t value);
+
+    // Сдвигает содержимое на (dx, dy), как ScrollWindowEx. Открывшаяся полоса остается прежней,
+    // ее должен перерисовать вызывающий
+    void Scroll(int dx, int dy);
+
+    // Сохраняет кадр в двоичный PPM (P6). Возвращает false при ошибке записи
+    bool WritePpm(const char* path) const;
+
+    // Переводит COLORREF (0x00BBGGRR) в формат пикселя (0x00RRGGBB)
+    static std::uint32_t ToPixel(Color color) {
+        return (static_cast<std::uint32_t>(ColorR(color)) << 16) | (static_cast<std::uint32_t>(ColorG(color)) << 8) | static_cast<std::uint32_t>(ColorB(color));
+    }
+
+private:
+    int width = 0;
+    int height = 0;
+    std::vector<std::uint32_t> pixels;
+};
@@ -0,0 +1,57 @@
+﻿#include "GameBench.h"
+#include <chrono>
+#include <cstdio>
+#include <utility>
+#include <vector>
+#include "GameRules.h"
+
+// xorshift32: генератор не должен стоить больше самого хода
+static std::uint32_t NextRandom(std::uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+RandomGamesResult MeasureRandomGames(int cols, int rows, int winLength, std::uint64_t games, std::uint32_t seed) {
+    RandomGamesResult result;
+    if (cols <= 0 || rows <= 0) return result;
+
+    GameRules rules(winLength);
+    rules.SetBounds(cols, rows);
+    std::vector<std::pair<int, int>> cells;
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < cols; ++col) cells.emplace_back(col, row);
+    }
+    std::uint32_t state = seed ? seed : 1;
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::uint64_t game = 0; game < games; ++game) {
+        rules.Reset();
+        GameOutcome outcome = rules.Outcome();
+        // Случайный порядок клеток выбирается по ходу партии (частичная перетасовка Фишера — Йетса)
+        for (std::size_t move = 0; move < cells.size() && outcome == GameOutcome::None; ++move) {
+            std::size_t pick = move + NextRandom(state) % (cells.size() - move);
+            std::swap(cells[move], cells[pick]);
+            outcome = rules.Place(cells[move].first, cells[move].second, move % 2 ? Mark::Cross : Mark::Circle);
+            ++result.moves;
+        }
+        if (outcome == GameOutcome::CircleWins) ++result.circleWins;
+        else if (outcome == GameOutcome::CrossWins) ++result.crossWins;
+        else ++result.draws;  // Поле заполнено без линии — тоже ничья
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.games = games;
+    return result;
+}
+
+std::string FormatRandomGames(const RandomGamesResult& result, int cols, int rows, int winLength) {
+    char text[256];
+    std::snprintf(text, sizeof(text),
+        "%dx%d, %d in a row: %llu games in %.3f s, %.0f games/s, %.0f moves/s\n"
+        "  circles %llu, crosses %llu, draws %llu\n",
+        cols, rows, winLength, static_cast<unsigned long long>(result.games), result.seconds,
+        result.GamesPerSecond(), result.MovesPerSecond(), static_cast<unsigned long long>(result.circleWins),
+        static_cast<unsigned long long>(result.crossWins), static_cast<unsigned long long>(result.draws));
+    return text;
+}
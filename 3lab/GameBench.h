@@ -0,0 +1,21 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+
+// Итог прогона случайных партий
+struct RandomGamesResult {
+    std::uint64_t games = 0;
+    std::uint64_t moves = 0;
+    std::uint64_t circleWins = 0;
+    std::uint64_t crossWins = 0;
+    std::uint64_t draws = 0;
+    double seconds = 0;
+
+    double GamesPerSecond() const { return seconds > 0 ? games / seconds : 0; }
+    double MovesPerSecond() const { return seconds > 0 ? moves / seconds : 0; }
+};
+
+// Играет games случайных партий на поле cols x rows до победы или ничьей через GameRules
+RandomGamesResult MeasureRandomGames(int cols, int rows, int winLength, std::uint64_t games, std::uint32_t seed);
+
+std::string FormatRandomGames(const RandomGamesResult& result, int cols, int rows, int winLength);
@@ -0,0 +1,180 @@
+﻿#include "GameClient.h"
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h>
+#include <afunix.h>
+#include <mutex>
+#else
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+GameClient::~GameClient() {
+    Close();
+}
+
+bool GameClient::Connect(const std::string& path) {
+    Close();
+    sockaddr_un address = {};
+    if (path.size() >= sizeof(address.sun_path)) return false;
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+
+#ifdef _WIN32
+    static std::once_flag started;
+    std::call_once(started, [] {
+        WSADATA data;
+        WSAStartup(MAKEWORD(2, 2), &data);
+    });
+    SOCKET fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == INVALID_SOCKET) return false;
+    DWORD timeout = GameClientTimeoutMs;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        closesocket(fd);
+        return false;
+    }
+    socket = static_cast<Socket>(fd);
+#else
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    // По истечении времени send и recv возвращают EAGAIN, и соединение закрывается как потерянное
+    timeval timeout = { static_cast<time_t>(GameClientTimeoutMs / 1000), static_cast<suseconds_t>(GameClientTimeoutMs % 1000 * 1000) };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return false;
+    }
+    socket = fd;
+#endif
+    return true;
+}
+
+void GameClient::Close() {
+    if (socket == InvalidSocket) return;
+#ifdef _WIN32
+    closesocket(static_cast<SOCKET>(socket));
+#else
+    close(socket);
+#endif
+    socket = InvalidSocket;
+}
+
+bool GameClient::SendAll(const void* data, std::size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+#ifdef _WIN32
+        int n = send(static_cast<SOCKET>(socket), bytes, static_cast<int>(size), 0);
+#else
+        ssize_t n = send(socket, bytes, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        if (n <= 0) {
+            Close();
+            return false;
+        }
+        bytes += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool GameClient::ReceiveAll(void* data, std::size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+#ifdef _WIN32
+        int n = recv(static_cast<SOCKET>(socket), bytes, static_cast<int>(size), 0);
+#else
+        ssize_t n = recv(socket, bytes, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        if (n <= 0) {
+            Close();
+            return false;
+        }
+        bytes += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool GameClient::ReceiveHeader(GameMessage type, std::uint32_t& count) {
+    GameMessageHeader header;
+    if (!ReceiveAll(&header, sizeof(header))) return false;
+    if (header.type != static_cast<std::uint32_t>(type) || header.count > GameMaxBatch) {
+        Close();  // Ответ не по протоколу: дальше поток байтов не разобрать
+        return false;
+    }
+    count = header.count;
+    return true;
+}
+
+bool GameClient::Send(const GameMove* moves, std::size_t count, GameMoveResult* results) {
+    if (!IsOpen() || count > GameMaxBatch) return false;
+    GameMessageHeader header = { static_cast<std::uint32_t>(GameMessage::Moves), static_cast<std::uint32_t>(count) };
+    std::uint32_t replies = 0;
+    if (!SendAll(&header, sizeof(header)) || !SendAll(moves, count * sizeof(GameMove))
+        || !ReceiveHeader(GameMessage::Results, replies)) return false;
+    if (replies != count) {
+        Close();
+        return false;
+    }
+    return ReceiveAll(results, count * sizeof(GameMoveResult));
+}
+
+bool GameClient::Fetch(std::uint32_t board, std::uint32_t since, std::vector<GameMove>& moves) {
+    if (!IsOpen()) return false;
+    GameMessageHeader header = { static_cast<std::uint32_t>(GameMessage::Fetch), 1 };
+    GameFetch fetch = { board, since };
+    std::uint32_t count = 0;
+    if (!SendAll(&header, sizeof(header)) || !SendAll(&fetch, sizeof(fetch))
+        || !ReceiveHeader(GameMessage::History, count)) return false;
+    moves.resize(count);
+    return ReceiveAll(moves.data(), count * sizeof(GameMove));
+}
+
+bool ServerBoard::Open(const std::string& path, std::uint32_t id) {
+    board = id;
+    version = 0;
+    return client.Connect(path);
+}
+
+bool ServerBoard::Place(int col, int row, Mark mark) {
+    GameMove move = { board, col, row, static_cast<std::uint8_t>(mark), {} };
+    GameMoveResult result;
+    return client.Send(&move, 1, &result) && result.status == static_cast<std::uint8_t>(MoveStatus::Placed);
+}
+
+bool ServerBoard::Join(Board& local) {
+    Board remote;
+    version = 0;
+    if (!Poll(remote, [](int, int) {})) return false;
+    if (version > 0) {
+        local = std::move(remote);
+        return true;
+    }
+
+    // Партия на сервере пустая: выкладываем свое поле пачками. Свои же ходы потом придут
+    // опросом, но в mirror уже стоят и повторно не перерисовываются. Непринятые ходы убираем:
+    // их клетки займут ходы сервера при следующем опросе
+    std::vector<GameMove> moves;
+    std::vector<GameMoveResult> results(GameMaxBatch);
+    local.ForEach([&](int col, int row, Mark mark) {
+        moves.push_back({ board, col, row, static_cast<std::uint8_t>(mark), {} });
+    });
+    for (std::size_t first = 0; first < moves.size(); first += GameMaxBatch) {
+        std::size_t count = moves.size() - first < GameMaxBatch ? moves.size() - first : GameMaxBatch;
+        if (!client.Send(moves.data() + first, count, results.data())) return false;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (results[i].status != static_cast<std::uint8_t>(MoveStatus::Placed)) local.Clear(moves[first + i].col, moves[first + i].row);
+        }
+    }
+    return true;
+}
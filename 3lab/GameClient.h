@@ -0,0 +1,87 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Board.h"
+#include "GameProtocol.h"
+
+const unsigned int ServerBoardPollMs = 30;        // Период опроса сервера потоком сессии (ServerSession)
+const unsigned int GameClientTimeoutMs = 2000;    // Дольше ответа сервера не ждем: сессия должна останавливаться
+
+// Соединение с сервером партий (AF_UNIX: сокет POSIX или Winsock в Windows 10 и новее).
+// Запросы синхронные: отправили сообщение — дождались ответа, но не дольше GameClientTimeoutMs
+// на каждую передачу. Сервер, который не отвечает, считается потерянным: соединение закрывается
+class GameClient {
+public:
+    GameClient() = default;
+    ~GameClient();
+
+    GameClient(const GameClient&) = delete;
+    GameClient& operator=(const GameClient&) = delete;
+
+    bool Connect(const std::string& path);
+    void Close();
+    bool IsOpen() const { return socket != InvalidSocket; }
+
+    // Отправляет count ходов одним сообщением и получает результат каждого. При ошибке связи закрывает соединение
+    bool Send(const GameMove* moves, std::size_t count, GameMoveResult* results);
+    // Получает ходы партии начиная с since (не больше GameMaxBatch за раз)
+    bool Fetch(std::uint32_t board, std::uint32_t since, std::vector<GameMove>& moves);
+
+private:
+    bool SendAll(const void* data, std::size_t size);
+    bool ReceiveAll(void* data, std::size_t size);
+    bool ReceiveHeader(GameMessage type, std::uint32_t& count);
+
+#ifdef _WIN32
+    typedef std::uintptr_t Socket;  // SOCKET
+    static constexpr Socket InvalidSocket = ~static_cast<Socket>(0);
+#else
+    typedef int Socket;
+    static constexpr Socket InvalidSocket = -1;
+#endif
+    Socket socket = InvalidSocket;
+};
+
+// Партия на сервере, к которой подключено окно. Работает как SharedBoard, только через сокет:
+// ход сначала принимает сервер (клетку мог занять другой клиент), а ходы других клиентов
+// приходят опросом по номеру версии партии
+class ServerBoard {
+public:
+    bool Open(const std::string& path, std::uint32_t board);
+    void Close() { client.Close(); }
+    bool IsOpen() const { return client.IsOpen(); }
+    std::uint32_t Id() const { return board; }
+    std::uint32_t Version() const { return version; }
+
+    // Ставит метку на сервере. Возвращает false, если сервер ход не принял или связь потеряна
+    bool Place(int col, int row, Mark mark);
+    // Отправляет count ходов одним сообщением (не больше GameMaxBatch) и получает результат каждого.
+    // Возвращает false, если связь потеряна
+    bool Place(const GameMove* moves, std::size_t count, GameMoveResult* results) { return client.Send(moves, count, results); }
+    // Первый клиент партии выкладывает на сервер свое поле, остальные заменяют свое полем сервера.
+    // Ходы, которые сервер не принял (клетку занял другой клиент, партия решилась), убираются из local
+    bool Join(Board& local);
+
+    // Переносит в mirror ходы других клиентов и вызывает f(col, row) для каждой новой метки.
+    // Возвращает false, если связь потеряна
+    template <typename F>
+    bool Poll(Board& mirror, F&& f) {
+        while (client.IsOpen()) {
+            if (!client.Fetch(board, version, pending)) return false;
+            for (const GameMove& move : pending) {
+                if (mirror.Place(move.col, move.row, static_cast<Mark>(move.mark))) f(move.col, move.row);
+            }
+            version += static_cast<std::uint32_t>(pending.size());
+            if (pending.size() < GameMaxBatch) return true;
+        }
+        return false;
+    }
+
+private:
+    GameClient client;
+    std::uint32_t board = 0;
+    std::uint32_t version = 0;     // Сколько ходов партии уже перенесено в mirror
+    std::vector<GameMove> pending;  // Память под ответы Fetch переиспользуется
+};
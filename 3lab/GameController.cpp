@@ -0,0 +1,293 @@
+﻿#include "GameController.h"
+#include <algorithm>
+#include "Profiler.h"
+
+GameController::GameController(Board& board, Renderer& renderer, FrameScheduler& frames)
+    : board(board), renderer(renderer), frames(frames), regions(board) {
+    view.cellSize = settings.gridSize;
+}
+
+void GameController::ApplySettings(const Settings& fresh, std::uint32_t keys) {
+    CopySettings(settings, fresh, keys);
+    if (keys & SettingsKeyBit(SettingsKey::GridSize)) view.ZoomAt(width / 2, height / 2, settings.gridSize);
+    if (keys & SettingsKeyBit(SettingsKey::GridLineColor)) {
+        gridLineColor = settings.gridLineColor;
+        renderer.SetGridColor(gridLineColor);
+    }
+    if (keys & SettingsKeyBit(SettingsKey::BackgroundColor)) renderer.SetBackgroundColor(settings.backgroundColor);
+    if (settings.winLength != rules.WinLength()) {
+        rules.SetWinLength(settings.winLength);
+        rules.Rebuild(board);  // Те же метки могут уже составлять линию новой длины
+    }
+    InvalidateAll();
+}
+
+Settings GameController::CurrentSettings() const {
+    Settings current = settings;
+    current.gridSize = view.cellSize;
+    current.windowWidth = width;
+    current.windowHeight = height;
+    current.gridLineColor = gridLineColor;
+    current.winLength = rules.WinLength();
+    return current;
+}
+
+ControllerAction GameController::Handle(const InputEvent& event) {
+    switch (event.kind) {
+    case InputKind::LeftDown:
+    case InputKind::RightDown: {
+        PROFILE_SCOPE("input.click");
+        int col = view.ColAt(event.x);  // Номер клетки по оси X
+        int row = view.RowAt(event.y);  // Номер клетки по оси Y
+        // С компьютерным соперником человек играет только кругами и только в свою очередь
+        if (aiEnabled && (event.kind == InputKind::RightDown || AiTurn())) return ControllerAction::None;
+        // Левая кнопка ставит круг, правая — крест, только если клетка свободна
+        GameOutcome before = rules.Outcome();
+        if (PlaceMark(col, row, event.kind == InputKind::LeftDown ? Mark::Circle : Mark::Cross)) {
+            InvalidateCell(col, row);  // Перерисовываем только эту клетку
+        }
+        if (rules.Outcome() != before) return ControllerAction::GameOver;
+        return AiTurn() ? ControllerAction::AiTurn : ControllerAction::None;
+    }
+    case InputKind::MiddleDown:
+        panning = true;
+        panFromX = event.x;
+        panFromY = event.y;
+        return ControllerAction::None;
+    case InputKind::MouseMove:
+        if (panning) {
+            Pan(event.x - panFromX, event.y - panFromY);
+            panFromX = event.x;
+            panFromY = event.y;
+        }
+        return ControllerAction::None;
+    case InputKind::MiddleUp:
+        panning = false;
+        return ControllerAction::None;
+    case InputKind::Wheel:
+        HandleWheel(event);
+        return ControllerAction::None;
+    case InputKind::Key:
+        return HandleKey(event);
+    case InputKind::Resize:
+        width = event.x;   // Новый размер ширины окна
+        height = event.y;  // Новый размер высоты окна
+        return ControllerAction::None;
+    default:
+        return ControllerAction::None;
+    }
+}
+
+void GameController::HandleWheel(const InputEvent& event) {
+    PROFILE_SCOPE("input.wheel");
+    // Ctrl + колесико меняет масштаб относительно точки под курсором
+    if (event.modifiers & ModControl) {
+        view.ZoomAt(event.x, event.y, event.value > 0 ? view.cellSize * 5 / 4 + 1 : view.cellSize * 4 / 5);
+        InvalidateAll();
+        return;
+    }
+    // Изменяем цвет сетки в зависимости от прокрутки, ограничивая компоненты от 0 до 255
+    int step = event.value > 0 ? 5 : -5;
+    int r = std::max(0, std::min(255, ColorR(gridLineColor) + step));
+    int g = std::max(0, std::min(255, ColorG(gridLineColor) + step));
+    int b = std::max(0, std::min(255, ColorB(gridLineColor) + step));
+
+    gridLineColor = MakeColor(r, g, b);  // Обновляем цвет сетки
+    renderer.SetGridColor(gridLineColor);  // Перо сетки пересоздастся при следующей отрисовке
+    InvalidateAll();  // Перерисуем окно в ближайшем кадре
+}
+
+ControllerAction GameController::HandleKey(const InputEvent& event) {
+    PROFILE_SCOPE("input.key");
+    int key = event.value;
+    // Если нажата клавиша ESC или комбинация Ctrl+Q, выходим из программы
+    if (key == KeyEscape || ((event.modifiers & ModControl) && key == 'Q')) {
+        return ControllerAction::Quit;
+    }
+    // Если нажата клавиша Enter, меняем цвет фона окна на случайный
+    if (key == KeyEnter) {
+        std::uniform_int_distribution<int> component(0, 255);
+        int r = component(random);
+        int g = component(random);
+        int b = component(random);
+        Color newColor = MakeColor(r, g, b);
+        renderer.SetBackgroundColor(newColor);  // Кисть пересоздается только здесь
+        settings.backgroundColor = newColor;  // Сразу сохраняем новый цвет
+        InvalidateAll();
+        return ControllerAction::None;
+    }
+    // Стрелки сдвигают поле на четверть окна
+    if (key == KeyLeft || key == KeyRight || key == KeyUp || key == KeyDown) {
+        int dx = key == KeyLeft ? width / 4 : (key == KeyRight ? -width / 4 : 0);
+        int dy = key == KeyUp ? height / 4 : (key == KeyDown ? -height / 4 : 0);
+        Pan(dx, dy);
+        return ControllerAction::None;
+    }
+    // F2 отдает кресты компьютеру и забирает обратно
+    if (key == KeyF2) {
+        aiEnabled = !aiEnabled;
+        return ControllerAction::ToggleAi;
+    }
+    // F3 включает и выключает тепловую карту: оттенок плиток по числу меток в них
+    if (key == KeyF3) {
+        renderer.SetHeatmap(renderer.Heatmap() ? nullptr : &regions);
+        InvalidateAll();
+        return ControllerAction::None;
+    }
+    // F9 начинает и заканчивает запись трассы ввода для воспроизведения без окна
+    if (key == KeyF9) {
+        return ControllerAction::ToggleTraceRecording;
+    }
+#if PROFILING_ENABLED
+    // F11 сохраняет замеры в файл, F12 включает и выключает их вывод на экран
+    if (key == KeyF11) {
+        return ControllerAction::DumpProfile;
+    }
+    if (key == KeyF12) {
+        InvalidateAll();
+        return ControllerAction::ToggleProfileOverlay;
+    }
+#endif
+    // Ctrl+Z отменяет ход, Ctrl+Y (или Ctrl+Shift+Z) повторяет
+    if ((event.modifiers & ModControl) && key == 'Z') {
+        return event.modifiers & ModShift ? Redo() : Undo();
+    }
+    if ((event.modifiers & ModControl) && key == 'Y') {
+        return Redo();
+    }
+    // Если нажата комбинация Shift + C, открываем Блокнот
+    if ((event.modifiers & ModShift) && key == 'C') {
+        return ControllerAction::OpenNotepad;
+    }
+    return ControllerAction::None;
+}
+
+bool GameController::PlaceMark(int col, int row, Mark mark) {
+    if (sharedBoard && sharedBoard->IsOpen() && !sharedBoard->Place(col, row, mark)) return false;
+    // Пока окно не получило поле сервера, ход пропал бы вместе с локальным полем
+    if (serverSession && !serverPlaying && (serverSession->State() == ServerState::Joining || serverSession->State() == ServerState::Playing)) return false;
+    if (!board.Place(col, row, mark)) return false;
+    rules.Place(col, row, mark);
+    regions.SyncCell(col, row);
+    if (journal) journal->Append(JournalOp::Place, col, row, mark);
+    if (history) history->Record(col, row, mark);
+    if (serverPlaying) serverSession->Place(col, row, mark);
+    hasLastMove = true;
+    lastCol = col;
+    lastRow = row;
+    return true;
+}
+
+bool GameController::AiTurn() const {
+    return aiEnabled && rules.Outcome() == GameOutcome::None && board.Count(Mark::Circle) > board.Count(Mark::Cross);
+}
+
+AiPosition GameController::AiSnapshot() const {
+    // Ходов в этом запуске еще не было — ищем вокруг центра окна
+    int col = hasLastMove ? lastCol : view.ColAt(width / 2);
+    int row = hasLastMove ? lastRow : view.RowAt(height / 2);
+    return AiPosition::Around(board, col, row, rules.WinLength());
+}
+
+ControllerAction GameController::PlaceAiMove(int col, int row) {
+    if (!AiTurn()) return ControllerAction::None;  // Пока искали, соперника выключили или партия решилась
+    if (!PlaceMark(col, row, Mark::Cross)) return ControllerAction::AiTurn;  // Клетку заняли — ищем заново
+    InvalidateCell(col, row);
+    if (rules.Outcome() != GameOutcome::None) return ControllerAction::GameOver;
+    return AiTurn() ? ControllerAction::AiTurn : ControllerAction::None;
+}
+
+ControllerAction GameController::JumpHistory(std::size_t version) {
+    if (!history || AiTurn() || version > history->Size() || version == history->Position()) return ControllerAction::None;
+    PROFILE_SCOPE("history.jump");
+    GameOutcome before = rules.Outcome();
+    historyChanges.clear();
+    history->Jump(version, board, &historyChanges);
+
+    // Правила меняются только по измененным клеткам: снятие и ход пересчитывают по 4 линии
+    std::size_t cells = 0;
+    for (const HistoryChange& change : historyChanges) {
+        regions.SyncCell(change.wordCol * Board::CellsPerWord, change.row);  // Участок сверяется один раз на слово
+        ForEachChangedCell(change, [&](int col, int row, Mark was, Mark now) {
+            if (journal) journal->Append(now == Mark::Empty ? JournalOp::Clear : JournalOp::Place, col, row, now);
+            if (was != Mark::Empty) rules.Remove(col, row);
+            if (now != Mark::Empty) rules.Place(col, row, now);
+            if (++cells <= MaxDamageRects) InvalidateCell(col, row);
+        });
+    }
+    if (cells > MaxDamageRects) InvalidateAll();  // Столько прямоугольников всё равно слились бы в один
+    if (rules.Outcome() != before) return ControllerAction::GameOver;
+    return AiTurn() ? ControllerAction::AiTurn : ControllerAction::None;
+}
+
+ControllerAction GameController::Undo() {
+    if (!history || !history->CanUndo()) return ControllerAction::None;
+    std::size_t version = history->Position() - 1;
+    // Ответ компьютера отменяется вместе с ходом человека, иначе компьютер тут же сходит снова
+    if (aiEnabled && version > 0 && history->Move(version).mark == Mark::Cross) --version;
+    return JumpHistory(version);
+}
+
+ControllerAction GameController::Redo() {
+    if (!history || !history->CanRedo()) return ControllerAction::None;
+    std::size_t version = history->Position() + 1;
+    if (aiEnabled && version < history->Size() && history->Move(version).mark == Mark::Cross) ++version;
+    return JumpHistory(version);
+}
+
+ControllerAction GameController::RemoteChange(int col, int row) {
+    InvalidateCell(col, row);
+    regions.SyncCell(col, row);
+    GameOutcome before = rules.Outcome();
+    Mark mark = board.Get(col, row);
+    Mark known = rules.MarkAt(col, row);
+    if (known != mark) {
+        if (known != Mark::Empty) rules.Remove(col, row);  // Метку убрали или заменили
+        if (mark != Mark::Empty) rules.Place(col, row, mark);
+    }
+    return rules.Outcome() != before ? ControllerAction::GameOver : ControllerAction::None;
+}
+
+ControllerAction GameController::ApplyServerUpdates(const ServerUpdates& updates) {
+    GameOutcome before = rules.Outcome();
+    if (updates.joined) {
+        serverPlaying = true;
+        board = updates.board;
+        hasLastMove = false;
+        ResyncRules();
+        InvalidateAll();
+    }
+    // Клетку заняли раньше или партия уже решена: своя метка заменяется тем, что стоит на сервере
+    bool rolledBack = false;
+    for (const GameMove& move : updates.rejected) {
+        Mark actual = static_cast<Mark>(move.mark);
+        if (board.Get(move.col, move.row) == actual) continue;
+        if (board.Clear(move.col, move.row) && journal) journal->Append(JournalOp::Clear, move.col, move.row);
+        if (actual != Mark::Empty) board.Place(move.col, move.row, actual);
+        RemoteChange(move.col, move.row);
+        rolledBack = true;
+    }
+    // Клетка, занятая своим еще не отвеченным ходом, не трогается: если он проиграл, придет в rejected
+    for (const GameMove& move : updates.remote) {
+        if (board.Place(move.col, move.row, static_cast<Mark>(move.mark))) RemoteChange(move.col, move.row);
+    }
+    if (updates.lost) serverPlaying = false;  // Дальше ходы остаются только на локальном поле
+    if (updates.joined || rules.Outcome() != before) return ControllerAction::GameOver;
+    return rolledBack && AiTurn() ? ControllerAction::AiTurn : ControllerAction::None;  // Откатили ход компьютера
+}
+
+void GameController::InvalidateCell(int col, int row) {
+    frames.Invalidate(renderer.Heatmap() ? HeatmapDamageRect(col, row, view) : CellDamageRect(col, row, view));
+}
+
+void GameController::InvalidateAll() {
+    frames.InvalidateAll();
+}
+
+// Сдвиги за кадр складываются: уже нарисованное копируется одним сдвигом,
+// перерисовывается только открывшаяся полоса
+void GameController::Pan(int dx, int dy) {
+    if (dx == 0 && dy == 0) return;
+    view.Pan(dx, dy);
+    frames.Scroll(dx, dy);
+}
@@ -0,0 +1,132 @@
+﻿#pragma once
+#include <random>
+#include "AiSearch.h"
+#include "Board.h"
+#include "BoardHistory.h"
+#include "FrameScheduler.h"
+#include "GameRules.h"
+#include "InputTrace.h"
+#include "MoveJournal.h"
+#include "RegionCounter.h"
+#include "Renderer.h"
+#include "ServerSession.h"
+#include "Settings.h"
+#include "SharedBoard.h"
+#include "Viewport.h"
+
+// Что окно должно сделать после события (то, что без Win32 не выполнить)
+enum class ControllerAction : std::uint8_t {
+    None,
+    Quit,                  // Закрыть программу
+    OpenNotepad,           // Открыть Блокнот
+    DumpProfile,           // Сохранить замеры в файл
+    ToggleProfileOverlay,  // Показать или скрыть замеры поверх поля
+    ToggleTraceRecording,  // Начать или закончить запись трассы ввода
+    GameOver,              // Итог партии изменился: ход решил ее или отмена вернула в игру
+    AiTurn,                // Ходит компьютер: начать поиск хода
+    ToggleAi,              // Компьютерный соперник включен или выключен
+};
+
+// Логика игры без окна: разбирает события ввода, ставит метки, двигает и масштабирует поле,
+// меняет цвета и отмечает повреждения в FrameScheduler. WindowProc только переводит сообщения
+// в InputEvent, а режим воспроизведения подает события из трассы — поведение одно и то же
+class GameController {
+public:
+    GameController(Board& board, Renderer& renderer, FrameScheduler& frames);
+
+    // Журнал ходов и общее поле необязательны (nullptr — не используются)
+    void SetJournal(MoveJournal* journal) { this->journal = journal; }
+    void SetSharedBoard(SharedBoard* shared) { sharedBoard = shared; }
+    void SetServerSession(ServerSession* session) { serverSession = session; }
+    // История для отмены и повтора (Ctrl+Z / Ctrl+Y). На общем поле и на сервере не подключается:
+    // чужие ходы в нее не попадают
+    void SetHistory(BoardHistory* history) { this->history = history; }
+    // Зерно для случайного цвета фона (Enter), чтобы воспроизведение было повторяемым
+    void SetRandomSeed(unsigned seed) { random.seed(seed); }
+
+    // Применяет настройки (при запуске и после перечитывания settings.ini). keys — какие ключи
+    // брать из fresh: остальные, включая масштаб и цвет сетки, измененные мышью, не трогаются.
+    // Масштаб меняется относительно центра окна, размер окна контроллер только запоминает
+    void ApplySettings(const Settings& fresh, std::uint32_t keys = AllSettingsKeys);
+
+    // Обрабатывает одно событие ввода
+    ControllerAction Handle(const InputEvent& event);
+
+    // Ставит метку на поле, учитывает ее в правилах и записывает ход в журнал. На общем поле
+    // клетку сначала занимаем в общей памяти: если другой экземпляр успел раньше, ход не засчитывается.
+    // На сервер ход уходит после постановки, не дожидаясь ответа; пока поле сервера не пришло, меток не ставим
+    bool PlaceMark(int col, int row, Mark mark);
+
+    // Переходит к версии истории (числу ходов от ее начала): поле, правила, журнал и перерисовка.
+    // Пока компьютер ищет ход, история не двигается
+    ControllerAction JumpHistory(std::size_t version);
+    // Отменяет или повторяет ход. С компьютерным соперником — вместе с его ответом
+    ControllerAction Undo();
+    ControllerAction Redo();
+
+    // Клетку изменил другой экземпляр (поле уже обновлено): перерисовка и правила
+    ControllerAction RemoteChange(int col, int row);
+    // Новости потока сессии сервера: поле после подключения, откат непринятых ходов и ходы других клиентов
+    ControllerAction ApplyServerUpdates(const ServerUpdates& updates);
+    // Пересчитывает правила и счетчик меток по всему полю (после загрузки или полной синхронизации)
+    void ResyncRules() {
+        rules.Rebuild(board);
+        regions.Rebuild();
+    }
+    GameOutcome Outcome() const { return rules.Outcome(); }
+    const GameRules& Rules() const { return rules; }
+    // Числа меток в прямоугольниках поля (по ним рисуется тепловая карта, F3)
+    const RegionCounter& Regions() const { return regions; }
+    bool HeatmapEnabled() const { return renderer.Heatmap() != nullptr; }
+
+    // Компьютер играет крестами (F2): пока он думает, клики не ставят меток, правая кнопка отключена
+    bool AiEnabled() const { return aiEnabled; }
+    // Очередь компьютера: партия не решена и кругов больше, чем крестов
+    bool AiTurn() const;
+    // Снимок позиции вокруг последнего хода для поиска
+    AiPosition AiSnapshot() const;
+    // Ставит крест, найденный поиском. Если клетку успели занять, снова возвращает AiTurn
+    ControllerAction PlaceAiMove(int col, int row);
+
+    void InvalidateCell(int col, int row);  // Перерисовать одну клетку
+    void InvalidateAll();                   // Перерисовать всё окно
+    void Pan(int dx, int dy);               // Сдвинуть видимую часть поля
+
+    const Viewport& View() const { return view; }
+    int Width() const { return width; }
+    int Height() const { return height; }
+    // Последние примененные настройки (как в файле, без изменений мышью)
+    const Settings& AppliedSettings() const { return settings; }
+    // Текущее состояние для сохранения: масштаб, размер окна и цвета
+    Settings CurrentSettings() const;
+
+private:
+    void HandleWheel(const InputEvent& event);
+    ControllerAction HandleKey(const InputEvent& event);
+
+    Board& board;
+    Renderer& renderer;
+    FrameScheduler& frames;
+    GameRules rules;  // Поиск собранных линий
+    RegionCounter regions;  // Числа меток по участкам для запросов по прямоугольникам
+    MoveJournal* journal = nullptr;
+    SharedBoard* sharedBoard = nullptr;
+    ServerSession* serverSession = nullptr;
+    bool serverPlaying = false;  // Поле сервера получено: ходы уходят на сервер
+    BoardHistory* history = nullptr;
+    std::vector<HistoryChange> historyChanges;  // Буфер изменений перехода (переиспользуется)
+
+    Settings settings = DefaultSettings();
+    Viewport view;               // Видимая часть поля: сдвиг и размер ячейки сетки
+    Color gridLineColor = settings.gridLineColor;
+    int width = settings.windowWidth;    // Размер клиентской области
+    int height = settings.windowHeight;
+    bool panning = false;        // Поле перетаскивается средней кнопкой мыши
+    int panFromX = 0;            // Последняя точка перетаскивания
+    int panFromY = 0;
+    std::minstd_rand random;     // Случайный цвет фона
+    bool aiEnabled = false;      // Кресты за компьютером
+    bool hasLastMove = false;    // Последний ход этого запуска (вокруг него ищет компьютер)
+    int lastCol = 0;
+    int lastRow = 0;
+};
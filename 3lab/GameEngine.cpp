@@ -0,0 +1,87 @@
+﻿#include "GameEngine.h"
+
+GameEngine::GameEngine(unsigned int shards, int winLength, std::size_t maxGames)
+    : shards(new Shard[shards > 0 ? shards : 1]), shardCount(shards > 0 ? shards : 1), winLength(winLength), maxGames(maxGames) {
+}
+
+GameMoveResult GameEngine::Place(Shard& shard, const GameMove& move) {
+    GameMoveResult result = {};
+    Mark mark = static_cast<Mark>(move.mark);
+    if (mark != Mark::Circle && mark != Mark::Cross) {
+        result.status = static_cast<std::uint8_t>(MoveStatus::BadMark);  // Партию из-за ошибочного хода не заводим
+        return result;
+    }
+
+    auto it = shard.games.find(move.board);
+    if (it == shard.games.end()) {
+        // Партия создается при первом ходе, если предел партий не достигнут
+        if (games.fetch_add(1, std::memory_order_relaxed) >= maxGames) {
+            games.fetch_sub(1, std::memory_order_relaxed);
+            result.status = static_cast<std::uint8_t>(MoveStatus::NoRoom);
+            return result;
+        }
+        it = shard.games.emplace(move.board, std::make_unique<Game>(winLength)).first;
+    }
+    std::unique_ptr<Game>& game = it->second;
+    result.version = static_cast<std::uint32_t>(game->history.size());
+    if (game->rules.Outcome() != GameOutcome::None) {
+        result.status = static_cast<std::uint8_t>(MoveStatus::Finished);
+    }
+    else if (!game->board.Place(move.col, move.row, mark)) {
+        result.status = static_cast<std::uint8_t>(MoveStatus::Occupied);
+    }
+    else {
+        game->rules.Place(move.col, move.row, mark);
+        game->history.push_back(move);
+        ++shard.moves;
+        result.version = static_cast<std::uint32_t>(game->history.size());
+        result.status = static_cast<std::uint8_t>(MoveStatus::Placed);
+    }
+    result.outcome = static_cast<std::uint8_t>(game->rules.Outcome());
+    return result;
+}
+
+void GameEngine::Apply(const GameMove* moves, std::size_t count, GameMoveResult* results) {
+    std::size_t i = 0;
+    while (i < count) {
+        Shard& shard = ShardOf(moves[i].board);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        do {
+            results[i] = Place(shard, moves[i]);
+            ++i;
+        } while (i < count && &ShardOf(moves[i].board) == &shard);
+    }
+}
+
+std::uint32_t GameEngine::History(std::uint32_t board, std::uint32_t since, std::vector<GameMove>& out, std::size_t limit) const {
+    out.clear();
+    Shard& shard = ShardOf(board);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.games.find(board);
+    if (it == shard.games.end()) return 0;
+
+    const std::vector<GameMove>& history = it->second->history;
+    if (since < history.size()) {
+        std::size_t count = history.size() - since < limit ? history.size() - since : limit;
+        out.assign(history.begin() + since, history.begin() + since + count);
+    }
+    return static_cast<std::uint32_t>(history.size());
+}
+
+std::size_t GameEngine::Boards() const {
+    std::size_t total = 0;
+    for (unsigned int i = 0; i < shardCount; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        total += shards[i].games.size();
+    }
+    return total;
+}
+
+std::uint64_t GameEngine::Moves() const {
+    std::uint64_t total = 0;
+    for (unsigned int i = 0; i < shardCount; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        total += shards[i].moves;
+    }
+    return total;
+}
@@ -0,0 +1,63 @@
+﻿#pragma once
+#include <cstddef>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Board.h"
+#include "GameProtocol.h"
+#include "GameRules.h"
+#include "Settings.h"
+
+const unsigned int DefaultGameShards = 64;  // Шардов по умолчанию: заметно больше рабочих потоков сервера
+const std::size_t DefaultMaxGames = 65536;  // Партий по умолчанию не больше: каждая держит поле и историю в памяти
+
+// Партии сервера без сети. Партии разложены по шардам по номеру (board % shards), у каждого шарда
+// свой мьютекс, так что ходы в разные партии почти никогда не ждут друг друга. Глобальной блокировки нет.
+// Число партий ограничено maxGames: ход в новую партию сверх предела получает MoveStatus::NoRoom
+class GameEngine {
+public:
+    explicit GameEngine(unsigned int shards = DefaultGameShards, int winLength = DEFAULT_WIN_LENGTH,
+        std::size_t maxGames = DefaultMaxGames);
+
+    GameEngine(const GameEngine&) = delete;
+    GameEngine& operator=(const GameEngine&) = delete;
+
+    // Применяет ходы по порядку и пишет результат каждого в results[i].
+    // Подряд идущие ходы одного шарда делаются под одной блокировкой
+    void Apply(const GameMove* moves, std::size_t count, GameMoveResult* results);
+
+    // Копирует в out до limit ходов партии начиная с номера since. Возвращает число ходов в партии
+    std::uint32_t History(std::uint32_t board, std::uint32_t since, std::vector<GameMove>& out, std::size_t limit) const;
+
+    // Число партий и принятых ходов (обходит все шарды, для сводок)
+    std::size_t Boards() const;
+    std::uint64_t Moves() const;
+
+private:
+    struct Game {
+        Board board;
+        GameRules rules;
+        std::vector<GameMove> history;  // Принятые ходы по порядку: по ним клиенты догоняют партию
+
+        explicit Game(int winLength) : rules(winLength) {}
+    };
+
+    // Шард на своей строке кэша, чтобы мьютексы соседних шардов не делили ее между ядрами
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::uint32_t, std::unique_ptr<Game>> games;
+        std::uint64_t moves = 0;
+    };
+
+    Shard& ShardOf(std::uint32_t board) const { return shards[board % shardCount]; }
+    GameMoveResult Place(Shard& shard, const GameMove& move);
+
+    std::unique_ptr<Shard[]> shards;
+    unsigned int shardCount;
+    int winLength;
+    std::size_t maxGames;
+    std::atomic<std::size_t> games{ 0 };  // Заведено партий во всех шардах
+};
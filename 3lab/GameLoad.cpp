@@ -0,0 +1,85 @@
+﻿#include "GameLoad.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+#include "GameClient.h"
+
+GameLoadResult RunGameLoad(const std::string& path, unsigned int clients, std::uint32_t boards, unsigned int batch, double seconds) {
+    typedef std::chrono::steady_clock Clock;
+
+    GameLoadResult result;
+    result.clients = clients;
+    if (clients == 0 || boards == 0 || batch == 0 || batch > GameMaxBatch) return result;
+
+    // Сначала подключаются все клиенты, чтобы нагрузка начиналась одновременно
+    std::vector<GameClient> connections(clients);
+    for (GameClient& client : connections) {
+        if (!client.Connect(path)) return result;
+    }
+    result.connected = true;
+
+    struct ClientStats {
+        std::uint64_t batches = 0;
+        std::uint64_t placed = 0;
+        std::vector<float> latencies;  // Микросекунды на пачку
+    };
+    std::vector<ClientStats> stats(clients);
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < clients; ++i) {
+        threads.emplace_back([&, i] {
+            std::mt19937 random(i + 1);
+            std::uniform_int_distribution<std::uint32_t> board(0, boards - 1);
+            std::uniform_int_distribution<int> cell(-512, 511);
+            std::vector<GameMove> moves(batch);
+            std::vector<GameMoveResult> results(batch);
+            ClientStats& own = stats[i];
+            own.latencies.reserve(1 << 16);
+            while (Clock::now() < deadline) {
+                for (GameMove& move : moves) {
+                    move = { board(random), cell(random), cell(random), static_cast<std::uint8_t>(random() % 2 ? Mark::Cross : Mark::Circle), {} };
+                }
+                Clock::time_point sent = Clock::now();
+                if (!connections[i].Send(moves.data(), moves.size(), results.data())) break;
+                own.latencies.push_back(std::chrono::duration<float, std::micro>(Clock::now() - sent).count());
+                ++own.batches;
+                for (const GameMoveResult& moveResult : results) {
+                    if (moveResult.status == static_cast<std::uint8_t>(MoveStatus::Placed)) ++own.placed;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<float> latencies;
+    for (const ClientStats& own : stats) {
+        result.batches += own.batches;
+        result.placed += own.placed;
+        latencies.insert(latencies.end(), own.latencies.begin(), own.latencies.end());
+    }
+    result.moves = result.batches * batch;
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        result.p50Us = latencies[latencies.size() / 2];
+        result.p99Us = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+        result.maxUs = latencies.back();
+    }
+    return result;
+}
+
+std::string FormatGameLoad(const GameLoadResult& result) {
+    char text[256];
+    std::snprintf(text, sizeof(text),
+        "clients %u: %llu moves in %.2f s: %.0f moves/s (%llu placed), %llu batches\n"
+        "batch latency us: p50 %.1f p99 %.1f max %.1f\n",
+        result.clients, static_cast<unsigned long long>(result.moves), result.seconds, result.MovesPerSecond(),
+        static_cast<unsigned long long>(result.placed), static_cast<unsigned long long>(result.batches),
+        result.p50Us, result.p99Us, result.maxUs);
+    return text;
+}
@@ -0,0 +1,25 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+
+// Итог нагрузки на сервер партий
+struct GameLoadResult {
+    unsigned int clients = 0;
+    std::uint64_t batches = 0;   // Отправлено пачек ходов (каждая — один запрос и один ответ)
+    std::uint64_t moves = 0;     // Отправлено ходов
+    std::uint64_t placed = 0;    // Из них принято сервером
+    double seconds = 0;
+    double p50Us = 0;            // Задержка пачки: от отправки до полученного ответа
+    double p99Us = 0;
+    double maxUs = 0;
+    bool connected = false;      // Все клиенты подключились
+
+    double MovesPerSecond() const { return seconds > 0 ? moves / seconds : 0; }
+};
+
+// clients потоков, у каждого свое соединение, seconds секунд шлют пачки по batch случайных ходов
+// в случайные партии из boards. Клетки берутся из квадрата 1024x1024, так что партии
+// почти не кончаются, а занятые клетки встречаются редко
+GameLoadResult RunGameLoad(const std::string& path, unsigned int clients, std::uint32_t boards, unsigned int batch, double seconds);
+
+std::string FormatGameLoad(const GameLoadResult& result);
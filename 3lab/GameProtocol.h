@@ -0,0 +1,67 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Протокол сервера партий (3lab-server) поверх локального сокета (AF_UNIX).
+// Сообщение — заголовок и count записей фиксированного размера, без разбора текста.
+// Клиент шлет Moves или Fetch и ждет ответ (Results или History) того же порядка
+
+const char GameServerSocket[] = "3lab.sock";  // Путь сокета по умолчанию (в рабочем каталоге)
+const std::uint32_t GameMaxBatch = 4096;      // Наибольшее число записей в одном сообщении
+
+enum class GameMessage : std::uint32_t {
+    Moves = 1,    // Клиент: count записей GameMove
+    Fetch = 2,    // Клиент: одна запись GameFetch
+    Results = 3,  // Сервер: count записей GameMoveResult, по одной на ход в том же порядке
+    History = 4,  // Сервер: count записей GameMove — ходы партии начиная с GameFetch::since
+};
+
+// Что сервер сделал с ходом
+enum class MoveStatus : std::uint8_t {
+    Placed = 1,    // Метка поставлена
+    Occupied = 2,  // Клетка занята
+    Finished = 3,  // Партия уже решена, ходы не принимаются
+    BadMark = 4,   // Метка не круг и не крест
+    NoRoom = 5,    // Новая партия не заведена: на сервере уже наибольшее число партий
+};
+
+#pragma pack(push, 1)
+struct GameMessageHeader {
+    std::uint32_t type;   // GameMessage
+    std::uint32_t count;  // Число записей после заголовка
+};
+
+struct GameMove {
+    std::uint32_t board;  // Номер партии: партии создаются при первом ходе
+    std::int32_t col;
+    std::int32_t row;
+    std::uint8_t mark;    // Mark
+    std::uint8_t reserved[3];
+};
+
+struct GameMoveResult {
+    std::uint32_t version;  // Ходов в партии после этого хода
+    std::uint8_t status;    // MoveStatus
+    std::uint8_t outcome;   // GameOutcome после хода
+    std::uint16_t reserved;
+};
+
+struct GameFetch {
+    std::uint32_t board;
+    std::uint32_t since;  // Сколько ходов партии клиент уже знает
+};
+#pragma pack(pop)
+
+static_assert(sizeof(GameMove) == 16, "ходы должны быть по 16 байт");
+static_assert(sizeof(GameMoveResult) == 8, "ответы на ходы должны быть по 8 байт");
+
+// Размер записи сообщения данного типа (0 — неизвестный тип)
+inline std::size_t GameRecordSize(std::uint32_t type) {
+    switch (static_cast<GameMessage>(type)) {
+    case GameMessage::Moves: return sizeof(GameMove);
+    case GameMessage::Fetch: return sizeof(GameFetch);
+    case GameMessage::Results: return sizeof(GameMoveResult);
+    case GameMessage::History: return sizeof(GameMove);
+    default: return 0;
+    }
+}
@@ -0,0 +1,289 @@
+﻿#include "GameRules.h"
+#include <algorithm>
+#include "Bits.h"
+
+// Направления линий: строка, столбец, диагональ вниз-вправо, диагональ вверх-вправо
+static const int DirCol[4] = { 1, 0, 1, 1 };
+static const int DirRow[4] = { 0, 1, 1, -1 };
+
+static const std::size_t InitialSegments = 256;
+
+// Номер линии и позиция клетки на ней. Для диагоналей номер — разность или сумма координат,
+// поэтому он считается в 64 битах
+static void LinePosition(int direction, int col, int row, std::int64_t& line, std::int64_t& pos) {
+    switch (direction) {
+    case 0: line = row; pos = col; break;
+    case 1: line = col; pos = row; break;
+    case 2: line = static_cast<std::int64_t>(col) - row; pos = col; break;
+    default: line = static_cast<std::int64_t>(col) + row; pos = col; break;
+    }
+}
+
+// Ключ отрезка: направление (2 бита), номер линии со смещением (34 бита), номер отрезка (26 бит)
+static std::uint64_t SegmentKey(int direction, std::int64_t line, std::int64_t segment) {
+    return (static_cast<std::uint64_t>(direction) << 60)
+        | ((static_cast<std::uint64_t>(line + (std::int64_t(1) << 33)) & ((std::uint64_t(1) << 34) - 1)) << 26)
+        | (static_cast<std::uint64_t>(segment) & ((std::uint64_t(1) << 26) - 1));
+}
+
+// Сколько окон из n клеток, целиком лежащих в серии, проходит через клетку. up и down — длина
+// серии от клетки вверх и вниз вместе с ней; окна через клетку не выходят дальше n - 1 от нее
+static int WindowsInRun(int up, int down, int n) {
+    int cells = std::min(up, n) + std::min(down, n) - 1;
+    return std::max(0, cells - n + 1);
+}
+
+static std::size_t SlotOf(std::uint64_t key, std::size_t mask) {
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDull;
+    key ^= key >> 33;
+    return static_cast<std::size_t>(key) & mask;
+}
+
+GameRules::GameRules(int winLength) : winLength(std::max(MinWinLength, std::min(MaxWinLength, winLength))) {
+    table.resize(InitialSegments);
+}
+
+bool GameRules::SetBounds(int newCols, int newRows) {
+    bool bounded = newCols > 0 && newRows > 0;
+    if (bounded && (newCols > MaxBoundedSize || newRows > MaxBoundedSize)) return false;
+    cols = bounded ? newCols : 0;
+    rows = bounded ? newRows : 0;
+
+    // Линии ограниченного поля и окна на них считаются один раз
+    lineBase[0] = 0;                    // Строки: бит — столбец
+    lineBase[1] = rows;                 // Столбцы: бит — строка
+    lineBase[2] = rows + cols;          // Диагонали вниз-вправо: col - row + rows - 1, бит — столбец
+    lineBase[3] = rows + cols + (bounded ? cols + rows - 1 : 0);  // Вверх-вправо: col + row, бит — столбец
+    lines.assign(bounded ? static_cast<std::size_t>(lineBase[3] + cols + rows - 1) : 0, DenseLine{ 0, 0 });
+    auto starts = [this](int lo, int hi) {
+        // Окна с началом в [lo, hi - winLength + 1] целиком лежат на клетках [lo, hi] линии
+        int last = hi - winLength + 1;
+        if (last < lo) return std::uint64_t(0);
+        std::uint64_t upper = last >= 63 ? ~std::uint64_t(0) : (std::uint64_t(1) << (last + 1)) - 1;
+        return upper & ~((std::uint64_t(1) << lo) - 1);
+    };
+    for (int row = 0; row < rows; ++row) lines[lineBase[0] + row].validStarts = starts(0, cols - 1);
+    for (int col = 0; col < cols; ++col) lines[lineBase[1] + col].validStarts = starts(0, rows - 1);
+    for (int k = 0; k < cols + rows - 1; ++k) {
+        int diff = k - (rows - 1);  // col - row
+        lines[lineBase[2] + k].validStarts = starts(std::max(0, diff), std::min(cols - 1, rows - 1 + diff));
+        lines[lineBase[3] + k].validStarts = starts(std::max(0, k - (rows - 1)), std::min(cols - 1, k));
+    }
+    totalWindows = 0;
+    for (const DenseLine& line : lines) totalWindows += PopCount(line.validStarts);
+
+    Reset();
+    return true;
+}
+
+void GameRules::SetWinLength(int newWinLength) {
+    winLength = std::max(MinWinLength, std::min(MaxWinLength, newWinLength));
+    SetBounds(cols, rows);  // Окна на линиях зависят от длины
+}
+
+void GameRules::Reset() {
+    outcome = GameOutcome::None;
+    fullWindows[0] = fullWindows[1] = 0;
+    if (cols > 0) {
+        for (auto& words : dense) words.assign(lines.size(), 0);
+        for (DenseLine& line : lines) line.dead = 0;
+        liveWindows = totalWindows;
+        if (liveWindows == 0) outcome = GameOutcome::Draw;  // Поле меньше линии
+        return;
+    }
+
+    used = 0;
+    // Старые записи становятся невидимыми без очистки таблицы
+    if (++generation == 0) {
+        for (Segment& segment : table) segment.generation = 0;
+        generation = 1;
+    }
+    liveWindows = 0;
+}
+
+void GameRules::Rebuild(const Board& board) {
+    Reset();
+    board.ForEach([this](int col, int row, Mark mark) { Place(col, row, mark); });
+}
+
+GameRules::Segment& GameRules::Find(std::uint64_t key) {
+    if ((used + 1) * 2 > table.size()) Grow();  // Не больше половины заполнения
+    std::size_t mask = table.size() - 1;
+    for (std::size_t slot = SlotOf(key, mask);; slot = (slot + 1) & mask) {
+        Segment& segment = table[slot];
+        if (segment.generation != generation) {
+            segment = { key, generation, { 0, 0 } };
+            ++used;
+            return segment;
+        }
+        if (segment.key == key) return segment;
+    }
+}
+
+const GameRules::Segment* GameRules::Lookup(std::uint64_t key) const {
+    std::size_t mask = table.size() - 1;
+    for (std::size_t slot = SlotOf(key, mask);; slot = (slot + 1) & mask) {
+        const Segment& segment = table[slot];
+        if (segment.generation != generation) return nullptr;
+        if (segment.key == key) return &segment;
+    }
+}
+
+void GameRules::Grow() {
+    std::vector<Segment> old(table.size() * 2);
+    old.swap(table);
+    std::size_t mask = table.size() - 1;
+    for (const Segment& segment : old) {
+        if (segment.generation != generation) continue;
+        std::size_t slot = SlotOf(segment.key, mask);
+        while (table[slot].generation == generation) slot = (slot + 1) & mask;
+        table[slot] = segment;
+    }
+}
+
+// Собранные окна игрока через занятую им клетку pos линии. word — отрезок, в котором лежит клетка
+int GameRules::WindowsThrough(int direction, std::int64_t line, std::int64_t pos, int player, std::uint64_t word) const {
+    std::int64_t segment = pos >> 6;
+    int bit = static_cast<int>(pos & 63);
+
+    int up = CountTrailingOnes(word >> bit);          // Вместе с самой клеткой
+    int down = CountLeadingOnes(word << (63 - bit));  // Тоже вместе с ней
+
+    // Серия уперлась в край слова, не набрав длины окна, — продолжение лежит в соседнем отрезке
+    if (up < winLength && bit + up == 64) {
+        if (const Segment* next = Lookup(SegmentKey(direction, line, segment + 1))) up += CountTrailingOnes(next->bits[player]);
+    }
+    if (down < winLength && down == bit + 1) {
+        if (const Segment* prev = Lookup(SegmentKey(direction, line, segment - 1))) down += CountLeadingOnes(prev->bits[player]);
+    }
+    return WindowsInRun(up, down, winLength);
+}
+
+GameOutcome GameRules::Place(int col, int row, Mark mark) {
+    if (mark == Mark::Empty || !InBounds(col, row)) return outcome;
+    int player = mark == Mark::Circle ? 0 : 1;
+
+    std::size_t windows = cols > 0 ? PlaceDense(col, row, player) : PlaceSparse(col, row, player);
+    fullWindows[player] += windows;
+    if (windows > 0 && (outcome == GameOutcome::None || outcome == GameOutcome::Draw)) {
+        outcome = player == 0 ? GameOutcome::CircleWins : GameOutcome::CrossWins;
+    }
+    else if (outcome == GameOutcome::None && cols > 0 && liveWindows == 0) {
+        outcome = GameOutcome::Draw;
+    }
+    return outcome;
+}
+
+GameOutcome GameRules::Remove(int col, int row) {
+    Mark mark = MarkAt(col, row);
+    if (mark == Mark::Empty) return outcome;
+    int player = mark == Mark::Circle ? 0 : 1;
+    fullWindows[player] -= cols > 0 ? RemoveDense(col, row, player) : RemoveSparse(col, row, player);
+
+    // Линия победителя разрушена: из оставшихся линий первой собрана линия соперника
+    int winner = outcome == GameOutcome::CircleWins ? 0 : outcome == GameOutcome::CrossWins ? 1 : -1;
+    if (winner >= 0 && fullWindows[winner] == 0) {
+        outcome = fullWindows[1 - winner] == 0 ? GameOutcome::None
+            : winner == 0 ? GameOutcome::CrossWins : GameOutcome::CircleWins;
+    }
+    // Освободившаяся клетка может оживить окна
+    if (outcome == GameOutcome::Draw && liveWindows > 0) outcome = GameOutcome::None;
+    else if (outcome == GameOutcome::None && cols > 0 && liveWindows == 0) outcome = GameOutcome::Draw;
+    return outcome;
+}
+
+Mark GameRules::MarkAt(int col, int row) const {
+    if (!InBounds(col, row)) return Mark::Empty;
+    std::uint64_t bits[2];
+    if (cols > 0) {
+        for (int player = 0; player < 2; ++player) bits[player] = dense[player][static_cast<std::size_t>(lineBase[0] + row)] >> col;
+    }
+    else {
+        const Segment* segment = Lookup(SegmentKey(0, row, col >> 6));
+        if (!segment) return Mark::Empty;
+        for (int player = 0; player < 2; ++player) bits[player] = segment->bits[player] >> (col & 63);
+    }
+    if (bits[0] & 1) return Mark::Circle;
+    if (bits[1] & 1) return Mark::Cross;
+    return Mark::Empty;
+}
+
+std::size_t GameRules::PlaceSparse(int col, int row, int player) {
+    std::size_t windows = 0;
+    for (int d = 0; d < 4; ++d) {
+        std::int64_t line, pos;
+        LinePosition(d, col, row, line, pos);
+        Segment& segment = Find(SegmentKey(d, line, pos >> 6));
+        std::uint64_t& word = segment.bits[player];
+        word |= std::uint64_t(1) << (pos & 63);
+        windows += WindowsThrough(d, line, pos, player, word);
+    }
+    return windows;
+}
+
+std::size_t GameRules::RemoveSparse(int col, int row, int player) {
+    std::size_t windows = 0;
+    for (int d = 0; d < 4; ++d) {
+        std::int64_t line, pos;
+        LinePosition(d, col, row, line, pos);
+        Segment& segment = Find(SegmentKey(d, line, pos >> 6));  // Клетка занята, отрезок уже есть
+        std::uint64_t& word = segment.bits[player];
+        windows += WindowsThrough(d, line, pos, player, word);  // Окна через клетку — до снятия
+        word &= ~(std::uint64_t(1) << (pos & 63));
+    }
+    return windows;
+}
+
+// Начала окон линии, в которых есть хоть одна метка: бит i, если занят любой из битов i..i+N-1
+std::uint64_t GameRules::Spread(std::uint64_t word) const {
+    int span = 1;
+    while (span * 2 <= winLength) {
+        word |= word >> span;
+        span *= 2;
+    }
+    if (span < winLength) word |= word >> (winLength - span);
+    return word;
+}
+
+std::size_t GameRules::PlaceDense(int col, int row, int player) {
+    const int index[4] = { row, col, col - row + rows - 1, col + row };
+    const int bits[4] = { col, row, col, col };
+    std::size_t windows = 0;
+    for (int d = 0; d < 4; ++d) {
+        std::size_t line = static_cast<std::size_t>(lineBase[d] + index[d]);
+        int bit = bits[d];
+        std::uint64_t& word = dense[player][line];
+        word |= std::uint64_t(1) << bit;
+
+        // Серия через новую метку: единицы от ее бита вверх и вниз (сама клетка посчитана в обеих)
+        windows += WindowsInRun(CountTrailingOnes(word >> bit), CountLeadingOnes(word << (63 - bit)), winLength);
+
+        // Окна, где теперь есть метки обоих игроков, больше никто не соберет
+        DenseLine& info = lines[line];
+        std::uint32_t dead = PopCount(Spread(dense[0][line]) & Spread(dense[1][line]) & info.validStarts);
+        liveWindows -= dead - info.dead;
+        info.dead = dead;
+    }
+    return windows;
+}
+
+std::size_t GameRules::RemoveDense(int col, int row, int player) {
+    const int index[4] = { row, col, col - row + rows - 1, col + row };
+    const int bits[4] = { col, row, col, col };
+    std::size_t windows = 0;
+    for (int d = 0; d < 4; ++d) {
+        std::size_t line = static_cast<std::size_t>(lineBase[d] + index[d]);
+        int bit = bits[d];
+        std::uint64_t& word = dense[player][line];
+        windows += WindowsInRun(CountTrailingOnes(word >> bit), CountLeadingOnes(word << (63 - bit)), winLength);
+        word &= ~(std::uint64_t(1) << bit);
+
+        // Окна могут ожить: мертвых на линии становится не больше, чем было
+        DenseLine& info = lines[line];
+        std::uint32_t dead = PopCount(Spread(dense[0][line]) & Spread(dense[1][line]) & info.validStarts);
+        liveWindows += info.dead - dead;
+        info.dead = dead;
+    }
+    return windows;
+}
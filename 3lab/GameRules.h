@@ -0,0 +1,107 @@
+﻿#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "Board.h"
+
+const int MinWinLength = 3;   // Крестики-нолики
+const int MaxWinLength = 16;  // Серия должна помещаться в два соседних 64-битных отрезка линии
+const int MaxBoundedSize = 64;  // Сторона ограниченного поля: линия целиком в одном слове
+
+// Итог партии
+enum class GameOutcome : std::uint8_t {
+    None,        // Партия продолжается
+    CircleWins,  // Круги собрали линию
+    CrossWins,   // Кресты собрали линию
+    Draw,        // Ни одна линия больше не может быть собрана
+};
+
+// Правила "N в ряд" на битбордах. Для каждого игрока каждая строка, столбец и обе диагонали
+// поля хранятся в 64-битных словах, бит — клетка линии. Ход ставит один бит в четырех словах,
+// а длина серии через новую метку считается сдвигом и маской: единицы подряд от бита хода
+// вверх и вниз. Поэтому проверка победы стоит O(1) на ход при любом размере поля.
+// Ограниченное поле (до MaxBoundedSize по стороне) лежит в плотных массивах линий, и для него
+// ведется ничья: окно из N клеток мертво, если в нем есть метки обоих игроков. Мертвые окна
+// линии — это (растяжка кругов) & (растяжка крестов), где растяжка за log N сдвигов отмечает
+// начала окон с хотя бы одной меткой. Ход пересчитывает только свои 4 линии, ничья — когда
+// живых окон не осталось. Бесконечное поле хранит линии отрезками по 64 клетки в хэш-таблице.
+// Для снятия меток (отмена хода) ведется число собранных окон каждого игрока: ход и снятие
+// меняют его на число окон через свою клетку, так что итог пересчитывается по тем же 4 линиям
+class GameRules {
+public:
+    explicit GameRules(int winLength = 5);
+
+    // Ограничивает поле прямоугольником [0, cols) x [0, rows): тогда считается ничья, а ходы
+    // вне поля не принимаются. 0 x 0 — поле бесконечно и ничьей не бывает. Сбрасывает партию.
+    // Возвращает false, если сторона больше MaxBoundedSize
+    bool SetBounds(int cols, int rows);
+    // Меняет длину выигрышной линии (MinWinLength..MaxWinLength). Сбрасывает партию
+    void SetWinLength(int winLength);
+    int WinLength() const { return winLength; }
+
+    // Начинает новую партию. Стоит O(1) для бесконечного поля и O(cols + rows) для ограниченного
+    void Reset();
+    // Заново учитывает все метки поля (после загрузки снимка или смены длины линии)
+    void Rebuild(const Board& board);
+
+    // Учитывает метку в свободной клетке. Возвращает итог партии после хода:
+    // первая собранная линия остается итогом, даже если партию продолжают
+    GameOutcome Place(int col, int row, Mark mark);
+    // Снимает метку с клетки и пересматривает итог по 4 линиям через нее. Если снятая метка
+    // разрушила последнюю линию победителя, итогом становится линия соперника (она собрана позже)
+    // или партия продолжается. Возвращает итог после снятия
+    GameOutcome Remove(int col, int row);
+    // Метка, учтенная в клетке
+    Mark MarkAt(int col, int row) const;
+    // Клетка внутри ограниченного поля (для бесконечного — любая)
+    bool InBounds(int col, int row) const {
+        return cols == 0 || (col >= 0 && row >= 0 && col < cols && row < rows);
+    }
+
+    GameOutcome Outcome() const { return outcome; }
+    std::size_t LiveWindows() const { return liveWindows; }  // Окна, которые еще может собрать хоть кто-то
+    // Окна из WinLength клеток, целиком занятые метками игрока
+    std::size_t FullWindows(Mark mark) const { return mark == Mark::Empty ? 0 : fullWindows[mark == Mark::Circle ? 0 : 1]; }
+
+private:
+    // Отрезок линии: по слову на игрока. generation отличает записи текущей партии от старых
+    struct Segment {
+        std::uint64_t key;
+        std::uint32_t generation;
+        std::uint64_t bits[2];
+    };
+
+    // Линия ограниченного поля: ее слова в dense и маска начал окон, целиком лежащих на линии
+    struct DenseLine {
+        std::uint64_t validStarts;
+        std::uint32_t dead;  // Мертвых окон на линии
+    };
+
+    Segment& Find(std::uint64_t key);
+    const Segment* Lookup(std::uint64_t key) const;
+    void Grow();
+    int WindowsThrough(int direction, std::int64_t line, std::int64_t pos, int player, std::uint64_t word) const;
+    std::size_t PlaceSparse(int col, int row, int player);
+    std::size_t PlaceDense(int col, int row, int player);
+    std::size_t RemoveSparse(int col, int row, int player);
+    std::size_t RemoveDense(int col, int row, int player);
+    std::uint64_t Spread(std::uint64_t word) const;
+
+    int winLength;
+    int cols = 0;
+    int rows = 0;
+    GameOutcome outcome = GameOutcome::None;
+    std::size_t fullWindows[2] = {};  // Собранные окна по игрокам
+
+    // Открытая адресация с линейным пробированием; размер — степень двойки
+    std::vector<Segment> table;
+    std::uint32_t generation = 1;
+    std::size_t used = 0;
+
+    // Ограниченное поле: линии всех направлений подряд (строки, столбцы, обе диагонали)
+    int lineBase[4] = {};              // Первая линия направления
+    std::vector<std::uint64_t> dense[2];  // Слова линий по игрокам
+    std::vector<DenseLine> lines;
+    std::size_t totalWindows = 0;
+    std::size_t liveWindows = 0;
+};
@@ -0,0 +1,263 @@
+﻿#include "GameServer.h"
+#include <cerrno>
+#include <cstring>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const int MaxEvents = 64;              // Событий за один epoll_wait
+static const std::size_t ReadChunk = 65536;   // Сколько читать из сокета за вызов read
+static const std::size_t MaxPendingInput = 4 << 20;  // Больше за один проход не читаем, остальное — в следующий
+static const std::size_t MaxPendingOutput = 1 << 20; // Столько неотправленных ответов — и запросы больше не разбираются
+
+struct GameServer::Connection {
+    int fd = -1;
+    std::vector<char> in;    // Принятые байты, еще не сложившиеся в целое сообщение
+    std::vector<char> out;   // Ответы, которые сокет пока не принял
+    std::size_t sent = 0;    // Сколько байтов out уже отправлено
+    bool blocked = false;    // Ждем EPOLLOUT и пока не читаем запросы
+};
+
+struct GameServer::Worker {
+    int epoll = -1;
+    std::thread thread;
+    std::unordered_map<int, Connection> connections;  // Соединения этого потока по дескриптору
+    // Память под разбор сообщений переиспользуется между сообщениями
+    std::vector<GameMove> moves;
+    std::vector<GameMoveResult> results;
+    std::vector<GameMove> history;
+};
+
+GameServer::GameServer(GameEngine& engine) : engine(engine) {
+}
+
+GameServer::~GameServer() {
+    Stop();
+}
+
+bool GameServer::Start(const std::string& socketPath, unsigned int workerCount) {
+    if (listenFd >= 0 || socketPath.size() >= sizeof(sockaddr_un::sun_path)) return false;
+    path = socketPath;
+    stopping = false;
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+    unlink(path.c_str());  // Файл сокета мог остаться от прошлого запуска
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (listenFd < 0 || wakeFd < 0
+        || bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || listen(listenFd, SOMAXCONN) != 0) {
+        Stop();
+        return false;
+    }
+
+    for (unsigned int i = 0; i < (workerCount > 0 ? workerCount : 1); ++i) {
+        std::unique_ptr<Worker> worker = std::make_unique<Worker>();
+        worker->epoll = epoll_create1(EPOLL_CLOEXEC);
+        epoll_event listenEvent = {};
+        listenEvent.events = EPOLLIN | EPOLLEXCLUSIVE;  // Новое соединение будит один поток, а не все
+        listenEvent.data.fd = listenFd;
+        epoll_event wakeEvent = {};
+        wakeEvent.events = EPOLLIN;
+        wakeEvent.data.fd = wakeFd;
+        if (worker->epoll < 0
+            || epoll_ctl(worker->epoll, EPOLL_CTL_ADD, listenFd, &listenEvent) != 0
+            || epoll_ctl(worker->epoll, EPOLL_CTL_ADD, wakeFd, &wakeEvent) != 0) {
+            if (worker->epoll >= 0) close(worker->epoll);
+            Stop();
+            return false;
+        }
+        workers.push_back(std::move(worker));
+    }
+    for (std::unique_ptr<Worker>& worker : workers) {
+        Worker* self = worker.get();
+        worker->thread = std::thread([this, self] { Run(*self); });
+    }
+    return true;
+}
+
+void GameServer::Stop() {
+    stopping = true;
+    if (wakeFd >= 0) {
+        std::uint64_t one = 1;
+        (void)!write(wakeFd, &one, sizeof(one));  // eventfd остается взведенным и будит все потоки
+    }
+    for (std::unique_ptr<Worker>& worker : workers) {
+        if (worker->thread.joinable()) worker->thread.join();
+        for (auto& entry : worker->connections) close(entry.first);
+        close(worker->epoll);
+    }
+    workers.clear();
+    connections = 0;
+
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(path.c_str());
+        listenFd = -1;
+    }
+    if (wakeFd >= 0) {
+        close(wakeFd);
+        wakeFd = -1;
+    }
+}
+
+void GameServer::Run(Worker& worker) {
+    epoll_event events[MaxEvents];
+    while (!stopping.load(std::memory_order_relaxed)) {
+        int count = epoll_wait(worker.epoll, events, MaxEvents, -1);
+        if (count < 0 && errno != EINTR) break;
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wakeFd) return;
+            if (fd == listenFd) {
+                Accept(worker);
+                continue;
+            }
+
+            auto it = worker.connections.find(fd);
+            if (it == worker.connections.end()) continue;
+            Connection& connection = it->second;
+            bool alive = (events[i].events & (EPOLLERR | EPOLLHUP)) == 0;
+            if (alive && (events[i].events & EPOLLOUT)) alive = Serve(worker, connection);
+            if (alive && (events[i].events & EPOLLIN)) alive = Receive(worker, connection);
+            if (!alive) Drop(worker, fd);
+        }
+    }
+}
+
+void GameServer::Accept(Worker& worker) {
+    for (;;) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;  // EAGAIN: очередь разобрана (или соединение принял другой поток)
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(worker.epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            continue;
+        }
+        worker.connections[fd].fd = fd;
+        connections.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool GameServer::Receive(Worker& worker, Connection& connection) {
+    // Читаем всё, что пришло: сокет неблокирующий, конец данных — EAGAIN
+    while (connection.in.size() < MaxPendingInput) {
+        std::size_t used = connection.in.size();
+        connection.in.resize(used + ReadChunk);
+        ssize_t n = read(connection.fd, connection.in.data() + used, ReadChunk);
+        connection.in.resize(used + (n > 0 ? static_cast<std::size_t>(n) : 0));
+        if (n == 0) return false;  // Клиент закрыл соединение
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+            break;
+        }
+    }
+    return Serve(worker, connection);
+}
+
+bool GameServer::Serve(Worker& worker, Connection& connection) {
+    // Process останавливается на MaxPendingOutput: после отправки разбираем остаток, пока клиент принимает ответы
+    for (;;) {
+        std::size_t pending = connection.in.size();
+        bool wasBlocked = connection.blocked;
+        if (!Process(worker, connection) || !Flush(worker, connection)) return false;
+        if (connection.blocked || (connection.in.size() == pending && !wasBlocked)) return true;
+    }
+}
+
+bool GameServer::Process(Worker& worker, Connection& connection) {
+    std::size_t offset = 0;
+    while (connection.in.size() - offset >= sizeof(GameMessageHeader)) {
+        // Клиент не читает ответы: запросы ждут во входном буфере, пока Flush не отправит накопленное
+        if (connection.blocked || connection.out.size() - connection.sent >= MaxPendingOutput) break;
+        GameMessageHeader header;
+        std::memcpy(&header, connection.in.data() + offset, sizeof(header));
+        std::size_t recordSize = GameRecordSize(header.type);
+        bool request = header.type == static_cast<std::uint32_t>(GameMessage::Moves)
+            || (header.type == static_cast<std::uint32_t>(GameMessage::Fetch) && header.count == 1);
+        if (!request || header.count > GameMaxBatch) return false;  // Чужой протокол: соединение закрывается
+
+        std::size_t length = sizeof(header) + header.count * recordSize;
+        if (connection.in.size() - offset < length) break;  // Сообщение пришло не целиком
+        const char* payload = connection.in.data() + offset + sizeof(header);
+
+        GameMessageHeader reply = {};
+        const char* body = nullptr;
+        std::size_t bodyBytes = 0;
+        if (header.type == static_cast<std::uint32_t>(GameMessage::Moves)) {
+            worker.moves.resize(header.count);
+            worker.results.resize(header.count);
+            std::memcpy(worker.moves.data(), payload, header.count * sizeof(GameMove));
+            engine.Apply(worker.moves.data(), header.count, worker.results.data());
+            reply = { static_cast<std::uint32_t>(GameMessage::Results), header.count };
+            body = reinterpret_cast<const char*>(worker.results.data());
+            bodyBytes = header.count * sizeof(GameMoveResult);
+        }
+        else {
+            GameFetch fetch;
+            std::memcpy(&fetch, payload, sizeof(fetch));
+            engine.History(fetch.board, fetch.since, worker.history, GameMaxBatch);
+            reply = { static_cast<std::uint32_t>(GameMessage::History), static_cast<std::uint32_t>(worker.history.size()) };
+            body = reinterpret_cast<const char*>(worker.history.data());
+            bodyBytes = worker.history.size() * sizeof(GameMove);
+        }
+
+        const char* replyBytes = reinterpret_cast<const char*>(&reply);
+        connection.out.insert(connection.out.end(), replyBytes, replyBytes + sizeof(reply));
+        connection.out.insert(connection.out.end(), body, body + bodyBytes);
+        if (connection.out.size() - connection.sent > peakOutput.load(std::memory_order_relaxed)) {
+            peakOutput.store(connection.out.size() - connection.sent, std::memory_order_relaxed);
+        }
+        offset += length;
+        messages.fetch_add(1, std::memory_order_relaxed);
+    }
+    connection.in.erase(connection.in.begin(), connection.in.begin() + offset);
+    return true;
+}
+
+bool GameServer::Flush(Worker& worker, Connection& connection) {
+    while (connection.sent < connection.out.size()) {
+        ssize_t n = send(connection.fd, connection.out.data() + connection.sent, connection.out.size() - connection.sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+            // Клиент не успевает читать: ждем EPOLLOUT и пока не принимаем новые запросы
+            if (connection.blocked) return true;
+            connection.blocked = true;
+            epoll_event event = {};
+            event.events = EPOLLOUT;
+            event.data.fd = connection.fd;
+            return epoll_ctl(worker.epoll, EPOLL_CTL_MOD, connection.fd, &event) == 0;
+        }
+        connection.sent += static_cast<std::size_t>(n);
+    }
+
+    connection.out.clear();
+    connection.sent = 0;
+    if (connection.blocked) {
+        connection.blocked = false;
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = connection.fd;
+        if (epoll_ctl(worker.epoll, EPOLL_CTL_MOD, connection.fd, &event) != 0) return false;
+    }
+    return true;
+}
+
+void GameServer::Drop(Worker& worker, int fd) {
+    epoll_ctl(worker.epoll, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    worker.connections.erase(fd);
+    connections.fetch_sub(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,59 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GameEngine.h"
+
+const unsigned int DefaultServerWorkers = 4;  // Рабочих потоков сервера по умолчанию
+
+// Сервер партий на локальном сокете (AF_UNIX, только Linux: epoll). Небольшое фиксированное число
+// рабочих потоков, у каждого свой epoll. Слушающий сокет стоит во всех epoll с EPOLLEXCLUSIVE:
+// соединение принимает один проснувшийся поток и дальше обслуживает его сам, так что соединения
+// между потоками не делятся и буферы не блокируются. Ходы уходят в GameEngine с блокировками по шардам.
+// Клиент, который шлет запросы, но не читает ответы, упирается в предел неотправленных ответов:
+// его запросы ждут во входном буфере, а новые не читаются, пока ответы не уйдут
+class GameServer {
+public:
+    explicit GameServer(GameEngine& engine);
+    ~GameServer();
+
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    // Создает сокет path (старый файл сокета удаляется) и запускает workers потоков
+    bool Start(const std::string& path, unsigned int workers = DefaultServerWorkers);
+    // Останавливает потоки, закрывает соединения и удаляет файл сокета
+    void Stop();
+
+    // Открытых соединений и обработанных сообщений (для сводок)
+    std::size_t Connections() const { return connections.load(std::memory_order_relaxed); }
+    std::uint64_t Messages() const { return messages.load(std::memory_order_relaxed); }
+    // Наибольший объем неотправленных ответов одного соединения
+    std::size_t PeakOutput() const { return peakOutput.load(std::memory_order_relaxed); }
+
+private:
+    struct Connection;
+    struct Worker;
+
+    void Run(Worker& worker);
+    void Accept(Worker& worker);
+    bool Receive(Worker& worker, Connection& connection);
+    bool Serve(Worker& worker, Connection& connection);
+    bool Process(Worker& worker, Connection& connection);
+    bool Flush(Worker& worker, Connection& connection);
+    void Drop(Worker& worker, int fd);
+
+    GameEngine& engine;
+    std::string path;
+    int listenFd = -1;
+    int wakeFd = -1;  // eventfd: будит потоки при остановке
+    std::atomic<bool> stopping{ false };
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<std::size_t> connections{ 0 };
+    std::atomic<std::uint64_t> messages{ 0 };
+    std::atomic<std::size_t> peakOutput{ 0 };
+};
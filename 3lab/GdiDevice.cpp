@@ -0,0 +1,94 @@
+﻿#include "GdiDevice.h"
+#include <vector>
+
+static_assert(sizeof(Point) == sizeof(POINT), "Point должен совпадать с POINT для PolyPolyline");
+static_assert(sizeof(std::uint32_t) == sizeof(DWORD), "счетчики точек передаются в PolyPolyline как DWORD");
+
+void GdiDevice::Attach(HDC dc) {
+    hdc = dc;
+    oldPen = GetCurrentObject(hdc, OBJ_PEN);
+    oldBrush = SelectObject(hdc, GetStockObject(NULL_BRUSH));  // Круги рисуются без заливки
+}
+
+void GdiDevice::Detach() {
+    // Возвращаем исходные объекты, чтобы наши перья можно было удалить в любой момент
+    SelectObject(hdc, oldPen);
+    SelectObject(hdc, oldBrush);
+    hdc = NULL;
+}
+
+GfxObject GdiDevice::CreatePenObject(Color color, int width) {
+    ++objectsCreated;
+    return reinterpret_cast<GfxObject>(CreatePen(PS_SOLID, width, color));
+}
+
+GfxObject GdiDevice::CreateBrushObject(Color color) {
+    ++objectsCreated;
+    return reinterpret_cast<GfxObject>(CreateSolidBrush(color));
+}
+
+GfxObject GdiDevice::CreatePatternObject(const Color* pixels, int width, int height) {
+    // Упакованный DIB: заголовок и строки снизу вверх по 32 бита (0x00RRGGBB). GDI копирует его
+    // в кисть, так что буфер можно освободить сразу
+    const std::size_t headerWords = sizeof(BITMAPINFOHEADER) / sizeof(std::uint32_t);
+    std::vector<std::uint32_t> dib(headerWords + static_cast<std::size_t>(width) * height);
+    BITMAPINFOHEADER* header = reinterpret_cast<BITMAPINFOHEADER*>(dib.data());
+    header->biSize = sizeof(BITMAPINFOHEADER);
+    header->biWidth = width;
+    header->biHeight = height;
+    header->biPlanes = 1;
+    header->biBitCount = 32;
+    header->biCompression = BI_RGB;
+    std::uint32_t* bits = dib.data() + headerWords;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) bits[static_cast<std::size_t>(height - 1 - y) * width + x] = Framebuffer::ToPixel(pixels[y * width + x]);
+    }
+    ++objectsCreated;
+    return reinterpret_cast<GfxObject>(CreateDIBPatternBrushPt(dib.data(), DIB_RGB_COLORS));
+}
+
+void GdiDevice::DestroyObject(GfxObject object) {
+    DeleteObject(reinterpret_cast<HGDIOBJ>(object));
+}
+
+void GdiDevice::SelectPenObject(GfxObject pen) {
+    SelectObject(hdc, reinterpret_cast<HGDIOBJ>(pen));
+}
+
+void GdiDevice::FillRectangle(const Rect& rect, GfxObject brush) {
+    RECT rc = ToRECT(rect);
+    FillRect(hdc, &rc, reinterpret_cast<HBRUSH>(brush));
+}
+
+void GdiDevice::FillPattern(const Rect& rect, GfxObject pattern, int originX, int originY) {
+    // Начало узора задается в координатах устройства, GDI сам берет его по модулю размера узора
+    SetBrushOrgEx(hdc, originX, originY, NULL);
+    RECT rc = ToRECT(rect);
+    FillRect(hdc, &rc, reinterpret_cast<HBRUSH>(pattern));
+}
+
+void GdiDevice::DrawPolyPolyline(const Point* points, const std::uint32_t* counts, std::size_t polylines) {
+    PolyPolyline(hdc, reinterpret_cast<const POINT*>(points), reinterpret_cast<const DWORD*>(counts), static_cast<DWORD>(polylines));
+}
+
+void GdiDevice::DrawEllipse(int left, int top, int right, int bottom) {
+    Ellipse(hdc, left, top, right, bottom);
+}
+
+void BlitFramebuffer(HDC hdc, const Framebuffer& frame, const Rect& area) {
+    int top = area.top > 0 ? area.top : 0;
+    int bottom = area.bottom < frame.Height() ? area.bottom : frame.Height();
+    if (top >= bottom || frame.Width() <= 0) return;
+
+    // Полоса строк [top, bottom) как отдельный DIB сверху вниз: так смещение по y не зависит
+    // от того, как GDI считает строки у DIB с отрицательной высотой
+    BITMAPINFO info = {};
+    info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    info.bmiHeader.biWidth = frame.Width();
+    info.bmiHeader.biHeight = -(bottom - top);
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
+    SetDIBitsToDevice(hdc, area.left, top, area.right - area.left, bottom - top, area.left, 0, 0, bottom - top,
+        frame.Row(top), &info, DIB_RGB_COLORS);
+}
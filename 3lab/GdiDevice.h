@@ -0,0 +1,43 @@
+﻿#pragma once
+#include <windows.h>
+#include "Framebuffer.h"
+#include "Graphics.h"
+
+// Преобразования между RECT и переносимым Rect
+inline Rect ToRect(const RECT& rc) {
+    return { static_cast<int>(rc.left), static_cast<int>(rc.top), static_cast<int>(rc.right), static_cast<int>(rc.bottom) };
+}
+inline RECT ToRECT(const Rect& rc) {
+    return { rc.left, rc.top, rc.right, rc.bottom };
+}
+
+// Выводит область area готового кадра в окно одним копированием (кадр совпадает с клиентской областью)
+void BlitFramebuffer(HDC hdc, const Framebuffer& frame, const Rect& area);
+
+// Вывод сцены через GDI. Объект живет всё время работы окна,
+// а контекст устройства подключается на время одного WM_PAINT
+class GdiDevice : public GraphicsDevice {
+public:
+    void Attach(HDC hdc);  // Подключает контекст и запоминает выбранные в нем объекты
+    void Detach();         // Возвращает контексту исходные объекты
+
+    GfxObject CreatePenObject(Color color, int width) override;
+    GfxObject CreateBrushObject(Color color) override;
+    GfxObject CreatePatternObject(const Color* pixels, int width, int height) override;
+    void DestroyObject(GfxObject object) override;
+    void SelectPenObject(GfxObject pen) override;
+
+    void FillRectangle(const Rect& rect, GfxObject brush) override;
+    void FillPattern(const Rect& rect, GfxObject pattern, int originX, int originY) override;
+    void DrawPolyPolyline(const Point* points, const std::uint32_t* counts, std::size_t polylines) override;
+    void DrawEllipse(int left, int top, int right, int bottom) override;
+
+    // Сколько перьев и кистей создано за всё время (для замеров числа объектов GDI на кадр)
+    std::size_t ObjectsCreated() const { return objectsCreated; }
+
+private:
+    HDC hdc = NULL;
+    HGDIOBJ oldPen = NULL;    // Перо, выбранное в контексте до нас
+    HGDIOBJ oldBrush = NULL;  // Кисть, выбранная в контексте до нас
+    std::size_t objectsCreated = 0;
+};
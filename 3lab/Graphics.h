@@ -0,0 +1,56 @@
+﻿#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Цвет в формате COLORREF (0x00BBGGRR), чтобы значения из настроек передавались без преобразований
+typedef std::uint32_t Color;
+
+constexpr Color MakeColor(int r, int g, int b) {
+    return static_cast<Color>(r & 0xFF) | (static_cast<Color>(g & 0xFF) << 8) | (static_cast<Color>(b & 0xFF) << 16);
+}
+constexpr int ColorR(Color c) { return static_cast<int>(c & 0xFF); }
+constexpr int ColorG(Color c) { return static_cast<int>((c >> 8) & 0xFF); }
+constexpr int ColorB(Color c) { return static_cast<int>((c >> 16) & 0xFF); }
+
+// Точка в пикселях
+struct Point {
+    int x;
+    int y;
+};
+
+// Прямоугольник в пикселях, правая и нижняя границы не включаются (как RECT)
+struct Rect {
+    int left;
+    int top;
+    int right;
+    int bottom;
+
+    bool IsEmpty() const { return left >= right || top >= bottom; }
+    bool Intersects(const Rect& other) const {
+        return left < other.right && other.left < right && top < other.bottom && other.top < bottom;
+    }
+};
+
+// Дескриптор объекта устройства (перо, кисть). 0 — нет объекта
+typedef std::uintptr_t GfxObject;
+
+// Абстрактное устройство рисования. Объекты создаются один раз и живут между кадрами,
+// а примитивы передаются пачками, чтобы кадр стоил несколько вызовов, а не тысячи
+class GraphicsDevice {
+public:
+    virtual ~GraphicsDevice() = default;
+
+    virtual GfxObject CreatePenObject(Color color, int width) = 0;  // Создает перо
+    virtual GfxObject CreateBrushObject(Color color) = 0;           // Создает сплошную кисть
+    // Создает кисть-узор из картинки width x height (цвета построчно сверху вниз)
+    virtual GfxObject CreatePatternObject(const Color* pixels, int width, int height) = 0;
+    virtual void DestroyObject(GfxObject object) = 0;               // Удаляет перо или кисть
+    virtual void SelectPenObject(GfxObject pen) = 0;                // Выбирает перо для линий и эллипсов
+
+    virtual void FillRectangle(const Rect& rect, GfxObject brush) = 0;  // Заливает прямоугольник кистью
+    // Заливает прямоугольник узором, повторяя его так, что левый верхний угол картинки попадает в (originX, originY)
+    virtual void FillPattern(const Rect& rect, GfxObject pattern, int originX, int originY) = 0;
+    // Рисует несколько ломаных за один вызов: counts[i] точек в i-й ломаной
+    virtual void DrawPolyPolyline(const Point* points, const std::uint32_t* counts, std::size_t polylines) = 0;
+    virtual void DrawEllipse(int left, int top, int right, int bottom) = 0;  // Рисует контур эллипса без заливки
+};
@@ -0,0 +1,28 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Быстрый некриптографический 64-битный хэш для контрольных сумм и обнаружения изменений.
+// Обрабатывает по 8 байт за шаг, поэтому годится и для многомегабайтных снимков поля
+inline std::uint64_t Hash64(const void* data, std::size_t size, std::uint64_t seed = 0x9E3779B97F4A7C15ull) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const std::uint64_t prime = 0xFF51AFD7ED558CCDull;
+    std::uint64_t h = seed ^ (size * prime);
+
+    for (; size >= 8; size -= 8, p += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p, 8);
+        h = (h ^ word) * prime;
+        h ^= h >> 29;
+    }
+    std::uint64_t tail = 0;
+    std::memcpy(&tail, p, size);
+    h = (h ^ tail) * prime;
+
+    // Финальное перемешивание (как в MurmurHash3)
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
@@ -0,0 +1,250 @@
+﻿#include "HistoryBench.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include "Board.h"
+#include "BoardHistory.h"
+#include "Framebuffer.h"
+#include "FrameScheduler.h"
+#include "GameController.h"
+#include "GameRules.h"
+#include "Hash.h"
+#include "Renderer.h"
+#include "Settings.h"
+#include "SoftwareDevice.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// Не дает компилятору выбросить результат замеряемого вызова
+static volatile std::size_t historySink = 0;
+
+static double ElapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+static double Percentile(std::vector<double>& values, double p) {
+    if (values.empty()) return 0;
+    std::size_t index = static_cast<std::size_t>(p * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+// Случайная партия без повторов клеток: одинаковая для всех значений checkpoints
+static std::vector<HistoryMove> RandomMoves(std::size_t count, int side) {
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> coord(-side / 2, side - side / 2 - 1);
+    Board board;
+    std::vector<HistoryMove> moves;
+    moves.reserve(count);
+    while (moves.size() < count) {
+        int col = coord(random);
+        int row = coord(random);
+        Mark mark = moves.size() % 2 ? Mark::Cross : Mark::Circle;
+        if (board.Place(col, row, mark)) moves.push_back({ col, row, mark });
+    }
+    return moves;
+}
+
+// Отпечаток поля, не зависящий от порядка обхода: сумма хэшей занятых клеток
+static std::uint64_t BoardPrint(const Board& board) {
+    std::uint64_t print = 0;
+    board.ForEach([&print](int col, int row, Mark mark) {
+        std::int32_t cell[3] = { col, row, static_cast<std::int32_t>(mark) };
+        print += Hash64(cell, sizeof(cell));
+    });
+    return print;
+}
+
+// Сверяет поле после переходов к версиям samples (в случайном порядке) с полем, собранным из ходов 0..v
+// за один проход по партии. Заодно сверяет Get в каждой из этих версий для случайных клеток партии
+static bool VerifyJumps(const std::vector<HistoryMove>& game, BoardHistory& history, Board& board,
+    std::vector<std::size_t> samples, std::mt19937& random) {
+    std::vector<std::pair<std::size_t, std::uint64_t>> prints;  // Версия и отпечаток поля после перехода к ней
+    for (std::size_t version : samples) {
+        history.Jump(version, board);
+        prints.push_back({ version, BoardPrint(board) });
+    }
+    prints.push_back({ history.Position(), BoardPrint(board) });
+    std::sort(prints.begin(), prints.end());
+
+    Board reference;
+    std::uniform_int_distribution<std::size_t> cell(0, game.empty() ? 0 : game.size() - 1);
+    std::size_t placed = 0;
+    bool match = true;
+    for (const std::pair<std::size_t, std::uint64_t>& print : prints) {
+        for (; placed < print.first; ++placed) reference.Place(game[placed].col, game[placed].row, game[placed].mark);
+        match = match && BoardPrint(reference) == print.second;
+        for (int i = 0; i < 100 && !game.empty(); ++i) {
+            std::size_t index = cell(random);
+            Mark expected = index < print.first ? game[index].mark : Mark::Empty;
+            match = match && history.Get(print.first, game[index].col, game[index].row) == expected;
+        }
+    }
+    return match;
+}
+
+// Правила контроллера совпадают с правилами, заново учитывающими все метки поля: те же
+// собранные окна игроков и тот же ответ, решена ли партия
+static bool RulesMatchBoard(const GameRules& rules, const Board& board) {
+    GameRules rebuilt(rules.WinLength());
+    rebuilt.Rebuild(board);
+    return rules.FullWindows(Mark::Circle) == rebuilt.FullWindows(Mark::Circle)
+        && rules.FullWindows(Mark::Cross) == rebuilt.FullWindows(Mark::Cross)
+        && (rules.Outcome() == GameOutcome::None) == (rebuilt.Outcome() == GameOutcome::None);
+}
+
+// Отмена, повтор и переходы через GameController, как по Ctrl+Z / Ctrl+Y в окне
+static void MeasureControllerJumps(Board& board, BoardHistory& history, std::size_t jumps, std::mt19937& random,
+    HistoryBenchResult& result) {
+    Settings settings = DefaultSettings();
+    Framebuffer frame(settings.windowWidth, settings.windowHeight);
+    SoftwareDevice device(frame);
+    Renderer renderer(device);
+    FrameScheduler frames;
+    GameController controller(board, renderer, frames);
+    controller.SetHistory(&history);
+    controller.ApplySettings(settings);
+    controller.ResyncRules();  // Поле уже в той версии, где его оставили замеры истории
+
+    Clock::time_point start = Clock::now();
+    GameRules rebuilt(controller.Rules().WinLength());
+    rebuilt.Rebuild(board);
+    result.rebuildUs = ElapsedUs(start);
+
+    std::uniform_int_distribution<std::size_t> version(0, history.Size());
+    std::vector<double> latencies;
+    latencies.reserve(jumps);
+    for (std::size_t i = 0; i < jumps; ++i) {
+        std::size_t target = version(random);
+        start = Clock::now();
+        controller.JumpHistory(target);
+        latencies.push_back(ElapsedUs(start));
+    }
+    result.controllerJumpP50Us = Percentile(latencies, 0.5);
+    result.controllerJumpP99Us = Percentile(latencies, 0.99);
+
+    start = Clock::now();
+    for (std::size_t i = 0; i < jumps; ++i) {
+        if (i % 2 || !history.CanUndo()) controller.Redo();
+        else controller.Undo();
+    }
+    result.controllerStepUs = jumps ? ElapsedUs(start) / jumps : 0;
+
+    // Вне замеров: после переходов в обе стороны правила те же, что у пересчитанных по полю
+    bool match = RulesMatchBoard(controller.Rules(), board);
+    for (std::size_t i = 0; i < VerifiedRules; ++i) {
+        controller.JumpHistory(version(random));
+        match = match && RulesMatchBoard(controller.Rules(), board);
+        controller.Undo();
+        match = match && RulesMatchBoard(controller.Rules(), board);
+    }
+    result.match = result.match && match;
+}
+
+std::vector<HistoryBenchResult> MeasureHistory(std::size_t moves, int side, const std::vector<int>& checkpoints,
+    std::size_t jumps, HistoryCopyCost* copyCost) {
+    std::vector<HistoryMove> game = RandomMoves(moves, side);
+    std::vector<HistoryBenchResult> results;
+    for (int checkpointMoves : checkpoints) {
+        HistoryBenchResult result;
+        result.checkpointMoves = checkpointMoves;
+        result.moves = moves;
+
+        Board board;
+        BoardHistory history(checkpointMoves);
+        history.Reset(board);
+        Clock::time_point start = Clock::now();
+        for (const HistoryMove& move : game) {
+            board.Place(move.col, move.row, move.mark);
+            history.Record(move.col, move.row, move.mark);
+        }
+        result.recordNs = moves ? ElapsedUs(start) * 1000 / moves : 0;
+        result.bytesPerMove = moves ? static_cast<double>(history.MemoryBytes()) / moves : 0;
+        result.nodes = history.Nodes();
+
+        if (copyCost && copyCost->boardBytes == 0) {
+            copyCost->boardBytes = board.ChunkCount() * sizeof(BoardChunk);
+            start = Clock::now();
+            Board copy = board;
+            copyCost->copyUs = ElapsedUs(start);
+            historySink = copy.ChunkCount();
+        }
+
+        std::mt19937 random(2);
+        std::uniform_int_distribution<std::size_t> version(0, moves);
+        std::vector<double> latencies;
+        latencies.reserve(jumps);
+        for (std::size_t i = 0; i < jumps; ++i) {
+            std::size_t target = version(random);
+            start = Clock::now();
+            history.Jump(target, board);
+            latencies.push_back(ElapsedUs(start));
+        }
+        result.jumpP50Us = Percentile(latencies, 0.5);
+        result.jumpP99Us = Percentile(latencies, 0.99);
+
+        std::uniform_int_distribution<std::size_t> distance(1, NearJumpMoves);
+        start = Clock::now();
+        for (std::size_t i = 0; i < jumps; ++i) {
+            std::size_t position = history.Position();
+            std::size_t step = distance(random);
+            history.Jump(i % 2 && position + step <= moves ? position + step : (position >= step ? position - step : position + step), board);
+        }
+        result.nearUs = jumps ? ElapsedUs(start) / jumps : 0;
+
+        // Шаги назад и вперед по очереди от случайной версии (как Ctrl+Z / Ctrl+Y)
+        start = Clock::now();
+        for (std::size_t i = 0; i < jumps; ++i) {
+            std::size_t position = history.Position();
+            history.Jump(i % 2 || position == 0 ? position + 1 : position - 1, board);
+        }
+        result.stepUs = jumps ? ElapsedUs(start) / jumps : 0;
+
+        std::uniform_int_distribution<std::size_t> cell(0, moves ? moves - 1 : 0);
+        std::size_t hits = 0;
+        start = Clock::now();
+        for (std::size_t i = 0; i < jumps * 100; ++i) {
+            const HistoryMove& move = game[cell(random)];
+            hits += history.Get(version(random), move.col, move.row) != Mark::Empty;
+        }
+        result.getNs = jumps ? ElapsedUs(start) * 1000 / (jumps * 100) : 0;
+        historySink = hits;
+
+        MeasureControllerJumps(board, history, jumps, random, result);
+
+        // Вне замеров: переходы в любую сторону дают то же поле, что и ходы 0..v, сыгранные заново
+        std::vector<std::size_t> samples;
+        for (std::size_t i = 0; i < VerifiedJumps; ++i) samples.push_back(version(random));
+        samples.push_back(0);
+        samples.push_back(moves);
+        result.match = VerifyJumps(game, history, board, samples, random) && result.match;
+        result.verified = samples.size() + 1;
+        results.push_back(result);
+    }
+    return results;
+}
+
+std::string FormatHistory(const std::vector<HistoryBenchResult>& results, const HistoryCopyCost& copyCost) {
+    std::string text = "checkpoint    moves  record,ns  bytes/move      nodes  step,us  jump 1k,us  jump p50,us  jump p99,us   get,ns"
+        "  ctl step,us  ctl jump p50,us  ctl jump p99,us  match\n";
+    char line[240];
+    for (const HistoryBenchResult& result : results) {
+        std::snprintf(line, sizeof(line), "%10d %8zu %10.0f %11.1f %10zu %8.2f %11.1f %12.1f %12.1f %8.0f %12.2f %16.1f %16.1f  %s\n",
+            result.checkpointMoves, result.moves, result.recordNs, result.bytesPerMove, result.nodes, result.stepUs, result.nearUs,
+            result.jumpP50Us, result.jumpP99Us, result.getNs, result.controllerStepUs, result.controllerJumpP50Us,
+            result.controllerJumpP99Us, result.match ? "yes" : "NO");
+        text += line;
+    }
+    if (!results.empty()) {
+        std::snprintf(line, sizeof(line), "rules rebuild over the final board: %.0f us (what every undo cost before GameRules::Remove)\n",
+            results.back().rebuildUs);
+        text += line;
+    }
+    std::snprintf(line, sizeof(line), "full copy per move instead: %.1f MB per copy, %.0f us per copy\n",
+        copyCost.boardBytes / 1048576.0, copyCost.copyUs);
+    text += line;
+    return text;
+}
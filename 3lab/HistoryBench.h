@@ -0,0 +1,46 @@
+﻿#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Память и скорость истории ходов при одном значении HistoryCheckpointMoves
+struct HistoryBenchResult {
+    int checkpointMoves = 0;
+    std::size_t moves = 0;
+    double recordNs = 0;        // Запись хода в историю
+    double bytesPerMove = 0;    // Узлы всех версий и список ходов на один ход
+    std::size_t nodes = 0;
+    double stepUs = 0;          // Отмена или повтор одного хода (с изменением поля)
+    double nearUs = 0;          // Переход на случайное число ходов до NearJumpMoves назад или вперед
+    double jumpP50Us = 0;       // Переход к случайной версии (с изменением поля)
+    double jumpP99Us = 0;
+    double getNs = 0;           // Клетка в случайной версии без перехода
+    double controllerStepUs = 0;   // Ctrl+Z / Ctrl+Y через GameController: поле, правила, счетчик меток, перерисовка
+    double controllerJumpP50Us = 0;  // GameController::JumpHistory к случайной версии
+    double controllerJumpP99Us = 0;
+    double rebuildUs = 0;       // GameRules::Rebuild по последнему полю — столько стоила каждая отмена до Remove
+    std::size_t verified = 0;   // Версий, сверенных с полем, собранным заново из ходов 0..v
+    bool match = true;          // Поле после перехода и Get совпали с эталоном во всех сверенных версиях,
+                                // правила контроллера — с правилами, пересчитанными по полю
+};
+
+const std::size_t VerifiedJumps = 50;  // Переходов к случайным версиям, которые сверяются с эталоном
+const std::size_t VerifiedRules = 8;   // Переходов контроллера, после которых правила сверяются с Rebuild
+
+const std::size_t NearJumpMoves = 1000;
+
+// Полная копия поля на каждый ход — то, чего позволяет избежать история
+struct HistoryCopyCost {
+    std::size_t boardBytes = 0;   // Участки поля после всех ходов
+    double copyUs = 0;            // Одна копия Board
+};
+
+// moves случайных ходов по квадрату side x side клеток, затем jumps переходов к случайным версиям
+// и столько же шагов отмены/повтора, для каждого значения checkpoints — сначала самой истории,
+// затем через GameController. После замеров VerifiedJumps случайных переходов и последняя версия
+// сверяются с полем, собранным заново из первых v ходов, а правила контроллера после VerifiedRules
+// переходов — с правилами, пересчитанными по полю
+std::vector<HistoryBenchResult> MeasureHistory(std::size_t moves, int side, const std::vector<int>& checkpoints,
+    std::size_t jumps, HistoryCopyCost* copyCost);
+
+std::string FormatHistory(const std::vector<HistoryBenchResult>& results, const HistoryCopyCost& copyCost);
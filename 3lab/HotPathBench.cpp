@@ -0,0 +1,309 @@
+﻿#include "HotPathBench.h"
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string_view>
+#include "Board.h"
+#include "FrameScheduler.h"
+#include "Framebuffer.h"
+#include "GameController.h"
+#include "Renderer.h"
+#include "Replay.h"
+#include "AtomicFile.h"
+#include "Settings.h"
+#include "SettingsStore.h"
+#include "SoftwareDevice.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Не дает компилятору выбросить результат замеряемого вызова
+static volatile int benchSink = 0;
+
+// Поле, занятое на четверть в видимой области
+static void FillVisible(Board& board, const Viewport& view, int width, int height) {
+    std::mt19937 random(1);
+    for (int row = view.RowAt(0); row <= view.RowAt(height - 1); ++row) {
+        for (int col = view.ColAt(0); col <= view.ColAt(width - 1); ++col) {
+            if (random() % 4 == 0) board.Place(col, row, random() % 2 ? Mark::Circle : Mark::Cross);
+        }
+    }
+}
+
+// Клик левой кнопкой и вывод кадра с поврежденной клеткой — путь WM_LBUTTONDOWN + WM_PAINT.
+// Клики идут через клетку, чтобы метки не собирались в линии и партия не заканчивалась.
+// Когда свободные клетки кончаются, поле очищается (раз в несколько сотен кликов)
+static BenchStats BenchClick() {
+    Settings settings = DefaultSettings();
+    settings.gridSize = HotPathCellSize;
+    settings.windowWidth = HotPathWidth;
+    settings.windowHeight = HotPathHeight;
+
+    Board board;
+    Framebuffer frame(HotPathWidth, HotPathHeight);
+    SoftwareDevice device(frame);
+    Renderer renderer(device);
+    FrameScheduler frames;
+    FrameDamage damage;
+    GameController controller(board, renderer, frames);
+    controller.ApplySettings(settings);
+    PresentFrame(frames, damage, renderer, device, frame, board, controller.View());
+
+    int cols = HotPathWidth / HotPathCellSize / 2;
+    int rows = HotPathHeight / HotPathCellSize / 2;
+    int next = 0;
+    return MeasureBench("click", true, [&](std::size_t iterations) {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            if (next == cols * rows) {
+                board.ClearAll();
+                controller.ResyncRules();
+                controller.InvalidateAll();
+                PresentFrame(frames, damage, renderer, device, frame, board, controller.View());
+                next = 0;
+            }
+            int x = (next % cols) * 2 * HotPathCellSize + HotPathCellSize / 2;
+            int y = (next / cols) * 2 * HotPathCellSize + HotPathCellSize / 2;
+            ++next;
+            controller.Handle({ InputKind::LeftDown, 0, x, y, 0 });
+            PresentFrame(frames, damage, renderer, device, frame, board, controller.View());
+        }
+    });
+}
+
+// Полный кадр WM_PAINT: фон, сетка и метки во всё окно
+static BenchStats BenchPaint() {
+    Viewport view;
+    view.cellSize = HotPathCellSize;
+    Board board;
+    FillVisible(board, view, HotPathWidth, HotPathHeight);
+
+    Framebuffer frame(HotPathWidth, HotPathHeight);
+    SoftwareDevice device(frame);
+    Renderer renderer(device);
+    Rect client = { 0, 0, HotPathWidth, HotPathHeight };
+    return MeasureBench("paint.full", true, [&](std::size_t iterations) {
+        for (std::size_t i = 0; i < iterations; ++i) renderer.Paint(board, view, client, client);
+    });
+}
+
+// Заливка всего кадра одной кистью — предел пикселей в секунду для SoftwareDevice
+static BenchStats BenchFill() {
+    Framebuffer frame(HotPathWidth, HotPathHeight);
+    SoftwareDevice device(frame);
+    GfxObject brush = device.CreateBrushObject(MakeColor(0, 0, 255));
+    Rect client = { 0, 0, HotPathWidth, HotPathHeight };
+    BenchStats stats = MeasureBench("paint.fill", true, [&](std::size_t iterations) {
+        for (std::size_t i = 0; i < iterations; ++i) device.FillRectangle(client, brush);
+    });
+    stats.pixelsPerOp = static_cast<double>(HotPathWidth) * HotPathHeight;
+    return stats;
+}
+
+// DrawGrid во всё окно узором (gridCache) или линиями
+static BenchStats BenchGrid(bool gridCache) {
+    Viewport view;
+    view.cellSize = HotPathCellSize;
+    Framebuffer frame(HotPathWidth, HotPathHeight);
+    SoftwareDevice device(frame);
+    Renderer renderer(device);
+    renderer.SetGridCache(gridCache);
+    Rect client = { 0, 0, HotPathWidth, HotPathHeight };
+    return MeasureBench(gridCache ? "grid.pattern" : "grid.lines", true, [&](std::size_t iterations) {
+        for (std::size_t i = 0; i < iterations; ++i) renderer.DrawGrid(view, client, client);
+    });
+}
+
+// Постановка метки: клетки квадрата BoardBenchSide x BoardBenchSide (больше миллиона) заполняются
+// подряд, поэтому в каждый замер попадают и новые участки, и уже выделенные; полное поле очищается
+static BenchStats BenchPlace() {
+    Board board;
+    std::size_t next = 0;
+    const std::size_t cells = static_cast<std::size_t>(BoardBenchSide) * BoardBenchSide;
+    BenchStats stats = MeasureBench("board.place", true, [&](std::size_t iterations) {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            if (next == cells) {
+                board.ClearAll();
+                next = 0;
+            }
+            int col = static_cast<int>(next % BoardBenchSide) - BoardBenchSide / 2;
+            int row = static_cast<int>(next / BoardBenchSide) - BoardBenchSide / 2;
+            board.Place(col, row, next & 1 ? Mark::Cross : Mark::Circle);
+            ++next;
+        }
+    });
+    stats.noisePercent = PlaceBenchNoise;
+    return stats;
+}
+
+// Чтение клетки в случайном месте того же квадрата, занятого на четверть (больше 250 тысяч меток)
+static BenchStats BenchGet() {
+    Board board;
+    std::mt19937 random(1);
+    for (int row = -BoardBenchSide / 2; row < BoardBenchSide / 2; ++row) {
+        for (int col = -BoardBenchSide / 2; col < BoardBenchSide / 2; ++col) {
+            if (random() % 4 == 0) board.Place(col, row, random() % 2 ? Mark::Circle : Mark::Cross);
+        }
+    }
+    std::uint32_t state = 1;
+    return MeasureBench("board.get", true, [&](std::size_t iterations) {
+        int found = 0;
+        for (std::size_t i = 0; i < iterations; ++i) {
+            state = state * 1664525u + 1013904223u;  // Линейный конгруэнтный генератор: дешевле mt19937
+            int col = static_cast<int>((state >> 22) & (BoardBenchSide - 1)) - BoardBenchSide / 2;
+            int row = static_cast<int>((state >> 12) & (BoardBenchSide - 1)) - BoardBenchSide / 2;
+            found += board.Get(col, row) != Mark::Empty;
+        }
+        benchSink = found;
+    });
+}
+
+static BenchStats BenchParse() {
+    char text[SettingsTextCapacity];
+    std::size_t length = FormatSettings(DefaultSettings(), text, sizeof(text));
+    return MeasureBench("settings.parse", true, [&](std::size_t iterations) {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            Settings settings = DefaultSettings();
+            ParseSettings(std::string_view(text, length), settings);
+            benchSink = settings.gridSize;
+        }
+    });
+}
+
+// Чтение готового файла способом method
+static BenchStats BenchLoad(int method, const std::string& path) {
+    std::unique_ptr<SettingsStore> store = CreateSettingsStore(method, path);
+    store->Save(DefaultSettings());
+    BenchStats stats = MeasureBench(std::string("settings.load.") + store->Name(), true, [&](std::size_t iterations) {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            Settings settings = DefaultSettings();
+            store->Load(settings);
+            benchSink = settings.gridSize;
+        }
+    });
+    stats.noisePercent = FileBenchNoise;
+    return stats;
+}
+
+// Запись способом method. Настройки чередуются: одинаковый текст Save пропускает.
+// Время определяет fsync, поэтому с эталоном метрика не сравнивается
+static BenchStats BenchSave(int method, const std::string& path) {
+    std::unique_ptr<SettingsStore> store = CreateSettingsStore(method, path);
+    Settings settings[2] = { DefaultSettings(), DefaultSettings() };
+    settings[1].gridSize += 1;
+    std::size_t turn = 0;
+    return MeasureBench(std::string("settings.save.") + store->Name(), false, [&](std::size_t iterations) {
+        for (std::size_t i = 0; i < iterations; ++i) store->Save(settings[turn++ & 1]);
+    });
+}
+
+// Текст настроек, дополненный до size байт строками без '=' (их разбор пропускает). Каждая
+// шестнадцатая строка длиннее килобайта: так проверяется и чтение длинных строк
+static std::string PaddedSettings(std::size_t size) {
+    char text[SettingsTextCapacity];
+    std::string padded(text, FormatSettings(DefaultSettings(), text, sizeof(text)));
+    for (int line = 0; padded.size() < size; ++line) {
+        padded += "; ";
+        padded.append(line % 16 == 15 ? 1200 : 70, 'x');
+        padded += "\n";
+    }
+    padded.resize(size);
+    padded.back() = '\n';
+    return padded;
+}
+
+// Выбрасывает страницы файла из кэша ОС, чтобы следующее чтение шло с диска. Есть только в Linux:
+// у Windows нет такого вызова для одного файла, там холодные замеры не запускаются
+static bool DropFileCache(const std::string& path) {
+#ifdef __linux__
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = fdatasync(fd) == 0 && posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return ok;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+static bool CanDropFileCache() {
+#ifdef __linux__
+    return true;
+#else
+    return false;
+#endif
+}
+
+static std::string SizeName(std::size_t size) {
+    return size >= 1048576 ? std::to_string(size / 1048576) + "m" : std::to_string(size / 1024) + "k";
+}
+
+// Чтение большого файла: из кэша страниц (warm) или после сброса кэша (cold)
+static BenchStats BenchLoadSize(int method, const std::string& path, std::size_t size, bool cold) {
+    std::unique_ptr<SettingsStore> store = CreateSettingsStore(method, path);
+    std::string text = PaddedSettings(size);
+    store->Write(path, text.data(), text.size());
+    std::string name = std::string("settings.load.") + store->Name() + "." + SizeName(size) + (cold ? ".cold" : "");
+    return MeasureBench(name, false, [&](std::size_t iterations) {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            if (cold) DropFileCache(path);
+            Settings settings = DefaultSettings();
+            store->Load(settings);
+            benchSink = settings.gridSize;
+        }
+    });
+}
+
+// Запись большого файла: только в кэш страниц или до диска (sync — с fsync, как в Save)
+static BenchStats BenchSaveSize(int method, const std::string& path, std::size_t size, bool sync) {
+    std::unique_ptr<SettingsStore> store = CreateSettingsStore(method, path);
+    std::string text = PaddedSettings(size);
+    std::string name = std::string("settings.save.") + store->Name() + "." + SizeName(size) + (sync ? ".sync" : "");
+    return MeasureBench(name, false, [&](std::size_t iterations) {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            store->Write(path, text.data(), text.size());
+            if (sync) SyncFile(path);
+        }
+    });
+}
+
+std::vector<BenchStats> RunHotPathBenches(const std::string& filter, const std::string& workPath) {
+    std::vector<BenchStats> results;
+    // Фильтр проверяется до подготовки: поле и кадр строятся только для нужных метрик
+    auto wanted = [&](std::string_view name) { return filter.empty() || name.find(filter) != std::string_view::npos; };
+
+    if (wanted("board.place")) results.push_back(BenchPlace());
+    if (wanted("board.get")) results.push_back(BenchGet());
+    if (wanted("click")) results.push_back(BenchClick());
+    if (wanted("paint.full")) results.push_back(BenchPaint());
+    if (wanted("paint.fill")) results.push_back(BenchFill());
+    if (wanted("grid.pattern")) results.push_back(BenchGrid(true));
+    if (wanted("grid.lines")) results.push_back(BenchGrid(false));
+    if (wanted("settings.parse")) results.push_back(BenchParse());
+    for (int method = 1; method <= 4; ++method) {
+        std::string name = CreateSettingsStore(method, workPath)->Name();
+        if (wanted("settings.load." + name)) results.push_back(BenchLoad(method, workPath));
+    }
+    for (int method = 1; method <= 4; ++method) {
+        std::string name = CreateSettingsStore(method, workPath)->Name();
+        if (wanted("settings.save." + name)) results.push_back(BenchSave(method, workPath));
+    }
+    // Файлы настроек от десятков килобайт до нескольких мегабайт: разбор, системные вызовы и диск.
+    // Метрики не сравниваются с эталоном — время определяет диск и кэш страниц
+    for (std::size_t size : SettingsSweepSizes) {
+        for (int method = 1; method <= 4; ++method) {
+            std::string name = CreateSettingsStore(method, workPath)->Name();
+            std::string suffix = "." + SizeName(size);
+            if (wanted("settings.load." + name + suffix)) results.push_back(BenchLoadSize(method, workPath, size, false));
+            if (CanDropFileCache() && wanted("settings.load." + name + suffix + ".cold")) {
+                results.push_back(BenchLoadSize(method, workPath, size, true));
+            }
+            if (wanted("settings.save." + name + suffix)) results.push_back(BenchSaveSize(method, workPath, size, false));
+            if (wanted("settings.save." + name + suffix + ".sync")) results.push_back(BenchSaveSize(method, workPath, size, true));
+        }
+    }
+    std::remove(workPath.c_str());
+    return results;
+}
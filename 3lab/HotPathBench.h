@@ -0,0 +1,25 @@
+﻿#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "MicroBench.h"
+
+const int HotPathWidth = 1280;    // Окно, в котором замеряются клик и кадр
+const int HotPathHeight = 720;
+const int HotPathCellSize = 20;
+const int BoardBenchSide = 1024;  // Квадрат клеток для замеров поля: 2^20, больше миллиона постановок до очистки
+// Чтение файла упирается в системные вызовы и кэш страниц: между запусками его медиана гуляет
+// сильнее, чем у чистых вычислений, и меньший порог давал бы ложные регрессии
+const double FileBenchNoise = 30;
+// Постановка то выделяет участки, то очищает поле: медиана зависит от того, на какую часть цикла
+// пришлись выборки, и между запусками гуляет так же
+const double PlaceBenchNoise = 30;
+// Размеры файлов настроек для замеров чтения и записи больших конфигураций
+const std::size_t SettingsSweepSizes[] = { 64 * 1024, 1024 * 1024, 4 * 1024 * 1024 };
+
+// Замеряет горячие пути окна без окна: постановку и чтение клетки поля, клик с выводом поврежденной клетки, полный кадр, заливку кадра,
+// сетку узором и линиями, разбор settings.ini и чтение/запись настроек всеми четырьмя способами
+// (и файлов от 64 КБ до 4 МБ: из кэша и с диска).
+// Файлы настроек создаются рядом с workPath и удаляются после замера.
+// filter — подстрока имени метрики (пустая — все)
+std::vector<BenchStats> RunHotPathBenches(const std::string& filter, const std::string& workPath);
@@ -0,0 +1,98 @@
+﻿#include "InputTrace.h"
+#include <charconv>
+#include <cstdio>
+#include "MappedFile.h"
+
+static const char* const KindNames[InputKindCount] = {
+    "lclick", "rclick", "mdown", "mup", "move", "wheel", "key", "resize",
+};
+
+const char* InputKindName(InputKind kind) {
+    return KindNames[static_cast<int>(kind)];
+}
+
+// Отделяет очередное слово строки
+static std::string_view NextToken(std::string_view& line) {
+    std::size_t begin = line.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) {
+        line = std::string_view();
+        return line;
+    }
+    std::size_t end = line.find_first_of(" \t\r", begin);
+    if (end == std::string_view::npos) end = line.size();
+    std::string_view token = line.substr(begin, end - begin);
+    line.remove_prefix(end);
+    return token;
+}
+
+static bool ParseNumber(std::string_view token, int& out) {
+    auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), out);
+    return ec == std::errc() && end == token.data() + token.size();
+}
+
+bool ParseInputEvent(std::string_view line, InputEvent& event) {
+    std::string_view name = NextToken(line);
+    if (name.empty() || name[0] == '#') return false;
+
+    int kind = 0;
+    while (kind < InputKindCount && name != KindNames[kind]) ++kind;
+    if (kind == InputKindCount) return false;
+
+    event = InputEvent{ static_cast<InputKind>(kind), 0, 0, 0, 0 };
+    if (!ParseNumber(NextToken(line), event.x) || !ParseNumber(NextToken(line), event.y)) return false;
+
+    // Дальше — необязательное значение и модификаторы в любом порядке
+    for (std::string_view token = NextToken(line); !token.empty(); token = NextToken(line)) {
+        if (token == "ctrl") event.modifiers |= ModControl;
+        else if (token == "shift") event.modifiers |= ModShift;
+        else if (!ParseNumber(token, event.value)) return false;
+    }
+    return true;
+}
+
+std::string FormatInputEvent(const InputEvent& event) {
+    char line[64];
+    int length = std::snprintf(line, sizeof(line), "%s %d %d", InputKindName(event.kind), event.x, event.y);
+    std::string text(line, length);
+    if (event.value != 0) text += " " + std::to_string(event.value);
+    if (event.modifiers & ModControl) text += " ctrl";
+    if (event.modifiers & ModShift) text += " shift";
+    return text;
+}
+
+bool LoadInputTrace(const char* path, std::vector<InputEvent>& events, std::size_t* badLines) {
+    MappedFile file;
+    if (!file.OpenRead(path)) return false;
+
+    std::string_view text(file.Data(), file.Size());
+    std::size_t bad = 0;
+    while (!text.empty()) {
+        std::size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+
+        InputEvent event;
+        if (ParseInputEvent(line, event)) {
+            events.push_back(event);
+        }
+        else {
+            std::string_view rest = line;
+            std::string_view first = NextToken(rest);
+            if (!first.empty() && first[0] != '#') ++bad;  // Пустые строки и комментарии ошибками не считаются
+        }
+    }
+    if (badLines) *badLines = bad;
+    return true;
+}
+
+bool SaveInputTrace(const char* path, const std::vector<InputEvent>& events) {
+    FILE* file = std::fopen(path, "wb");
+    if (!file) return false;
+    for (const InputEvent& event : events) {
+        std::string line = FormatInputEvent(event);
+        line += '\n';
+        std::fwrite(line.data(), 1, line.size(), file);
+    }
+    bool ok = std::ferror(file) == 0;
+    return std::fclose(file) == 0 && ok;
+}
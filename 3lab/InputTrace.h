@@ -0,0 +1,58 @@
+﻿#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Вид события ввода
+enum class InputKind : std::uint8_t {
+    LeftDown,    // Левая кнопка: круг
+    RightDown,   // Правая кнопка: крест
+    MiddleDown,  // Средняя кнопка: начало перетаскивания поля
+    MiddleUp,    // Конец перетаскивания
+    MouseMove,   // Движение мыши
+    Wheel,       // Колесико (с Ctrl — масштаб)
+    Key,         // Нажатие клавиши
+    Resize,      // Новый размер клиентской области
+    Count
+};
+const int InputKindCount = static_cast<int>(InputKind::Count);
+
+// Клавиши-модификаторы, зажатые во время события
+const std::uint8_t ModControl = 1;
+const std::uint8_t ModShift = 2;
+
+// Коды клавиш, которые обрабатывает игра (совпадают с виртуальными кодами Windows VK_*)
+const int KeyEnter = 0x0D;
+const int KeyEscape = 0x1B;
+const int KeyLeft = 0x25;
+const int KeyUp = 0x26;
+const int KeyRight = 0x27;
+const int KeyDown = 0x28;
+const int KeyF2 = 0x71;
+const int KeyF3 = 0x72;
+const int KeyF9 = 0x78;
+const int KeyF11 = 0x7A;
+const int KeyF12 = 0x7B;
+
+// Событие ввода без привязки к окну. Точки — в клиентских координатах
+struct InputEvent {
+    InputKind kind;
+    std::uint8_t modifiers;  // ModControl | ModShift
+    int x;                   // Точка события или новая ширина (Resize)
+    int y;                   // Точка события или новая высота (Resize)
+    int value;               // Поворот колесика (Wheel) или код клавиши (Key)
+};
+
+const char* InputKindName(InputKind kind);
+
+// Трасса ввода — текстовый файл, событие на строку: "<вид> <x> <y> [значение] [ctrl] [shift]",
+// например "lclick 120 80", "wheel 160 120 -120 ctrl", "key 0 0 13", "resize 800 600".
+// Пустые строки и строки с '#' пропускаются
+bool ParseInputEvent(std::string_view line, InputEvent& event);
+std::string FormatInputEvent(const InputEvent& event);
+
+// Читает трассу целиком. badLines (если задан) получает число строк, которые не удалось разобрать
+bool LoadInputTrace(const char* path, std::vector<InputEvent>& events, std::size_t* badLines = nullptr);
+bool SaveInputTrace(const char* path, const std::vector<InputEvent>& events);
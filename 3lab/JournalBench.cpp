@@ -0,0 +1,82 @@
+﻿#include "JournalBench.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include "Board.h"
+#include "MoveJournal.h"
+
+typedef std::chrono::steady_clock Clock;
+
+const std::size_t MaxSyncedRecords = 1000;  // fsync на каждую запись: больше не дождаться
+
+static double Seconds(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Ход номер i: клетки заполняют квадрат 1024x1024 по строкам, метки чередуются
+static void MoveAt(std::size_t i, int& col, int& row, Mark& mark) {
+    col = static_cast<int>(i % 1024) - 512;
+    row = static_cast<int>(i / 1024 % 1024) - 512;
+    mark = i % 2 ? Mark::Cross : Mark::Circle;
+}
+
+// Пишет count ходов, фиксируя журнал каждые commitEvery записей (0 — только при закрытии)
+static double WriteJournal(const std::string& path, std::size_t count, std::size_t commitEvery) {
+    std::remove(path.c_str());
+    MoveJournal journal;
+    if (!journal.Open(path, 0)) return 0;
+    Clock::time_point start = Clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        int col, row;
+        Mark mark;
+        MoveAt(i, col, row, mark);
+        journal.Append(JournalOp::Place, col, row, mark);
+        if (commitEvery && (i + 1) % commitEvery == 0) journal.Commit();
+    }
+    journal.Close();  // Последняя пачка и fsync входят в замер
+    double seconds = Seconds(start);
+    return seconds > 0 ? count / seconds : 0;
+}
+
+JournalBenchResult MeasureJournal(std::size_t records, const std::string& workPath) {
+    JournalBenchResult result;
+    result.records = records;
+    std::string path = workPath + ".journal";
+
+    result.syncedRecords = std::min(records, MaxSyncedRecords);
+    result.syncedPerSecond = WriteJournal(path, result.syncedRecords, 1);
+    result.groupPerSecond = WriteJournal(path, records, JournalGroupRecords);
+    result.appendPerSecond = WriteJournal(path, records, 0);
+
+    // Поле после журнала: на квадрате 1024x1024 повторные ходы в занятые клетки не ставятся
+    Board board;
+    Clock::time_point start = Clock::now();
+    std::size_t replayed = MoveJournal::Replay(path, board);
+    double seconds = Seconds(start);
+    result.replayPerSecond = seconds > 0 ? replayed / seconds : 0;
+    result.match = replayed == records;
+    for (std::size_t i = 0; i < records && i < 1024 * 1024 && result.match; ++i) {
+        int col, row;
+        Mark mark;
+        MoveAt(i, col, row, mark);
+        result.match = board.Get(col, row) == mark;
+    }
+    std::remove(path.c_str());
+    return result;
+}
+
+std::string FormatJournal(const JournalBenchResult& result) {
+    char line[200];
+    std::string text = "mode                       records     records/s\n";
+    std::snprintf(line, sizeof(line), "append (write per %4zu) %10zu %13.0f\n", JournalGroupRecords, result.records, result.appendPerSecond);
+    text += line;
+    std::snprintf(line, sizeof(line), "group commit (fsync/%zu) %10zu %13.0f\n", JournalGroupRecords, result.records, result.groupPerSecond);
+    text += line;
+    std::snprintf(line, sizeof(line), "fsync per record        %10zu %13.0f\n", result.syncedRecords, result.syncedPerSecond);
+    text += line;
+    std::snprintf(line, sizeof(line), "replay                  %10zu %13.0f\n", result.records, result.replayPerSecond);
+    text += line;
+    std::snprintf(line, sizeof(line), "replayed board matches: %s\n", result.match ? "yes" : "NO");
+    text += line;
+    return text;
+}
@@ -0,0 +1,19 @@
+﻿#pragma once
+#include <cstddef>
+#include <string>
+
+// Пропускная способность журнала ходов при разных способах фиксации
+struct JournalBenchResult {
+    std::size_t records = 0;
+    double appendPerSecond = 0;     // Append без сброса на диск: пачки по JournalGroupRecords уходят в файл
+    double groupPerSecond = 0;      // Commit (write + fsync) после каждой пачки
+    std::size_t syncedRecords = 0;  // Записей в замере с fsync на каждую (он на порядки медленнее)
+    double syncedPerSecond = 0;     // Commit после каждой записи — то, от чего избавляет групповая фиксация
+    double replayPerSecond = 0;     // MoveJournal::Replay при запуске
+    bool match = true;              // Replay вернул все записи и то же поле
+};
+
+// records ходов в журнал рядом с workPath (файл удаляется после замера)
+JournalBenchResult MeasureJournal(std::size_t records, const std::string& workPath);
+
+std::string FormatJournal(const JournalBenchResult& result);
@@ -0,0 +1,49 @@
+﻿#include "Log.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <mutex>
+
+static std::mutex logMutex;
+static FILE* logFile = nullptr;
+static std::chrono::steady_clock::time_point logStart;
+
+bool OpenLog(const std::string& path) {
+    std::lock_guard<std::mutex> lock(logMutex);
+    if (logFile) return true;
+#ifdef _MSC_VER
+    if (fopen_s(&logFile, path.c_str(), "ab") != 0) logFile = nullptr;
+#else
+    logFile = std::fopen(path.c_str(), "ab");
+#endif
+    if (!logFile) return false;
+
+    logStart = std::chrono::steady_clock::now();
+    std::time_t now = std::time(nullptr);
+    std::tm local = {};
+#ifdef _WIN32
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local);
+    std::fprintf(logFile, "=== %s\n", stamp);
+    std::fflush(logFile);
+    return true;
+}
+
+void LogLine(std::string_view text) {
+    std::lock_guard<std::mutex> lock(logMutex);
+    if (!logFile) return;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - logStart).count();
+    std::fprintf(logFile, "%10.3f %.*s\n", ms, static_cast<int>(text.size()), text.data());
+    std::fflush(logFile);  // Строка должна остаться в файле, даже если программа упадет следом
+}
+
+void CloseLog() {
+    std::lock_guard<std::mutex> lock(logMutex);
+    if (!logFile) return;
+    std::fclose(logFile);
+    logFile = nullptr;
+}
@@ -0,0 +1,12 @@
+﻿#pragma once
+#include <string>
+#include <string_view>
+
+// Журнал работы программы (текст UTF-8, строка на событие). Предупреждения пишутся сюда,
+// а не в модальные окна: программа не ждет нажатия OK, которое в киоске некому сделать.
+// Каждая строка начинается со времени в миллисекундах от OpenLog. Вызовы потокобезопасны
+
+// Открывает журнал на дозапись и пишет строку с датой запуска. Без открытого журнала LogLine ничего не делает
+bool OpenLog(const std::string& path);
+void LogLine(std::string_view text);
+void CloseLog();
@@ -0,0 +1,135 @@
+﻿#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::OpenRead(const char* path) {
+    Close();
+    HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+    file = hFile;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0) {
+        Close();
+        return false;
+    }
+
+    mapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!data) {
+        Close();
+        return false;
+    }
+    size = static_cast<std::size_t>(fileSize.QuadPart);
+    return true;
+}
+
+bool MappedFile::Create(const char* path, std::size_t newSize) {
+    Close();
+    HANDLE hFile = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+    file = hFile;
+    if (newSize == 0) return true;  // Пустой файл не отображается
+
+    // Отображение нужного размера само растягивает файл
+    ULONGLONG size64 = newSize;
+    mapping = CreateFileMappingW(hFile, NULL, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), NULL);
+    data = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, newSize) : nullptr;
+    if (!data) {
+        Close();
+        return false;
+    }
+    size = newSize;
+    writable = true;
+    return true;
+}
+
+bool MappedFile::Flush() {
+    if (!writable) return false;
+    return FlushViewOfFile(data, size) && FlushFileBuffers(file);
+}
+
+void MappedFile::Close() {
+    if (data) UnmapViewOfFile(data);
+    if (mapping) CloseHandle(mapping);
+    if (file) CloseHandle(file);
+    data = nullptr;
+    mapping = nullptr;
+    file = nullptr;
+    size = 0;
+    writable = false;
+}
+
+#else
+
+bool MappedFile::OpenRead(const char* path) {
+    Close();
+    fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        Close();
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        Close();
+        return false;
+    }
+    data = view;
+    size = static_cast<std::size_t>(st.st_size);
+    return true;
+}
+
+bool MappedFile::Create(const char* path, std::size_t newSize) {
+    Close();
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    if (newSize == 0) return true;  // Пустой файл не отображается
+
+    if (ftruncate(fd, static_cast<off_t>(newSize)) != 0) {
+        Close();
+        return false;
+    }
+    void* view = mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) {
+        Close();
+        return false;
+    }
+    data = view;
+    size = newSize;
+    writable = true;
+    return true;
+}
+
+bool MappedFile::Flush() {
+    if (!writable) return false;
+    return msync(data, size, MS_SYNC) == 0 && fsync(fd) == 0;
+}
+
+void MappedFile::Close() {
+    if (data) munmap(data, size);
+    if (fd >= 0) close(fd);
+    data = nullptr;
+    fd = -1;
+    size = 0;
+    writable = false;
+}
+
+#endif
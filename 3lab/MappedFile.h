@@ -0,0 +1,39 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Файл, отображенный в память (CreateFileMapping/MapViewOfFile в Windows, mmap в POSIX).
+// Закрывается автоматически в деструкторе
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Отображает существующий файл целиком только для чтения. Пустой файл считается ошибкой
+    bool OpenRead(const char* path);
+    // Создает (или обнуляет) файл заданного размера и отображает его для записи
+    bool Create(const char* path, std::size_t size);
+    // Сбрасывает записанные в отображение данные на диск
+    bool Flush();
+    // Снимает отображение и закрывает файл
+    void Close();
+
+    bool IsOpen() const { return data != nullptr; }
+    const char* Data() const { return static_cast<const char*>(data); }
+    char* MutableData() { return writable ? static_cast<char*>(data) : nullptr; }
+    std::size_t Size() const { return size; }
+
+private:
+    void* data = nullptr;
+    std::size_t size = 0;
+    bool writable = false;
+#ifdef _WIN32
+    void* file = nullptr;     // HANDLE файла
+    void* mapping = nullptr;  // HANDLE отображения
+#else
+    int fd = -1;
+#endif
+};
@@ -0,0 +1,124 @@
+﻿#include "MicroBench.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+static double Median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    std::size_t middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+// Время body(iterations) в наносекундах
+static double TimeBody(const std::function<void(std::size_t)>& body, std::size_t iterations) {
+    auto start = std::chrono::steady_clock::now();
+    body(iterations);
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+BenchStats MeasureBench(const std::string& name, bool tracked, const std::function<void(std::size_t)>& body) {
+    BenchStats stats;
+    stats.name = name;
+    stats.tracked = tracked;
+
+    // Подбор числа операций: удваиваем, пока замер не станет длиннее BenchSampleMs (это же и прогрев)
+    std::size_t iterations = 1;
+    for (;;) {
+        double ns = TimeBody(body, iterations);
+        if (ns >= BenchSampleMs * 1e6 || iterations >= (std::size_t(1) << 30)) break;
+        double scale = ns > 0 ? BenchSampleMs * 1e6 / ns : 16;
+        iterations = static_cast<std::size_t>(iterations * std::min(16.0, std::max(2.0, scale * 1.2)));
+    }
+
+    std::vector<double> samples;
+    samples.reserve(BenchSamples);
+    for (int i = 0; i < BenchSamples; ++i) samples.push_back(TimeBody(body, iterations) / iterations);
+
+    std::vector<double> deviations;
+    stats.iterations = iterations;
+    stats.medianNs = Median(samples);
+    stats.minNs = *std::min_element(samples.begin(), samples.end());
+    for (double sample : samples) deviations.push_back(std::fabs(sample - stats.medianNs));
+    stats.madNs = Median(deviations);
+    return stats;
+}
+
+// Время в удобных единицах
+static std::string FormatNs(double ns) {
+    char text[32];
+    if (ns >= 1e6) std::snprintf(text, sizeof(text), "%.2f ms", ns / 1e6);
+    else if (ns >= 1e3) std::snprintf(text, sizeof(text), "%.2f us", ns / 1e3);
+    else std::snprintf(text, sizeof(text), "%.1f ns", ns);
+    return text;
+}
+
+std::string FormatBenchStats(const std::vector<BenchStats>& results) {
+    std::string text = "metric                          median        min     spread   iterations\n";
+    char line[160];
+    for (const BenchStats& stats : results) {
+        std::snprintf(line, sizeof(line), "%-28s %11s %10s %8.1f%% %12zu%s", stats.name.c_str(), FormatNs(stats.medianNs).c_str(),
+            FormatNs(stats.minNs).c_str(), stats.SpreadPercent(), stats.iterations, stats.tracked ? "" : "  (untracked)");
+        text += line;
+        if (stats.pixelsPerOp > 0 && stats.medianNs > 0) {
+            std::snprintf(line, sizeof(line), "  %.2f Gpix/s", stats.pixelsPerOp / stats.medianNs);
+            text += line;
+        }
+        text += "\n";
+    }
+    return text;
+}
+
+bool SaveBenchBaseline(const std::string& path, const std::vector<BenchStats>& results) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    file << "# 3lab-bench baseline: metric median_ns\n";
+    char line[128];
+    for (const BenchStats& stats : results) {
+        if (!stats.tracked) continue;
+        std::snprintf(line, sizeof(line), "%s %.1f\n", stats.name.c_str(), stats.medianNs);
+        file << line;
+    }
+    file.close();
+    return static_cast<bool>(file);
+}
+
+bool LoadBenchBaseline(const std::string& path, std::map<std::string, double>& baseline) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string name;
+        double ns = 0;
+        if (fields >> name >> ns && ns > 0) baseline[name] = ns;
+    }
+    return true;
+}
+
+bool BenchRegressed(const BenchStats& stats, const std::map<std::string, double>& baseline, double thresholdPercent) {
+    auto it = baseline.find(stats.name);
+    double limit = std::max(thresholdPercent, stats.noisePercent);
+    return stats.tracked && it != baseline.end() && (stats.medianNs - it->second) * 100 / it->second > limit;
+}
+
+int CompareBenchBaseline(const std::vector<BenchStats>& results, const std::map<std::string, double>& baseline,
+    double thresholdPercent, std::string& report) {
+    int regressions = 0;
+    report += "metric                        baseline    current     change\n";
+    char line[160];
+    for (const BenchStats& stats : results) {
+        auto it = baseline.find(stats.name);
+        if (!stats.tracked || it == baseline.end()) continue;
+        double change = (stats.medianNs - it->second) * 100 / it->second;
+        bool regressed = BenchRegressed(stats, baseline, thresholdPercent);
+        regressions += regressed;
+        std::snprintf(line, sizeof(line), "%-28s %10s %10s %+9.1f%%%s\n", stats.name.c_str(), FormatNs(it->second).c_str(),
+            FormatNs(stats.medianNs).c_str(), change, regressed ? "  REGRESSION" : "");
+        report += line;
+    }
+    return regressions;
+}
@@ -0,0 +1,47 @@
+﻿#pragma once
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Микробенчмарки горячих путей с устойчивой статистикой. Число повторов подбирается так,
+// чтобы замер шел не меньше BenchSampleMs, после прогрева снимается BenchSamples замеров,
+// а сравниваются медианы: одиночные всплески (прерывания, соседние процессы) их не сдвигают
+
+const int BenchSamples = 15;       // Замеров на метрику
+const double BenchSampleMs = 20;   // Минимальная длительность одного замера
+const double DefaultBenchThreshold = 15;  // Допустимое ухудшение медианы, %
+const int BenchRetries = 2;        // Повторных замеров метрики, вышедшей за порог
+
+// Итог одной метрики, время — на одну операцию
+struct BenchStats {
+    std::string name;
+    bool tracked = true;        // Участвует в сравнении с эталоном (запись с fsync меряет диск, а не код)
+    double noisePercent = 0;    // Известный разброс медианы между запусками: порог сравнения не ниже него
+    std::size_t iterations = 0; // Операций в одном замере
+    double medianNs = 0;
+    double minNs = 0;
+    double madNs = 0;           // Медиана отклонений от медианы — разброс, нечувствительный к выбросам
+    double pixelsPerOp = 0;     // Пикселей за операцию (у заливок): в выводе добавляется пропускная способность
+
+    double SpreadPercent() const { return medianNs > 0 ? madNs * 100 / medianNs : 0; }
+};
+
+// Замеряет body(iterations), которое должно выполнить iterations операций
+BenchStats MeasureBench(const std::string& name, bool tracked, const std::function<void(std::size_t)>& body);
+
+std::string FormatBenchStats(const std::vector<BenchStats>& results);
+
+// Эталон: строки "имя медиана_нс", строки с # — комментарии. Пишутся только отслеживаемые метрики
+bool SaveBenchBaseline(const std::string& path, const std::vector<BenchStats>& results);
+bool LoadBenchBaseline(const std::string& path, std::map<std::string, double>& baseline);
+
+// Медиана стала медленнее эталонной больше чем на thresholdPercent (или на noisePercent, если он больше).
+// Метрика, которой нет в эталоне, не сравнивается
+bool BenchRegressed(const BenchStats& stats, const std::map<std::string, double>& baseline, double thresholdPercent);
+
+// Сравнивает медианы с эталоном и дописывает таблицу в report. Возвращает число метрик,
+// ставших медленнее больше чем на thresholdPercent
+int CompareBenchBaseline(const std::vector<BenchStats>& results, const std::map<std::string, double>& baseline,
+    double thresholdPercent, std::string& report);
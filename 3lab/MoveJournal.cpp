@@ -0,0 +1,208 @@
+﻿#include "MoveJournal.h"
+#include <cstring>
+#include "Hash.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Заголовок файла журнала
+struct JournalHeader {
+    char magic[4];           // "CCMJ"
+    std::uint32_t version;   // MoveJournalVersion
+    std::uint32_t recordSize;
+    std::uint32_t reserved;
+};
+
+static_assert(sizeof(JournalHeader) == 16, "заголовок журнала должен быть 16 байт");
+
+static const char JournalMagic[4] = { 'C', 'C', 'M', 'J' };
+
+static std::uint16_t RecordCheck(const JournalRecord& record) {
+    return static_cast<std::uint16_t>(Hash64(&record, offsetof(JournalRecord, check)));
+}
+
+static bool ValidHeader(const JournalHeader& header) {
+    return std::memcmp(header.magic, JournalMagic, sizeof(JournalMagic)) == 0
+        && header.version == MoveJournalVersion && header.recordSize == sizeof(JournalRecord);
+}
+
+MoveJournal::~MoveJournal() {
+    Close();
+}
+
+std::size_t MoveJournal::Replay(const std::string& path, Board& board) {
+    MappedFile file;
+    if (!file.OpenRead(path.c_str()) || file.Size() < sizeof(JournalHeader)) return 0;
+
+    JournalHeader header;
+    std::memcpy(&header, file.Data(), sizeof(header));
+    if (!ValidHeader(header)) return 0;
+
+    std::size_t count = (file.Size() - sizeof(header)) / sizeof(JournalRecord);
+    const char* records = file.Data() + sizeof(header);
+    for (std::size_t i = 0; i < count; ++i) {
+        JournalRecord record;
+        std::memcpy(&record, records + i * sizeof(JournalRecord), sizeof(record));
+        if (record.sequence != i || record.check != RecordCheck(record)) return i;
+
+        // Повторное применение безопасно: занятая клетка не перезаписывается, пустая не очищается
+        if (record.op == static_cast<std::uint8_t>(JournalOp::Clear)) {
+            board.Clear(record.col, record.row);
+        } else {
+            board.Place(record.col, record.row, static_cast<Mark>(record.mark));
+        }
+    }
+    return count;
+}
+
+bool MoveJournal::Commit() {
+    bool ok = WritePending();
+    if (IsOpen() && unsynced) {
+        ok = SyncToDisk() && ok;
+        unsynced = false;
+    }
+    return ok;
+}
+
+bool MoveJournal::BeginCommit() {
+    WritePending();
+    bool needed = IsOpen() && unsynced;
+    unsynced = false;
+    return needed;
+}
+
+void MoveJournal::Append(JournalOp op, int col, int row, Mark mark) {
+    JournalRecord record = {};
+    record.col = col;
+    record.row = row;
+    record.sequence = nextSequence++;
+    record.op = static_cast<std::uint8_t>(op);
+    record.mark = static_cast<std::uint8_t>(mark);
+    record.check = RecordCheck(record);
+    pending.push_back(record);
+
+    if (pending.size() >= JournalGroupRecords) WritePending();
+}
+
+#ifdef _WIN32
+
+bool MoveJournal::IsOpen() const {
+    return file != nullptr;
+}
+
+bool MoveJournal::Open(const std::string& path, std::size_t validRecords) {
+    Close();
+    HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return false;
+    file = hFile;
+
+    nextSequence = static_cast<std::uint32_t>(validRecords);
+    if (validRecords == 0) return Reset();
+    return Truncate(sizeof(JournalHeader) + validRecords * sizeof(JournalRecord));
+}
+
+void MoveJournal::Close() {
+    if (!file) return;
+    Commit();
+    CloseHandle(file);
+    file = nullptr;
+}
+
+bool MoveJournal::WritePending() {
+    if (!file || pending.empty()) return file != nullptr;
+    DWORD bytes = static_cast<DWORD>(pending.size() * sizeof(JournalRecord));
+    DWORD written = 0;
+    BOOL ok = WriteFile(file, pending.data(), bytes, &written, NULL) && written == bytes;
+    pending.clear();
+    unsynced = true;
+    return ok != FALSE;
+}
+
+bool MoveJournal::SyncToDisk() const {
+    return file && FlushFileBuffers(file);
+}
+
+bool MoveJournal::Truncate(std::uint64_t size) {
+    LARGE_INTEGER offset;
+    offset.QuadPart = static_cast<LONGLONG>(size);
+    return SetFilePointerEx(file, offset, NULL, FILE_BEGIN) && SetEndOfFile(file);
+}
+
+bool MoveJournal::Reset() {
+    if (!file) return false;
+    pending.clear();
+    nextSequence = 0;
+
+    JournalHeader header = {};
+    std::memcpy(header.magic, JournalMagic, sizeof(JournalMagic));
+    header.version = MoveJournalVersion;
+    header.recordSize = sizeof(JournalRecord);
+
+    DWORD written = 0;
+    bool ok = Truncate(0) && WriteFile(file, &header, sizeof(header), &written, NULL) && written == sizeof(header);
+    unsynced = true;
+    return Commit() && ok;
+}
+
+#else
+
+bool MoveJournal::IsOpen() const {
+    return fd >= 0;
+}
+
+bool MoveJournal::Open(const std::string& path, std::size_t validRecords) {
+    Close();
+    fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+
+    nextSequence = static_cast<std::uint32_t>(validRecords);
+    if (validRecords == 0) return Reset();
+    return Truncate(sizeof(JournalHeader) + validRecords * sizeof(JournalRecord));
+}
+
+void MoveJournal::Close() {
+    if (fd < 0) return;
+    Commit();
+    close(fd);
+    fd = -1;
+}
+
+bool MoveJournal::WritePending() {
+    if (fd < 0 || pending.empty()) return fd >= 0;
+    std::size_t bytes = pending.size() * sizeof(JournalRecord);
+    bool ok = write(fd, pending.data(), bytes) == static_cast<ssize_t>(bytes);
+    pending.clear();
+    unsynced = true;
+    return ok;
+}
+
+bool MoveJournal::SyncToDisk() const {
+    return fd >= 0 && fdatasync(fd) == 0;
+}
+
+bool MoveJournal::Truncate(std::uint64_t size) {
+    return ftruncate(fd, static_cast<off_t>(size)) == 0 && lseek(fd, static_cast<off_t>(size), SEEK_SET) >= 0;
+}
+
+bool MoveJournal::Reset() {
+    if (fd < 0) return false;
+    pending.clear();
+    nextSequence = 0;
+
+    JournalHeader header = {};
+    std::memcpy(header.magic, JournalMagic, sizeof(JournalMagic));
+    header.version = MoveJournalVersion;
+    header.recordSize = sizeof(JournalRecord);
+
+    bool ok = Truncate(0) && write(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header));
+    unsynced = true;
+    return Commit() && ok;
+}
+
+#endif
@@ -0,0 +1,83 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Board.h"
+
+// Операция над клеткой, записанная в журнал
+enum class JournalOp : std::uint8_t {
+    Place = 1,  // Поставить метку
+    Clear = 2,  // Очистить клетку
+};
+
+// Запись журнала фиксированного размера. Порядковый номер и контрольная сумма
+// позволяют отбросить недописанный хвост после сбоя
+#pragma pack(push, 1)
+struct JournalRecord {
+    std::int32_t col;
+    std::int32_t row;
+    std::uint32_t sequence;  // Номер записи от начала журнала
+    std::uint8_t op;         // JournalOp
+    std::uint8_t mark;       // Mark для Place
+    std::uint16_t check;     // Младшие биты Hash64 от предыдущих полей
+};
+#pragma pack(pop)
+
+static_assert(sizeof(JournalRecord) == 16, "записи журнала должны быть по 16 байт");
+
+const std::uint32_t MoveJournalVersion = 1;
+const std::size_t JournalGroupRecords = 256;      // Сколько записей копится в памяти до одной записи в файл
+const unsigned int JournalCommitIntervalMs = 1000;  // Период сброса журнала на диск (WM_TIMER)
+
+// Журнал ходов только на дозапись: каждый ход — одна 16-байтная запись.
+// Записи копятся пачкой и уходят в файл одним вызовом write, а на диск сбрасываются
+// раз в JournalCommitIntervalMs (групповая фиксация), так что клик не ждет fsync.
+// При запуске журнал проигрывается поверх последнего снимка поля; после сохранения снимка он обнуляется
+class MoveJournal {
+public:
+    MoveJournal() = default;
+    ~MoveJournal();
+
+    MoveJournal(const MoveJournal&) = delete;
+    MoveJournal& operator=(const MoveJournal&) = delete;
+
+    // Проигрывает журнал на поле. Возвращает число целых записей;
+    // чтение останавливается на первой битой или недописанной записи
+    static std::size_t Replay(const std::string& path, Board& board);
+
+    // Открывает журнал на дозапись после validRecords целых записей (результат Replay).
+    // Недописанный хвост отрезается, пустой или чужой файл начинается заново
+    bool Open(const std::string& path, std::size_t validRecords);
+    // Сбрасывает журнал и закрывает файл
+    void Close();
+    bool IsOpen() const;
+
+    // Добавляет запись в пачку. Полная пачка сразу уходит в файл (без сброса на диск)
+    void Append(JournalOp op, int col, int row, Mark mark = Mark::Empty);
+    // Записывает накопленную пачку и сбрасывает файл на диск, если было что сбрасывать
+    bool Commit();
+    // Первая половина Commit: отдает пачку ОС и возвращает true, если файл нужно сбросить на диск.
+    // Сброс (SyncToDisk) можно сделать в другом потоке, пока этот продолжает дописывать ходы
+    bool BeginCommit();
+    // Сбрасывает файл на диск. Не трогает пачку, поэтому безопасен параллельно с Append
+    bool SyncToDisk() const;
+    // Обнуляет журнал (вызывается после того, как поле сохранено снимком)
+    bool Reset();
+
+    std::size_t Pending() const { return pending.size(); }
+    std::uint32_t Records() const { return nextSequence; }
+
+private:
+    bool WritePending();
+    bool Truncate(std::uint64_t size);
+
+#ifdef _WIN32
+    void* file = nullptr;  // HANDLE (INVALID_HANDLE_VALUE хранится как nullptr)
+#else
+    int fd = -1;
+#endif
+    std::vector<JournalRecord> pending;  // Записи, еще не отданные ОС
+    std::uint32_t nextSequence = 0;      // Номер следующей записи
+    bool unsynced = false;               // В файл писали после последнего сброса на диск
+};
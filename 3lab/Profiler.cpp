@@ -0,0 +1,178 @@
+﻿#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+#include <mutex>
+
+// Гистограмма одного замера в одном потоке. Пишет только поток-владелец (load + store без
+// блокирующих инструкций), читатель сводки видит значения через атомарные загрузки
+struct ProfileHistogram {
+    std::atomic<std::uint64_t> buckets[ProfileHistogramBuckets] = {};
+    std::atomic<std::uint64_t> count{ 0 };
+    std::atomic<std::uint64_t> sum{ 0 };
+    std::atomic<std::uint64_t> max{ 0 };
+};
+
+struct ThreadProfile {
+    ProfileHistogram metrics[MaxProfileMetrics];
+};
+
+struct ProfileMetricInfo {
+    const char* name;
+    ProfileKind kind;
+};
+
+// Реестр замеров и гистограмм потоков. Мьютекс берется только при регистрации замера
+// или первого замера в новом потоке, запись значений его не касается
+static std::mutex registryMutex;
+static ProfileMetricInfo metricInfo[MaxProfileMetrics];
+static std::atomic<int> metricCount{ 0 };
+static std::vector<std::unique_ptr<ThreadProfile>>& ThreadProfiles() {
+    static std::vector<std::unique_ptr<ThreadProfile>> profiles;  // Живут до конца процесса, даже если поток завершился
+    return profiles;
+}
+
+static ThreadProfile& CurrentThreadProfile() {
+    thread_local ThreadProfile* profile = nullptr;
+    if (!profile) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        ThreadProfiles().push_back(std::make_unique<ThreadProfile>());
+        profile = ThreadProfiles().back().get();
+    }
+    return *profile;
+}
+
+static int FloorLog2(std::uint64_t x) {
+    int log = 0;
+    for (int step = 32; step > 0; step /= 2) {
+        if (x >> step) {
+            x >>= step;
+            log += step;
+        }
+    }
+    return log;
+}
+
+// Корзина значения: 0..3 как есть, дальше по 4 корзины на степень двойки (погрешность до 25%)
+static int BucketOf(std::uint64_t value) {
+    if (value < 4) return static_cast<int>(value);
+    int log = FloorLog2(value);
+    return 4 * (log - 1) + static_cast<int>((value >> (log - 2)) & 3);
+}
+
+// Наибольшее значение, попадающее в корзину
+static std::uint64_t BucketUpperBound(int bucket) {
+    if (bucket < 4) return static_cast<std::uint64_t>(bucket);
+    int log = bucket / 4 + 1;
+    std::uint64_t low = static_cast<std::uint64_t>(4 + bucket % 4) << (log - 2);
+    return low + (std::uint64_t(1) << (log - 2)) - 1;
+}
+
+static void Bump(std::atomic<std::uint64_t>& counter, std::uint64_t delta) {
+    counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+int RegisterProfileMetric(const char* name, ProfileKind kind) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    int count = metricCount.load(std::memory_order_relaxed);
+    if (count >= MaxProfileMetrics) return -1;
+    metricInfo[count] = { name, kind };
+    metricCount.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+void RecordProfileValue(int metric, std::uint64_t value) {
+    if (metric < 0) return;
+    ProfileHistogram& histogram = CurrentThreadProfile().metrics[metric];
+    Bump(histogram.buckets[BucketOf(value)], 1);
+    Bump(histogram.count, 1);
+    Bump(histogram.sum, value);
+    if (value > histogram.max.load(std::memory_order_relaxed)) histogram.max.store(value, std::memory_order_relaxed);
+}
+
+std::vector<ProfileStats> CollectProfile() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::vector<ProfileStats> result;
+    int count = metricCount.load(std::memory_order_acquire);
+    std::uint64_t buckets[ProfileHistogramBuckets];
+
+    for (int metric = 0; metric < count; ++metric) {
+        ProfileStats stats = { metricInfo[metric].name, metricInfo[metric].kind, 0, 0, 0, 0, 0 };
+        std::fill(std::begin(buckets), std::end(buckets), 0);
+        for (const auto& profile : ThreadProfiles()) {
+            const ProfileHistogram& histogram = profile->metrics[metric];
+            for (int b = 0; b < ProfileHistogramBuckets; ++b) buckets[b] += histogram.buckets[b].load(std::memory_order_relaxed);
+            stats.count += histogram.count.load(std::memory_order_relaxed);
+            stats.sum += histogram.sum.load(std::memory_order_relaxed);
+            stats.max = std::max(stats.max, histogram.max.load(std::memory_order_relaxed));
+        }
+        if (stats.count == 0) continue;
+
+        // Перцентили — по верхней границе корзины (но не больше максимума)
+        std::uint64_t seen = 0, total = 0;
+        for (std::uint64_t n : buckets) total += n;
+        for (int b = 0; b < ProfileHistogramBuckets && seen < total; ++b) {
+            seen += buckets[b];
+            if (!stats.p50 && seen * 2 >= total) stats.p50 = std::min(BucketUpperBound(b), stats.max);
+            if (seen * 100 >= total * 99) {
+                stats.p99 = std::min(BucketUpperBound(b), stats.max);
+                break;
+            }
+        }
+        result.push_back(stats);
+    }
+    return result;
+}
+
+// Значение замера для вывода: время в миллисекундах, числа как есть
+static std::string FormatValue(ProfileKind kind, std::uint64_t value) {
+    char text[32];
+    if (kind == ProfileKind::Timer) {
+        std::snprintf(text, sizeof(text), "%.3fms", static_cast<double>(value) / 1e6);
+    } else {
+        std::snprintf(text, sizeof(text), "%llu", static_cast<unsigned long long>(value));
+    }
+    return text;
+}
+
+std::string FormatProfileStats(const ProfileStats& stats) {
+    char count[32];
+    std::snprintf(count, sizeof(count), "%llu", static_cast<unsigned long long>(stats.count));
+    return std::string(stats.name) + "  n=" + count
+        + "  p50=" + FormatValue(stats.kind, stats.p50)
+        + "  p99=" + FormatValue(stats.kind, stats.p99)
+        + "  max=" + FormatValue(stats.kind, stats.max);
+}
+
+bool DumpProfile(const char* path) {
+    std::vector<ProfileStats> stats = CollectProfile();
+    std::string name = path;
+    bool json = name.size() >= 5 && name.compare(name.size() - 5, 5, ".json") == 0;
+
+#ifdef _MSC_VER
+    FILE* file = nullptr;
+    if (fopen_s(&file, path, "w") != 0) return false;
+#else
+    FILE* file = std::fopen(path, "w");
+    if (!file) return false;
+#endif
+    if (json) std::fprintf(file, "[\n");
+    else std::fprintf(file, "name,kind,count,sum,p50,p99,max\n");
+
+    for (std::size_t i = 0; i < stats.size(); ++i) {
+        const ProfileStats& s = stats[i];
+        const char* kind = s.kind == ProfileKind::Timer ? "ns" : "value";
+        unsigned long long values[5] = { s.count, s.sum, s.p50, s.p99, s.max };
+        if (json) {
+            std::fprintf(file, "  {\"name\": \"%s\", \"kind\": \"%s\", \"count\": %llu, \"sum\": %llu, \"p50\": %llu, \"p99\": %llu, \"max\": %llu}%s\n",
+                s.name, kind, values[0], values[1], values[2], values[3], values[4], i + 1 < stats.size() ? "," : "");
+        } else {
+            std::fprintf(file, "%s,%s,%llu,%llu,%llu,%llu,%llu\n", s.name, kind, values[0], values[1], values[2], values[3], values[4]);
+        }
+    }
+
+    if (json) std::fprintf(file, "]\n");
+    return std::fclose(file) == 0;
+}
@@ -0,0 +1,84 @@
+﻿#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Замеры включены в отладочной сборке. В Release макросы ниже превращаются в пустые выражения,
+// а включить их там можно, определив PROFILING_ENABLED=1
+#ifndef PROFILING_ENABLED
+#ifdef NDEBUG
+#define PROFILING_ENABLED 0
+#else
+#define PROFILING_ENABLED 1
+#endif
+#endif
+
+const int MaxProfileMetrics = 64;      // Сколько разных замеров можно зарегистрировать
+const int ProfileHistogramBuckets = 252;  // 4 корзины на каждую степень двойки от 1 до 2^63
+
+// Что хранит замер
+enum class ProfileKind : std::uint8_t {
+    Timer,  // Длительность в наносекундах
+    Value,  // Произвольное число (например, объектов GDI за кадр)
+};
+
+// Сводка по замеру, собранная со всех потоков
+struct ProfileStats {
+    const char* name;
+    ProfileKind kind;
+    std::uint64_t count;
+    std::uint64_t sum;
+    std::uint64_t p50;
+    std::uint64_t p99;
+    std::uint64_t max;
+};
+
+// Регистрирует замер (один раз на место вызова) и возвращает его номер, -1 если место кончилось
+int RegisterProfileMetric(const char* name, ProfileKind kind);
+// Добавляет значение в гистограмму текущего потока. Без блокировок: у каждого потока свои гистограммы
+void RecordProfileValue(int metric, std::uint64_t value);
+
+// Сводки по всем замерам, у которых есть значения
+std::vector<ProfileStats> CollectProfile();
+// Строка сводки для вывода на экран ("paint  n=10  p50=0.12ms ...")
+std::string FormatProfileStats(const ProfileStats& stats);
+// Записывает сводки в файл: JSON, если имя оканчивается на .json, иначе CSV
+bool DumpProfile(const char* path);
+
+// Замеряет время жизни объекта и записывает его в гистограмму замера
+class ProfileTimer {
+public:
+    explicit ProfileTimer(int metric) : metric(metric), start(std::chrono::steady_clock::now()) {}
+    ~ProfileTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        RecordProfileValue(metric, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    ProfileTimer(const ProfileTimer&) = delete;
+    ProfileTimer& operator=(const ProfileTimer&) = delete;
+
+private:
+    int metric;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if PROFILING_ENABLED
+// Замеряет время до конца текущего блока
+#define PROFILE_SCOPE(name) \
+    static const int PROFILE_CONCAT(profileMetric, __LINE__) = RegisterProfileMetric(name, ProfileKind::Timer); \
+    ProfileTimer PROFILE_CONCAT(profileTimer, __LINE__)(PROFILE_CONCAT(profileMetric, __LINE__))
+// Записывает значение в гистограмму
+#define PROFILE_VALUE(name, value) \
+    do { \
+        static const int profileMetric = RegisterProfileMetric(name, ProfileKind::Value); \
+        RecordProfileValue(profileMetric, static_cast<std::uint64_t>(value)); \
+    } while (0)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_VALUE(name, value) ((void)0)
+#endif
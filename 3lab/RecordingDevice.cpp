@@ -0,0 +1,58 @@
+﻿#include "RecordingDevice.h"
+
+void RecordingDevice::Record(DrawCommand::Kind kind, int a, int b, int c, int d, Color color) {
+    commands.push_back({ kind, { a, b, c, d }, color });
+    ++counts[kind];
+}
+
+GfxObject RecordingDevice::CreatePenObject(Color color, int width) {
+    Record(DrawCommand::CreatePen, width, 0, 0, 0, color);
+    ++alive;
+    return nextObject++;
+}
+
+GfxObject RecordingDevice::CreateBrushObject(Color color) {
+    Record(DrawCommand::CreateBrush, 0, 0, 0, 0, color);
+    ++alive;
+    return nextObject++;
+}
+
+GfxObject RecordingDevice::CreatePatternObject(const Color*, int width, int height) {
+    Record(DrawCommand::CreatePattern, width, height, 0, 0, 0);
+    ++alive;
+    return nextObject++;
+}
+
+void RecordingDevice::DestroyObject(GfxObject object) {
+    Record(DrawCommand::DestroyObject, static_cast<int>(object), 0, 0, 0, 0);
+    --alive;
+}
+
+void RecordingDevice::SelectPenObject(GfxObject pen) {
+    Record(DrawCommand::SelectPen, static_cast<int>(pen), 0, 0, 0, 0);
+}
+
+void RecordingDevice::FillRectangle(const Rect& rect, GfxObject) {
+    Record(DrawCommand::FillRect, rect.left, rect.top, rect.right, rect.bottom, 0);
+}
+
+void RecordingDevice::FillPattern(const Rect& rect, GfxObject, int, int) {
+    Record(DrawCommand::FillPattern, rect.left, rect.top, rect.right, rect.bottom, 0);
+}
+
+void RecordingDevice::DrawPolyPolyline(const Point*, const std::uint32_t* polyCounts, std::size_t polylines) {
+    Record(DrawCommand::PolyPolyline, static_cast<int>(polylines), 0, 0, 0, 0);
+    for (std::size_t i = 0; i < polylines; ++i) {
+        lines += polyCounts[i] - 1;
+    }
+}
+
+void RecordingDevice::DrawEllipse(int left, int top, int right, int bottom) {
+    Record(DrawCommand::Ellipse, left, top, right, bottom, 0);
+}
+
+void RecordingDevice::Reset() {
+    commands.clear();
+    for (std::size_t& count : counts) count = 0;
+    lines = 0;
+}
@@ -0,0 +1,42 @@
+﻿#pragma once
+#include <vector>
+#include "Graphics.h"
+
+// Одна записанная команда устройства
+struct DrawCommand {
+    enum Kind { CreatePen, CreateBrush, CreatePattern, DestroyObject, SelectPen, FillRect, FillPattern, PolyPolyline, Ellipse, KindCount } kind;
+    int args[4];       // Прямоугольник, либо args[0] — толщина пера / число ломаных / номер объекта, либо размер узора
+    Color color;       // Цвет создаваемого объекта
+};
+
+// Устройство без окна: запоминает команды вместо рисования и считает вызовы каждого вида.
+// Позволяет на любой платформе проверить, сколько работы и сколько созданий объектов порождает кадр
+class RecordingDevice : public GraphicsDevice {
+public:
+    GfxObject CreatePenObject(Color color, int width) override;
+    GfxObject CreateBrushObject(Color color) override;
+    GfxObject CreatePatternObject(const Color* pixels, int width, int height) override;
+    void DestroyObject(GfxObject object) override;
+    void SelectPenObject(GfxObject pen) override;
+
+    void FillRectangle(const Rect& rect, GfxObject brush) override;
+    void FillPattern(const Rect& rect, GfxObject pattern, int originX, int originY) override;
+    void DrawPolyPolyline(const Point* points, const std::uint32_t* counts, std::size_t polylines) override;
+    void DrawEllipse(int left, int top, int right, int bottom) override;
+
+    const std::vector<DrawCommand>& Commands() const { return commands; }
+    std::size_t Count(DrawCommand::Kind kind) const { return counts[kind]; }
+    std::size_t ObjectsCreated() const { return counts[DrawCommand::CreatePen] + counts[DrawCommand::CreateBrush] + counts[DrawCommand::CreatePattern]; }
+    std::size_t ObjectsAlive() const { return alive; }  // Создано и еще не удалено (за все кадры)
+    std::size_t LinesDrawn() const { return lines; }  // Сколько отрезков пришло во всех PolyPolyline
+    void Reset();  // Начинает новый кадр: очищает записи и счетчики (созданные объекты остаются живыми)
+
+private:
+    void Record(DrawCommand::Kind kind, int a, int b, int c, int d, Color color);
+
+    std::vector<DrawCommand> commands;
+    std::size_t counts[DrawCommand::KindCount] = {};
+    std::size_t lines = 0;
+    std::size_t alive = 0;
+    GfxObject nextObject = 1;
+};
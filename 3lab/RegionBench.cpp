@@ -0,0 +1,140 @@
+﻿#include "RegionBench.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include "Board.h"
+#include "Framebuffer.h"
+#include "RegionCounter.h"
+#include "Renderer.h"
+#include "SoftwareDevice.h"
+
+typedef std::chrono::steady_clock Clock;
+
+const int RegionFrameWidth = 1280;
+const int RegionFrameHeight = 720;
+const int RegionFrameCell = 20;
+const int RegionFrames = 20;
+
+// Не дает компилятору выбросить результат замеряемого вызова
+static volatile std::uint64_t regionSink = 0;
+
+static double ElapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+struct QueryRect {
+    int col0, row0, col1, row1;
+};
+
+static double PaintMs(const Board& board, Renderer& renderer, const Viewport& view) {
+    Rect client = { 0, 0, RegionFrameWidth, RegionFrameHeight };
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < RegionFrames; ++i) {
+        renderer.Paint(board, view, client, client);
+    }
+    return ElapsedUs(start) / 1000 / RegionFrames;
+}
+
+RegionBenchResult MeasureRegions(int side, int density, std::size_t queries) {
+    RegionBenchResult result;
+    result.side = side;
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> coord(0, side - 1);
+    std::uniform_int_distribution<int> percent(0, 99);
+
+    // Поле заполняется построчно: так участки создаются по одному и без промахов по хэш-таблице
+    Board board;
+    for (int row = 0; row < side; ++row) {
+        for (int col = 0; col < side; ++col) {
+            if (percent(random) < density) board.Place(col, row, random() % 2 ? Mark::Cross : Mark::Circle);
+        }
+    }
+    result.marks = board.Count(Mark::Circle) + board.Count(Mark::Cross);
+
+    RegionCounter counter(board);
+    Clock::time_point start = Clock::now();
+    counter.Rebuild();
+    result.buildMs = ElapsedUs(start) / 1000;
+    result.counterSide = counter.Side();
+
+    // Ходы в пустые клетки поля, как в партии: постановка и сверка участка
+    std::size_t placed = 0;
+    start = Clock::now();
+    for (std::size_t i = 0; i < queries; ++i) {
+        int col = coord(random);
+        int row = coord(random);
+        if (board.Place(col, row, i % 2 ? Mark::Cross : Mark::Circle)) ++placed;
+        counter.SyncCell(col, row);
+    }
+    result.syncNs = queries ? ElapsedUs(start) * 1000 / queries : 0;
+    result.marks += placed;
+
+    std::uint64_t sum = 0;
+    for (int maxSide : { 64, 1024, side }) {
+        RegionQueryResult query;
+        query.maxSide = maxSide;
+        query.queries = queries;
+        std::uniform_int_distribution<int> extent(1, maxSide);
+        std::vector<QueryRect> rects(queries);
+        for (QueryRect& rect : rects) {
+            int width = extent(random);
+            int height = extent(random);
+            rect.col0 = coord(random) - width / 2;
+            rect.row0 = coord(random) - height / 2;
+            rect.col1 = rect.col0 + width;
+            rect.row1 = rect.row0 + height;
+        }
+
+        std::vector<RegionCount> counts(queries);
+        start = Clock::now();
+        for (std::size_t i = 0; i < queries; ++i) {
+            counts[i] = counter.Count(rects[i].col0, rects[i].row0, rects[i].col1, rects[i].row1);
+        }
+        query.countNs = queries ? ElapsedUs(start) * 1000 / queries : 0;
+
+        std::size_t scanned = std::min(std::max<std::size_t>(queries / 100, 1), queries);
+        start = Clock::now();
+        for (std::size_t i = 0; i < scanned; ++i) {
+            RegionCount count;
+            board.ForEachIn(rects[i].col0, rects[i].row0, rects[i].col1, rects[i].row1, [&](int, int, Mark mark) {
+                ++(mark == Mark::Circle ? count.circles : count.crosses);
+            });
+            query.match = query.match && count.circles == counts[i].circles && count.crosses == counts[i].crosses;
+        }
+        query.scanNs = scanned ? ElapsedUs(start) * 1000 / scanned : 0;
+        for (const RegionCount& count : counts) sum += count.Marks();
+        result.queries.push_back(query);
+    }
+    regionSink = sum;
+
+    // Кадр посередине поля: плитки карты стоят по запросу на каждую
+    Framebuffer frame(RegionFrameWidth, RegionFrameHeight);
+    SoftwareDevice device(frame);
+    Renderer renderer(device);
+    Viewport view;
+    view.cellSize = RegionFrameCell;
+    view.x = static_cast<std::int64_t>(side / 2) * RegionFrameCell - RegionFrameWidth / 2;
+    view.y = static_cast<std::int64_t>(side / 2) * RegionFrameCell - RegionFrameHeight / 2;
+    result.paintMs = PaintMs(board, renderer, view);
+    renderer.SetHeatmap(&counter);
+    result.heatmapPaintMs = PaintMs(board, renderer, view);
+    return result;
+}
+
+std::string FormatRegions(const RegionBenchResult& result) {
+    char line[160];
+    std::snprintf(line, sizeof(line), "board %dx%d, %zu marks; counter grid %dx%d chunks, build %.1f ms, place+sync %.0f ns\n",
+        result.side, result.side, result.marks, result.counterSide, result.counterSide, result.buildMs, result.syncNs);
+    std::string text = line;
+    text += "max side  queries   count,ns      scan,ns  speedup  match\n";
+    for (const RegionQueryResult& query : result.queries) {
+        std::snprintf(line, sizeof(line), "%8d %8zu %10.0f %12.0f %8.0f  %s\n", query.maxSide, query.queries, query.countNs,
+            query.scanNs, query.countNs > 0 ? query.scanNs / query.countNs : 0, query.match ? "yes" : "NO");
+        text += line;
+    }
+    std::snprintf(line, sizeof(line), "frame %dx%d cell %d: %.2f ms plain, %.2f ms with heatmap\n",
+        RegionFrameWidth, RegionFrameHeight, RegionFrameCell, result.paintMs, result.heatmapPaintMs);
+    text += line;
+    return text;
+}
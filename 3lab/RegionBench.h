@@ -0,0 +1,30 @@
+﻿#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Запросы одного размера: счетчик против обхода клеток
+struct RegionQueryResult {
+    int maxSide = 0;            // Стороны прямоугольников случайны в [1, maxSide]
+    std::size_t queries = 0;
+    double countNs = 0;         // RegionCounter::Count
+    double scanNs = 0;          // Board::ForEachIn с подсчетом каждой метки
+    bool match = true;          // Ответы совпали на всех сверенных запросах
+};
+
+struct RegionBenchResult {
+    int side = 0;               // Поле side x side клеток
+    std::size_t marks = 0;
+    int counterSide = 0;        // Сторона сетки счетчика в участках
+    double buildMs = 0;         // RegionCounter::Rebuild
+    double syncNs = 0;          // Постановка метки вместе с SyncCell
+    std::vector<RegionQueryResult> queries;
+    double paintMs = 0;         // Кадр 1280x720 без тепловой карты
+    double heatmapPaintMs = 0;  // Тот же кадр с тепловой картой
+};
+
+// Поле side x side со случайными метками (density процентов клеток), затем queries запросов
+// каждого размера. Обход клеток медленнее на порядки, поэтому сверяется на сотой части запросов
+RegionBenchResult MeasureRegions(int side, int density, std::size_t queries);
+
+std::string FormatRegions(const RegionBenchResult& result);
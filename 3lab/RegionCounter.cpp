@@ -0,0 +1,193 @@
+﻿#include "RegionCounter.h"
+#include <algorithm>
+#include <climits>
+#include "Bits.h"
+
+static const std::uint64_t CircleBits = 0x5555555555555555ULL;  // Младшие биты пар — круги
+static const std::uint64_t CrossBits = 0xAAAAAAAAAAAAAAAAULL;   // Старшие — кресты
+
+// Первый участок, начинающийся не левее клетки
+static int CeilChunk(int cell) {
+    return Board::ChunkOf(cell) + ((cell & (Board::ChunkSize - 1)) != 0);
+}
+
+void RegionCounter::Rebuild() {
+    int col0 = INT_MAX, row0 = INT_MAX, col1 = INT_MIN, row1 = INT_MIN;
+    board.ForEachChunk([&](int chunkCol, int chunkRow, const BoardChunk&) {
+        col0 = std::min(col0, chunkCol);
+        row0 = std::min(row0, chunkRow);
+        col1 = std::max(col1, chunkCol);
+        row1 = std::max(row1, chunkRow);
+    });
+
+    side = 0;
+    overflow = false;
+    chunks.clear();
+    tree.clear();
+    if (col0 > col1) return;  // Поле пусто
+
+    // Сетка — степень двойки с запасом вдвое, занятая область посередине: рост в любую сторону
+    // перестраивает сетку не чаще, чем область удваивается
+    std::int64_t extent = std::max<std::int64_t>(static_cast<std::int64_t>(col1) - col0, static_cast<std::int64_t>(row1) - row0) + 1;
+    if (extent * 2 > MaxRegionSide) {
+        overflow = extent > MaxRegionSide;
+        side = overflow ? 0 : MaxRegionSide;
+    }
+    else {
+        side = 1;
+        while (side < extent * 2) side *= 2;
+    }
+    if (overflow) return;
+    originCol = static_cast<int>(std::max<std::int64_t>(INT_MIN >> Board::ChunkShift, col0 - (side - (static_cast<std::int64_t>(col1) - col0 + 1)) / 2));
+    originRow = static_cast<int>(std::max<std::int64_t>(INT_MIN >> Board::ChunkShift, row0 - (side - (static_cast<std::int64_t>(row1) - row0 + 1)) / 2));
+
+    std::size_t cells = static_cast<std::size_t>(side) * side;
+    chunks.assign(cells, Counts{ 0, 0 });
+    board.ForEachChunk([&](int chunkCol, int chunkRow, const BoardChunk& chunk) {
+        chunks[static_cast<std::size_t>(chunkRow - originRow) * side + (chunkCol - originCol)] = { chunk.circles, chunk.crosses };
+    });
+
+    // Дерево строится за O(side^2): каждый узел прибавляется к родителю сначала по строкам, потом по столбцам
+    tree.resize(cells);
+    for (std::size_t i = 0; i < cells; ++i) tree[i] = { chunks[i].circles, chunks[i].crosses };
+    for (int j = 0; j < side; ++j) {
+        RegionCount* line = &tree[static_cast<std::size_t>(j) * side];
+        for (int i = 0; i < side; ++i) {
+            int parent = i | (i + 1);
+            if (parent < side) {
+                line[parent].circles += line[i].circles;
+                line[parent].crosses += line[i].crosses;
+            }
+        }
+    }
+    for (int j = 0; j < side; ++j) {
+        int parent = j | (j + 1);
+        if (parent >= side) continue;
+        const RegionCount* from = &tree[static_cast<std::size_t>(j) * side];
+        RegionCount* to = &tree[static_cast<std::size_t>(parent) * side];
+        for (int i = 0; i < side; ++i) {
+            to[i].circles += from[i].circles;
+            to[i].crosses += from[i].crosses;
+        }
+    }
+}
+
+void RegionCounter::SyncChunk(int chunkCol, int chunkRow) {
+    const BoardChunk* chunk = board.FindChunk(chunkCol, chunkRow);
+    std::int64_t col = static_cast<std::int64_t>(chunkCol) - originCol;
+    std::int64_t row = static_cast<std::int64_t>(chunkRow) - originRow;
+    if (col < 0 || row < 0 || col >= side || row >= side) {
+        // Вне сетки меток не было: пустой участок ничего не меняет, занятый — расширяет сетку
+        if (chunk && !overflow) Rebuild();
+        return;
+    }
+
+    Counts& old = chunks[static_cast<std::size_t>(row) * side + col];
+    Counts fresh = { chunk ? chunk->circles : 0, chunk ? chunk->crosses : 0 };
+    if (fresh.circles == old.circles && fresh.crosses == old.crosses) return;
+    Add(static_cast<int>(col), static_cast<int>(row), static_cast<std::int64_t>(fresh.circles) - old.circles,
+        static_cast<std::int64_t>(fresh.crosses) - old.crosses);
+    old = fresh;
+}
+
+void RegionCounter::Add(int i, int j, std::int64_t circles, std::int64_t crosses) {
+    for (int y = j; y < side; y |= y + 1) {
+        RegionCount* line = &tree[static_cast<std::size_t>(y) * side];
+        for (int x = i; x < side; x |= x + 1) {
+            line[x].circles += static_cast<std::uint64_t>(circles);  // Отрицательная разница — по модулю 2^64
+            line[x].crosses += static_cast<std::uint64_t>(crosses);
+        }
+    }
+}
+
+RegionCount RegionCounter::Prefix(int i, int j) const {
+    RegionCount sum;
+    for (int y = j - 1; y >= 0; y = (y & (y + 1)) - 1) {
+        const RegionCount* line = &tree[static_cast<std::size_t>(y) * side];
+        for (int x = i - 1; x >= 0; x = (x & (x + 1)) - 1) {
+            sum.circles += line[x].circles;
+            sum.crosses += line[x].crosses;
+        }
+    }
+    return sum;
+}
+
+// Метки участков, лежащих в прямоугольнике целиком
+RegionCount RegionCounter::CountChunks(int chunkCol0, int chunkRow0, int chunkCol1, int chunkRow1) const {
+    RegionCount count;
+    if (chunkCol0 >= chunkCol1 || chunkRow0 >= chunkRow1) return count;
+    if (overflow) {
+        board.ForEachChunkIn(chunkCol0, chunkRow0, chunkCol1, chunkRow1, [&](int, int, const BoardChunk& chunk) {
+            count.circles += chunk.circles;
+            count.crosses += chunk.crosses;
+        });
+        return count;
+    }
+
+    // Вне сетки меток нет: прямоугольник обрезается по ней
+    auto clamp = [&](int chunk, int origin) {
+        return static_cast<int>(std::min<std::int64_t>(side, std::max<std::int64_t>(0, static_cast<std::int64_t>(chunk) - origin)));
+    };
+    int i0 = clamp(chunkCol0, originCol), i1 = clamp(chunkCol1, originCol);
+    int j0 = clamp(chunkRow0, originRow), j1 = clamp(chunkRow1, originRow);
+    if (i0 >= i1 || j0 >= j1) return count;
+    // Суммы в беззнаковых числах: переполнения взаимно сокращаются
+    RegionCount a = Prefix(i1, j1), b = Prefix(i0, j1), c = Prefix(i1, j0), d = Prefix(i0, j0);
+    count.circles = a.circles - b.circles - c.circles + d.circles;
+    count.crosses = a.crosses - b.crosses - c.crosses + d.crosses;
+    return count;
+}
+
+void RegionCounter::CountCells(int chunkCol0, int chunkRow0, int chunkCol1, int chunkRow1,
+    int col0, int row0, int col1, int row1, RegionCount& count) const {
+    board.ForEachChunkIn(chunkCol0, chunkRow0, chunkCol1, chunkRow1, [&](int chunkCol, int chunkRow, const BoardChunk& chunk) {
+        std::int64_t baseCol = static_cast<std::int64_t>(chunkCol) * Board::ChunkSize;
+        std::int64_t baseRow = static_cast<std::int64_t>(chunkRow) * Board::ChunkSize;
+        int localCol0 = static_cast<int>(std::max<std::int64_t>(0, col0 - baseCol));
+        int localCol1 = static_cast<int>(std::min<std::int64_t>(Board::ChunkSize, col1 - baseCol));
+        int localRow0 = static_cast<int>(std::max<std::int64_t>(0, row0 - baseRow));
+        int localRow1 = static_cast<int>(std::min<std::int64_t>(Board::ChunkSize, row1 - baseRow));
+
+        // Маска столбцов [localCol0, localCol1) для каждого слова строки
+        std::uint64_t masks[BoardChunk::RowWords];
+        for (int w = 0; w < BoardChunk::RowWords; ++w) {
+            int first = std::max(localCol0 - w * Board::CellsPerWord, 0);
+            int last = std::min(localCol1 - w * Board::CellsPerWord, Board::CellsPerWord);
+            masks[w] = 0;
+            if (first < last) {
+                std::uint64_t high = last == Board::CellsPerWord ? ~std::uint64_t(0) : (std::uint64_t(1) << (last * 2)) - 1;
+                masks[w] = high & ~((std::uint64_t(1) << (first * 2)) - 1);
+            }
+        }
+        for (int row = localRow0; row < localRow1; ++row) {
+            const std::uint64_t* line = &chunk.words[row * BoardChunk::RowWords];
+            for (int w = 0; w < BoardChunk::RowWords; ++w) {
+                std::uint64_t word = line[w] & masks[w];
+                count.circles += PopCount(word & CircleBits);
+                count.crosses += PopCount(word & CrossBits);
+            }
+        }
+    });
+}
+
+RegionCount RegionCounter::Count(int col0, int row0, int col1, int row1) const {
+    RegionCount count;
+    if (col0 >= col1 || row0 >= row1) return count;
+    int chunkCol0 = Board::ChunkOf(col0), chunkCol1 = Board::ChunkOf(col1 - 1) + 1;
+    int chunkRow0 = Board::ChunkOf(row0), chunkRow1 = Board::ChunkOf(row1 - 1) + 1;
+    int innerCol0 = CeilChunk(col0), innerCol1 = Board::ChunkOf(col1);
+    int innerRow0 = CeilChunk(row0), innerRow1 = Board::ChunkOf(row1);
+    if (innerCol0 >= innerCol1 || innerRow0 >= innerRow1) {
+        // Целых участков нет: прямоугольник меньше участка хотя бы по одной стороне
+        CountCells(chunkCol0, chunkRow0, chunkCol1, chunkRow1, col0, row0, col1, row1, count);
+        return count;
+    }
+
+    count = CountChunks(innerCol0, innerRow0, innerCol1, innerRow1);
+    // Полосы частичных участков: сверху и снизу во всю ширину, слева и справа между ними
+    CountCells(chunkCol0, chunkRow0, chunkCol1, innerRow0, col0, row0, col1, row1, count);
+    CountCells(chunkCol0, innerRow1, chunkCol1, chunkRow1, col0, row0, col1, row1, count);
+    CountCells(chunkCol0, innerRow0, innerCol0, innerRow1, col0, row0, col1, row1, count);
+    CountCells(innerCol1, innerRow0, chunkCol1, innerRow1, col0, row0, col1, row1, count);
+    return count;
+}
@@ -0,0 +1,61 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Board.h"
+
+const int MaxRegionSide = 1024;  // Сторона сетки счетчиков в участках (65536 клеток): дальше — обход участков
+
+// Число кругов и крестов в прямоугольнике
+struct RegionCount {
+    std::uint64_t circles = 0;
+    std::uint64_t crosses = 0;
+
+    std::uint64_t Marks() const { return circles + crosses; }
+};
+
+// Счетчик меток в прямоугольниках поля. Для каждого участка 64x64 хранятся числа кругов
+// и крестов, над ними — двумерное дерево Фенвика по сетке участков, покрывающей занятую
+// область. Прямоугольник раскладывается на участки, лежащие в нем целиком (сумма из дерева
+// за O(log^2 n)), и полосу частичных участков по краям, где клетки считаются PopCount по
+// словам строк. Изменение поля сообщается через SyncCell: участок сверяется с Board и дерево
+// получает разницу за O(log^2 n). Метка вне сетки перестраивает ее с запасом (O(участков));
+// если занятая область шире MaxRegionSide участков, сумма внутренних участков берется обходом
+class RegionCounter {
+public:
+    explicit RegionCounter(const Board& board) : board(board) {}
+
+    // Пересчитывает всё по полю (после загрузки, очистки или полной синхронизации)
+    void Rebuild();
+    // Клетка на поле изменилась: участок, в котором она лежит, сверяется с полем
+    void SyncCell(int col, int row) { SyncChunk(Board::ChunkOf(col), Board::ChunkOf(row)); }
+    void SyncChunk(int chunkCol, int chunkRow);
+
+    // Метки в прямоугольнике [col0, col1) x [row0, row1)
+    RegionCount Count(int col0, int row0, int col1, int row1) const;
+
+    int Side() const { return side; }  // Сторона сетки в участках (0 — поле пусто)
+    bool Overflow() const { return overflow; }
+
+private:
+    struct Counts {
+        std::uint32_t circles;
+        std::uint32_t crosses;
+    };
+
+    void Add(int i, int j, std::int64_t circles, std::int64_t crosses);
+    // Сумма по участкам сетки [0, i) x [0, j)
+    RegionCount Prefix(int i, int j) const;
+    RegionCount CountChunks(int chunkCol0, int chunkRow0, int chunkCol1, int chunkRow1) const;
+    // Клетки прямоугольника в участках [chunkCol0, chunkCol1) x [chunkRow0, chunkRow1)
+    void CountCells(int chunkCol0, int chunkRow0, int chunkCol1, int chunkRow1,
+        int col0, int row0, int col1, int row1, RegionCount& count) const;
+
+    const Board& board;
+    int originCol = 0;  // Участок в углу сетки
+    int originRow = 0;
+    int side = 0;
+    bool overflow = false;         // Занятая область шире MaxRegionSide
+    std::vector<Counts> chunks;    // Числа меток участков сетки (по строкам)
+    std::vector<RegionCount> tree; // Дерево Фенвика над ними (суммы шире 32 бит)
+};
@@ -0,0 +1,104 @@
+﻿#include "RenderBench.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include "Board.h"
+#include "Framebuffer.h"
+#include "Renderer.h"
+#include "SoftwareDevice.h"
+#include "ThreadPool.h"
+#include "TiledRenderer.h"
+#include "Viewport.h"
+
+std::vector<RenderScalingResult> MeasureRenderScaling(int width, int height, int cellSize, double density,
+    unsigned maxThreads, int frames) {
+    Viewport view;
+    view.cellSize = cellSize;
+    Board board;
+    std::mt19937 random(1);
+    std::bernoulli_distribution occupied(density);
+    for (int row = view.RowAt(0); row <= view.RowAt(height - 1); ++row) {
+        for (int col = view.ColAt(0); col <= view.ColAt(width - 1); ++col) {
+            if (occupied(random)) board.Place(col, row, random() % 2 ? Mark::Circle : Mark::Cross);
+        }
+    }
+
+    Framebuffer frame(width, height);
+    Rect client = { 0, 0, width, height };
+    std::vector<RenderScalingResult> results;
+    for (unsigned threads = 1; threads <= maxThreads; ++threads) {
+        ThreadPool pool(threads - 1);
+        TiledRenderer renderer(pool);
+        renderer.Paint(board, view, client, frame);  // Прогрев: перья, страницы кадра, потоки
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i) renderer.Paint(board, view, client, frame);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        RenderScalingResult result;
+        result.threads = threads;
+        result.framesPerSecond = seconds > 0 ? frames / seconds : 0;
+        result.speedup = results.empty() ? 1.0 : result.framesPerSecond / results[0].framesPerSecond;
+        result.steals = pool.Steals();
+        results.push_back(result);
+    }
+    return results;
+}
+
+std::string FormatRenderScaling(const std::vector<RenderScalingResult>& results) {
+    std::string text = "threads   frames/s   speedup   steals\n";
+    char line[96];
+    for (const RenderScalingResult& result : results) {
+        std::snprintf(line, sizeof(line), "%7u %10.2f %9.2f %8llu\n", result.threads, result.framesPerSecond,
+            result.speedup, static_cast<unsigned long long>(result.steals));
+        text += line;
+    }
+    return text;
+}
+
+// Среднее время кадра в микросекундах
+static double MeasurePaint(Renderer& renderer, const Board& board, const Viewport& view, const Rect& client, int frames) {
+    renderer.Paint(board, view, client, client);  // Прогрев: перья и узор создаются здесь
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i) renderer.Paint(board, view, client, client);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return frames > 0 ? seconds * 1e6 / frames : 0;
+}
+
+std::vector<GridCacheResult> MeasureGridCache(int width, int height, const std::vector<int>& cellSizes, int frames) {
+    Board board;
+    Rect client = { 0, 0, width, height };
+    Framebuffer lines(width, height), pattern(width, height);
+    std::vector<GridCacheResult> results;
+    for (int cellSize : cellSizes) {
+        Viewport view;
+        view.cellSize = cellSize;
+        view.x = -cellSize / 3;  // Сетка не с начала окна: проверяется и фаза узора
+        view.y = cellSize / 2;
+
+        SoftwareDevice linesDevice(lines), patternDevice(pattern);
+        Renderer linesRenderer(linesDevice), patternRenderer(patternDevice);
+        linesRenderer.SetGridCache(false);
+
+        GridCacheResult result;
+        result.cellSize = cellSize;
+        result.linesUs = MeasurePaint(linesRenderer, board, view, client, frames);
+        result.patternUs = MeasurePaint(patternRenderer, board, view, client, frames);
+        result.speedup = result.patternUs > 0 ? result.linesUs / result.patternUs : 0;
+        result.identical = std::memcmp(lines.Data(), pattern.Data(), static_cast<std::size_t>(width) * height * sizeof(std::uint32_t)) == 0;
+        results.push_back(result);
+    }
+    return results;
+}
+
+std::string FormatGridCache(const std::vector<GridCacheResult>& results) {
+    std::string text = " cell   lines us  pattern us   speedup  same\n";
+    char line[96];
+    for (const GridCacheResult& result : results) {
+        std::snprintf(line, sizeof(line), "%5d %10.1f %11.1f %9.2f  %s\n", result.cellSize, result.linesUs, result.patternUs,
+            result.speedup, result.identical ? "yes" : "NO");
+        text += line;
+    }
+    return text;
+}
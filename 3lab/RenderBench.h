@@ -0,0 +1,33 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Замер масштабирования отрисовки по плиткам на одном числе потоков
+struct RenderScalingResult {
+    unsigned threads = 0;        // Потоков рисования (вместе с вызывающим)
+    double framesPerSecond = 0;
+    double speedup = 0;          // Во сколько раз быстрее, чем в одном потоке
+    std::uint64_t steals = 0;    // Сколько плиток украдено у соседей
+};
+
+// Заполняет поле случайными метками (density — доля занятых клеток видимой области)
+// и рисует полные кадры width x height программным растеризатором на 1..maxThreads потоках
+std::vector<RenderScalingResult> MeasureRenderScaling(int width, int height, int cellSize, double density,
+    unsigned maxThreads, int frames);
+
+std::string FormatRenderScaling(const std::vector<RenderScalingResult>& results);
+
+// Стоимость кадра фона с сеткой с узором и без него при одном размере клетки
+struct GridCacheResult {
+    int cellSize = 0;
+    double linesUs = 0;     // Заливка фона и линии сетки, мкс на кадр
+    double patternUs = 0;   // Заливка узором, мкс на кадр
+    double speedup = 0;
+    bool identical = false; // Кадры совпали попиксельно
+};
+
+// Рисует пустое поле width x height программным растеризатором (frames кадров на каждый размер клетки)
+std::vector<GridCacheResult> MeasureGridCache(int width, int height, const std::vector<int>& cellSizes, int frames);
+
+std::string FormatGridCache(const std::vector<GridCacheResult>& results);
@@ -0,0 +1,197 @@
+﻿#include "Checks.h"
+#include <cstdio>
+#include <random>
+#include "Board.h"
+#include "Framebuffer.h"
+#include "MappedFile.h"
+#include "RecordingDevice.h"
+#include "RegionCounter.h"
+#include "Renderer.h"
+#include "SoftwareDevice.h"
+
+const int CheckWidth = 1280;
+const int CheckHeight = 720;
+const int CheckCellSize = 20;
+const int DamageCol = 30;             // Клетка, по которой «кликают»
+const int DamageRow = 18;
+const int MaxDamageCommands = 4;      // Узор фона с сеткой, перо, эллипс — и запас на одну команду
+const int GoldenPanel = 128;          // Сторона панели эталонной сцены
+const char* const GoldenActualPath = "golden-scene.actual.ppm";  // Кадр, не совпавший с эталоном (в рабочем каталоге)
+
+static Viewport CheckView() {
+    Viewport view;
+    view.cellSize = CheckCellSize;
+    return view;
+}
+
+// Поле с метками вдали от клетки клика. Соседи клетки (квадрат 5x5) на обоих полях пусты:
+// их метки попадают в поврежденную область и честно рисуются, но от размера поля не зависят
+static void FillAround(Board& board, int radius) {
+    for (int row = DamageRow - radius; row < DamageRow + radius; ++row) {
+        for (int col = DamageCol - radius; col < DamageCol + radius; ++col) {
+            if (col >= DamageCol - 2 && col <= DamageCol + 2 && row >= DamageRow - 2 && row <= DamageRow + 2) continue;
+            board.Place(col, row, (col + row) % 2 ? Mark::Cross : Mark::Circle);
+        }
+    }
+}
+
+// Команды кадра, перерисовывающего клетку после клика. Первый полный кадр создает объекты и не считается
+static void PaintDamage(const Board& board, RecordingDevice& device, std::size_t& commands, std::size_t& lines) {
+    Renderer renderer(device);
+    Viewport view = CheckView();
+    Rect client = { 0, 0, CheckWidth, CheckHeight };
+    renderer.Paint(board, view, client, client);
+    device.Reset();
+    renderer.Paint(board, view, client, CellDamageRect(DamageCol, DamageRow, view));
+    commands = device.Commands().size();
+    lines = device.LinesDrawn();
+}
+
+CheckResult CheckCellDamage() {
+    CheckResult result;
+    Board small, large;
+    for (int i = 0; i < 10; ++i) small.Place(i * 3, 0, i % 2 ? Mark::Cross : Mark::Circle);
+    FillAround(large, 158);  // 316x316 без квадрата 5x5 — почти 100 тысяч меток
+    small.Place(DamageCol, DamageRow, Mark::Circle);
+    large.Place(DamageCol, DamageRow, Mark::Circle);
+
+    RecordingDevice smallDevice, largeDevice;
+    std::size_t smallCommands = 0, smallLines = 0, largeCommands = 0, largeLines = 0;
+    PaintDamage(small, smallDevice, smallCommands, smallLines);
+    PaintDamage(large, largeDevice, largeCommands, largeLines);
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "cell damage: %zu marks -> %zu commands, %zu lines; %zu marks -> %zu commands, %zu lines",
+        small.Count(Mark::Circle) + small.Count(Mark::Cross), smallCommands, smallLines,
+        large.Count(Mark::Circle) + large.Count(Mark::Cross), largeCommands, largeLines);
+    result.Note(line);
+    result.Expect(smallCommands == largeCommands && smallLines == largeLines, "damage frame depends on the number of marks");
+    result.Expect(largeCommands <= MaxDamageCommands, "damage frame issues more than " + std::to_string(MaxDamageCommands) + " commands");
+    return result;
+}
+
+// Число объектов, созданных кадром после изменения change
+template <typename F>
+static std::size_t CreatedBy(Renderer& renderer, RecordingDevice& device, const Board& board, F&& change) {
+    Viewport view = CheckView();
+    Rect client = { 0, 0, CheckWidth, CheckHeight };
+    change();
+    device.Reset();
+    renderer.Paint(board, view, client, client);
+    return device.ObjectsCreated();
+}
+
+CheckResult CheckObjectChurn() {
+    CheckResult result;
+    Board board;
+    FillAround(board, 20);
+    RecordingDevice device;
+    char line[160];
+    // Фон с сеткой рисуется и узором, и линиями: у каждого пути свои объекты
+    for (bool gridCache : { true, false }) {
+        {
+            Renderer renderer(device);
+            renderer.SetGridCache(gridCache);
+            std::size_t first = CreatedBy(renderer, device, board, [] {});
+            std::size_t steady = 0;
+            for (int frame = 0; frame < 10; ++frame) steady += CreatedBy(renderer, device, board, [] {});
+            std::size_t background = CreatedBy(renderer, device, board, [&] { renderer.SetBackgroundColor(MakeColor(1, 2, 3)); });
+            std::size_t grid = CreatedBy(renderer, device, board, [&] { renderer.SetGridColor(MakeColor(4, 5, 6)); });
+            std::size_t same = CreatedBy(renderer, device, board, [&] { renderer.SetGridColor(MakeColor(4, 5, 6)); });
+            std::snprintf(line, sizeof(line), "%s: first frame %zu objects, 10 steady frames %zu, background %zu, grid %zu, same color %zu",
+                gridCache ? "grid pattern" : "grid lines", first, steady, background, grid, same);
+            result.Note(line);
+            result.Expect(steady == 0, "steady frames create objects");
+            result.Expect(background == 1, "background color change does not create exactly one object");
+            result.Expect(grid == 1, "grid color change does not create exactly one object");
+            result.Expect(same == 0, "setting the same color recreates objects");
+
+            std::size_t alive = device.ObjectsAlive();
+            renderer.ReleaseObjects();
+            std::snprintf(line, sizeof(line), "%s: %zu objects alive, %zu after ReleaseObjects",
+                gridCache ? "grid pattern" : "grid lines", alive, device.ObjectsAlive());
+            result.Note(line);
+            result.Expect(device.ObjectsAlive() == 0, "ReleaseObjects leaves objects alive");
+            CreatedBy(renderer, device, board, [] {});  // Объекты создаются заново, их удалит деструктор
+        }
+        result.Expect(device.ObjectsAlive() == 0, "Renderer destructor leaves objects alive");
+    }
+    return result;
+}
+
+// Поле эталонной сцены: квадрат 256x256 клеток, доля занятых клеток своя у каждого участка
+static void FillGolden(Board& board) {
+    std::mt19937 random(7);
+    for (int row = -128; row < 128; ++row) {
+        for (int col = -128; col < 128; ++col) {
+            unsigned eighths = static_cast<unsigned>(Board::ChunkOf(col) * 3 + Board::ChunkOf(row) * 5) & 7;
+            if (random() % 8 < eighths) board.Place(col, row, random() % 2 ? Mark::Cross : Mark::Circle);
+        }
+    }
+}
+
+// Кадр из трех панелей GoldenPanel x GoldenPanel: клетки 16 пикселей, они же с тепловой картой, клетки в пиксель
+static void PaintGolden(const Board& board, const RegionCounter& counter, Framebuffer& frame) {
+    SoftwareDevice device(frame);
+    Renderer renderer(device);
+    Rect client = { 0, 0, frame.Width(), frame.Height() };
+    const int cellSizes[3] = { 16, 16, 1 };
+    for (int panel = 0; panel < 3; ++panel) {
+        Rect clip = { panel * GoldenPanel, 0, (panel + 1) * GoldenPanel, GoldenPanel };
+        Viewport view;
+        view.cellSize = cellSizes[panel];
+        // Середина поля — в середине панели, сдвиг на полклетки проверяет неровный край
+        view.x = -panel * GoldenPanel - GoldenPanel / 2 + view.cellSize / 2;
+        view.y = -GoldenPanel / 2 + view.cellSize / 2;
+        renderer.SetHeatmap(panel == 1 ? &counter : nullptr);
+        device.SetClip(clip);
+        renderer.Paint(board, view, client, clip);
+    }
+}
+
+CheckResult CheckGoldenImage(const std::string& reference, bool update) {
+    CheckResult result;
+    Board board;
+    FillGolden(board);
+    RegionCounter counter(board);
+    counter.Rebuild();
+    Framebuffer frame(GoldenPanel * 3, GoldenPanel);
+    PaintGolden(board, counter, frame);
+
+    if (update) {
+        result.Expect(frame.WritePpm(reference.c_str()), "cannot write " + reference);
+        result.Note("golden image written to " + reference);
+        return result;
+    }
+
+    // Кадр пишется тем же WritePpm, что и эталон, и сравнивается побайтно
+    if (!frame.WritePpm(GoldenActualPath)) {
+        result.Expect(false, std::string("cannot write ") + GoldenActualPath);
+        return result;
+    }
+    MappedFile expected, actual;
+    if (!expected.OpenRead(reference.c_str())) {
+        result.Expect(false, "cannot read " + reference);
+        return result;
+    }
+    actual.OpenRead(GoldenActualPath);
+    result.Expect(expected.Size() == actual.Size(), "golden image size differs");
+    std::size_t differing = 0;
+    if (expected.Size() == actual.Size()) {
+        std::size_t payload = static_cast<std::size_t>(frame.Width()) * frame.Height() * 3;
+        std::size_t header = actual.Size() - payload;
+        for (std::size_t i = header; i < actual.Size(); i += 3) {
+            differing += expected.Data()[i] != actual.Data()[i] || expected.Data()[i + 1] != actual.Data()[i + 1]
+                || expected.Data()[i + 2] != actual.Data()[i + 2];
+        }
+    }
+    char line[160];
+    std::snprintf(line, sizeof(line), "golden image %dx%d: %zu pixels differ", frame.Width(), frame.Height(), differing);
+    result.Note(line);
+    result.Expect(differing == 0, std::string("frame differs from ") + reference + ", see " + GoldenActualPath);
+    if (result.passed) {
+        actual.Close();
+        std::remove(GoldenActualPath);
+    }
+    return result;
+}
@@ -0,0 +1,303 @@
+﻿#include "Renderer.h"
+#include <algorithm>
+#include <climits>
+#include "Profiler.h"
+
+Rect CellDamageRect(int col, int row, const Viewport& view) {
+    // При отдалении клетка меняет оттенок плитки всего участка
+    if (view.cellSize < LodCellSize) {
+        int left = view.ScreenX(Board::ChunkOf(col) * Board::ChunkSize);
+        int top = view.ScreenY(Board::ChunkOf(row) * Board::ChunkSize);
+        int extent = Board::ChunkSize * view.cellSize;
+        return { left, top, left + extent, top + extent };
+    }
+    // Перо толщиной 2 выходит за границу клетки на пиксель, берем с запасом
+    int x = view.ScreenX(col);
+    int y = view.ScreenY(row);
+    return { x - MarkPenWidth, y - MarkPenWidth, x + view.cellSize + MarkPenWidth, y + view.cellSize + MarkPenWidth };
+}
+
+int HeatmapTileCells(int cellSize) {
+    int cells = 2;
+    while (cells * cellSize < HeatmapTilePixels) cells *= 2;
+    return cells;
+}
+
+Rect HeatmapDamageRect(int col, int row, const Viewport& view) {
+    if (view.cellSize < LodCellSize) return CellDamageRect(col, row, view);  // Карта при отдалении не рисуется
+    // Плитки выровнены по клеткам, кратным их стороне (& верно и для отрицательных); перо крайней клетки выходит за плитку
+    int cells = HeatmapTileCells(view.cellSize);
+    int x = view.ScreenX(col & -cells);
+    int y = view.ScreenY(row & -cells);
+    int extent = cells * view.cellSize;
+    return { x - MarkPenWidth, y - MarkPenWidth, x + extent + MarkPenWidth, y + extent + MarkPenWidth };
+}
+
+Renderer::Renderer(GraphicsDevice& device) : device(device) {
+    colors[BackgroundBrush] = MakeColor(0, 0, 255);
+    colors[GridPen] = MakeColor(255, 0, 0);
+    colors[CirclePen] = CircleColor;
+    colors[CrossPen] = CrossColor;
+}
+
+Renderer::~Renderer() {
+    ReleaseObjects();
+}
+
+void Renderer::SetBackgroundColor(Color color) {
+    SetSlotColor(BackgroundBrush, color);
+}
+
+void Renderer::SetGridColor(Color color) {
+    SetSlotColor(GridPen, color);
+}
+
+void Renderer::SetSlotColor(Slot slot, Color color) {
+    if (colors[slot] == color) return;
+    colors[slot] = color;
+    if (slot == BackgroundBrush) ReleaseDensityBrushes();  // Оттенки плиток смешиваются с фоном
+    if (slot == BackgroundBrush || slot == GridPen) ReleaseGridPattern();
+    // Объект со старым цветом больше не нужен, новый создадим при первом использовании
+    if (objects[slot]) {
+        device.DestroyObject(objects[slot]);
+        objects[slot] = 0;
+    }
+}
+
+GfxObject Renderer::Object(Slot slot) {
+    if (!objects[slot]) {
+        objects[slot] = slot == BackgroundBrush
+            ? device.CreateBrushObject(colors[slot])
+            : device.CreatePenObject(colors[slot], slot == GridPen ? 1 : MarkPenWidth);
+    }
+    return objects[slot];
+}
+
+void Renderer::SelectPen(Slot slot) {
+    GfxObject pen = Object(slot);
+    if (selectedPen == slot) return;
+    device.SelectPenObject(pen);
+    selectedPen = slot;
+}
+
+GfxObject Renderer::DensityBrush(bool crosses, int level) {
+    GfxObject& brush = densityBrushes[crosses][level];
+    if (!brush) {
+        // Оттенок между фоном и цветом преобладающих меток
+        Color background = colors[BackgroundBrush];
+        Color target = crosses ? CrossColor : CircleColor;
+        int weight = level + 1;
+        auto mix = [&](int from, int to) { return from + (to - from) * weight / DensityLevels; };
+        brush = device.CreateBrushObject(MakeColor(mix(ColorR(background), ColorR(target)),
+            mix(ColorG(background), ColorG(target)), mix(ColorB(background), ColorB(target))));
+    }
+    return brush;
+}
+
+void Renderer::ReleaseDensityBrushes() {
+    for (auto& row : densityBrushes) {
+        for (GfxObject& brush : row) {
+            if (brush) device.DestroyObject(brush);
+            brush = 0;
+        }
+    }
+}
+
+GfxObject Renderer::GridPattern(int cellSize) {
+    if (gridPattern && gridPatternSize == cellSize) return gridPattern;
+    ReleaseGridPattern();
+    // Клетка цвета фона, верхняя строка и левый столбец — линии сетки
+    patternPixels.assign(static_cast<std::size_t>(cellSize) * cellSize, colors[BackgroundBrush]);
+    for (int i = 0; i < cellSize; ++i) {
+        patternPixels[i] = colors[GridPen];
+        patternPixels[static_cast<std::size_t>(i) * cellSize] = colors[GridPen];
+    }
+    gridPattern = device.CreatePatternObject(patternPixels.data(), cellSize, cellSize);
+    gridPatternSize = cellSize;
+    return gridPattern;
+}
+
+void Renderer::ReleaseGridPattern() {
+    if (gridPattern) device.DestroyObject(gridPattern);
+    gridPattern = 0;
+    gridPatternSize = 0;
+}
+
+void Renderer::ReleaseObjects() {
+    for (GfxObject& object : objects) {
+        if (object) device.DestroyObject(object);
+        object = 0;
+    }
+    ReleaseDensityBrushes();
+    ReleaseGridPattern();
+    selectedPen = -1;
+}
+
+void Renderer::Paint(const Board& board, const Viewport& view, const Rect& client, const Rect& clip) {
+    selectedPen = -1;  // Контекст устройства у каждого кадра свой
+
+    if (view.cellSize < LodCellSize) {
+        // Линии и метки сливались бы в шум: рисуем по плитке на участок
+        device.FillRectangle(clip, Object(BackgroundBrush));
+        DrawDensity(board, view, clip);
+        return;
+    }
+    if (heatmap) {
+        // Плитки карты лежат под сеткой, поэтому узор фона с сеткой здесь не годится
+        device.FillRectangle(clip, Object(BackgroundBrush));
+        DrawHeatmap(view, clip);
+        DrawGrid(view, client, clip);
+    }
+    else if (gridCache && view.cellSize <= MaxGridPatternSize) {
+        // Фон и сетка одной заливкой: угол узора — на границе клетки (0, 0), приведенной в [0, cellSize)
+        PROFILE_SCOPE("draw.grid.pattern");
+        int size = view.cellSize;
+        int originX = static_cast<int>(((-view.x) % size + size) % size);
+        int originY = static_cast<int>(((-view.y) % size + size) % size);
+        device.FillPattern(clip, GridPattern(size), originX, originY);
+    }
+    else {
+        device.FillRectangle(clip, Object(BackgroundBrush));  // Заливаем фон
+        DrawGrid(view, client, clip);
+    }
+    DrawCircles(board, view, clip);
+    DrawCrosses(board, view, clip);
+}
+
+// Функция для рисования сетки: все линии, попадающие в clip, одним вызовом
+void Renderer::DrawGrid(const Viewport& view, const Rect& client, const Rect& clip) {
+    PROFILE_SCOPE("draw.grid");
+    int size = view.cellSize;
+    int right = std::min(client.right, clip.right);
+    int bottom = std::min(client.bottom, clip.bottom);
+    int top = std::max(0, clip.top);
+    int left = std::max(0, clip.left);
+
+    points.clear();
+    counts.clear();
+
+    // Вертикальные линии (первая — на ближайшей границе клетки не левее left)
+    for (int x = view.ScreenX(view.ColAt(left - 1) + 1); x < right; x += size) {
+        points.push_back({ x, top });
+        points.push_back({ x, bottom });
+        counts.push_back(2);
+    }
+
+    // Горизонтальные линии
+    for (int y = view.ScreenY(view.RowAt(top - 1) + 1); y < bottom; y += size) {
+        points.push_back({ left, y });
+        points.push_back({ right, y });
+        counts.push_back(2);
+    }
+
+    if (counts.empty()) return;
+    SelectPen(GridPen);
+    device.DrawPolyPolyline(points.data(), counts.data(), counts.size());
+}
+
+// Диапазон клеток, метки которых (с учетом толщины пера) могут попасть в clip
+static void CellRange(const Rect& clip, const Viewport& view, int& col0, int& row0, int& col1, int& row1) {
+    col0 = view.ColAt(clip.left - MarkPenWidth);
+    row0 = view.RowAt(clip.top - MarkPenWidth);
+    col1 = view.ColAt(clip.right + MarkPenWidth) + 1;
+    row1 = view.RowAt(clip.bottom + MarkPenWidth) + 1;
+}
+
+// Функция для рисования кругов. Эллипсы в GDI не группируются, но перо выбирается один раз
+void Renderer::DrawCircles(const Board& board, const Viewport& view, const Rect& clip) {
+    PROFILE_SCOPE("draw.circles");
+    int col0, row0, col1, row1;
+    CellRange(clip, view, col0, row0, col1, row1);
+    int cellSize = view.cellSize;
+    int radius = cellSize / 2;
+
+    board.ForEachIn(col0, row0, col1, row1, [&](int col, int row, Mark mark) {
+        if (mark != Mark::Circle) return;
+        int x = view.ScreenX(col) + cellSize / 2;  // Центр клетки по оси X
+        int y = view.ScreenY(row) + cellSize / 2;  // Центр клетки по оси Y
+        SelectPen(CirclePen);
+        device.DrawEllipse(x - radius, y - radius, x + radius, y + radius);
+    });
+}
+
+// Функция для рисования крестов: обе линии каждого креста в одной пачке
+void Renderer::DrawCrosses(const Board& board, const Viewport& view, const Rect& clip) {
+    PROFILE_SCOPE("draw.crosses");
+    int col0, row0, col1, row1;
+    CellRange(clip, view, col0, row0, col1, row1);
+    int cellSize = view.cellSize;
+    int half = cellSize / 2 / 2;
+
+    points.clear();
+    counts.clear();
+    board.ForEachIn(col0, row0, col1, row1, [&](int col, int row, Mark mark) {
+        if (mark != Mark::Cross) return;
+        int x = view.ScreenX(col) + cellSize / 2;  // Центр клетки по оси X
+        int y = view.ScreenY(row) + cellSize / 2;  // Центр клетки по оси Y
+        points.push_back({ x - half, y - half });
+        points.push_back({ x + half, y + half });
+        points.push_back({ x + half, y - half });
+        points.push_back({ x - half, y + half });
+        counts.push_back(2);
+        counts.push_back(2);
+    });
+
+    if (counts.empty()) return;
+    SelectPen(CrossPen);
+    device.DrawPolyPolyline(points.data(), counts.data(), counts.size());
+}
+
+// Номер старшего единичного бита (0 для 1)
+static int FloorLog2(std::uint32_t x) {
+    int log = 0;
+    while (x >>= 1) ++log;
+    return log;
+}
+
+// Плитки плотности: один прямоугольник на непустой участок, оттенок растет с логарифмом числа меток
+void Renderer::DrawDensity(const Board& board, const Viewport& view, const Rect& clip) {
+    PROFILE_SCOPE("draw.density");
+    int chunk0Col = Board::ChunkOf(view.ColAt(clip.left));
+    int chunk0Row = Board::ChunkOf(view.RowAt(clip.top));
+    int chunk1Col = Board::ChunkOf(view.ColAt(clip.right - 1)) + 1;
+    int chunk1Row = Board::ChunkOf(view.RowAt(clip.bottom - 1)) + 1;
+    const int maxLog = FloorLog2(Board::ChunkSize * Board::ChunkSize);
+
+    board.ForEachChunkIn(chunk0Col, chunk0Row, chunk1Col, chunk1Row, [&](int chunkCol, int chunkRow, const BoardChunk& chunk) {
+        int level = FloorLog2(chunk.Marks()) * (DensityLevels - 1) / maxLog;
+        int left = view.ScreenX(chunkCol * Board::ChunkSize);
+        int top = view.ScreenY(chunkRow * Board::ChunkSize);
+        int extent = Board::ChunkSize * view.cellSize;
+        Rect tile = { std::max(left, clip.left), std::max(top, clip.top),
+            std::min(left + extent, clip.right), std::min(top + extent, clip.bottom) };
+        device.FillRectangle(tile, DensityBrush(chunk.crosses > chunk.circles, level));
+    });
+}
+
+// Тепловая карта: плитка на каждый квадрат HeatmapTileCells клеток, где есть метки. Число меток
+// берется запросом к счетчику, оттенок растет с его логарифмом, но не выше половины цвета меток,
+// чтобы метки оставались видны поверх плитки
+void Renderer::DrawHeatmap(const Viewport& view, const Rect& clip) {
+    PROFILE_SCOPE("draw.heatmap");
+    int cells = HeatmapTileCells(view.cellSize);
+    std::int64_t col0 = view.ColAt(clip.left) & -cells;
+    std::int64_t row0 = view.RowAt(clip.top) & -cells;
+    std::int64_t col1 = static_cast<std::int64_t>(view.ColAt(clip.right - 1)) + 1;
+    std::int64_t row1 = static_cast<std::int64_t>(view.RowAt(clip.bottom - 1)) + 1;
+    const int maxLog = FloorLog2(static_cast<std::uint32_t>(cells) * cells);
+    int extent = cells * view.cellSize;
+
+    for (std::int64_t row = row0; row < row1; row += cells) {
+        for (std::int64_t col = col0; col < col1; col += cells) {
+            RegionCount count = heatmap->Count(static_cast<int>(col), static_cast<int>(row),
+                static_cast<int>(std::min<std::int64_t>(col + cells, INT_MAX)), static_cast<int>(std::min<std::int64_t>(row + cells, INT_MAX)));
+            if (count.Marks() == 0) continue;
+            int level = FloorLog2(static_cast<std::uint32_t>(count.Marks())) * (DensityLevels / 2 - 1) / maxLog;
+            int left = view.ScreenX(static_cast<int>(col));
+            int top = view.ScreenY(static_cast<int>(row));
+            Rect tile = { std::max(left, clip.left), std::max(top, clip.top),
+                std::min(left + extent, clip.right), std::min(top + extent, clip.bottom) };
+            device.FillRectangle(tile, DensityBrush(count.crosses > count.circles, level));
+        }
+    }
+}
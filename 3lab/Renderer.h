@@ -0,0 +1,90 @@
+﻿#pragma once
+#include <vector>
+#include "Board.h"
+#include "Graphics.h"
+#include "RegionCounter.h"
+#include "Viewport.h"
+
+const Color CircleColor = MakeColor(0, 255, 0);   // Цвет кругов (зеленый)
+const Color CrossColor = MakeColor(255, 255, 0);  // Цвет крестов (желтый)
+const int MarkPenWidth = 2;                        // Толщина пера для кругов и крестов
+const int LodCellSize = 4;     // Клетки мельче этого рисуются плитками плотности вместо сетки и меток
+const int DensityLevels = 8;   // Число оттенков плитки плотности
+const int MaxGridPatternSize = 128;  // Клетки крупнее рисуются линиями: их на экране мало, а узор занимал бы много памяти
+const int HeatmapTilePixels = 96;    // Наименьшая сторона плитки тепловой карты на экране
+
+// Прямоугольник клетки на экране вместе с запасом на толщину пера меток.
+// Именно его нужно перерисовывать после изменения одной клетки (при отдалении — плитку всего участка)
+Rect CellDamageRect(int col, int row, const Viewport& view);
+// Сторона плитки тепловой карты в клетках: степень двойки не меньше 2, плитка не мельче HeatmapTilePixels
+int HeatmapTileCells(int cellSize);
+// То же при включенной тепловой карте: клетка меняет оттенок всей своей плитки
+Rect HeatmapDamageRect(int col, int row, const Viewport& view);
+
+// Рисует видимую часть поля через GraphicsDevice.
+// Перья и кисти создаются один раз и пересоздаются только при смене цвета,
+// все линии сетки и все кресты уходят на устройство одним вызовом DrawPolyPolyline.
+// Фон и сетка периодичны с шагом в клетку, поэтому рисуются одной заливкой узором: клетка
+// цвета фона с линией сетки по левому и верхнему краю. Узор строится один раз и пересоздается
+// только при смене размера клетки или цветов (размер окна на него не влияет).
+// При сильном отдалении (клетка меньше LodCellSize) каждый участок 64x64 рисуется
+// одной плиткой, оттенок которой зависит от числа меток на нем. Тепловая карта так же
+// подкрашивает под сеткой плитки HeatmapTileCells x HeatmapTileCells клеток, числа меток
+// в которых берутся из RegionCounter
+class Renderer {
+public:
+    explicit Renderer(GraphicsDevice& device);
+    ~Renderer();
+
+    Renderer(const Renderer&) = delete;
+    Renderer& operator=(const Renderer&) = delete;
+
+    void SetBackgroundColor(Color color);
+    void SetGridColor(Color color);
+    Color BackgroundColor() const { return colors[BackgroundBrush]; }
+    Color GridColor() const { return colors[GridPen]; }
+    // Узор фона с сеткой (по умолчанию включен; выключается для сравнения в замерах)
+    void SetGridCache(bool enabled) { gridCache = enabled; }
+    bool GridCache() const { return gridCache; }
+    // Тепловая карта по счетчику меток (nullptr — выключена). Счетчик должен следить за тем же полем
+    void SetHeatmap(const RegionCounter* counter) { heatmap = counter; }
+    const RegionCounter* Heatmap() const { return heatmap; }
+
+    // Рисует фон, сетку и метки, попадающие в clip. client — клиентская область окна
+    void Paint(const Board& board, const Viewport& view, const Rect& client, const Rect& clip);
+
+    void DrawGrid(const Viewport& view, const Rect& client, const Rect& clip);  // Функция рисования сетки
+    void DrawCircles(const Board& board, const Viewport& view, const Rect& clip);  // Функция рисования кругов
+    void DrawCrosses(const Board& board, const Viewport& view, const Rect& clip);  // Функция рисования крестов
+    void DrawDensity(const Board& board, const Viewport& view, const Rect& clip);  // Плитки плотности при отдалении
+    void DrawHeatmap(const Viewport& view, const Rect& clip);  // Плитки тепловой карты
+
+    // Удаляет все созданные объекты устройства (они будут созданы заново при следующем кадре)
+    void ReleaseObjects();
+
+private:
+    // Кэшируемые объекты устройства
+    enum Slot { BackgroundBrush, GridPen, CirclePen, CrossPen, SlotCount };
+
+    GfxObject Object(Slot slot);
+    GfxObject DensityBrush(bool crosses, int level);
+    void SetSlotColor(Slot slot, Color color);
+    void SelectPen(Slot slot);
+    void ReleaseDensityBrushes();
+    GfxObject GridPattern(int cellSize);
+    void ReleaseGridPattern();
+
+    GraphicsDevice& device;
+    GfxObject objects[SlotCount] = {};  // Созданные объекты (0 — еще не создан)
+    Color colors[SlotCount] = {};       // Цвет, с которым объект должен быть создан
+    int selectedPen = -1;               // Слот пера, выбранного в текущем кадре
+    GfxObject densityBrushes[2][DensityLevels] = {};  // Кисти плиток: [перевес крестов][оттенок]
+    bool gridCache = true;
+    const RegionCounter* heatmap = nullptr;
+    GfxObject gridPattern = 0;          // Узор фона с сеткой (0 — еще не создан)
+    int gridPatternSize = 0;            // Размер клетки, для которого он построен
+    std::vector<Color> patternPixels;   // Картинка узора (буфер переиспользуется)
+
+    std::vector<Point> points;          // Буфер точек для пакетной отправки линий
+    std::vector<std::uint32_t> counts;  // Число точек в каждой ломаной
+};
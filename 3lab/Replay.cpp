@@ -0,0 +1,232 @@
+﻿#include "Replay.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include "Board.h"
+#include "BoardHistory.h"
+#include "Framebuffer.h"
+#include "FrameScheduler.h"
+#include "GameController.h"
+#include "Renderer.h"
+#include "SoftwareDevice.h"
+
+bool PresentFrame(FrameScheduler& frames, FrameDamage& damage, Renderer& renderer, SoftwareDevice& device,
+    Framebuffer& frame, const Board& board, const Viewport& view, std::uint64_t nowMs) {
+    if (!frames.TakeFrame(nowMs, damage)) return false;
+
+    Rect client = { 0, 0, frame.Width(), frame.Height() };
+    if (damage.full) {
+        damage.rects.assign(1, client);
+    }
+    else if (damage.scrollX != 0 || damage.scrollY != 0) {
+        frame.Scroll(damage.scrollX, damage.scrollY);
+        int dx = damage.scrollX;
+        int dy = damage.scrollY;
+        if (dx > 0) damage.rects.push_back({ 0, 0, dx, client.bottom });
+        if (dx < 0) damage.rects.push_back({ client.right + dx, 0, client.right, client.bottom });
+        if (dy > 0) damage.rects.push_back({ 0, 0, client.right, dy });
+        if (dy < 0) damage.rects.push_back({ 0, client.bottom + dy, client.right, client.bottom });
+    }
+    for (const Rect& rect : damage.rects) {
+        device.SetClip(rect);
+        renderer.Paint(board, view, client, rect);
+    }
+    device.ResetClip();
+    return true;
+}
+
+ReplayReport ReplayTrace(const std::vector<InputEvent>& events, const Settings& settings) {
+    typedef std::chrono::steady_clock Clock;
+
+    Board board;
+    Framebuffer frame(settings.windowWidth, settings.windowHeight);
+    SoftwareDevice device(frame);
+    Renderer renderer(device);
+    FrameScheduler frames;
+    FrameDamage damage;
+    BoardHistory history;  // Ctrl+Z / Ctrl+Y в трассе отменяют и повторяют ходы, как в окне
+    GameController controller(board, renderer, frames);
+    controller.SetHistory(&history);
+    controller.SetRandomSeed(1);
+    controller.ApplySettings(settings);
+    PresentFrame(frames, damage, renderer, device, frame, board, controller.View());  // Первый кадр не замеряется
+
+    ReplayReport report;
+    std::vector<double> latencies;
+    latencies.reserve(events.size());
+    double kindTotals[InputKindCount] = {};
+    Clock::time_point start = Clock::now();
+    for (const InputEvent& event : events) {
+        Clock::time_point begin = Clock::now();
+        ControllerAction action = controller.Handle(event);
+        if (event.kind == InputKind::Resize) {
+            frame.Resize(event.x, event.y);  // Окно само перерисовывает себя после изменения размера
+            device.ResetClip();
+            controller.InvalidateAll();
+        }
+        if (PresentFrame(frames, damage, renderer, device, frame, board, controller.View())) ++report.frames;
+        double us = std::chrono::duration<double, std::micro>(Clock::now() - begin).count();
+
+        latencies.push_back(us);
+        ++report.kindCounts[static_cast<int>(event.kind)];
+        kindTotals[static_cast<int>(event.kind)] += us;
+        if (action == ControllerAction::Quit) break;
+    }
+    report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    report.events = latencies.size();
+    report.pixels = device.PixelsWritten();
+    report.marks = board.Count(Mark::Circle) + board.Count(Mark::Cross);
+    for (int i = 0; i < InputKindCount; ++i) {
+        if (report.kindCounts[i] > 0) report.kindMeanUs[i] = kindTotals[i] / report.kindCounts[i];
+    }
+    if (!latencies.empty()) {
+        double total = 0;
+        for (double us : latencies) total += us;
+        report.meanUs = total / latencies.size();
+        std::sort(latencies.begin(), latencies.end());
+        report.p50Us = latencies[(latencies.size() - 1) / 2];
+        report.p99Us = latencies[(latencies.size() - 1) * 99 / 100];
+        report.maxUs = latencies.back();
+    }
+    return report;
+}
+
+std::string FormatReplayReport(const ReplayReport& report) {
+    char line[160];
+    std::string text;
+    std::snprintf(line, sizeof(line), "events %zu in %.3f s: %.0f events/s, %zu frames, %zu marks\n",
+        report.events, report.seconds, report.EventsPerSecond(), report.frames, report.marks);
+    text += line;
+    std::snprintf(line, sizeof(line), "latency us: mean %.2f p50 %.2f p99 %.2f max %.2f\n",
+        report.meanUs, report.p50Us, report.p99Us, report.maxUs);
+    text += line;
+    std::snprintf(line, sizeof(line), "pixels %llu (%.1f Mpix/s)\n", static_cast<unsigned long long>(report.pixels),
+        report.seconds > 0 ? report.pixels / report.seconds / 1e6 : 0.0);
+    text += line;
+    for (int i = 0; i < InputKindCount; ++i) {
+        if (report.kindCounts[i] == 0) continue;
+        std::snprintf(line, sizeof(line), "  %-7s %8zu events, mean %.2f us\n",
+            InputKindName(static_cast<InputKind>(i)), report.kindCounts[i], report.kindMeanUs[i]);
+        text += line;
+    }
+    return text;
+}
+
+FrameBurstReport MeasureFrameBurst(std::size_t count, double spacingMs, const Settings& settings) {
+    Board board;
+    Framebuffer frame(settings.windowWidth, settings.windowHeight);
+    SoftwareDevice device(frame);
+    Renderer renderer(device);
+    FrameScheduler frames;
+    FrameDamage damage;
+    GameController controller(board, renderer, frames);
+    controller.SetRandomSeed(1);
+    controller.ApplySettings(settings);
+    PresentFrame(frames, damage, renderer, device, frame, board, controller.View());  // Первый кадр — до пачки
+
+    FrameBurstReport report;
+    report.events = count;
+    report.spacingMs = spacingMs;
+    report.intervalMs = frames.Interval();
+    std::uint64_t requests0 = frames.Requests();
+    std::uint64_t frames0 = frames.Frames();
+
+    // Начало пачки сдвинуто на интервал: первый кадр пачки не ждет кадра до нее
+    std::uint64_t startMs = frames.Interval();
+    std::uint64_t timerMs = 0;
+    std::mt19937 random(1);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint64_t nowMs = startMs + static_cast<std::uint64_t>(i * spacingMs);
+        // Таймер кадра срабатывает раньше следующего события
+        if (frames.TimerArmed() && timerMs <= nowMs) {
+            frames.TimerFired();
+            PresentFrame(frames, damage, renderer, device, frame, board, controller.View(), timerMs);
+        }
+        int x = static_cast<int>(random() % static_cast<unsigned>(settings.windowWidth));
+        int y = static_cast<int>(random() % static_cast<unsigned>(settings.windowHeight));
+        if (i % 2 == 0) {
+            controller.Handle({ InputKind::Wheel, 0, x, y, random() % 2 ? 120 : -120 });
+        }
+        else {
+            controller.Handle({ random() % 2 ? InputKind::LeftDown : InputKind::RightDown, 0, x, y, 0 });
+        }
+        // То же решение, что в RequestFrame окна: кадр сразу или один таймер на все события до него
+        unsigned delay = 0;
+        switch (frames.RequestFrame(nowMs, delay)) {
+        case FrameAction::Present: PresentFrame(frames, damage, renderer, device, frame, board, controller.View(), nowMs); break;
+        case FrameAction::ArmTimer: timerMs = nowMs + delay; break;
+        default: break;
+        }
+    }
+    std::uint64_t endMs = startMs + static_cast<std::uint64_t>((count ? count - 1 : 0) * spacingMs);
+    if (frames.TimerArmed()) {
+        frames.TimerFired();
+        PresentFrame(frames, damage, renderer, device, frame, board, controller.View(), timerMs);
+        endMs = timerMs;
+    }
+
+    report.burstMs = static_cast<double>(endMs - startMs);
+    report.requests = frames.Requests() - requests0;
+    report.frames = frames.Frames() - frames0;
+    report.maxFrames = (endMs - startMs) / report.intervalMs + 1;
+    report.marks = board.Count(Mark::Circle) + board.Count(Mark::Cross);
+    report.bounded = report.frames <= report.maxFrames && !frames.Dirty() && (count == 0 || report.frames > 0);
+    return report;
+}
+
+std::string FormatFrameBurst(const FrameBurstReport& report) {
+    char line[200];
+    std::string text;
+    std::snprintf(line, sizeof(line), "events %zu, %.2f ms apart, burst %.0f ms, frame interval %u ms, %zu marks\n",
+        report.events, report.spacingMs, report.burstMs, report.intervalMs, report.marks);
+    text += line;
+    std::snprintf(line, sizeof(line), "repaint requests %llu, frames %llu (at most %llu): %s\n",
+        static_cast<unsigned long long>(report.requests), static_cast<unsigned long long>(report.frames),
+        static_cast<unsigned long long>(report.maxFrames), report.bounded ? "bounded by the frame rate" : "NOT BOUNDED");
+    text += line;
+    return text;
+}
+
+std::vector<InputEvent> GenerateInputTrace(std::size_t count, unsigned seed, int width, int height) {
+    std::mt19937 random(seed);
+    std::vector<InputEvent> events;
+    events.reserve(count);
+    auto point = [&](int limit) { return static_cast<int>(random() % static_cast<unsigned>(limit > 0 ? limit : 1)); };
+
+    while (events.size() < count) {
+        unsigned roll = random() % 100;
+        if (roll < 40) {
+            events.push_back({ InputKind::LeftDown, 0, point(width), point(height), 0 });
+        }
+        else if (roll < 60) {
+            events.push_back({ InputKind::RightDown, 0, point(width), point(height), 0 });
+        }
+        else if (roll < 75) {
+            // Колесико: чаще цвет сетки, иногда масштаб под курсором
+            std::uint8_t modifiers = random() % 4 == 0 ? ModControl : 0;
+            events.push_back({ InputKind::Wheel, modifiers, point(width), point(height), random() % 2 ? 120 : -120 });
+        }
+        else if (roll < 87) {
+            // Перетаскивание средней кнопкой: нажатие, несколько движений, отпускание
+            int x = point(width), y = point(height);
+            events.push_back({ InputKind::MiddleDown, 0, x, y, 0 });
+            for (int steps = 2 + random() % 8; steps > 0; --steps) {
+                x += static_cast<int>(random() % 21) - 10;
+                y += static_cast<int>(random() % 21) - 10;
+                events.push_back({ InputKind::MouseMove, 0, x, y, 0 });
+            }
+            events.push_back({ InputKind::MiddleUp, 0, x, y, 0 });
+        }
+        else if (roll < 97) {
+            static const int keys[] = { KeyLeft, KeyRight, KeyUp, KeyDown, KeyEnter };
+            events.push_back({ InputKind::Key, 0, 0, 0, keys[random() % 5] });
+        }
+        else {
+            events.push_back({ InputKind::Resize, 0, width / 2 + point(width), height / 2 + point(height), 0 });
+        }
+    }
+    events.resize(count);  // Перетаскивание могло выйти за нужное число событий
+    return events;
+}
@@ -0,0 +1,66 @@
+﻿#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "FrameScheduler.h"
+#include "Framebuffer.h"
+#include "InputTrace.h"
+#include "Renderer.h"
+#include "Settings.h"
+#include "SoftwareDevice.h"
+
+// Итог воспроизведения трассы
+struct ReplayReport {
+    std::size_t events = 0;       // Обработано событий
+    std::size_t frames = 0;       // Выведено кадров
+    double seconds = 0;           // Время обработки и отрисовки всех событий
+    double meanUs = 0;            // Задержка события: от получения до готового кадра
+    double p50Us = 0;
+    double p99Us = 0;
+    double maxUs = 0;
+    std::uint64_t pixels = 0;     // Записано пикселей
+    std::size_t marks = 0;        // Меток на поле после воспроизведения
+    std::size_t kindCounts[InputKindCount] = {};
+    double kindMeanUs[InputKindCount] = {};
+
+    double EventsPerSecond() const { return seconds > 0 ? events / seconds : 0; }
+};
+
+// Прогоняет трассу через GameController и программный рендерер без окна. После каждого
+// события выводится кадр с накопленными повреждениями (как если бы события приходили
+// реже интервала кадра), так что задержка включает и обработку, и отрисовку.
+// Событие Quit (Esc, Ctrl+Q) завершает воспроизведение, как и в окне
+ReplayReport ReplayTrace(const std::vector<InputEvent>& events, const Settings& settings);
+
+// Выводит накопленные повреждения в кадр так же, как PresentFrame и WM_PAINT в окне:
+// сдвиг копирует уже нарисованное, перерисовываются только открывшиеся полосы и отмеченные области.
+// Возвращает false, если выводить нечего. nowMs — время кадра для планировщика
+bool PresentFrame(FrameScheduler& frames, FrameDamage& damage, Renderer& renderer, SoftwareDevice& device,
+    Framebuffer& frame, const Board& board, const Viewport& view, std::uint64_t nowMs = 0);
+
+// Итог пачки событий, пришедших чаще интервала кадра
+struct FrameBurstReport {
+    std::size_t events = 0;
+    double spacingMs = 0;         // Промежуток между событиями
+    double burstMs = 0;           // От первого события до последнего кадра
+    unsigned intervalMs = 0;      // Интервал кадра
+    std::uint64_t requests = 0;   // FrameScheduler::Requests за пачку
+    std::uint64_t frames = 0;     // FrameScheduler::Frames за пачку
+    std::uint64_t maxFrames = 0;  // Не больше одного кадра на интервал (и один в начале пачки)
+    std::size_t marks = 0;        // Меток на поле после пачки
+    bool bounded = false;         // frames <= maxFrames, и последнее состояние выведено
+};
+
+// Пачка из count кликов и прокруток колесика (смена цвета сетки — перерисовка всего окна), пришедших
+// через spacingMs друг за другом. Время модельное: кадр или таймер выбирает FrameScheduler::RequestFrame,
+// как в окне, так что число кадров не зависит от скорости машины
+FrameBurstReport MeasureFrameBurst(std::size_t count, double spacingMs, const Settings& settings);
+
+std::string FormatFrameBurst(const FrameBurstReport& report);
+
+std::string FormatReplayReport(const ReplayReport& report);
+
+// Синтетическая трасса: клики, перетаскивания, колесико, клавиши и изменения размера
+// в окне width x height. Одинаковое зерно дает одинаковую трассу
+std::vector<InputEvent> GenerateInputTrace(std::size_t count, unsigned seed, int width, int height);
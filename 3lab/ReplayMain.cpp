@@ -0,0 +1,249 @@
+﻿// Воспроизведение трассы ввода без окна (для замеров на сборочных машинах, в том числе под Linux).
+//   3lab-replay <trace> [settings.ini]            — прогнать трассу и вывести события в секунду и задержки
+//   3lab-replay --generate <count> <trace> [seed] — записать синтетическую трассу
+//   3lab-replay --scaling [width height cell threads] — отрисовка по плиткам на 1..threads потоках
+//   3lab-replay --games [cols rows length count]  — случайные партии через детектор линий
+//   3lab-replay --grid-cache [width height frames] — кадр фона с сеткой с узором и линиями
+//   3lab-replay --ai-suite [threads depth]        — позиции с известным ответом (код возврата 1 при ошибке)
+//   3lab-replay --ai-bench [ms threads]           — узлы поиска в секунду на 1..threads потоках
+//   3lab-replay --startup [runs]                  — время от запуска процесса до первого кадра (текст и кэш настроек)
+//   3lab-replay --ui-latency [jobMs events]       — задержка ввода при медленной работе в потоке окна и в TaskRuntime,
+//                                                   в Linux — и с сервером партий (код возврата 1, если поле окна не сошлось с сервером)
+//   3lab-replay --history [moves side]            — память и переходы истории ходов (код возврата 1 при расхождении)
+//   3lab-replay --regions [side density queries]  — запросы числа меток в прямоугольниках и кадр с тепловой картой
+//   3lab-replay --snapshot [marks runs]           — загрузка и запись снимка поля против текстовой записи
+//   3lab-replay --journal [records]               — дозапись журнала ходов: без сброса, групповая фиксация, fsync на ход
+//   3lab-replay --burst [events spacingMs]        — пачка событий чаще кадра: просьбы о перерисовке против кадров
+// В Windows-сборку окна этот файл не входит: у нее своя точка входа wWinMain
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "AiBench.h"
+#include "BoardHistory.h"
+#include "GameBench.h"
+#include "GameRules.h"
+#include "HistoryBench.h"
+#include "InputTrace.h"
+#include "JournalBench.h"
+#include "MappedFile.h"
+#include "RegionBench.h"
+#include "RenderBench.h"
+#include "Replay.h"
+#include "Settings.h"
+#include "SnapshotBench.h"
+#include "StartupBench.h"
+#include "TaskBench.h"
+#ifdef __linux__
+#include "ServerBench.h"
+#endif
+
+int main(int argc, char** argv) {
+    if (argc >= 4 && std::string_view(argv[1]) == "--generate") {
+        std::size_t count = std::strtoul(argv[2], nullptr, 10);
+        unsigned seed = argc > 4 ? static_cast<unsigned>(std::strtoul(argv[4], nullptr, 10)) : 1;
+        Settings settings = DefaultSettings();
+        if (!SaveInputTrace(argv[3], GenerateInputTrace(count, seed, settings.windowWidth, settings.windowHeight))) {
+            std::fprintf(stderr, "cannot write %s\n", argv[3]);
+            return 1;
+        }
+        return 0;
+    }
+    if (argc >= 2 && std::string_view(argv[1]) == "--scaling") {
+        // По умолчанию — экран 4K, мелкая клетка и поле, занятое наполовину
+        int width = argc > 2 ? std::atoi(argv[2]) : 3840;
+        int height = argc > 3 ? std::atoi(argv[3]) : 2160;
+        int cellSize = argc > 4 ? std::atoi(argv[4]) : 12;
+        unsigned threads = argc > 5 ? static_cast<unsigned>(std::atoi(argv[5])) : std::thread::hardware_concurrency();
+        if (width <= 0 || height <= 0 || cellSize <= 0 || threads == 0) {
+            std::fprintf(stderr, "bad scaling parameters\n");
+            return 2;
+        }
+        std::fputs(FormatRenderScaling(MeasureRenderScaling(width, height, cellSize, 0.5, threads, 20)).c_str(), stdout);
+        return 0;
+    }
+    if (argc >= 2 && std::string_view(argv[1]) == "--grid-cache") {
+        int width = argc > 2 ? std::atoi(argv[2]) : 1920;
+        int height = argc > 3 ? std::atoi(argv[3]) : 1080;
+        int frames = argc > 4 ? std::atoi(argv[4]) : 50;
+        if (width <= 0 || height <= 0 || frames <= 0) {
+            std::fprintf(stderr, "bad grid cache parameters\n");
+            return 2;
+        }
+        std::fputs(FormatGridCache(MeasureGridCache(width, height, { 4, 8, 16, 32, 64, 128, 256, 512 }, frames)).c_str(), stdout);
+        return 0;
+    }
+    if (argc >= 2 && std::string_view(argv[1]) == "--games") {
+        // По умолчанию — гомоку на поле 15x15
+        int cols = argc > 2 ? std::atoi(argv[2]) : 15;
+        int rows = argc > 3 ? std::atoi(argv[3]) : 15;
+        int winLength = argc > 4 ? std::atoi(argv[4]) : 5;
+        std::uint64_t games = argc > 5 ? std::strtoull(argv[5], nullptr, 10) : 100000;
+        if (cols <= 0 || rows <= 0 || cols > MaxBoundedSize || rows > MaxBoundedSize || winLength < MinWinLength || winLength > MaxWinLength || games == 0) {
+            std::fprintf(stderr, "bad game parameters\n");
+            return 2;
+        }
+        RandomGamesResult result = MeasureRandomGames(cols, rows, winLength, games, 1);
+        std::fputs(FormatRandomGames(result, cols, rows, winLength).c_str(), stdout);
+        return 0;
+    }
+    if (argc >= 2 && std::string_view(argv[1]) == "--ai-suite") {
+        unsigned threads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 1;
+        int depth = argc > 3 ? std::atoi(argv[3]) : 6;
+        if (threads == 0 || depth <= 0) {
+            std::fprintf(stderr, "bad suite parameters\n");
+            return 2;
+        }
+        std::vector<AiSuiteResult> results = RunAiSuite(threads, depth);
+        std::fputs(FormatAiSuite(results).c_str(), stdout);
+        for (const AiSuiteResult& result : results) {
+            if (!result.passed) return 1;
+        }
+        return 0;
+    }
+    if (argc >= 2 && std::string_view(argv[1]) == "--ai-bench") {
+        int timeMs = argc > 2 ? std::atoi(argv[2]) : 2000;
+        unsigned threads = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : std::thread::hardware_concurrency();
+        if (timeMs <= 0 || threads == 0) {
+            std::fprintf(stderr, "bad bench parameters\n");
+            return 2;
+        }
+        std::fputs(FormatAiScaling(MeasureAiScaling(timeMs, threads)).c_str(), stdout);
+        return 0;
+    }
+    if (argc >= 2 && std::string_view(argv[1]) == "--startup") {
+        int runs = argc > 2 ? std::atoi(argv[2]) : 20;
+        if (runs <= 0) {
+            std::fprintf(stderr, "bad startup parameters\n");
+            return 2;
+        }
+        std::vector<StartupResult> results = MeasureStartup(argv[0], "startup-bench", runs);
+        if (results.size() != 2) {
+            std::fprintf(stderr, "startup run failed\n");
+            return 1;
+        }
+        std::fputs(FormatStartup(results).c_str(), stdout);
+        return 0;
+    }
+    if (argc >= 2 && std::string_view(argv[1]) == "--ui-latency") {
+        int jobMs = argc > 2 ? std::atoi(argv[2]) : 50;
+        long events = argc > 3 ? std::atol(argv[3]) : 3000;
+        if (jobMs <= 0 || events <= 0) {
+            std::fprintf(stderr, "bad latency parameters\n");
+            return 2;
+        }
+        // Событие раз в миллисекунду (быстрое перетаскивание мышью), медленная работа — каждые 100 событий
+        std::vector<UiLatencyResult> results = MeasureUiLatency(jobMs, static_cast<std::size_t>(events), 1000, 100);
+#ifdef __linux__
+        std::vector<UiLatencyResult> server = MeasureServerUiLatency(jobMs, static_cast<std::size_t>(events), 1000, 100);
+        results.insert(results.end(), server.begin(), server.end());
+#endif
+        std::fputs(FormatUiLatency(results).c_str(), stdout);
+        for (const UiLatencyResult& result : results) {
+            if (!result.match) return 1;
+        }
+        return 0;
+    }
+    if (argc >= 2 && std::string_view(argv[1]) == "--history") {
+        // По умолчанию — миллион ходов на квадрате 2000x2000 (занята четверть клеток)
+        long moves = argc > 2 ? std::atol(argv[2]) : 1000000;
+        int side = argc > 3 ? std::atoi(argv[3]) : 2000;
+        if (moves <= 0 || side <= 0 || static_cast<double>(side) * side < moves) {
+            std::fprintf(stderr, "bad history parameters\n");
+            return 2;
+        }
+        HistoryCopyCost copyCost;
+        std::vector<HistoryBenchResult> results = MeasureHistory(static_cast<std::size_t>(moves), side,
+            { 1, 4, HistoryCheckpointMoves, 64 }, 1000, &copyCost);
+        std::fputs(FormatHistory(results, copyCost).c_str(), stdout);
+        for (const HistoryBenchResult& result : results) {
+            if (!result.match) return 1;
+        }
+        return 0;
+    }
+    if (argc >= 2 && std::string_view(argv[1]) == "--regions") {
+        // По умолчанию — поле 4096x4096 (16,8 млн клеток), занята четверть
+        int side = argc > 2 ? std::atoi(argv[2]) : 4096;
+        int density = argc > 3 ? std::atoi(argv[3]) : 25;
+        long queries = argc > 4 ? std::atol(argv[4]) : 100000;
+        if (side <= 0 || density < 0 || density > 100 || queries <= 0) {
+            std::fprintf(stderr, "bad regions parameters\n");
+            return 2;
+        }
+        RegionBenchResult result = MeasureRegions(side, density, static_cast<std::size_t>(queries));
+        std::fputs(FormatRegions(result).c_str(), stdout);
+        for (const RegionQueryResult& query : result.queries) {
+            if (!query.match) return 1;
+        }
+        return 0;
+    }
+    if (argc >= 2 && std::string_view(argv[1]) == "--snapshot") {
+        // По умолчанию — миллион меток (квадрат 2000x2000, занята четверть)
+        long marks = argc > 2 ? std::atol(argv[2]) : 1000000;
+        int runs = argc > 3 ? std::atoi(argv[3]) : 5;
+        if (marks <= 0 || runs <= 0) {
+            std::fprintf(stderr, "bad snapshot parameters\n");
+            return 2;
+        }
+        SnapshotBenchResult result = MeasureSnapshot(static_cast<std::size_t>(marks), runs, "3lab-replay-snapshot");
+        std::fputs(FormatSnapshot(result).c_str(), stdout);
+        return result.match ? 0 : 1;
+    }
+    if (argc >= 2 && std::string_view(argv[1]) == "--burst") {
+        long events = argc > 2 ? std::atol(argv[2]) : 1000;
+        double spacingMs = argc > 3 ? std::atof(argv[3]) : 0.25;
+        if (events <= 0 || spacingMs < 0) {
+            std::fprintf(stderr, "bad burst parameters\n");
+            return 2;
+        }
+        FrameBurstReport report = MeasureFrameBurst(static_cast<std::size_t>(events), spacingMs, DefaultSettings());
+        std::fputs(FormatFrameBurst(report).c_str(), stdout);
+        return report.bounded ? 0 : 1;
+    }
+    if (argc >= 2 && std::string_view(argv[1]) == "--journal") {
+        long records = argc > 2 ? std::atol(argv[2]) : 1000000;
+        if (records <= 0) {
+            std::fprintf(stderr, "bad journal parameters\n");
+            return 2;
+        }
+        JournalBenchResult result = MeasureJournal(static_cast<std::size_t>(records), "3lab-replay-bench");
+        std::fputs(FormatJournal(result).c_str(), stdout);
+        return result.match ? 0 : 1;
+    }
+    if (argc >= 4 && std::string_view(argv[1]) == "--first-frame") {
+        return RunStartupChild(argv[2], std::string_view(argv[3]) == "cache");  // Дочерний процесс --startup
+    }
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <trace> [settings.ini]\n       %s --generate <count> <trace> [seed]\n"
+            "       %s --scaling [width height cell threads]\n       %s --games [cols rows length count]\n"
+            "       %s --grid-cache [width height frames]\n       %s --ai-suite [threads depth]\n       %s --ai-bench [ms threads]\n"
+            "       %s --startup [runs]\n       %s --ui-latency [jobMs events]\n       %s --history [moves side]\n"
+            "       %s --regions [side density queries]\n       %s --snapshot [marks runs]\n"
+            "       %s --journal [records]\n"
+            "       %s --burst [events spacingMs]\n",
+            argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+        return 2;
+    }
+
+    std::vector<InputEvent> events;
+    std::size_t badLines = 0;
+    if (!LoadInputTrace(argv[1], events, &badLines)) {
+        std::fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 1;
+    }
+    if (badLines > 0) std::fprintf(stderr, "%zu malformed lines skipped\n", badLines);
+
+    // Настройки влияют на размер кадра и масштаб, поэтому их лучше брать те же, что на машине с окном
+    Settings settings = DefaultSettings();
+    if (argc > 2) {
+        MappedFile file;
+        if (!file.OpenRead(argv[2]) || !ParseSettings(std::string_view(file.Data(), file.Size()), settings).Ok()) {
+            std::fprintf(stderr, "bad settings file %s, using defaults\n", argv[2]);
+        }
+    }
+
+    ReplayReport report = ReplayTrace(events, settings);
+    std::fputs(FormatReplayReport(report).c_str(), stdout);
+    return 0;
+}
@@ -0,0 +1,76 @@
+﻿#include "Checks.h"
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+#include "Board.h"
+#include "GameRules.h"
+
+// Решена ли партия и как: ничья и победа различаются, победитель — нет (при линиях обоих игроков
+// первой считается собранная раньше, а Rebuild учитывает метки не в порядке ходов)
+static int OutcomeKind(GameOutcome outcome) {
+    if (outcome == GameOutcome::None) return 0;
+    return outcome == GameOutcome::Draw ? 1 : 2;
+}
+
+// Правила, изменяемые ходами и снятиями, совпадают с правилами, заново учитывающими поле
+static bool SameAsRebuilt(const GameRules& rules, const Board& board, int cols, int rows) {
+    GameRules rebuilt(rules.WinLength());
+    rebuilt.SetBounds(cols, rows);
+    rebuilt.Rebuild(board);
+    return rules.FullWindows(Mark::Circle) == rebuilt.FullWindows(Mark::Circle)
+        && rules.FullWindows(Mark::Cross) == rebuilt.FullWindows(Mark::Cross)
+        && rules.LiveWindows() == rebuilt.LiveWindows()
+        && OutcomeKind(rules.Outcome()) == OutcomeKind(rebuilt.Outcome());
+}
+
+CheckResult CheckRulesRemove(int games) {
+    CheckResult result;
+    std::mt19937 random(1);
+    // Ограниченное поле (ничья, плотные линии) и бесконечное (отрезки линий в хэш-таблице,
+    // серии через границы 64-клеточных отрезков)
+    const int sizes[2][2] = { { 15, 15 }, { 0, 0 } };
+    for (const auto& size : sizes) {
+        int cols = size[0], rows = size[1];
+        std::size_t checked = 0, mismatches = 0, wins = 0;
+        for (int game = 0; game < games; ++game) {
+            GameRules rules(game % 2 ? 5 : 3);
+            rules.SetBounds(cols, rows);
+            Board board;
+            std::vector<std::pair<int, int>> cells;
+            int side = cols > 0 ? cols : 12;
+            int origin = cols > 0 ? 0 : 64 - side / 2;  // Бесконечное поле: квадрат на стыке отрезков
+            for (int row = 0; row < side; ++row) {
+                for (int col = 0; col < side; ++col) cells.emplace_back(origin + col, origin + row);
+            }
+            std::shuffle(cells.begin(), cells.end(), random);
+            cells.resize(cells.size() * 3 / 4);
+            for (std::size_t i = 0; i < cells.size(); ++i) {
+                Mark mark = i % 2 ? Mark::Cross : Mark::Circle;
+                board.Place(cells[i].first, cells[i].second, mark);
+                rules.Place(cells[i].first, cells[i].second, mark);
+            }
+            if (rules.Outcome() == GameOutcome::CircleWins || rules.Outcome() == GameOutcome::CrossWins) ++wins;
+
+            // Половина партий снимается в обратном порядке (отмена), половина — вразброс
+            if (game % 4 >= 2) std::shuffle(cells.begin(), cells.end(), random);
+            else std::reverse(cells.begin(), cells.end());
+            for (const std::pair<int, int>& cell : cells) {
+                Mark was = board.Get(cell.first, cell.second);
+                bool known = rules.MarkAt(cell.first, cell.second) == was;
+                board.Clear(cell.first, cell.second);
+                rules.Remove(cell.first, cell.second);
+                ++checked;
+                if (!known || rules.MarkAt(cell.first, cell.second) != Mark::Empty || !SameAsRebuilt(rules, board, cols, rows)) {
+                    ++mismatches;
+                }
+            }
+            if (rules.Outcome() != GameOutcome::None) ++mismatches;  // Поле снова пусто
+        }
+        result.Note(std::string(cols > 0 ? "15x15" : "infinite") + ": " + std::to_string(games) + " games, "
+            + std::to_string(wins) + " won, " + std::to_string(checked) + " removals checked, "
+            + std::to_string(mismatches) + " mismatches");
+        result.Expect(mismatches == 0, std::string(cols > 0 ? "bounded" : "infinite") + " board: rules after Remove differ from Rebuild");
+    }
+    return result;
+}
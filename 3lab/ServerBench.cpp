@@ -0,0 +1,323 @@
+﻿#include "ServerBench.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "GameClient.h"
+#include "GameEngine.h"
+#include "GameServer.h"
+#include "Replay.h"
+#include "ServerSession.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// Посредник между окном и сервером: пересылает байты в обе стороны, а запрос окна, пришедший
+// после очередной отметки времени, держит stallMs. Соединения обслуживаются каждое своим потоком
+class StallingProxy {
+public:
+    ~StallingProxy() { Stop(); }
+
+    bool Start(const std::string& path, const std::string& serverPath, int stallMs, int stallEveryUs) {
+        this->path = path;
+        this->serverPath = serverPath;
+        this->stallMs = stallMs;
+        this->stallEveryUs = stallEveryUs;
+        listenFd = Listen(path);
+        if (listenFd < 0) return false;
+        acceptor = std::thread(&StallingProxy::Accept, this);
+        return true;
+    }
+
+    void Stop() {
+        stopping = true;
+        if (acceptor.joinable()) acceptor.join();
+        for (std::thread& relay : relays) relay.join();
+        relays.clear();
+        if (listenFd >= 0) {
+            close(listenFd);
+            unlink(path.c_str());
+            listenFd = -1;
+        }
+    }
+
+    std::size_t Stalls() const { return stalls.load(); }
+
+private:
+    static bool Address(const std::string& path, sockaddr_un& address) {
+        address = {};
+        if (path.size() >= sizeof(address.sun_path)) return false;
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size());
+        return true;
+    }
+
+    static int Listen(const std::string& path) {
+        sockaddr_un address;
+        if (!Address(path, address)) return -1;
+        unlink(path.c_str());
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 8) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    void Accept() {
+        while (!stopping) {
+            pollfd waiting = { listenFd, POLLIN, 0 };
+            if (poll(&waiting, 1, 20) <= 0) continue;
+            int client = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client < 0) continue;
+            sockaddr_un address;
+            int server = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (server < 0 || !Address(serverPath, address) || connect(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+                if (server >= 0) close(server);
+                close(client);
+                continue;
+            }
+            relays.emplace_back(&StallingProxy::Relay, this, client, server);
+        }
+    }
+
+    static bool Forward(int from, int to) {
+        char buffer[4096];
+        ssize_t n = recv(from, buffer, sizeof(buffer), 0);
+        if (n <= 0) return false;
+        for (ssize_t sent = 0; sent < n;) {
+            ssize_t written = send(to, buffer + sent, static_cast<std::size_t>(n - sent), MSG_NOSIGNAL);
+            if (written <= 0) return false;
+            sent += written;
+        }
+        return true;
+    }
+
+    void Relay(int client, int server) {
+        Clock::time_point nextStall = Clock::now() + std::chrono::microseconds(stallEveryUs);
+        pollfd fds[2] = { { client, POLLIN, 0 }, { server, POLLIN, 0 } };
+        while (!stopping) {
+            if (poll(fds, 2, 20) <= 0) continue;
+            if (fds[0].revents) {
+                if (Clock::now() >= nextStall) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(stallMs));
+                    nextStall = Clock::now() + std::chrono::microseconds(stallEveryUs);
+                    ++stalls;
+                }
+                if (!Forward(client, server)) break;
+            }
+            if (fds[1].revents && !Forward(server, client)) break;
+        }
+        close(client);
+        close(server);
+    }
+
+    std::string path;
+    std::string serverPath;
+    int stallMs = 0;
+    int stallEveryUs = 0;
+    int listenFd = -1;
+    std::atomic<bool> stopping{ false };
+    std::atomic<std::size_t> stalls{ 0 };
+    std::thread acceptor;
+    std::vector<std::thread> relays;  // Меняется только потоком acceptor, читается после его остановки
+};
+
+// Ход другого клиента: atUs от начала трассы
+struct RivalMove {
+    long long atUs;
+    int col;
+    int row;
+    Mark mark;
+};
+
+// Другой клиент партии: ставит метки по расписанию, пока его не остановят
+class RivalClient {
+public:
+    ~RivalClient() { Stop(); }
+
+    bool Open(const std::string& path, std::uint32_t id) { return server.Open(path, id); }
+
+    void Start(const std::vector<RivalMove>& moves) {
+        stopping = false;
+        thread = std::thread([this, &moves] {
+            Clock::time_point start = Clock::now();
+            for (const RivalMove& move : moves) {
+                std::this_thread::sleep_until(start + std::chrono::microseconds(move.atUs));
+                if (stopping || !server.IsOpen()) return;
+                server.Place(move.col, move.row, move.mark);
+            }
+        });
+    }
+
+    void Stop() {
+        stopping = true;
+        if (thread.joinable()) thread.join();
+        server.Close();
+    }
+
+private:
+    ServerBoard server;
+    std::atomic<bool> stopping{ false };
+    std::thread thread;
+};
+
+// Другой клиент занимает каждую вторую клетку, по которой щелкнет окно, на RivalLeadEvents событий
+// раньше — быстрее, чем окно узнает о его ходе, поэтому ход окна сервер отвергнет. Вид поля зависит
+// только от событий, поэтому клетки щелчков известны заранее
+const std::size_t RivalLeadEvents = 5;
+
+static std::vector<RivalMove> PlanRivalMoves(const Settings& settings, const std::vector<InputEvent>& trace, int intervalUs) {
+    Board board;
+    Framebuffer frame(settings.windowWidth, settings.windowHeight);
+    SoftwareDevice device(frame);
+    Renderer renderer(device);
+    FrameScheduler frames;
+    GameController controller(board, renderer, frames);
+    controller.ApplySettings(settings);
+
+    std::vector<RivalMove> moves;
+    std::size_t clicks = 0;
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        const InputEvent& event = trace[i];
+        if ((event.kind == InputKind::LeftDown || event.kind == InputKind::RightDown) && clicks++ % 2 == 0) {
+            long long atUs = static_cast<long long>(i > RivalLeadEvents ? i - RivalLeadEvents : 0) * intervalUs;
+            // Метка другая, чем у окна: откат виден на поле
+            moves.push_back({ atUs, controller.View().ColAt(event.x), controller.View().RowAt(event.y),
+                event.kind == InputKind::LeftDown ? Mark::Cross : Mark::Circle });
+        }
+        if (event.kind != InputKind::LeftDown && event.kind != InputKind::RightDown) controller.Handle(event);
+    }
+    return moves;
+}
+
+static bool SameBoard(const Board& a, const Board& b) {
+    if (a.Count(Mark::Circle) != b.Count(Mark::Circle) || a.Count(Mark::Cross) != b.Count(Mark::Cross)) return false;
+    bool same = true;
+    a.ForEach([&](int col, int row, Mark mark) { same &= b.Get(col, row) == mark; });
+    return same;
+}
+
+// Ждет, пока поле окна сойдется с полем сервера: ответы на последние ходы и чужие ходы еще в пути
+template <typename Sync>
+static bool Converge(const std::string& path, std::uint32_t id, Board& local, Sync&& sync) {
+    ServerBoard checker;
+    Board truth;
+    if (!checker.Open(path, id) || !checker.Join(truth)) return false;
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(GameClientTimeoutMs);
+    for (;;) {
+        sync();
+        if (!checker.Poll(truth, [](int, int) {})) return false;
+        if (SameBoard(local, truth)) return true;
+        if (Clock::now() >= deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+static UiLatencyResult RunServerUiLatency(bool background, const std::string& serverPath, const std::string& proxyPath,
+    std::uint32_t id, const Settings& settings, const std::vector<InputEvent>& trace, int intervalUs, const std::vector<RivalMove>& rivalMoves) {
+    UiLatencyWindow window(settings);
+    Board& board = window.GetBoard();
+    GameController& controller = window.Controller();
+
+    UiLatencyResult result;
+    result.mode = background ? "server-thread" : "server-inline";
+    RivalClient rival;
+    if (!rival.Open(serverPath, id)) {
+        result.match = false;
+        return result;
+    }
+
+    if (background) {
+        ServerSession session;
+        ServerUpdates updates;
+        controller.SetServerSession(&session);
+        // Поток окна разбирает новости сессии после каждого события, как WM_SERVER_UPDATE
+        auto apply = [&] {
+            if (session.TakeUpdates(updates)) controller.ApplyServerUpdates(updates);
+        };
+        session.Start(proxyPath, id, board, nullptr);
+        while (session.State() == ServerState::Joining) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        apply();  // Поле сервера
+        rival.Start(rivalMoves);
+        result = window.Run(result.mode, trace, intervalUs, [&](std::size_t) { apply(); });
+        rival.Stop();
+        result.match = session.State() == ServerState::Playing
+            && Converge(serverPath, id, board, [&] {
+                while (!session.Idle()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                apply();
+            });
+        session.Stop();
+        return result;
+    }
+
+    // Как окно до ServerSession: ход сначала принимает сервер, опрос — по таймеру в потоке окна.
+    // Щелчок здесь уже поставил метку, поэтому непринятый ход снимается
+    ServerBoard server;
+    bool joined = server.Open(proxyPath, id) && server.Join(board);
+    controller.ResyncRules();
+    auto poll = [&] {
+        server.Poll(board, [&](int col, int row) { controller.RemoteChange(col, row); });
+    };
+    std::size_t marks = board.Count(Mark::Circle) + board.Count(Mark::Cross);
+    Clock::time_point nextPoll = Clock::now() + std::chrono::milliseconds(ServerBoardPollMs);
+    rival.Start(rivalMoves);
+    result = window.Run(result.mode, trace, intervalUs, [&](std::size_t i) {
+        const InputEvent& event = trace[i];
+        std::size_t now = board.Count(Mark::Circle) + board.Count(Mark::Cross);
+        if ((event.kind == InputKind::LeftDown || event.kind == InputKind::RightDown) && now > marks) {
+            int col = controller.View().ColAt(event.x);
+            int row = controller.View().RowAt(event.y);
+            if (!server.Place(col, row, board.Get(col, row))) {
+                board.Clear(col, row);  // Клетку заняли раньше: метка сервера придет опросом
+                controller.RemoteChange(col, row);
+            }
+        }
+        if (Clock::now() >= nextPoll) {
+            poll();
+            nextPoll = Clock::now() + std::chrono::milliseconds(ServerBoardPollMs);
+        }
+        marks = board.Count(Mark::Circle) + board.Count(Mark::Cross);
+    });
+    rival.Stop();
+    result.match = joined && server.IsOpen() && Converge(serverPath, id, board, poll);
+    return result;
+}
+
+std::vector<UiLatencyResult> MeasureServerUiLatency(int jobMs, std::size_t events, int intervalUs, std::size_t jobEvery) {
+    std::string serverPath = "3lab-bench-" + std::to_string(getpid()) + ".sock";
+    std::string proxyPath = "3lab-bench-" + std::to_string(getpid()) + "-proxy.sock";
+    GameEngine engine(DefaultGameShards, MaxWinLength);
+    GameServer server(engine);
+    StallingProxy proxy;
+    // Дольше GameClientTimeoutMs клиент ответа не ждет и считает сервер потерянным
+    int stallMs = jobMs < static_cast<int>(GameClientTimeoutMs / 2) ? jobMs : static_cast<int>(GameClientTimeoutMs / 2);
+    if (!server.Start(serverPath, 2) || !proxy.Start(proxyPath, serverPath, stallMs, static_cast<int>(jobEvery) * intervalUs)) {
+        UiLatencyResult failed;
+        failed.mode = "server";
+        failed.match = false;
+        return { failed };
+    }
+
+    // Клетки мельче обычных, а линия длиннее: поле заполняется не сразу, и партия не решается
+    // в первые секунды (после этого сервер отвергает все ходы)
+    Settings settings = DefaultSettings();
+    settings.gridSize = 12;
+    settings.winLength = MaxWinLength;
+    std::vector<InputEvent> trace = GenerateInputTrace(events, 1, settings.windowWidth, settings.windowHeight);
+    std::vector<RivalMove> rivalMoves = PlanRivalMoves(settings, trace, intervalUs);
+    std::vector<UiLatencyResult> results;
+    for (bool background : { false, true }) {
+        std::size_t stalls = proxy.Stalls();
+        results.push_back(RunServerUiLatency(background, serverPath, proxyPath, background ? 2 : 1, settings, trace, intervalUs, rivalMoves));
+        results.back().jobs = proxy.Stalls() - stalls;
+    }
+    proxy.Stop();
+    server.Stop();
+    return results;
+}
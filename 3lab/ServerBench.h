@@ -0,0 +1,12 @@
+﻿#pragma once
+#include <cstddef>
+#include <vector>
+#include "TaskBench.h"
+
+// Задержка ввода в партии на сервере. Сервер работает в этом же процессе, окно подключено к нему
+// через посредника, который раз в jobEvery событий (по времени) задерживает запрос окна на jobMs —
+// сервер занят или далеко. Другой клиент тем временем ставит метки в ту же партию.
+// "server-inline" — окно само ждет сокет: ход уходит на сервер прямо из обработки клика, опрос —
+// раз в ServerBoardPollMs между событиями. "server-thread" — ход ставится сразу, сокет ждет ServerSession.
+// В конце поле окна сверяется с полем сервера (match)
+std::vector<UiLatencyResult> MeasureServerUiLatency(int jobMs, std::size_t events, int intervalUs, std::size_t jobEvery);
@@ -0,0 +1,165 @@
+﻿#include "Checks.h"
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Board.h"
+#include "GameClient.h"
+#include "GameEngine.h"
+#include "GameServer.h"
+
+// Отдельный сокет на запуск: проверки не мешают запущенному 3lab-server и параллельным ctest
+static std::string CheckSocketPath() {
+    return "3lab-check-" + std::to_string(getpid()) + ".sock";
+}
+
+static std::string StatusText(std::uint8_t status) {
+    return std::to_string(static_cast<int>(status));
+}
+
+CheckResult CheckServerGameLimit() {
+    CheckResult result;
+    GameEngine engine(4, DEFAULT_WIN_LENGTH, 3);
+    GameMove moves[5];
+    GameMoveResult results[5];
+    for (std::uint32_t i = 0; i < 5; ++i) moves[i] = { i, 0, 0, static_cast<std::uint8_t>(Mark::Cross), {} };
+    moves[4] = { 1, 1, 0, static_cast<std::uint8_t>(Mark::Circle), {} };  // Ход в уже заведенную партию
+    engine.Apply(moves, 5, results);
+
+    std::string statuses;
+    for (const GameMoveResult& moveResult : results) statuses += StatusText(moveResult.status) + " ";
+    result.Note("limit 3 games, moves into games 0 1 2 3 1: statuses " + statuses + "boards=" + std::to_string(engine.Boards()));
+    for (int i = 0; i < 3; ++i) {
+        result.Expect(results[i].status == static_cast<std::uint8_t>(MoveStatus::Placed), "move into game " + std::to_string(i) + " rejected");
+    }
+    result.Expect(results[3].status == static_cast<std::uint8_t>(MoveStatus::NoRoom), "game over the limit was created");
+    result.Expect(results[4].status == static_cast<std::uint8_t>(MoveStatus::Placed), "existing game rejected a move at the limit");
+    result.Expect(engine.Boards() == 3, "engine holds more games than the limit");
+    return result;
+}
+
+CheckResult CheckServerJoinRejects() {
+    CheckResult result;
+    std::string path = CheckSocketPath();
+    GameEngine engine;
+    GameServer server(engine);
+    if (!server.Start(path, 1)) {
+        result.Expect(false, "cannot listen on " + path);
+        return result;
+    }
+
+    // Пять крестов в ряд решают партию: круг, который выкладывается после них, сервер не примет
+    Board local;
+    for (int col = 0; col < DEFAULT_WIN_LENGTH; ++col) local.Place(col, 0, Mark::Cross);
+    local.Place(10, 0, Mark::Circle);
+    ServerBoard remote;
+    bool joined = remote.Open(path, 7) && remote.Join(local);
+    result.Note(std::string("join ") + (joined ? "ok" : "failed") + ": local crosses=" + std::to_string(local.Count(Mark::Cross))
+        + " circles=" + std::to_string(local.Count(Mark::Circle)) + ", server moves=" + std::to_string(engine.Moves()));
+    result.Expect(joined, "join failed");
+    result.Expect(local.Get(10, 0) == Mark::Empty, "move rejected by the server stayed on the local board");
+    result.Expect(local.Count(Mark::Cross) == DEFAULT_WIN_LENGTH, "accepted moves were removed from the local board");
+    result.Expect(engine.Moves() == DEFAULT_WIN_LENGTH, "server accepted a move after the game was decided");
+    remote.Close();
+    server.Stop();
+    return result;
+}
+
+CheckResult CheckServerBackpressure(int requests) {
+    CheckResult result;
+    std::string path = CheckSocketPath();
+    GameEngine engine;
+    GameServer server(engine);
+    if (!server.Start(path, 1)) {
+        result.Expect(false, "cannot listen on " + path);
+        return result;
+    }
+
+    // Полная пачка ходов без соседних клеток: партия не решается, и каждый Fetch отвечает GameMaxBatch ходами
+    std::vector<GameMove> moves(GameMaxBatch);
+    std::vector<GameMoveResult> results(GameMaxBatch);
+    for (std::uint32_t i = 0; i < GameMaxBatch; ++i) {
+        moves[i] = { 1, static_cast<std::int32_t>(i % 64 * 2), static_cast<std::int32_t>(i / 64 * 2), static_cast<std::uint8_t>(i % 2 ? Mark::Circle : Mark::Cross), {} };
+    }
+    GameClient writer;
+    result.Expect(writer.Connect(path) && writer.Send(moves.data(), moves.size(), results.data()), "cannot fill the game");
+
+    // Клиент шлет все запросы разом и только потом начинает читать
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        result.Expect(false, "cannot connect to " + path);
+        if (fd >= 0) close(fd);
+        return result;
+    }
+    std::vector<char> request;
+    for (int i = 0; i < requests; ++i) {
+        GameMessageHeader header = { static_cast<std::uint32_t>(GameMessage::Fetch), 1 };
+        GameFetch fetch = { 1, 0 };
+        request.insert(request.end(), reinterpret_cast<const char*>(&header), reinterpret_cast<const char*>(&header) + sizeof(header));
+        request.insert(request.end(), reinterpret_cast<const char*>(&fetch), reinterpret_cast<const char*>(&fetch) + sizeof(fetch));
+    }
+    bool sent = write(fd, request.data(), request.size()) == static_cast<ssize_t>(request.size());
+    result.Expect(sent, "cannot send the requests");
+    usleep(200 * 1000);  // Серверу хватает времени разобрать всё, что он согласен разобрать
+    std::size_t peakWhileStalled = server.PeakOutput();
+
+    // Теперь читаем: сервер должен ответить на все запросы, дочитывая их по мере отправки ответов
+    std::size_t replyBytes = sizeof(GameMessageHeader) + GameMaxBatch * sizeof(GameMove);
+    std::size_t expected = replyBytes * static_cast<std::size_t>(requests);
+    std::size_t received = 0;
+    std::vector<char> buffer(1 << 16);
+    timeval timeout = { 5, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    while (sent && received < expected) {
+        ssize_t n = read(fd, buffer.data(), buffer.size());
+        if (n <= 0) break;
+        received += static_cast<std::size_t>(n);
+    }
+    close(fd);
+
+    result.Note(std::to_string(requests) + " fetches of " + std::to_string(replyBytes) + " bytes: peak unsent "
+        + std::to_string(peakWhileStalled) + " bytes while the client was not reading, received "
+        + std::to_string(received) + " of " + std::to_string(expected));
+    result.Expect(peakWhileStalled < (1 << 20) + replyBytes, "server kept queueing replies for a client that does not read");
+    result.Expect(received == expected, "server did not resume the queued requests after the client caught up");
+    writer.Close();
+    server.Stop();
+    return result;
+}
+
+CheckResult CheckServerClientTimeout() {
+    CheckResult result;
+    std::string path = CheckSocketPath();
+    // Сервер принимает соединение, но не отвечает
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size());
+    unlink(path.c_str());
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 1) != 0) {
+        result.Expect(false, "cannot listen on " + path);
+        if (listener >= 0) close(listener);
+        return result;
+    }
+
+    ServerBoard remote;
+    bool opened = remote.Open(path, 1);
+    auto start = std::chrono::steady_clock::now();
+    bool placed = opened && remote.Place(0, 0, Mark::Cross);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.Note("place against a silent server: " + std::string(placed ? "accepted" : "failed") + " after "
+        + std::to_string(static_cast<int>(ms)) + " ms, connection " + (remote.IsOpen() ? "open" : "closed"));
+    result.Expect(opened, "cannot connect to " + path);
+    result.Expect(!placed && !remote.IsOpen(), "silent server did not fail the move");
+    result.Expect(ms < GameClientTimeoutMs * 2, "client waited longer than its timeout");
+    close(listener);
+    unlink(path.c_str());
+    return result;
+}
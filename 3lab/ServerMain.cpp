@@ -0,0 +1,86 @@
+﻿// Сервер партий без окна и нагрузка на него (только Linux: epoll).
+//   3lab-server [socket workers shards games]                — обслуживать партии до SIGINT или SIGTERM
+//   3lab-server --load [socket clients boards batch seconds] — нагрузить запущенный сервер и вывести ходы в секунду
+//   3lab-server --bench [clients boards batch seconds workers] — то же против сервера в этом же процессе
+// Окно подключается к серверу аргументом server: 3lab.exe <размер> <метод> server [партия].
+// В Windows-сборку окна этот файл не входит: у нее своя точка входа wWinMain
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include "GameEngine.h"
+#include "GameLoad.h"
+#include "GameServer.h"
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && (std::string_view(argv[1]) == "--load" || std::string_view(argv[1]) == "--bench")) {
+        bool bench = std::string_view(argv[1]) == "--bench";
+        int arg = 2;
+        std::string path = bench ? "3lab-bench-" + std::to_string(getpid()) + ".sock" : (argc > arg ? argv[arg++] : GameServerSocket);
+        unsigned int clients = argc > arg ? static_cast<unsigned>(std::atoi(argv[arg])) : 4;
+        std::uint32_t boards = argc > arg + 1 ? static_cast<std::uint32_t>(std::strtoul(argv[arg + 1], nullptr, 10)) : 10000;
+        unsigned int batch = argc > arg + 2 ? static_cast<unsigned>(std::atoi(argv[arg + 2])) : 16;
+        double seconds = argc > arg + 3 ? std::atof(argv[arg + 3]) : 5;
+        unsigned int workers = bench && argc > arg + 4 ? static_cast<unsigned>(std::atoi(argv[arg + 4])) : DefaultServerWorkers;
+        if (clients == 0 || boards == 0 || batch == 0 || batch > GameMaxBatch || seconds <= 0 || workers == 0) {
+            std::fprintf(stderr, "bad load parameters\n");
+            return 2;
+        }
+
+        GameEngine engine;
+        GameServer server(engine);
+        if (bench && !server.Start(path, workers)) {
+            std::fprintf(stderr, "cannot listen on %s\n", path.c_str());
+            return 1;
+        }
+        GameLoadResult result = RunGameLoad(path, clients, boards, batch, seconds);
+        if (!result.connected) {
+            std::fprintf(stderr, "cannot connect to %s\n", path.c_str());
+            return 1;
+        }
+        std::fputs(FormatGameLoad(result).c_str(), stdout);
+        if (bench) std::printf("server: %u workers, %zu boards, %llu moves\n", workers, engine.Boards(),
+            static_cast<unsigned long long>(engine.Moves()));
+        return 0;
+    }
+    if (argc >= 2 && argv[1][0] == '-') {
+        std::fprintf(stderr, "usage: %s [socket workers shards games]\n       %s --load [socket clients boards batch seconds]\n"
+            "       %s --bench [clients boards batch seconds workers]\n", argv[0], argv[0], argv[0]);
+        return 2;
+    }
+
+    std::string path = argc > 1 ? argv[1] : GameServerSocket;
+    unsigned int workers = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : DefaultServerWorkers;
+    unsigned int shards = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : DefaultGameShards;
+    long games = argc > 4 ? std::atol(argv[4]) : static_cast<long>(DefaultMaxGames);
+    if (workers == 0 || shards == 0 || games <= 0) {
+        std::fprintf(stderr, "bad server parameters\n");
+        return 2;
+    }
+
+    // Сигналы остановки ждет главный поток, рабочие их не получают
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    GameEngine engine(shards, DEFAULT_WIN_LENGTH, static_cast<std::size_t>(games));
+    GameServer server(engine);
+    if (!server.Start(path, workers)) {
+        std::fprintf(stderr, "cannot listen on %s\n", path.c_str());
+        return 1;
+    }
+    std::printf("listening on %s: %u workers, %u shards, up to %ld games\n", path.c_str(), workers, shards, games);
+    std::fflush(stdout);
+
+    int signal = 0;
+    sigwait(&signals, &signal);
+    server.Stop();
+    std::printf("%zu boards, %llu moves, %llu messages\n", engine.Boards(),
+        static_cast<unsigned long long>(engine.Moves()), static_cast<unsigned long long>(server.Messages()));
+    return 0;
+}
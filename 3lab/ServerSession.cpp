@@ -0,0 +1,130 @@
+﻿#include "ServerSession.h"
+#include <chrono>
+#include <utility>
+
+ServerSession::~ServerSession() {
+    Stop();
+}
+
+void ServerSession::Start(const std::string& path, std::uint32_t board, const Board& local, ReadyCallback callback, unsigned poll) {
+    Stop();
+    id = board;
+    pollMs = poll;
+    onReady = std::move(callback);
+    stopping = false;
+    updates = ServerUpdates();
+    state = ServerState::Joining;
+    thread = std::thread(&ServerSession::Run, this, path, local);  // Поле копируется: окно продолжает работать со своим
+}
+
+void ServerSession::Stop() {
+    if (!thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_one();
+    thread.join();
+    server.Close();
+    queue.clear();
+    if (state == ServerState::Joining || state == ServerState::Playing) state = ServerState::Off;
+}
+
+void ServerSession::Place(int col, int row, Mark mark) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back({ id, col, row, static_cast<std::uint8_t>(mark), {} });
+    }
+    wakeup.notify_one();
+}
+
+bool ServerSession::TakeUpdates(ServerUpdates& taken) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (updates.Empty()) return false;
+    taken.joined = updates.joined;
+    if (updates.joined) taken.board = std::move(updates.board);
+    taken.rejected.swap(updates.rejected);
+    taken.remote.swap(updates.remote);
+    taken.lost = updates.lost;
+    // Память векторов, отданных окном в прошлый раз, переиспользуется
+    updates.joined = false;
+    updates.board = Board();
+    updates.rejected.clear();
+    updates.remote.clear();
+    updates.lost = false;
+    return true;
+}
+
+bool ServerSession::Idle() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.empty() && !sending;
+}
+
+void ServerSession::Publish(std::vector<GameMove>& rejected, std::vector<GameMove>& remote, bool alive) {
+    bool news;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        updates.rejected.insert(updates.rejected.end(), rejected.begin(), rejected.end());
+        updates.remote.insert(updates.remote.end(), remote.begin(), remote.end());
+        if (!alive) updates.lost = true;
+        news = !rejected.empty() || !remote.empty() || !alive;
+    }
+    rejected.clear();
+    remote.clear();
+    if (!alive) state = ServerState::Lost;
+    if (news && onReady) onReady();
+}
+
+void ServerSession::Run(std::string path, Board mirror) {
+    // mirror — поле, каким его знает сервер: свои принятые ходы и ходы других клиентов
+    bool joined = server.Open(path, id) && server.Join(mirror);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (joined) {
+            updates.joined = true;
+            updates.board = mirror;
+        }
+        else {
+            updates.lost = true;
+        }
+    }
+    state = joined ? ServerState::Playing : ServerState::Lost;
+    if (onReady) onReady();
+    if (!joined) return;
+
+    std::vector<GameMove> batch;
+    std::vector<GameMoveResult> results(GameMaxBatch);
+    std::vector<GameMove> rejected, remote;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wakeup.wait_for(lock, std::chrono::milliseconds(pollMs), [this] { return stopping || !queue.empty(); });
+        if (stopping) return;
+        batch.swap(queue);
+        sending = !batch.empty();
+        lock.unlock();
+
+        bool alive = true;
+        for (std::size_t first = 0; alive && first < batch.size(); first += GameMaxBatch) {
+            std::size_t count = batch.size() - first < GameMaxBatch ? batch.size() - first : GameMaxBatch;
+            alive = server.Place(batch.data() + first, count, results.data());
+            for (std::size_t i = 0; alive && i < count; ++i) {
+                const GameMove& move = batch[first + i];
+                if (results[i].status == static_cast<std::uint8_t>(MoveStatus::Placed)) mirror.Place(move.col, move.row, static_cast<Mark>(move.mark));
+                else rejected.push_back(move);
+            }
+        }
+        batch.clear();
+        // Опрос сразу после отправки: клетку отвергнутого хода уже занял чужой ход, и он придет вместе с отказом
+        if (alive) {
+            alive = server.Poll(mirror, [&](int col, int row) {
+                remote.push_back({ id, col, row, static_cast<std::uint8_t>(mirror.Get(col, row)), {} });
+            });
+        }
+        for (GameMove& move : rejected) move.mark = static_cast<std::uint8_t>(mirror.Get(move.col, move.row));
+        Publish(rejected, remote, alive);
+
+        lock.lock();
+        sending = false;
+        if (!alive) return;
+    }
+}
@@ -0,0 +1,78 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Board.h"
+#include "GameClient.h"
+
+// Что поток сессии накопил для окна с прошлого TakeUpdates
+struct ServerUpdates {
+    bool joined = false;             // Подключение к партии завершилось: поле окна заменяется board
+    Board board;                     // Поле сервера после подключения (только при joined)
+    std::vector<GameMove> rejected;  // Свои ходы, которые сервер не принял; mark — что на самом деле стоит в клетке
+    std::vector<GameMove> remote;    // Ходы других клиентов
+    bool lost = false;               // Подключиться не удалось или связь потеряна
+
+    bool Empty() const { return !joined && rejected.empty() && remote.empty() && !lost; }
+};
+
+enum class ServerState : std::uint8_t {
+    Off,      // Сессия не запущена
+    Joining,  // Поток подключается к партии
+    Playing,  // Ходы уходят на сервер, чужие приходят опросом
+    Lost,     // Связь потеряна: игра продолжается на локальном поле
+};
+
+// Партия на сервере в своем потоке, как поиск хода в AiPlayer: окно не ждет сокет. Окно ставит
+// свои ходы сразу и отдает их в Place, поток отправляет их пачкой и каждые pollMs забирает ходы
+// других клиентов. О новостях окно узнает из onReady (вызывается в потоке сессии — обычно это
+// PostMessage) и забирает их через TakeUpdates. Ход, который сервер не принял, приходит в rejected
+// вместе с тем, что на сервере стоит в его клетке, — окно откатывает свою метку
+class ServerSession {
+public:
+    using ReadyCallback = std::function<void()>;
+
+    ServerSession() = default;
+    ~ServerSession();
+
+    ServerSession(const ServerSession&) = delete;
+    ServerSession& operator=(const ServerSession&) = delete;
+
+    // Подключается к партии id сервера path в потоке сессии. local — поле окна: его выкладывает
+    // на сервер первый клиент партии (ServerBoard::Join). Итог придет как joined или lost
+    void Start(const std::string& path, std::uint32_t id, const Board& local, ReadyCallback onReady,
+        unsigned pollMs = ServerBoardPollMs);
+    // Останавливает поток (не дольше GameClientTimeoutMs, если он ждет ответа сервера)
+    void Stop();
+    ServerState State() const { return state.load(); }
+
+    // Отдает серверу ход, уже поставленный на поле окна
+    void Place(int col, int row, Mark mark);
+    // Забирает накопленное. false, если новостей нет
+    bool TakeUpdates(ServerUpdates& taken);
+    // Все отданные ходы отправлены и ответы разобраны
+    bool Idle() const;
+
+private:
+    void Run(std::string path, Board mirror);
+    void Publish(std::vector<GameMove>& rejected, std::vector<GameMove>& remote, bool alive);
+
+    ServerBoard server;  // Используется только потоком сессии
+    std::uint32_t id = 0;
+    unsigned pollMs = ServerBoardPollMs;
+    ReadyCallback onReady;
+    std::thread thread;
+    std::atomic<ServerState> state{ ServerState::Off };
+
+    mutable std::mutex mutex;
+    std::condition_variable wakeup;
+    std::vector<GameMove> queue;  // Ходы окна, которые поток еще не взял
+    bool sending = false;         // Поток отправляет взятые ходы
+    bool stopping = false;
+    ServerUpdates updates;
+};
@@ -0,0 +1,127 @@
+﻿#include "Settings.h"
+#include <charconv>
+
+static const char* const KeyNames[SettingsKeyCount] = {
+    "GridSize", "WindowWidth", "WindowHeight", "BackgroundColor", "GridLineColor", "WinLength", "AiTimeMs", "AiThreads",
+};
+
+const char* SettingsKeyName(SettingsKey key) {
+    return KeyNames[static_cast<int>(key)];
+}
+
+const char* SettingsErrorText(SettingsError error) {
+    switch (error) {
+    case SettingsError::None: return "ok";
+    case SettingsError::BadNumber: return "not a number";
+    case SettingsError::OutOfRange: return "out of range";
+    case SettingsError::BadColor: return "expected R,G,B";
+    }
+    return "unknown";
+}
+
+std::uint32_t DiffSettings(const Settings& a, const Settings& b) {
+    std::uint32_t keys = 0;
+    if (a.gridSize != b.gridSize) keys |= SettingsKeyBit(SettingsKey::GridSize);
+    if (a.windowWidth != b.windowWidth) keys |= SettingsKeyBit(SettingsKey::WindowWidth);
+    if (a.windowHeight != b.windowHeight) keys |= SettingsKeyBit(SettingsKey::WindowHeight);
+    if (a.backgroundColor != b.backgroundColor) keys |= SettingsKeyBit(SettingsKey::BackgroundColor);
+    if (a.gridLineColor != b.gridLineColor) keys |= SettingsKeyBit(SettingsKey::GridLineColor);
+    if (a.winLength != b.winLength) keys |= SettingsKeyBit(SettingsKey::WinLength);
+    if (a.aiTimeMs != b.aiTimeMs) keys |= SettingsKeyBit(SettingsKey::AiTimeMs);
+    if (a.aiThreads != b.aiThreads) keys |= SettingsKeyBit(SettingsKey::AiThreads);
+    return keys;
+}
+
+void CopySettings(Settings& to, const Settings& from, std::uint32_t keys) {
+    if (keys & SettingsKeyBit(SettingsKey::GridSize)) to.gridSize = from.gridSize;
+    if (keys & SettingsKeyBit(SettingsKey::WindowWidth)) to.windowWidth = from.windowWidth;
+    if (keys & SettingsKeyBit(SettingsKey::WindowHeight)) to.windowHeight = from.windowHeight;
+    if (keys & SettingsKeyBit(SettingsKey::BackgroundColor)) to.backgroundColor = from.backgroundColor;
+    if (keys & SettingsKeyBit(SettingsKey::GridLineColor)) to.gridLineColor = from.gridLineColor;
+    if (keys & SettingsKeyBit(SettingsKey::WinLength)) to.winLength = from.winLength;
+    if (keys & SettingsKeyBit(SettingsKey::AiTimeMs)) to.aiTimeMs = from.aiTimeMs;
+    if (keys & SettingsKeyBit(SettingsKey::AiThreads)) to.aiThreads = from.aiThreads;
+}
+
+// Пропускает хвостовые пробелы и '\r' (файлы, сохраненные с CRLF)
+static std::string_view TrimRight(std::string_view text) {
+    while (!text.empty() && (text.back() == '\r' || text.back() == ' ' || text.back() == '\t')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+// Читает целое число, занимающее всю строку value
+static SettingsError ParseInt(std::string_view value, int minValue, int maxValue, int& out) {
+    int number = 0;
+    auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), number);
+    if (ec == std::errc::result_out_of_range) return SettingsError::OutOfRange;
+    if (ec != std::errc() || end != value.data() + value.size()) return SettingsError::BadNumber;
+    if (number < minValue || number > maxValue) return SettingsError::OutOfRange;
+    out = number;
+    return SettingsError::None;
+}
+
+// Читает цвет "R,G,B", каждая компонента 0..255
+static SettingsError ParseColor(std::string_view value, Color& out) {
+    int rgb[3];
+    const char* p = value.data();
+    const char* end = value.data() + value.size();
+    for (int i = 0; i < 3; ++i) {
+        if (i > 0) {
+            if (p == end || *p != ',') return SettingsError::BadColor;
+            ++p;
+        }
+        auto [next, ec] = std::from_chars(p, end, rgb[i]);
+        if (ec != std::errc()) return SettingsError::BadColor;
+        if (rgb[i] < 0 || rgb[i] > 255) return SettingsError::OutOfRange;
+        p = next;
+    }
+    if (p != end) return SettingsError::BadColor;
+    out = MakeColor(rgb[0], rgb[1], rgb[2]);
+    return SettingsError::None;
+}
+
+void ParseSettingsLine(std::string_view line, int lineNumber, Settings& settings, SettingsParseResult& result) {
+    line = TrimRight(line);
+    std::size_t eq = line.find('=');
+    if (eq == std::string_view::npos) return;  // Заголовок секции, пустая строка или комментарий
+
+    std::string_view name = line.substr(0, eq);
+    std::string_view value = line.substr(eq + 1);
+
+    for (int i = 0; i < SettingsKeyCount; ++i) {
+        if (name != KeyNames[i]) continue;
+
+        SettingsError error = SettingsError::None;
+        switch (static_cast<SettingsKey>(i)) {
+        case SettingsKey::GridSize: error = ParseInt(value, 1, 4096, settings.gridSize); break;
+        case SettingsKey::WindowWidth: error = ParseInt(value, 1, 65535, settings.windowWidth); break;
+        case SettingsKey::WindowHeight: error = ParseInt(value, 1, 65535, settings.windowHeight); break;
+        case SettingsKey::BackgroundColor: error = ParseColor(value, settings.backgroundColor); break;
+        case SettingsKey::GridLineColor: error = ParseColor(value, settings.gridLineColor); break;
+        case SettingsKey::WinLength: error = ParseInt(value, 3, 16, settings.winLength); break;  // MinWinLength..MaxWinLength
+        case SettingsKey::AiTimeMs: error = ParseInt(value, 10, 600000, settings.aiTimeMs); break;
+        case SettingsKey::AiThreads: error = ParseInt(value, 0, 256, settings.aiThreads); break;
+        default: break;
+        }
+
+        result.found[i] = true;
+        result.errors[i] = error;
+        result.errorLines[i] = error == SettingsError::None ? 0 : lineNumber;
+        return;
+    }
+}
+
+SettingsParseResult ParseSettings(std::string_view text, Settings& settings) {
+    SettingsParseResult result;
+    int lineNumber = 1;
+    while (!text.empty()) {
+        std::size_t newline = text.find('\n');
+        std::string_view line = text.substr(0, newline);
+        ParseSettingsLine(line, lineNumber++, settings, result);
+        if (newline == std::string_view::npos) break;
+        text.remove_prefix(newline + 1);
+    }
+    return result;
+}
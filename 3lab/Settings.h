@@ -0,0 +1,72 @@
+﻿#pragma once
+#include <cstdint>
+#include <string_view>
+#include "Graphics.h"
+
+#define DEFAULT_GRID_SIZE 50  // Размер сетки по умолчанию
+#define DEFAULT_WIN_LENGTH 5  // Сколько меток в ряд нужно для победы (гомоку)
+#define DEFAULT_AI_TIME_MS 1000  // Время на ход компьютерного соперника
+#define DEFAULT_AI_THREADS 0     // Потоков поиска (0 — по числу ядер)
+
+//Стуктура конфига
+struct Settings {
+    int gridSize;
+    int windowWidth;
+    int windowHeight;
+    Color backgroundColor;
+    Color gridLineColor;
+    int winLength;
+    int aiTimeMs;
+    int aiThreads;
+};
+
+// Значения по умолчанию
+inline Settings DefaultSettings() {
+    return { DEFAULT_GRID_SIZE, 320, 240, MakeColor(0, 0, 255), MakeColor(255, 0, 0), DEFAULT_WIN_LENGTH,
+        DEFAULT_AI_TIME_MS, DEFAULT_AI_THREADS };
+}
+
+// Ключи файла настроек
+enum class SettingsKey { GridSize, WindowWidth, WindowHeight, BackgroundColor, GridLineColor, WinLength, AiTimeMs, AiThreads, Count };
+const int SettingsKeyCount = static_cast<int>(SettingsKey::Count);
+
+// Набор ключей — битовая маска, бит на SettingsKey
+inline std::uint32_t SettingsKeyBit(SettingsKey key) { return 1u << static_cast<int>(key); }
+const std::uint32_t AllSettingsKeys = (1u << SettingsKeyCount) - 1;
+
+// Ключи, значения которых в a и b различаются
+std::uint32_t DiffSettings(const Settings& a, const Settings& b);
+// Переносит из from в to значения ключей из набора keys
+void CopySettings(Settings& to, const Settings& from, std::uint32_t keys);
+
+// Что не так со значением ключа
+enum class SettingsError : std::uint8_t {
+    None,        // Значение прочитано
+    BadNumber,   // Не число или лишние символы после числа
+    OutOfRange,  // Число вне допустимого диапазона
+    BadColor,    // Цвет не в формате R,G,B
+};
+
+// Результат разбора: для каждого ключа — найден ли он и ошибка со строкой, где она встретилась.
+// При ошибке ключ сохраняет прежнее значение
+struct SettingsParseResult {
+    bool found[SettingsKeyCount] = {};
+    SettingsError errors[SettingsKeyCount] = {};
+    int errorLines[SettingsKeyCount] = {};  // Номер строки (с 1)
+
+    bool Ok() const {
+        for (SettingsError error : errors) {
+            if (error != SettingsError::None) return false;
+        }
+        return true;
+    }
+};
+
+const char* SettingsKeyName(SettingsKey key);
+const char* SettingsErrorText(SettingsError error);
+
+// Разбирает одну строку "Ключ=значение". Не выделяет память и не бросает исключений
+void ParseSettingsLine(std::string_view line, int lineNumber, Settings& settings, SettingsParseResult& result);
+
+// Разбирает весь текст файла настроек (например, отображенный в память) без копирования
+SettingsParseResult ParseSettings(std::string_view text, Settings& settings);
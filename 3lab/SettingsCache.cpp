@@ -0,0 +1,208 @@
+﻿#include "SettingsCache.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include "AtomicFile.h"
+#include "Hash.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include "SettingsStore.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <time.h>
+#endif
+
+static const char SettingsCacheMagic[4] = { 'C', 'C', 'S', 'C' };
+
+// Запись кэша: все значения по ключам SettingsKey, цвета — в формате Color
+struct SettingsCacheRecord {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t keyCount;   // SettingsKeyCount: новый ключ делает старые кэши недействительными
+    std::uint32_t foundMask;  // Какие ключи были в файле
+    std::uint64_t fileSize;
+    std::uint64_t fileModified;
+    std::uint64_t contentHash;  // Hash64 текста, из которого получены значения
+    std::uint32_t unsettled;    // Метка была моложе SettingsStampSettleSeconds: перед использованием сверяется хэш
+    std::uint32_t reserved;
+    std::uint32_t values[SettingsKeyCount];
+    std::uint64_t checksum;   // Hash64 всех полей выше
+};
+
+static FILE* OpenCacheFile(const std::string& path, const char* mode) {
+#ifdef _MSC_VER
+    FILE* file = nullptr;
+    return fopen_s(&file, path.c_str(), mode) == 0 ? file : nullptr;
+#else
+    return std::fopen(path.c_str(), mode);
+#endif
+}
+
+bool ReadFileStamp(const std::string& path, FileStamp& stamp) {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data)) return false;
+    stamp.size = (static_cast<std::uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+    stamp.modified = (static_cast<std::uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return false;
+    stamp.size = static_cast<std::uint64_t>(st.st_size);
+    stamp.modified = static_cast<std::uint64_t>(st.st_mtim.tv_sec) * 1000000000ull + static_cast<std::uint64_t>(st.st_mtim.tv_nsec);
+#endif
+    return true;
+}
+
+bool StampUnsettled(const FileStamp& stamp) {
+#ifdef _WIN32
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    std::uint64_t nowTicks = (static_cast<std::uint64_t>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+    const std::uint64_t ticksPerSecond = 10000000ull;
+#else
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    std::uint64_t nowTicks = static_cast<std::uint64_t>(now.tv_sec) * 1000000000ull + static_cast<std::uint64_t>(now.tv_nsec);
+    const std::uint64_t ticksPerSecond = 1000000000ull;
+#endif
+    // Время из будущего (переведенные часы) тоже ненадежно
+    return stamp.modified + SettingsStampSettleSeconds * ticksPerSecond > nowTicks;
+}
+
+bool ReadContentHash(const std::string& path, std::uint64_t& hash) {
+    MappedFile file;
+    if (!file.OpenRead(path.c_str())) return false;
+    hash = Hash64(file.Data(), file.Size());
+    return true;
+}
+
+static void PackSettings(const Settings& settings, std::uint32_t* values) {
+    values[static_cast<int>(SettingsKey::GridSize)] = static_cast<std::uint32_t>(settings.gridSize);
+    values[static_cast<int>(SettingsKey::WindowWidth)] = static_cast<std::uint32_t>(settings.windowWidth);
+    values[static_cast<int>(SettingsKey::WindowHeight)] = static_cast<std::uint32_t>(settings.windowHeight);
+    values[static_cast<int>(SettingsKey::BackgroundColor)] = settings.backgroundColor;
+    values[static_cast<int>(SettingsKey::GridLineColor)] = settings.gridLineColor;
+    values[static_cast<int>(SettingsKey::WinLength)] = static_cast<std::uint32_t>(settings.winLength);
+    values[static_cast<int>(SettingsKey::AiTimeMs)] = static_cast<std::uint32_t>(settings.aiTimeMs);
+    values[static_cast<int>(SettingsKey::AiThreads)] = static_cast<std::uint32_t>(settings.aiThreads);
+}
+
+static void UnpackSettings(const std::uint32_t* values, Settings& settings) {
+    settings.gridSize = static_cast<int>(values[static_cast<int>(SettingsKey::GridSize)]);
+    settings.windowWidth = static_cast<int>(values[static_cast<int>(SettingsKey::WindowWidth)]);
+    settings.windowHeight = static_cast<int>(values[static_cast<int>(SettingsKey::WindowHeight)]);
+    settings.backgroundColor = values[static_cast<int>(SettingsKey::BackgroundColor)];
+    settings.gridLineColor = values[static_cast<int>(SettingsKey::GridLineColor)];
+    settings.winLength = static_cast<int>(values[static_cast<int>(SettingsKey::WinLength)]);
+    settings.aiTimeMs = static_cast<int>(values[static_cast<int>(SettingsKey::AiTimeMs)]);
+    settings.aiThreads = static_cast<int>(values[static_cast<int>(SettingsKey::AiThreads)]);
+}
+
+bool LoadSettingsCache(const std::string& cachePath, const std::string& settingsPath, const FileStamp& stamp,
+    Settings& settings, SettingsParseResult& result, bool* unsettled) {
+    PROFILE_SCOPE("settings.cache.load");
+    // Запись меньше сотни байт: одно чтение дешевле отображения файла в память
+    FILE* file = OpenCacheFile(cachePath, "rb");
+    if (!file) return false;
+    SettingsCacheRecord record;
+    char extra;
+    bool complete = std::fread(&record, sizeof(record), 1, file) == 1 && std::fread(&extra, 1, 1, file) == 0;
+    std::fclose(file);
+    if (!complete) return false;
+
+    bool valid = std::memcmp(record.magic, SettingsCacheMagic, sizeof(SettingsCacheMagic)) == 0
+        && record.version == SettingsCacheVersion
+        && record.keyCount == SettingsKeyCount
+        && record.fileSize == stamp.size
+        && record.fileModified == stamp.modified
+        && record.checksum == Hash64(&record, offsetof(SettingsCacheRecord, checksum));
+    if (!valid) return false;
+    // Метка могла совпасть у двух разных записей файла: решает содержимое
+    std::uint64_t hash = 0;
+    if (record.unsettled && (!ReadContentHash(settingsPath, hash) || hash != record.contentHash)) return false;
+    if (unsettled) *unsettled = record.unsettled != 0;
+
+    UnpackSettings(record.values, settings);
+    result = {};
+    for (int i = 0; i < SettingsKeyCount; ++i) result.found[i] = (record.foundMask >> i) & 1;
+    return true;
+}
+
+bool SaveSettingsCache(const std::string& cachePath, const FileStamp& stamp, std::uint64_t contentHash,
+    const Settings& settings, const SettingsParseResult& result) {
+    PROFILE_SCOPE("settings.cache.save");
+    SettingsCacheRecord record = {};
+    std::memcpy(record.magic, SettingsCacheMagic, sizeof(SettingsCacheMagic));
+    record.version = SettingsCacheVersion;
+    record.keyCount = SettingsKeyCount;
+    for (int i = 0; i < SettingsKeyCount; ++i) {
+        if (result.found[i]) record.foundMask |= 1u << i;
+    }
+    record.fileSize = stamp.size;
+    record.fileModified = stamp.modified;
+    record.contentHash = contentHash;
+    record.unsettled = StampUnsettled(stamp) ? 1 : 0;
+    PackSettings(settings, record.values);
+    record.checksum = Hash64(&record, offsetof(SettingsCacheRecord, checksum));
+
+    std::string temp = TempPathFor(cachePath);
+    FILE* file = OpenCacheFile(temp, "wb");
+    if (!file) return false;
+    bool written = std::fwrite(&record, sizeof(record), 1, file) == 1;
+    if (std::fclose(file) != 0 || !written) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return AtomicReplace(temp, cachePath);
+}
+
+SettingsParseResult LoadSettingsCached(SettingsStore& store, Settings& settings, SettingsSource* source) {
+    FileStamp stamp;
+    std::string cachePath = SettingsCachePath(store.Path());
+    if (!ReadFileStamp(store.Path(), stamp)) {
+        if (source) *source = SettingsSource::Defaults;
+        return store.Load(settings);  // Хранилище само подставит значения по умолчанию
+    }
+
+    SettingsParseResult result;
+    bool unsettled = false;
+    if (LoadSettingsCache(cachePath, store.Path(), stamp, settings, result, &unsettled)) {
+        if (source) *source = SettingsSource::Cache;
+        // Хэш совпал, а метка уже устоялась: следующие запуски обойдутся без чтения текста
+        std::uint64_t hash = 0;
+        if (unsettled && !StampUnsettled(stamp) && ReadContentHash(store.Path(), hash)) {
+            SaveSettingsCache(cachePath, stamp, hash, settings, result);
+        }
+        return result;
+    }
+
+    // Хэш берется до и после разбора: текст, менявшийся во время чтения, не кэшируется
+    std::uint64_t hash = 0;
+    bool hashed = ReadContentHash(store.Path(), hash);
+    result = store.Load(settings);
+    if (source) *source = SettingsSource::Text;
+    // Файл могли изменить, пока его читали: тогда метка или текст уже другие и кэш не пишется
+    FileStamp after;
+    std::uint64_t hashAfter = 0;
+    if (hashed && result.Ok() && ReadFileStamp(store.Path(), after) && after == stamp
+        && ReadContentHash(store.Path(), hashAfter) && hashAfter == hash) {
+        SaveSettingsCache(cachePath, stamp, hash, settings, result);
+    }
+    return result;
+}
+
+void UpdateSettingsCache(const SettingsStore& store, const Settings& settings) {
+    FileStamp stamp;
+    if (!ReadFileStamp(store.Path(), stamp)) return;
+    SettingsParseResult result;
+    for (bool& found : result.found) found = true;  // Save пишет все ключи
+    // Хэш — от текста, который записал Save, а не от файла: если файл уже успели переписать,
+    // кэш просто не совпадет при следующем запуске
+    char text[SettingsTextCapacity];
+    std::size_t length = FormatSettings(settings, text, sizeof(text));
+    SaveSettingsCache(SettingsCachePath(store.Path()), stamp, Hash64(text, length), settings, result);
+}
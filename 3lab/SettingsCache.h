@@ -0,0 +1,61 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include "Settings.h"
+
+class SettingsStore;
+
+// Двоичный кэш разобранных настроек. Ключ кэша — размер и время изменения settings.ini:
+// пока файл не меняли, при запуске читается одна запись фиксированного размера вместо разбора текста.
+// Две записи за один тик часов ФС дают ту же метку, поэтому метка, которой на момент записи кэша
+// меньше SettingsStampSettleSeconds, считается ненадежной: такой кэш используется только после
+// сверки Hash64 текста и переписывается, как только метка устоится.
+// Кэш одноразовый: при любом несовпадении (другой файл, старая версия, битая контрольная сумма)
+// настройки просто разбираются заново
+
+const std::uint32_t SettingsCacheVersion = 2;
+const int SettingsStampSettleSeconds = 2;  // С запасом больше разрешения времени изменения в FAT и NTFS
+
+// Размер и время последнего изменения файла (в единицах ОС: 100 нс в Windows, 1 нс в POSIX)
+struct FileStamp {
+    std::uint64_t size = 0;
+    std::uint64_t modified = 0;
+
+    bool operator==(const FileStamp& other) const { return size == other.size && modified == other.modified; }
+    bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+// Читает размер и время изменения файла. Возвращает false, если файла нет
+bool ReadFileStamp(const std::string& path, FileStamp& stamp);
+// Метка моложе SettingsStampSettleSeconds: в тот же тик файл еще могут переписать
+bool StampUnsettled(const FileStamp& stamp);
+// Hash64 текста файла. Возвращает false, если файла нет или он пуст
+bool ReadContentHash(const std::string& path, std::uint64_t& hash);
+
+// Путь кэша для файла настроек
+inline std::string SettingsCachePath(const std::string& settingsPath) {
+    return settingsPath + ".bin";
+}
+
+// Читает кэш, если он записан для файла settingsPath с таким же размером и временем изменения.
+// Если при записи кэша метка еще не устоялась, сверяет хэш текста и сообщает об этом в unsettled
+bool LoadSettingsCache(const std::string& cachePath, const std::string& settingsPath, const FileStamp& stamp,
+    Settings& settings, SettingsParseResult& result, bool* unsettled = nullptr);
+// Записывает кэш (временный файл + переименование, без сброса на диск: потерянный кэш просто пересоберется).
+// contentHash — Hash64 текста, из которого получены settings
+bool SaveSettingsCache(const std::string& cachePath, const FileStamp& stamp, std::uint64_t contentHash,
+    const Settings& settings, const SettingsParseResult& result);
+
+// Откуда при запуске пришли настройки
+enum class SettingsSource {
+    Defaults,  // Файла нет
+    Cache,     // Из двоичного кэша, текст не разбирался
+    Text,      // Разобран settings.ini (кэш обновлен, если ошибок не было)
+};
+
+// Загружает настройки через кэш, а при промахе — через store и пересобирает кэш.
+// Настройки с ошибками разбора не кэшируются, чтобы предупреждения выводились при каждом запуске
+SettingsParseResult LoadSettingsCached(SettingsStore& store, Settings& settings, SettingsSource* source = nullptr);
+
+// Обновляет кэш после store.Save: время изменения файла сдвинулось, а содержимое известно
+void UpdateSettingsCache(const SettingsStore& store, const Settings& settings);
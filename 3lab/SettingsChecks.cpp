@@ -0,0 +1,270 @@
+﻿#include "Checks.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include "AtomicFile.h"
+#include "Board.h"
+#include "Framebuffer.h"
+#include "FrameScheduler.h"
+#include "GameController.h"
+#include "Renderer.h"
+#include "Settings.h"
+#include "SettingsCache.h"
+#include "SettingsStore.h"
+#include "SettingsWatcher.h"
+#include "SoftwareDevice.h"
+
+const char* const CheckSettingsPath = "3lab-check.ini";  // Временный файл в рабочем каталоге
+const int CheckReloadDebounceMs = 1000;  // Пауза дребезга в проверке: с запасом больше промежутков между заменами
+
+static std::string DescribeParse(const Settings& settings, const SettingsParseResult& result) {
+    std::string text = "GridSize=" + std::to_string(settings.gridSize) + " WinLength=" + std::to_string(settings.winLength);
+    for (int i = 0; i < SettingsKeyCount; ++i) {
+        if (result.errors[i] == SettingsError::None) continue;
+        text += std::string(" ") + SettingsKeyName(static_cast<SettingsKey>(i)) + ":" + SettingsErrorText(result.errors[i])
+            + "@" + std::to_string(result.errorLines[i]);
+    }
+    return text;
+}
+
+CheckResult CheckSettingsLongLines() {
+    CheckResult result;
+    // Хвост первой строки после 255 байт выглядит как ключ: прочитанный отдельно, он сменил бы GridSize
+    std::string text = "[Settings]\n;" + std::string(254, 'x') + "GridSize=3\n"
+        + "; " + std::string(5000, 'y') + "\n"
+        + "GridSize=" + std::string(600, '1') + "\n"
+        + "WinLength=7\n"
+        + "AiThreads=" + std::string(300, '9');  // Последняя строка без перевода строки
+
+    Settings expected = DefaultSettings();
+    std::string reference = DescribeParse(expected, ParseSettings(text, expected));
+    result.Note("ParseSettings: " + reference);
+    result.Expect(expected.gridSize == DefaultSettings().gridSize && expected.winLength == 7, "reference parse is wrong");
+
+    for (int method = 1; method <= 4; ++method) {
+        std::unique_ptr<SettingsStore> store = CreateSettingsStore(method, CheckSettingsPath);
+        if (!store->Write(CheckSettingsPath, text.data(), text.size())) {
+            result.Expect(false, std::string("cannot write ") + CheckSettingsPath);
+            break;
+        }
+        Settings settings = DefaultSettings();
+        SettingsParseResult parsed = store->Load(settings);
+        std::string described = DescribeParse(settings, parsed);
+        result.Note(std::string(store->Name()) + ": " + described);
+        result.Expect(described == reference, std::string(store->Name()) + " reads the file differently from ParseSettings");
+    }
+    std::remove(CheckSettingsPath);
+    return result;
+}
+
+CheckResult CheckSettingsSkippedWrite() {
+    CheckResult result;
+    namespace fs = std::filesystem;
+    for (int method = 1; method <= 4; ++method) {
+        std::remove(CheckSettingsPath);
+        std::unique_ptr<SettingsStore> store = CreateSettingsStore(method, CheckSettingsPath);
+        std::string name = store->Name();
+        Settings settings = DefaultSettings();
+        if (!store->Save(settings)) {
+            result.Expect(false, name + ": first save failed");
+            continue;
+        }
+        // Время изменения сдвигается на час назад: новая запись заметна даже при грубом разрешении часов ФС
+        std::error_code error;
+        fs::file_time_type stamp = fs::last_write_time(CheckSettingsPath, error) - std::chrono::hours(1);
+        fs::last_write_time(CheckSettingsPath, stamp, error);
+        result.Expect(!error, name + ": cannot set file time");
+
+        bool saved = store->Save(settings);
+        bool sameTime = fs::last_write_time(CheckSettingsPath, error) == stamp;
+        result.Note(name + ": skipped=" + std::to_string(store->SkippedWrites()) + " mtime " + (sameTime ? "unchanged" : "changed"));
+        result.Expect(saved && store->SkippedWrites() == 1, name + ": second save of the same settings was not skipped");
+        result.Expect(sameTime, name + ": second save of the same settings touched the file");
+
+        // Измененные настройки пишутся как обычно
+        settings.gridSize += 1;
+        saved = store->Save(settings);
+        result.Expect(saved && store->SkippedWrites() == 1, name + ": changed settings were not written");
+        result.Expect(fs::last_write_time(CheckSettingsPath, error) != stamp, name + ": changed settings left the file time");
+    }
+    std::remove(CheckSettingsPath);
+    return result;
+}
+
+CheckResult CheckSettingsReloadBurst(int replaces) {
+    CheckResult result;
+    std::remove(CheckSettingsPath);
+    std::unique_ptr<SettingsStore> store = CreateSettingsStore(static_cast<int>(SettingsMethod::NativeApi), CheckSettingsPath);
+    Settings settings = DefaultSettings();
+    if (!store->Save(settings)) {
+        result.Expect(false, std::string("cannot write ") + CheckSettingsPath);
+        return result;
+    }
+
+    std::atomic<unsigned> changes{ 0 };
+    SettingsWatcher watcher;
+    if (!watcher.Start(CheckSettingsPath, settings, [&changes] { ++changes; }, CheckReloadDebounceMs)) {
+        result.Expect(false, "watcher did not start");
+        std::remove(CheckSettingsPath);
+        return result;
+    }
+
+    // Серия атомарных замен (временный файл + rename) без fsync, каждая с другим размером клетки.
+    // Дребезг считается от последнего события, поэтому важен наибольший промежуток между заменами
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point last = Clock::now();
+    double maxGapMs = 0;
+    std::string temp = TempPathFor(CheckSettingsPath);
+    for (int i = 0; i < replaces; ++i) {
+        settings.gridSize = 2 + i % 100;
+        char text[SettingsTextCapacity];
+        std::size_t length = FormatSettings(settings, text, sizeof(text));
+        result.Expect(store->Write(temp, text, length) && AtomicReplace(temp, CheckSettingsPath), "replace " + std::to_string(i) + " failed");
+        Clock::time_point now = Clock::now();
+        maxGapMs = std::max(maxGapMs, std::chrono::duration<double, std::milli>(now - last).count());
+        last = now;
+    }
+    // Ждем перечитывания, а затем еще одну паузу дребезга: лишнее перечитывание успело бы случиться
+    for (int waited = 0; watcher.Reloads() == 0 && waited < CheckReloadDebounceMs * 4; waited += 10) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(CheckReloadDebounceMs));
+    watcher.Stop();
+
+    char gap[32];
+    std::snprintf(gap, sizeof(gap), "%.2f", maxGapMs);
+    result.Note(std::to_string(replaces) + " replaces, largest gap " + gap + " ms (debounce "
+        + std::to_string(CheckReloadDebounceMs) + " ms), reloads=" + std::to_string(watcher.Reloads())
+        + " callbacks=" + std::to_string(changes.load()) + " GridSize=" + std::to_string(watcher.Current()->gridSize));
+    // Промежуток больше дребезга — машина не дала провести серию, и проверка ничего бы не доказала
+    result.Expect(maxGapMs < CheckReloadDebounceMs, "replaces were not quick enough to form one burst");
+    result.Expect(watcher.Reloads() == 1, "burst of replaces was not collapsed into one reload");
+    result.Expect(changes.load() == 1, "burst of replaces notified more than once");
+    result.Expect(watcher.Current()->gridSize == settings.gridSize, "watcher did not pick up the last replace");
+    std::remove(CheckSettingsPath);
+    return result;
+}
+
+CheckResult CheckSettingsCacheSameStamp() {
+    CheckResult result;
+    namespace fs = std::filesystem;
+    std::string cachePath = SettingsCachePath(CheckSettingsPath);
+    std::remove(CheckSettingsPath);
+    std::remove(cachePath.c_str());
+    std::unique_ptr<SettingsStore> store = CreateSettingsStore(static_cast<int>(SettingsMethod::MemoryMapping), CheckSettingsPath);
+    Settings saved = DefaultSettings();
+    saved.gridSize = 40;
+    if (!store->Save(saved)) {
+        result.Expect(false, std::string("cannot write ") + CheckSettingsPath);
+        return result;
+    }
+
+    SettingsSource first, second, third;
+    Settings loaded = DefaultSettings();
+    LoadSettingsCached(*store, loaded, &first);
+    LoadSettingsCached(*store, loaded, &second);
+    result.Expect(first == SettingsSource::Text && second == SettingsSource::Cache, "cache was not written for an unchanged file");
+
+    // Вторая запись того же размера в тот же тик часов ФС: метка прежняя, текст другой
+    FileStamp before, after;
+    ReadFileStamp(CheckSettingsPath, before);
+    std::error_code error;
+    fs::file_time_type stamp = fs::last_write_time(CheckSettingsPath, error);
+    Settings edited = saved;
+    edited.gridSize = 41;
+    char text[SettingsTextCapacity];
+    std::size_t length = FormatSettings(edited, text, sizeof(text));
+    result.Expect(store->Write(CheckSettingsPath, text, length), "rewrite failed");
+    fs::last_write_time(CheckSettingsPath, stamp, error);
+    result.Expect(!error && ReadFileStamp(CheckSettingsPath, after) && after == before, "cannot give the rewrite the old file stamp");
+
+    loaded = DefaultSettings();
+    LoadSettingsCached(*store, loaded, &third);
+    result.Note(std::string("after same-stamp rewrite: source=") + (third == SettingsSource::Cache ? "cache" : "text")
+        + " GridSize=" + std::to_string(loaded.gridSize));
+    result.Expect(third == SettingsSource::Text, "stale cache used for a file rewritten with the same stamp");
+    result.Expect(loaded.gridSize == edited.gridSize, "settings from the rewrite were not loaded");
+
+    // Устоявшаяся метка (файл изменен час назад): кэш снова пишется и читается
+    fs::last_write_time(CheckSettingsPath, stamp - std::chrono::hours(1), error);
+    ReadFileStamp(CheckSettingsPath, after);
+    result.Expect(!error && !StampUnsettled(after), "cannot move the file stamp back");
+    LoadSettingsCached(*store, loaded, &first);
+    LoadSettingsCached(*store, loaded, &second);
+    result.Expect(first == SettingsSource::Text && second == SettingsSource::Cache && loaded.gridSize == edited.gridSize,
+        "cache was not used for a settled file stamp");
+    std::remove(CheckSettingsPath);
+    std::remove(cachePath.c_str());
+    return result;
+}
+
+// Записывает настройки в файл атомарной заменой, без fsync
+static bool ReplaceSettingsFile(SettingsStore& store, const Settings& settings) {
+    char text[SettingsTextCapacity];
+    std::size_t length = FormatSettings(settings, text, sizeof(text));
+    std::string temp = TempPathFor(CheckSettingsPath);
+    return store.Write(temp, text, length) && AtomicReplace(temp, CheckSettingsPath);
+}
+
+CheckResult CheckSettingsReloadKeys() {
+    const int debounceMs = 50;
+    CheckResult result;
+    std::remove(CheckSettingsPath);
+    std::unique_ptr<SettingsStore> store = CreateSettingsStore(static_cast<int>(SettingsMethod::NativeApi), CheckSettingsPath);
+    Settings file = DefaultSettings();
+    if (!ReplaceSettingsFile(*store, file)) {
+        result.Expect(false, std::string("cannot write ") + CheckSettingsPath);
+        return result;
+    }
+
+    // Окно запущено с размером клетки из командной строки, затем пользователь приблизил поле колесиком
+    Settings initial = file;
+    initial.gridSize = file.gridSize + 10;
+    Board board;
+    Framebuffer frame(initial.windowWidth, initial.windowHeight);
+    SoftwareDevice device(frame);
+    Renderer renderer(device);
+    FrameScheduler frames;
+    GameController controller(board, renderer, frames);
+    controller.Handle({ InputKind::Resize, 0, initial.windowWidth, initial.windowHeight, 0 });
+    controller.ApplySettings(initial);
+    controller.Handle({ InputKind::Wheel, ModControl, initial.windowWidth / 2, initial.windowHeight / 2, 1 });
+    int zoomed = controller.View().cellSize;
+
+    std::atomic<unsigned> changes{ 0 };
+    SettingsWatcher watcher;
+    if (!watcher.Start(CheckSettingsPath, initial, [&changes] { ++changes; }, debounceMs)) {
+        result.Expect(false, "watcher did not start");
+        std::remove(CheckSettingsPath);
+        return result;
+    }
+
+    // В файле меняется только цвет сетки
+    file.gridLineColor = MakeColor(1, 2, 3);
+    result.Expect(ReplaceSettingsFile(*store, file), "replace failed");
+    for (int waited = 0; changes.load() == 0 && waited < debounceMs * 40; waited += 10) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    watcher.Stop();
+
+    std::uint32_t keys = watcher.TakeChangedKeys();
+    std::shared_ptr<const Settings> fresh = watcher.Current();
+    controller.ApplySettings(*fresh, keys);
+    Settings current = controller.CurrentSettings();
+    result.Note("changed keys=" + std::to_string(keys) + " snapshot GridSize=" + std::to_string(fresh->gridSize)
+        + " cell " + std::to_string(zoomed) + " -> " + std::to_string(controller.View().cellSize));
+    result.Expect(changes.load() == 1, "color edit was not reloaded exactly once");
+    result.Expect(keys == SettingsKeyBit(SettingsKey::GridLineColor), "keys other than GridLineColor reported as changed");
+    result.Expect(fresh->gridSize == initial.gridSize, "reload replaced the command-line GridSize with the file value");
+    result.Expect(controller.View().cellSize == zoomed, "color edit reset the wheel zoom");
+    result.Expect(current.gridLineColor == file.gridLineColor, "new grid color was not applied");
+    result.Expect(watcher.TakeChangedKeys() == 0, "changed keys were not cleared");
+    std::remove(CheckSettingsPath);
+    return result;
+}
@@ -0,0 +1,112 @@
+﻿// Фаззинг разбора settings.ini. С libFuzzer (clang -fsanitize=fuzzer) это обычная цель:
+//   3lab-settings-fuzz [corpus_dir] -runs=N
+// Без него (SETTINGS_FUZZ_STANDALONE) своя main подает случайные мутации корректного файла:
+//   3lab-settings-fuzz [-runs=N] [file...]
+// На каждом входе проверяется: значения в допустимых пределах, у каждой ошибки есть строка,
+// а записанные заново настройки читаются без ошибок и без изменений. Нарушение — abort
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "Settings.h"
+#include "SettingsStore.h"
+
+static bool InRange(int value, int low, int high) {
+    return value >= low && value <= high;
+}
+
+static bool SameSettings(const Settings& a, const Settings& b) {
+    return a.gridSize == b.gridSize && a.windowWidth == b.windowWidth && a.windowHeight == b.windowHeight
+        && a.backgroundColor == b.backgroundColor && a.gridLineColor == b.gridLineColor && a.winLength == b.winLength
+        && a.aiTimeMs == b.aiTimeMs && a.aiThreads == b.aiThreads;
+}
+
+static void Require(bool condition, const char* what) {
+    if (condition) return;
+    std::fprintf(stderr, "settings fuzz: %s\n", what);
+    std::abort();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+    Settings settings = DefaultSettings();
+    SettingsParseResult result = ParseSettings(std::string_view(reinterpret_cast<const char*>(data), size), settings);
+
+    // Пределы те же, что в ParseSettingsLine: неверное значение не должно попасть в настройки
+    Require(InRange(settings.gridSize, 1, 4096), "GridSize out of range");
+    Require(InRange(settings.windowWidth, 1, 65535) && InRange(settings.windowHeight, 1, 65535), "window size out of range");
+    Require(settings.backgroundColor <= 0xFFFFFF && settings.gridLineColor <= 0xFFFFFF, "color out of range");
+    Require(InRange(settings.winLength, 3, 16), "WinLength out of range");
+    Require(InRange(settings.aiTimeMs, 10, 600000) && InRange(settings.aiThreads, 0, 256), "AI settings out of range");
+    for (int i = 0; i < SettingsKeyCount; ++i) {
+        bool failed = result.errors[i] != SettingsError::None;
+        Require(!failed || (result.found[i] && result.errorLines[i] > 0), "error without a key or line");
+    }
+
+    char text[SettingsTextCapacity];
+    std::size_t length = FormatSettings(settings, text, sizeof(text));
+    Require(length > 0, "settings do not fit SettingsTextCapacity");
+    Settings reread = DefaultSettings();
+    Require(ParseSettings(std::string_view(text, length), reread).Ok(), "formatted settings do not parse");
+    Require(SameSettings(settings, reread), "formatted settings read back differently");
+    return 0;
+}
+
+#ifdef SETTINGS_FUZZ_STANDALONE
+#include <fstream>
+#include <iterator>
+#include <random>
+
+// Случайная правка текста: байт, вставка, удаление, вставка имени ключа или числа
+static void Mutate(std::string& text, std::mt19937& random) {
+    static const char* const pieces[] = {
+        "GridSize=", "WindowWidth=", "BackgroundColor=", "WinLength=", "AiThreads=", "\n", "=", ",",
+        "-", "255", "4096", "99999999999", "2147483648", " ", "\r", "[Settings]", "#", "0x10",
+    };
+    std::size_t pos = text.empty() ? 0 : random() % (text.size() + 1);
+    switch (random() % 4) {
+    case 0:
+        if (!text.empty() && pos < text.size()) text[pos] = static_cast<char>(random());
+        break;
+    case 1:
+        text.insert(pos, 1, static_cast<char>(random()));
+        break;
+    case 2:
+        if (pos < text.size()) text.erase(pos, 1 + random() % 8);
+        break;
+    default:
+        text.insert(pos, pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))]);
+        break;
+    }
+}
+
+int main(int argc, char** argv) {
+    long runs = 100000;
+    int files = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "-runs=", 6) == 0) {
+            runs = std::atol(argv[i] + 6);
+            continue;
+        }
+        // Готовые входы (например, найденные libFuzzer) прогоняются как есть
+        std::ifstream file(argv[i], std::ios::binary);
+        std::string input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        LLVMFuzzerTestOneInput(reinterpret_cast<const std::uint8_t*>(input.data()), input.size());
+        ++files;
+    }
+    if (files > 0) return 0;
+
+    char seed[SettingsTextCapacity];
+    std::string base(seed, FormatSettings(DefaultSettings(), seed, sizeof(seed)));
+    std::mt19937 random(1);
+    for (long run = 0; run < runs; ++run) {
+        std::string text = base;
+        int edits = 1 + static_cast<int>(random() % 16);
+        for (int i = 0; i < edits; ++i) Mutate(text, random);
+        LLVMFuzzerTestOneInput(reinterpret_cast<const std::uint8_t*>(text.data()), text.size());
+    }
+    std::printf("%ld inputs ok\n", runs);
+    return 0;
+}
+#endif
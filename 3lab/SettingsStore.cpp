@@ -0,0 +1,274 @@
+﻿#include "SettingsStore.h"
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include "AtomicFile.h"
+#include "Hash.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Дописывает в буфер строку или число, сдвигая позицию. При нехватке места обнуляет позицию
+struct TextWriter {
+    char* pos;
+    char* end;
+
+    void Text(std::string_view text) {
+        if (!pos) return;
+        if (static_cast<std::size_t>(end - pos) < text.size()) { pos = nullptr; return; }
+        std::memcpy(pos, text.data(), text.size());
+        pos += text.size();
+    }
+    void Number(int value) {
+        if (!pos) return;
+        auto [next, ec] = std::to_chars(pos, end, value);
+        pos = ec == std::errc() ? next : nullptr;
+    }
+    void Rgb(Color color) {
+        Number(ColorR(color));
+        Text(",");
+        Number(ColorG(color));
+        Text(",");
+        Number(ColorB(color));
+    }
+};
+
+std::size_t FormatSettings(const Settings& settings, char* buffer, std::size_t capacity) {
+    TextWriter out = { buffer, buffer + capacity };
+    out.Text("[Settings]\n");
+    out.Text("GridSize="); out.Number(settings.gridSize); out.Text("\n");
+    out.Text("WindowWidth="); out.Number(settings.windowWidth); out.Text("\n");
+    out.Text("WindowHeight="); out.Number(settings.windowHeight); out.Text("\n");
+    out.Text("BackgroundColor="); out.Rgb(settings.backgroundColor); out.Text("\n");
+    out.Text("GridLineColor="); out.Rgb(settings.gridLineColor); out.Text("\n");
+    out.Text("WinLength="); out.Number(settings.winLength); out.Text("\n");
+    out.Text("AiTimeMs="); out.Number(settings.aiTimeMs); out.Text("\n");
+    out.Text("AiThreads="); out.Number(settings.aiThreads); out.Text("\n");
+    return out.pos ? static_cast<std::size_t>(out.pos - buffer) : 0;
+}
+
+// Метод 1: Отображение файлов на память
+class MappedSettingsStore : public SettingsStore {
+public:
+    using SettingsStore::SettingsStore;
+    const char* Name() const override { return "mmap"; }
+
+    SettingsParseResult Load(Settings& settings) override {
+        PROFILE_SCOPE("settings.mmap.load");
+        MappedFile file;
+        if (!file.OpenRead(path.c_str())) {
+            // Если файл не удалось открыть или он пуст, используем значения по умолчанию
+            settings = DefaultSettings();
+            return {};
+        }
+        // Разбираем отображенные байты напрямую, без копирования в строку
+        return ParseSettings(std::string_view(file.Data(), file.Size()), settings);
+    }
+
+    bool Write(const std::string& target, const char* text, std::size_t length) override {
+        PROFILE_SCOPE("settings.mmap.write");
+        // Отображение сразу имеет итоговый размер, текст копируется в него одним memcpy
+        MappedFile file;
+        if (!file.Create(target.c_str(), length)) return false;
+        std::memcpy(file.MutableData(), text, length);
+        return true;
+    }
+};
+
+// Метод 2: Файловые переменные (fopen, fgets, fwrite, fclose)
+static FILE* OpenCFile(const std::string& path, const char* mode) {
+#ifdef _MSC_VER
+    FILE* file = nullptr;
+    return fopen_s(&file, path.c_str(), mode) == 0 ? file : nullptr;
+#else
+    return std::fopen(path.c_str(), mode);
+#endif
+}
+
+class FileSettingsStore : public SettingsStore {
+public:
+    using SettingsStore::SettingsStore;
+    const char* Name() const override { return "stdio"; }
+
+    SettingsParseResult Load(Settings& settings) override {
+        PROFILE_SCOPE("settings.stdio.load");
+        FILE* file = OpenCFile(path, "r");
+        if (!file) {
+            settings = DefaultSettings();
+            return {};
+        }
+
+        // Читаем файл построчно и парсим настройки. fgets отдает строку кусками по размеру буфера,
+        // строка собирается целиком, поэтому длинная строка не распадается на несколько
+        SettingsParseResult result;
+        char chunk[256];
+        std::string line;
+        int lineNumber = 1;
+        while (std::fgets(chunk, sizeof(chunk), file)) {
+            std::size_t length = std::strlen(chunk);
+            bool complete = length > 0 && chunk[length - 1] == '\n';
+            line.append(chunk, complete ? length - 1 : length);
+            if (!complete) continue;
+            ParseSettingsLine(line, lineNumber++, settings, result);
+            line.clear();
+        }
+        if (!line.empty()) ParseSettingsLine(line, lineNumber, settings, result);  // Последняя строка без перевода строки
+
+        std::fclose(file);
+        return result;
+    }
+
+    bool Write(const std::string& target, const char* text, std::size_t length) override {
+        PROFILE_SCOPE("settings.stdio.write");
+        FILE* file = OpenCFile(target, "wb");
+        if (!file) return false;
+        bool ok = std::fwrite(text, 1, length, file) == length;
+        return std::fclose(file) == 0 && ok;
+    }
+};
+
+// Метод 3: Потоки ввода-вывода (ifstream / ofstream)
+class StreamSettingsStore : public SettingsStore {
+public:
+    using SettingsStore::SettingsStore;
+    const char* Name() const override { return "fstream"; }
+
+    SettingsParseResult Load(Settings& settings) override {
+        PROFILE_SCOPE("settings.fstream.load");
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            settings = DefaultSettings();
+            return {};
+        }
+
+        // Читаем файл построчно и парсим настройки (буфер строки переиспользуется)
+        SettingsParseResult result;
+        std::string line;
+        int lineNumber = 1;
+        while (std::getline(file, line)) {
+            ParseSettingsLine(line, lineNumber++, settings, result);
+        }
+        return result;
+    }
+
+    bool Write(const std::string& target, const char* text, std::size_t length) override {
+        PROFILE_SCOPE("settings.fstream.write");
+        std::ofstream file(target, std::ios::binary);
+        if (!file.is_open()) return false;
+        file.write(text, static_cast<std::streamsize>(length));
+        file.close();
+        return static_cast<bool>(file);
+    }
+};
+
+// Метод 4: Файловые функции ОС
+class NativeSettingsStore : public SettingsStore {
+public:
+    using SettingsStore::SettingsStore;
+#ifdef _WIN32
+    const char* Name() const override { return "winapi"; }
+
+    SettingsParseResult Load(Settings& settings) override {
+        PROFILE_SCOPE("settings.winapi.load");
+        HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        DWORD fileSize = hFile != INVALID_HANDLE_VALUE ? GetFileSize(hFile, NULL) : INVALID_FILE_SIZE;
+        std::string buffer(fileSize != INVALID_FILE_SIZE ? fileSize : 0, '\0');
+        DWORD bytesRead = 0;
+        if (fileSize == INVALID_FILE_SIZE || !ReadFile(hFile, buffer.data(), fileSize, &bytesRead, NULL)) {
+            if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+            settings = DefaultSettings();
+            return {};
+        }
+        CloseHandle(hFile);
+        return ParseSettings(std::string_view(buffer.data(), bytesRead), settings);
+    }
+
+    bool Write(const std::string& target, const char* text, std::size_t length) override {
+        PROFILE_SCOPE("settings.winapi.write");
+        HANDLE hFile = CreateFileA(target.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hFile == INVALID_HANDLE_VALUE) return false;
+        DWORD bytesWritten = 0;
+        BOOL ok = WriteFile(hFile, text, static_cast<DWORD>(length), &bytesWritten, NULL) && bytesWritten == length;
+        CloseHandle(hFile);
+        return ok != FALSE;
+    }
+#else
+    const char* Name() const override { return "posix"; }
+
+    SettingsParseResult Load(Settings& settings) override {
+        PROFILE_SCOPE("settings.posix.load");
+        int fd = open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            if (fd >= 0) close(fd);
+            settings = DefaultSettings();
+            return {};
+        }
+
+        std::string buffer(static_cast<std::size_t>(st.st_size), '\0');
+        std::size_t total = 0;
+        while (total < buffer.size()) {
+            ssize_t n = read(fd, buffer.data() + total, buffer.size() - total);
+            if (n <= 0) break;
+            total += static_cast<std::size_t>(n);
+        }
+        close(fd);
+        return ParseSettings(std::string_view(buffer.data(), total), settings);
+    }
+
+    bool Write(const std::string& target, const char* text, std::size_t length) override {
+        PROFILE_SCOPE("settings.posix.write");
+        int fd = open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        bool ok = write(fd, text, length) == static_cast<ssize_t>(length);
+        return close(fd) == 0 && ok;
+    }
+#endif
+};
+
+// Совпадает ли содержимое файла с текстом (сравниваются размер и Hash64, файл только читается)
+static bool SameContent(const std::string& path, const char* text, std::size_t length) {
+    MappedFile file;
+    if (!file.OpenRead(path.c_str()) || file.Size() != length) return false;
+    return Hash64(file.Data(), length) == Hash64(text, length);
+}
+
+bool SettingsStore::Save(const Settings& settings) {
+    PROFILE_SCOPE("settings.save");
+    // Текст формируется один раз в буфере на стеке и отдается хранилищу уже готовым
+    char text[SettingsTextCapacity];
+    std::size_t length = FormatSettings(settings, text, sizeof(text));
+    if (length == 0) return false;
+
+    // Настройки не менялись — файл не трогаем совсем
+    if (SameContent(path, text, length)) {
+        ++skippedWrites;
+        return true;
+    }
+
+    std::string temp = TempPathFor(path);
+    if (!Write(temp, text, length) || !SyncFile(temp)) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return AtomicReplace(temp, path);
+}
+
+std::unique_ptr<SettingsStore> CreateSettingsStore(int method, const std::string& path) {
+    switch (static_cast<SettingsMethod>(method)) {
+    case SettingsMethod::File: return std::make_unique<FileSettingsStore>(path);
+    case SettingsMethod::Stream: return std::make_unique<StreamSettingsStore>(path);
+    case SettingsMethod::NativeApi: return std::make_unique<NativeSettingsStore>(path);
+    default: return std::make_unique<MappedSettingsStore>(path);
+    }
+}
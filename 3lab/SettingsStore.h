@@ -0,0 +1,50 @@
+﻿#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include "Settings.h"
+
+// Способы чтения и записи settings.ini (аргумент командной строки method)
+enum class SettingsMethod {
+    MemoryMapping = 1,  // Отображение файла на память (CreateFileMapping / mmap)
+    File = 2,           // Файловые переменные (fopen, fgets, fwrite)
+    Stream = 3,         // Потоки ввода-вывода (ifstream / ofstream)
+    NativeApi = 4,      // Файловые функции ОС (CreateFile/ReadFile/WriteFile или open/read/write)
+};
+
+// Хранилище настроек. Каждый способ ввода-вывода — отдельная реализация,
+// выбираемая через CreateSettingsStore, так что их можно подменять и замерять
+class SettingsStore {
+public:
+    explicit SettingsStore(std::string path) : path(std::move(path)) {}
+    virtual ~SettingsStore() = default;
+
+    virtual const char* Name() const = 0;
+    // Читает настройки. Если файл не удалось открыть, записывает значения по умолчанию
+    virtual SettingsParseResult Load(Settings& settings) = 0;
+    // Записывает настройки во временный файл и атомарно подменяет им path.
+    // При сбое посреди записи на диске остается старый settings.ini. Если текст совпадает
+    // с тем, что уже лежит на диске (по Hash64), запись пропускается. Возвращает false при ошибке
+    bool Save(const Settings& settings);
+
+    const std::string& Path() const { return path; }
+    // Сколько раз Save обошелся без записи, потому что настройки не изменились
+    unsigned SkippedWrites() const { return skippedWrites; }
+
+    // Записывает готовый текст в файл target целиком (способом конкретного хранилища), без fsync
+    // и без подмены. Открыт для замеров записи файлов разного размера
+    virtual bool Write(const std::string& target, const char* text, std::size_t length) = 0;
+
+protected:
+    std::string path;
+    unsigned skippedWrites = 0;
+};
+
+// Создает хранилище для способа 1..4 (некорректный номер — отображение на память)
+std::unique_ptr<SettingsStore> CreateSettingsStore(int method, const std::string& path = "settings.ini");
+
+// Максимальная длина текста настроек, который формирует FormatSettings
+const std::size_t SettingsTextCapacity = 256;
+
+// Формирует текст settings.ini в buffer без выделения памяти. Возвращает длину или 0, если не хватило места
+std::size_t FormatSettings(const Settings& settings, char* buffer, std::size_t capacity);
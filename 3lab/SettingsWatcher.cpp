@@ -0,0 +1,217 @@
+﻿#include "SettingsWatcher.h"
+#include <cstring>
+#include "Hash.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Делит путь на каталог и имя файла ("settings.ini" -> ".", "settings.ini")
+static void SplitPath(const std::string& path, std::string& directory, std::string& name) {
+    std::string::size_type slash = path.find_last_of("/\\");
+    directory = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+    name = slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+
+SettingsWatcher::~SettingsWatcher() {
+    Stop();
+}
+
+// Запоминает, что сейчас записано в файле: с этим сравнивается каждое следующее чтение.
+// Ключи, которых в файле нет, берутся из initial
+void SettingsWatcher::ReadBaseline(const Settings& initial) {
+    fileSettings = initial;
+    contentHash = 0;
+    MappedFile file;
+    if (!file.OpenRead(path.c_str())) return;
+    contentHash = Hash64(file.Data(), file.Size());
+    ParseSettings(std::string_view(file.Data(), file.Size()), fileSettings);
+}
+
+void SettingsWatcher::Reload() {
+    MappedFile file;
+    // Пустой или недоступный файл — скорее всего его как раз переписывают, ждем следующего события
+    if (!file.OpenRead(path.c_str())) return;
+
+    std::uint64_t hash = Hash64(file.Data(), file.Size());
+    if (hash == contentHash) return;  // Файл трогали, но содержимое прежнее
+    contentHash = hash;
+
+    Settings parsed = fileSettings;
+    ParseSettings(std::string_view(file.Data(), file.Size()), parsed);
+    std::uint32_t keys = DiffSettings(fileSettings, parsed);
+    fileSettings = parsed;
+    if (keys == 0) return;  // Поменялись только комментарии, порядок строк или пробелы
+
+    std::shared_ptr<Settings> fresh = std::make_shared<Settings>(*Current());
+    CopySettings(*fresh, parsed, keys);
+    std::atomic_store(&current, std::shared_ptr<const Settings>(std::move(fresh)));
+    changedKeys |= keys;
+    ++reloads;
+    if (onChange) onChange();
+}
+
+#ifdef _WIN32
+
+bool SettingsWatcher::Start(const std::string& watchPath, const Settings& initial, ChangeCallback callback, int debounce) {
+    Stop();
+    path = watchPath;
+    std::atomic_store(&current, std::make_shared<const Settings>(initial));
+    ReadBaseline(initial);
+    changedKeys = 0;
+    onChange = std::move(callback);
+    debounceMs = debounce;
+
+    std::string dir, name;
+    SplitPath(path, dir, name);
+    fileName.assign(name.size(), L'\0');
+    fileName.resize(MultiByteToWideChar(CP_ACP, 0, name.c_str(), static_cast<int>(name.size()), &fileName[0], static_cast<int>(name.size())));
+
+    HANDLE hDir = CreateFileA(dir.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (hDir == INVALID_HANDLE_VALUE) return false;
+    directory = hDir;
+    ioEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    stopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+
+    thread = std::thread(&SettingsWatcher::Run, this);
+    return true;
+}
+
+void SettingsWatcher::Stop() {
+    if (thread.joinable()) {
+        SetEvent(stopEvent);
+        thread.join();
+    }
+    for (void** handle : { &directory, &ioEvent, &stopEvent }) {
+        if (*handle) CloseHandle(*handle);
+        *handle = nullptr;
+    }
+}
+
+void SettingsWatcher::Run() {
+    alignas(DWORD) char buffer[4096];
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = ioEvent;
+    const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+    bool pending = false;  // Было изменение, ждем тишины
+    bool armed = false;    // Запрос ReadDirectoryChangesW в работе
+
+    for (;;) {
+        if (!armed) {
+            if (!ReadDirectoryChangesW(directory, buffer, sizeof(buffer), FALSE, filter, NULL, &overlapped, NULL)) break;
+            armed = true;
+        }
+
+        HANDLE events[2] = { stopEvent, ioEvent };
+        DWORD wait = WaitForMultipleObjects(2, events, FALSE, pending ? static_cast<DWORD>(debounceMs) : INFINITE);
+        if (wait == WAIT_OBJECT_0) break;
+        if (wait == WAIT_TIMEOUT) {
+            pending = false;
+            Reload();
+            continue;
+        }
+
+        DWORD bytes = 0;
+        armed = false;
+        ResetEvent(ioEvent);
+        if (!GetOverlappedResult(directory, &overlapped, &bytes, FALSE)) break;
+        if (bytes == 0) {
+            pending = true;  // Буфер переполнился: событий было больше, чем поместилось, проверим файл
+            continue;
+        }
+
+        const char* entry = buffer;
+        for (;;) {
+            const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(entry);
+            if (info->FileNameLength == fileName.size() * sizeof(WCHAR)
+                && std::memcmp(info->FileName, fileName.data(), info->FileNameLength) == 0) {
+                pending = true;
+            }
+            if (info->NextEntryOffset == 0) break;
+            entry += info->NextEntryOffset;
+        }
+    }
+
+    if (armed) {
+        DWORD bytes = 0;
+        CancelIoEx(directory, &overlapped);
+        GetOverlappedResult(directory, &overlapped, &bytes, TRUE);
+    }
+}
+
+#else
+
+bool SettingsWatcher::Start(const std::string& watchPath, const Settings& initial, ChangeCallback callback, int debounce) {
+    Stop();
+    path = watchPath;
+    std::atomic_store(&current, std::make_shared<const Settings>(initial));
+    ReadBaseline(initial);
+    changedKeys = 0;
+    onChange = std::move(callback);
+    debounceMs = debounce;
+
+    std::string dir;
+    SplitPath(path, dir, fileName);
+
+    // Следим за каталогом: при атомарной замене (rename) у файла меняется inode
+    inotifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (inotifyFd < 0) return false;
+    if (inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0 || pipe(stopPipe) != 0) {
+        Stop();
+        return false;
+    }
+
+    thread = std::thread(&SettingsWatcher::Run, this);
+    return true;
+}
+
+void SettingsWatcher::Stop() {
+    if (thread.joinable()) {
+        // Закрытие записывающего конца будит poll (POLLHUP на stopPipe[0])
+        close(stopPipe[1]);
+        stopPipe[1] = -1;
+        thread.join();
+    }
+    for (int* fd : { &inotifyFd, &stopPipe[0], &stopPipe[1] }) {
+        if (*fd >= 0) close(*fd);
+        *fd = -1;
+    }
+}
+
+void SettingsWatcher::Run() {
+    alignas(inotify_event) char buffer[4096];
+    bool pending = false;  // Было изменение, ждем тишины
+
+    for (;;) {
+        pollfd fds[2] = { { inotifyFd, POLLIN, 0 }, { stopPipe[0], POLLIN, 0 } };
+        int ready = poll(fds, 2, pending ? debounceMs : -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+        if (ready == 0) {
+            pending = false;
+            Reload();
+            continue;
+        }
+
+        ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len && fileName == event->name) pending = true;
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,68 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include "Settings.h"
+
+const int SettingsReloadDebounceMs = 100;  // Тишина после последнего изменения, после которой файл перечитывается
+
+// Следит за файлом настроек и перечитывает его на лету (inotify / ReadDirectoryChangesW).
+// Серия быстрых изменений схлопывается в одно перечитывание, а разбор выполняется,
+// только если содержимое файла действительно изменилось (по Hash64).
+// В снимок переносятся только ключи, чье значение в файле изменилось с прошлого чтения:
+// остальные сохраняют значения initial (например, размер клетки из командной строки).
+// Новые настройки публикуются неизменяемым снимком: читатели берут Current() и не блокируются
+class SettingsWatcher {
+public:
+    // Вызывается из потока наблюдателя после публикации нового снимка
+    using ChangeCallback = std::function<void()>;
+
+    SettingsWatcher() = default;
+    ~SettingsWatcher();
+
+    SettingsWatcher(const SettingsWatcher&) = delete;
+    SettingsWatcher& operator=(const SettingsWatcher&) = delete;
+
+    // Начинает следить за path. initial — уже примененные настройки (ключи, которых нет в файле, сохраняют их значения).
+    // debounceMs — тишина после последнего изменения, после которой файл перечитывается
+    bool Start(const std::string& path, const Settings& initial, ChangeCallback onChange,
+        int debounceMs = SettingsReloadDebounceMs);
+    // Останавливает поток наблюдателя
+    void Stop();
+
+    // Последний опубликованный снимок настроек
+    std::shared_ptr<const Settings> Current() const { return std::atomic_load(&current); }
+    // Сколько раз настройки были перечитаны
+    unsigned Reloads() const { return reloads.load(); }
+    // Ключи, измененные в файле с прошлого вызова (маска SettingsKeyBit), и сброс набора
+    std::uint32_t TakeChangedKeys() { return changedKeys.exchange(0); }
+
+private:
+    void Run();
+    void Reload();
+    void ReadBaseline(const Settings& initial);
+
+    std::string path;
+    std::shared_ptr<const Settings> current;  // Меняется только через atomic_store
+    std::uint64_t contentHash = 0;            // Hash64 содержимого, из которого получен current
+    Settings fileSettings = {};               // Значения из файла при последнем чтении (только поток наблюдателя)
+    ChangeCallback onChange;
+    int debounceMs = SettingsReloadDebounceMs;
+    std::atomic<unsigned> reloads{ 0 };
+    std::atomic<std::uint32_t> changedKeys{ 0 };
+    std::thread thread;
+
+#ifdef _WIN32
+    void* directory = nullptr;  // HANDLE каталога с файлом
+    void* ioEvent = nullptr;    // Событие завершения ReadDirectoryChangesW
+    void* stopEvent = nullptr;  // Сигнал остановки
+    std::wstring fileName;
+#else
+    int inotifyFd = -1;
+    int stopPipe[2] = { -1, -1 };  // Запись в stopPipe[1] будит poll при остановке
+    std::string fileName;
+#endif
+};
@@ -0,0 +1,307 @@
+﻿#include "SharedBoard.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "атомики в общей памяти должны быть без блокировок");
+
+// Заголовок общей памяти. Поля после ready записываются создателем до публикации ready
+struct SharedBoardHeader {
+    char magic[4];                          // "CCSB"
+    std::uint32_t version;
+    std::int32_t cols;
+    std::int32_t rows;
+    std::uint32_t rowWords;
+    std::uint32_t ringSize;
+    std::atomic<std::uint32_t> ready;       // 1 — создатель закончил инициализацию
+    std::atomic<std::uint32_t> users;       // Сколько экземпляров подключено (последний удаляет общую память)
+    std::atomic<std::uint64_t> changeHead;  // Счетчик версий: число опубликованных изменений
+};
+
+// Запись кольца изменений. sequence = номер версии + 1 после записи, 0 — запись переписывается
+struct SharedBoardChange {
+    std::atomic<std::uint64_t> sequence;
+    std::atomic<std::uint32_t> cell;  // row * cols + col
+    std::uint32_t reserved;
+};
+
+static const char SharedMagic[4] = { 'C', 'C', 'S', 'B' };
+static const std::uint32_t SharedBoardVersion = 2;
+static const int ReadyTimeoutMs = 2000;  // Сколько ждать, пока создатель инициализирует поле
+
+static std::atomic<std::uint64_t>& AtomicWord(std::uint64_t* words, std::size_t index) {
+    return reinterpret_cast<std::atomic<std::uint64_t>*>(words)[index];
+}
+
+static std::size_t SharedSize(int cols, int rows) {
+    std::size_t rowWords = (static_cast<std::size_t>(cols) + Board::CellsPerWord - 1) / Board::CellsPerWord;
+    return sizeof(SharedBoardHeader) + SharedBoardRingSize * sizeof(SharedBoardChange) + rowWords * rows * sizeof(std::uint64_t);
+}
+
+SharedBoard::~SharedBoard() {
+    Close();
+}
+
+bool SharedBoard::Open(const char* name, int newCols, int newRows) {
+    Close();
+#ifndef _WIN32
+    bool removedStale = false;
+#endif
+    for (int attempt = 0; attempt < ReadyTimeoutMs; ++attempt) {
+        switch (Attach(name, newCols, newRows)) {
+        case AttachStatus::Attached:
+            return true;
+        case AttachStatus::Failed:
+            return false;
+        case AttachStatus::Unfinished:
+#ifdef _WIN32
+            return false;  // Отображение без файла исчезнет само, когда его закроют все процессы
+#else
+            // Создатель умер, не закончив инициализацию: такое поле уже не оживет, удаляем его и создаем заново
+            if (removedStale) return false;
+            removedStale = true;
+            shm_unlink(("/" + std::string(name)).c_str());
+            break;
+#endif
+        case AttachStatus::Closing:
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));  // Ждем, пока последний экземпляр удалит старое поле
+            break;
+        }
+    }
+    return false;
+}
+
+#ifdef _WIN32
+
+SharedBoard::AttachStatus SharedBoard::Attach(const char* name, int newCols, int newRows) {
+    size = SharedSize(newCols, newRows);
+    std::string mappingName = std::string("Local\\") + name;
+    HANDLE hMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+        static_cast<DWORD>(static_cast<std::uint64_t>(size) >> 32), static_cast<DWORD>(size), mappingName.c_str());
+    if (!hMapping) return AttachStatus::Failed;
+    created = GetLastError() != ERROR_ALREADY_EXISTS;
+
+    void* view = MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!view) {
+        CloseHandle(hMapping);
+        return AttachStatus::Failed;
+    }
+    mapping = hMapping;
+    header = static_cast<SharedBoardHeader*>(view);
+    // Отображение без файла живет, пока открыто хотя бы в одном процессе
+#else
+
+SharedBoard::AttachStatus SharedBoard::Attach(const char* name, int newCols, int newRows) {
+    size = SharedSize(newCols, newRows);
+    shmName = std::string("/") + name;
+
+    int fd = shm_open(shmName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    created = fd >= 0;
+    if (created) {
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            close(fd);
+            shm_unlink(shmName.c_str());
+            return AttachStatus::Failed;
+        }
+    } else {
+        if (errno != EEXIST) return AttachStatus::Failed;
+        // Поле удалили между двумя shm_open — пробуем создать его сами
+        if ((fd = shm_open(shmName.c_str(), O_RDWR, 0600)) < 0) return errno == ENOENT ? AttachStatus::Closing : AttachStatus::Failed;
+        // Создатель мог еще не успеть задать размер
+        struct stat st;
+        for (int waited = 0; fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) < size; ++waited) {
+            if (waited >= ReadyTimeoutMs) {
+                close(fd);
+                return AttachStatus::Unfinished;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // Отображение остается действительным и без дескриптора
+    if (view == MAP_FAILED) return AttachStatus::Failed;
+    header = static_cast<SharedBoardHeader*>(view);
+    // Объект общей памяти переживает процессы: последний отключившийся экземпляр удаляет его в Close
+#endif
+
+    ring = reinterpret_cast<SharedBoardChange*>(header + 1);
+    words = reinterpret_cast<std::uint64_t*>(ring + SharedBoardRingSize);
+
+    if (created) {
+        // Свежая общая память заполнена нулями: пустое поле, пустое кольцо, версия 0
+        new (header) SharedBoardHeader();
+        std::memcpy(header->magic, SharedMagic, sizeof(SharedMagic));
+        header->version = SharedBoardVersion;
+        header->cols = newCols;
+        header->rows = newRows;
+        header->rowWords = static_cast<std::uint32_t>((newCols + Board::CellsPerWord - 1) / Board::CellsPerWord);
+        header->ringSize = SharedBoardRingSize;
+        header->ready.store(1, std::memory_order_release);
+    } else {
+        for (int waited = 0; header->ready.load(std::memory_order_acquire) == 0; ++waited) {
+            if (waited >= ReadyTimeoutMs) {
+                Detach();
+                return AttachStatus::Unfinished;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        // Поле могло остаться от другой версии программы
+        if (std::memcmp(header->magic, SharedMagic, sizeof(SharedMagic)) != 0 || header->version != SharedBoardVersion
+            || header->cols != newCols || header->rows != newRows || header->ringSize != SharedBoardRingSize) {
+            Detach();
+            return AttachStatus::Failed;
+        }
+    }
+
+#ifndef _WIN32
+    // Счетчик был нулем: последний экземпляр как раз отключается и удаляет поле — подключаемся заново
+    if (header->users.fetch_add(1, std::memory_order_acq_rel) == 0 && !created) {
+        header->users.fetch_sub(1, std::memory_order_acq_rel);
+        Detach();
+        return AttachStatus::Closing;
+    }
+#else
+    header->users.fetch_add(1, std::memory_order_acq_rel);
+#endif
+
+    cols = header->cols;
+    rows = header->rows;
+    rowWords = static_cast<int>(header->rowWords);
+    cursor = header->changeHead.load(std::memory_order_acquire);
+    return AttachStatus::Attached;
+}
+
+void SharedBoard::Close() {
+    if (!header) return;
+    bool last = header->users.fetch_sub(1, std::memory_order_acq_rel) == 1;
+#ifndef _WIN32
+    if (last) shm_unlink(shmName.c_str());
+#else
+    (void)last;  // Отображение без файла система удаляет сама
+#endif
+    Detach();
+}
+
+void SharedBoard::Detach() {
+    if (!header) return;
+#ifdef _WIN32
+    UnmapViewOfFile(header);
+    CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    munmap(header, size);
+#endif
+    header = nullptr;
+    ring = nullptr;
+    words = nullptr;
+    cols = rows = rowWords = 0;
+    created = false;
+}
+
+bool SharedBoard::Place(int col, int row, Mark mark) {
+    if (!header || mark == Mark::Empty || col < 0 || row < 0 || col >= cols || row >= rows) return false;
+
+    std::atomic<std::uint64_t>& word = AtomicWord(words, static_cast<std::size_t>(row) * rowWords + col / Board::CellsPerWord);
+    int shift = (col % Board::CellsPerWord) * 2;
+    std::uint64_t old = word.load(std::memory_order_relaxed);
+    do {
+        if ((old >> shift) & 3) return false;  // Клетка уже занята
+    } while (!word.compare_exchange_weak(old, old | (static_cast<std::uint64_t>(mark) << shift), std::memory_order_acq_rel));
+
+    Publish(col, row);
+    return true;
+}
+
+bool SharedBoard::Clear(int col, int row) {
+    if (!header || col < 0 || row < 0 || col >= cols || row >= rows) return false;
+
+    std::atomic<std::uint64_t>& word = AtomicWord(words, static_cast<std::size_t>(row) * rowWords + col / Board::CellsPerWord);
+    int shift = (col % Board::CellsPerWord) * 2;
+    std::uint64_t old = word.load(std::memory_order_relaxed);
+    do {
+        if (((old >> shift) & 3) == 0) return false;
+    } while (!word.compare_exchange_weak(old, old & ~(std::uint64_t(3) << shift), std::memory_order_acq_rel));
+
+    Publish(col, row);
+    return true;
+}
+
+Mark SharedBoard::Get(int col, int row) const {
+    if (!header || col < 0 || row < 0 || col >= cols || row >= rows) return Mark::Empty;
+    std::uint64_t word = AtomicWord(words, static_cast<std::size_t>(row) * rowWords + col / Board::CellsPerWord).load(std::memory_order_acquire);
+    return static_cast<Mark>((word >> ((col % Board::CellsPerWord) * 2)) & 3);
+}
+
+void SharedBoard::Publish(int col, int row) {
+    // Резервируем версию, затем заполняем ее запись в кольце (писатели друг друга не ждут)
+    std::uint64_t slot = header->changeHead.fetch_add(1, std::memory_order_acq_rel);
+    SharedBoardChange& change = ring[slot % SharedBoardRingSize];
+    change.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    change.cell.store(static_cast<std::uint32_t>(row) * static_cast<std::uint32_t>(cols) + static_cast<std::uint32_t>(col), std::memory_order_relaxed);
+    change.sequence.store(slot + 1, std::memory_order_release);
+}
+
+SharedBoard::ChangeStatus SharedBoard::NextChange(int& col, int& row) {
+    std::uint64_t head = header->changeHead.load(std::memory_order_acquire);
+    if (cursor == head) return ChangeStatus::None;
+    if (head - cursor > SharedBoardRingSize) return ChangeStatus::Lapped;
+
+    const SharedBoardChange& change = ring[cursor % SharedBoardRingSize];
+    std::uint64_t sequence = change.sequence.load(std::memory_order_acquire);
+    if (sequence < cursor + 1) return ChangeStatus::None;  // Писатель еще заполняет запись, дочитаем при следующем опросе
+    std::uint32_t cell = change.cell.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence != cursor + 1 || change.sequence.load(std::memory_order_relaxed) != sequence) return ChangeStatus::Lapped;
+
+    ++cursor;
+    col = static_cast<int>(cell % static_cast<std::uint32_t>(cols));
+    row = static_cast<int>(cell / static_cast<std::uint32_t>(cols));
+    return ChangeStatus::Changed;
+}
+
+bool SharedBoard::SyncCell(Board& mirror, int col, int row) const {
+    // Источник истины — общая память, кольцо говорит только, какую клетку перечитать
+    Mark mark = Get(col, row);
+    if (mirror.Get(col, row) == mark) return false;
+    mirror.Clear(col, row);
+    if (mark != Mark::Empty) mirror.Place(col, row, mark);
+    return true;
+}
+
+void SharedBoard::CopyTo(Board& mirror) {
+    if (!header) return;
+    // Версию запоминаем до копирования: изменения во время копирования придут повторно и ничего не испортят
+    cursor = header->changeHead.load(std::memory_order_acquire);
+
+    // Общее поле занимает клетки [0, cols) x [0, rows) бесконечного поля. Метки mirror за его пределами
+    // не трогаются: их нельзя поделить с другими экземплярами, но терять их незачем
+    std::vector<std::pair<int, int>> inside;
+    mirror.ForEachIn(0, 0, cols, rows, [&inside](int col, int row, Mark) { inside.emplace_back(col, row); });
+    for (const std::pair<int, int>& cell : inside) mirror.Clear(cell.first, cell.second);
+    for (int row = 0; row < rows; ++row) {
+        for (int w = 0; w < rowWords; ++w) {
+            std::uint64_t word = AtomicWord(words, static_cast<std::size_t>(row) * rowWords + w).load(std::memory_order_acquire);
+            for (int i = 0; word != 0; ++i, word >>= 2) {
+                if (word & 3) mirror.Place(w * Board::CellsPerWord + i, row, static_cast<Mark>(word & 3));
+            }
+        }
+    }
+}
@@ -0,0 +1,105 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Board.h"
+
+const char SharedBoardName[] = "CirclesCrossesBoard";  // Имя общей памяти (одно на пользователя)
+const int SharedBoardCols = 1024;     // Емкость общего поля в клетках
+const int SharedBoardRows = 1024;
+const std::uint32_t SharedBoardRingSize = 4096;  // Последних изменений, которые помнит кольцо
+const unsigned int SharedBoardPollMs = 30;       // Период опроса изменений других экземпляров (WM_TIMER)
+
+struct SharedBoardHeader;
+struct SharedBoardChange;
+
+// Поле в общей памяти, которое видят все запущенные экземпляры программы
+// (именованное отображение в Windows, shm_open + mmap в POSIX). Оно покрывает
+// клетки [0, SharedBoardCols) x [0, SharedBoardRows) бесконечного поля.
+// Клетки упакованы так же, как в Board, и ставятся атомарным CAS по 64-битному слову,
+// поэтому две одновременные постановки в одну клетку не могут обе пройти.
+// Каждое изменение увеличивает счетчик версий и попадает в кольцо последних изменений;
+// читатели сверяют счетчик и перерисовывают только изменившиеся клетки, никого не блокируя.
+// Последний отключившийся экземпляр удаляет общую память; поле, создатель которого умер
+// до конца инициализации, удаляется и создается заново
+class SharedBoard {
+public:
+    SharedBoard() = default;
+    ~SharedBoard();
+
+    SharedBoard(const SharedBoard&) = delete;
+    SharedBoard& operator=(const SharedBoard&) = delete;
+
+    // Подключается к общему полю name или создает его размером cols x rows
+    bool Open(const char* name, int cols, int rows);
+    void Close();
+    bool IsOpen() const { return header != nullptr; }
+    // Поле создано этим экземпляром (остальные подключились к готовому)
+    bool Created() const { return created; }
+
+    int Cols() const { return cols; }
+    int Rows() const { return rows; }
+    // Клетка входит в общее поле (остальные клетки бесконечного поля общими не бывают)
+    bool Contains(int col, int row) const { return col >= 0 && row >= 0 && col < cols && row < rows; }
+
+    // Ставит метку в пустую клетку. Возвращает false, если клетка занята (в том числе другим экземпляром) или вне поля
+    bool Place(int col, int row, Mark mark);
+    // Очищает клетку. Возвращает false, если она уже была пустой
+    bool Clear(int col, int row);
+    Mark Get(int col, int row) const;
+
+    // Копирует общее поле в mirror целиком и начинает отслеживать изменения с текущей версии.
+    // Метки mirror вне общего поля остаются на месте
+    void CopyTo(Board& mirror);
+
+    // Переносит в mirror изменения всех экземпляров с прошлого вызова и вызывает f(col, row)
+    // для каждой клетки, которая в mirror действительно поменялась.
+    // Возвращает false, если экземпляр отстал больше чем на кольцо: тогда mirror скопирован заново
+    template <typename F>
+    bool Poll(Board& mirror, F&& f) {
+        int col, row;
+        for (;;) {
+            switch (NextChange(col, row)) {
+            case ChangeStatus::None:
+                return true;
+            case ChangeStatus::Lapped:
+                CopyTo(mirror);
+                return false;
+            case ChangeStatus::Changed:
+                if (SyncCell(mirror, col, row)) f(col, row);
+                break;
+            }
+        }
+    }
+
+private:
+    enum class ChangeStatus { None, Changed, Lapped };
+    enum class AttachStatus {
+        Attached,
+        Failed,
+        Unfinished,  // Создатель не закончил инициализацию за ReadyTimeoutMs
+        Closing,     // Последний экземпляр как раз удаляет поле
+    };
+
+    AttachStatus Attach(const char* name, int cols, int rows);
+    void Detach();  // Отключается от общей памяти, не трогая счетчик экземпляров
+
+    ChangeStatus NextChange(int& col, int& row);
+    bool SyncCell(Board& mirror, int col, int row) const;
+    void Publish(int col, int row);
+
+    SharedBoardHeader* header = nullptr;
+    SharedBoardChange* ring = nullptr;
+    std::uint64_t* words = nullptr;  // Доступ только через атомарные операции
+    std::size_t size = 0;
+    int cols = 0;
+    int rows = 0;
+    int rowWords = 0;
+    std::uint64_t cursor = 0;  // Версия, до которой изменения уже прочитаны
+    bool created = false;
+#ifdef _WIN32
+    void* mapping = nullptr;  // HANDLE отображения
+#else
+    std::string shmName;  // Имя для shm_unlink
+#endif
+};
@@ -0,0 +1,190 @@
+﻿#include "Checks.h"
+
+#ifndef _WIN32
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "Board.h"
+#include "SharedBoard.h"
+
+// Отдельное имя на запуск: проверка не мешает запущенным окнам и параллельным ctest
+static std::string CheckSharedName() {
+    return "CirclesCrossesCheck" + std::to_string(getpid());
+}
+
+// Общая память с этим именем еще существует (не удалена shm_unlink)
+static bool SharedMemoryExists(const std::string& name) {
+    int fd = shm_open(("/" + name).c_str(), O_RDONLY, 0600);
+    if (fd < 0) return false;
+    close(fd);
+    return true;
+}
+
+// Клетка номер index: строки общего поля по порядку
+static void CellAt(int index, int& col, int& row) {
+    col = index % SharedBoardCols;
+    row = index / SharedBoardCols;
+}
+
+const int WriterYieldCells = 64;  // Писатель уступает процессор через столько клеток (перемешивает писателей на одном ядре)
+
+// Итог писателя, который он передает родителю через канал
+struct WriterReport {
+    std::int32_t mark;
+    std::int32_t placed;
+};
+
+// Процесс-писатель: дожидается закрытия startFd, обходит cells клеток (кресты с начала, круги с конца,
+// так что за клетки спорят и писатели одной метки, и встречные) и ставит mark в каждую свободную.
+// Число удачных постановок пишет в resultFd
+static int RunWriter(const std::string& name, int cells, Mark mark, int startFd, int resultFd) {
+    SharedBoard shared;
+    if (!shared.Open(name.c_str(), SharedBoardCols, SharedBoardRows)) return 2;
+    char go;
+    if (read(startFd, &go, 1) != 0) return 4;  // Все писатели стартуют разом, когда родитель закроет канал
+    WriterReport report = { static_cast<std::int32_t>(mark), 0 };
+    for (int i = 0; i < cells; ++i) {
+        int col, row;
+        CellAt(mark == Mark::Cross ? i : cells - 1 - i, col, row);
+        report.placed += shared.Place(col, row, mark);
+        if (i % WriterYieldCells == 0) sched_yield();
+    }
+    shared.Close();
+    return write(resultFd, &report, sizeof(report)) == sizeof(report) ? 0 : 3;
+}
+
+CheckResult CheckSharedBoardStress(int processes, int cells) {
+    CheckResult result;
+    if (processes < 1 || cells < 1 || cells > SharedBoardCols * SharedBoardRows) {
+        result.Expect(false, "bad parameters");
+        return result;
+    }
+    std::string name = CheckSharedName();
+    SharedBoard shared;
+    if (!shared.Open(name.c_str(), SharedBoardCols, SharedBoardRows)) {
+        result.Expect(false, "cannot create shared board " + name);
+        return result;
+    }
+    result.Expect(shared.Created(), "shared board " + name + " already existed");
+
+    // poller опрашивает кольцо, пока идут записи; late читает его один раз в конце
+    Board polled, late;
+    shared.CopyTo(polled);
+    SharedBoard lateReader;
+    lateReader.Open(name.c_str(), SharedBoardCols, SharedBoardRows);
+    lateReader.CopyTo(late);
+
+    int fds[2], startFds[2];
+    if (pipe(fds) != 0 || pipe(startFds) != 0) {
+        result.Expect(false, "pipe failed");
+        return result;
+    }
+    std::vector<pid_t> children;
+    for (int p = 0; p < processes; ++p) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            close(startFds[1]);
+            _exit(RunWriter(name, cells, p % 2 ? Mark::Circle : Mark::Cross, startFds[0], fds[1]));
+        }
+        if (pid > 0) children.push_back(pid);
+    }
+    close(fds[1]);
+    close(startFds[0]);
+    close(startFds[1]);
+    result.Expect(static_cast<int>(children.size()) == processes, "fork failed");
+
+    auto start = std::chrono::steady_clock::now();
+    std::size_t running = children.size();
+    int lapped = 0;
+    while (running > 0) {
+        lapped += !shared.Poll(polled, [](int, int) {});
+        int status = 0;
+        pid_t done = waitpid(-1, &status, WNOHANG);
+        if (done <= 0) continue;
+        --running;
+        result.Expect(WIFEXITED(status) && WEXITSTATUS(status) == 0, "writer " + std::to_string(done) + " failed");
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    lapped += !shared.Poll(polled, [](int, int) {});
+
+    // Каждая клетка досталась ровно одному писателю
+    std::int32_t placed[2] = { 0, 0 };  // Кресты, круги
+    WriterReport report;
+    while (read(fds[0], &report, sizeof(report)) == sizeof(report)) {
+        placed[static_cast<Mark>(report.mark) == Mark::Circle] += report.placed;
+    }
+    close(fds[0]);
+    std::size_t crosses = 0, circles = 0;
+    bool polledMatches = true;
+    for (int i = 0; i < cells; ++i) {
+        int col, row;
+        CellAt(i, col, row);
+        Mark mark = shared.Get(col, row);
+        crosses += mark == Mark::Cross;
+        circles += mark == Mark::Circle;
+        polledMatches = polledMatches && polled.Get(col, row) == mark;
+    }
+    result.Note(std::to_string(processes) + " processes, " + std::to_string(cells) + " cells in "
+        + std::to_string(static_cast<int>(ms)) + " ms: placed crosses=" + std::to_string(placed[0]) + " circles="
+        + std::to_string(placed[1]) + ", board crosses=" + std::to_string(crosses) + " circles=" + std::to_string(circles)
+        + ", poller lapped " + std::to_string(lapped) + " times");
+    result.Expect(placed[0] + placed[1] == cells, "successful places do not add up to the number of cells");
+    result.Expect(crosses == static_cast<std::size_t>(placed[0]) && circles == static_cast<std::size_t>(placed[1]),
+        "marks on the board differ from successful places");
+    result.Expect(polledMatches && polled.Count(Mark::Cross) == crosses && polled.Count(Mark::Circle) == circles,
+        "concurrent poller's mirror differs from the shared board");
+
+    // Кольцо помнит SharedBoardRingSize последних изменений: столько и меньше читатель получает по одному
+    int changes = 0;
+    bool kept = lateReader.Poll(late, [&changes](int, int) { ++changes; });
+    result.Note("late reader: " + std::to_string(changes) + " changes" + (kept ? "" : ", lapped and copied the board"));
+    if (cells <= static_cast<int>(SharedBoardRingSize)) {
+        result.Expect(kept && changes == cells, "change ring lost or repeated changes");
+    } else {
+        result.Expect(!kept, "reader more than a ring behind was not told it lapped");
+    }
+    result.Expect(late.Count(Mark::Cross) == crosses && late.Count(Mark::Circle) == circles, "late reader's mirror differs");
+
+    // Последний отключившийся удаляет общую память
+    lateReader.Close();
+    result.Expect(SharedMemoryExists(name), "shared memory removed while still open");
+    shared.Close();
+    result.Expect(!SharedMemoryExists(name), "shared memory left behind after the last instance closed");
+    return result;
+}
+
+CheckResult CheckSharedBoardStale() {
+    CheckResult result;
+    std::string name = CheckSharedName();
+    // Создатель упал после ftruncate, но до ready: заголовок весь из нулей
+    int fd = shm_open(("/" + name).c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 || ftruncate(fd, 64 << 20) != 0) {
+        result.Expect(false, "cannot create a stale segment " + name);
+        if (fd >= 0) close(fd);
+        shm_unlink(("/" + name).c_str());
+        return result;
+    }
+    close(fd);
+
+    SharedBoard shared;
+    auto start = std::chrono::steady_clock::now();
+    bool opened = shared.Open(name.c_str(), SharedBoardCols, SharedBoardRows);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.Note("open over a stale segment: " + std::string(opened ? "ok" : "failed") + " in "
+        + std::to_string(static_cast<int>(ms)) + " ms, created=" + (shared.Created() ? "yes" : "no"));
+    result.Expect(opened && shared.Created(), "stale segment was not replaced");
+    result.Expect(shared.Place(3, 4, Mark::Cross) && shared.Get(3, 4) == Mark::Cross, "replaced board does not work");
+    shared.Close();
+    result.Expect(!SharedMemoryExists(name), "shared memory left behind after close");
+    shm_unlink(("/" + name).c_str());
+    return result;
+}
+
+#endif
@@ -0,0 +1,132 @@
+﻿#include "SnapshotBench.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "AtomicFile.h"
+#include "Board.h"
+#include "BoardSnapshot.h"
+#include "MappedFile.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double ElapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static double Median(std::vector<double> values) {
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+// Текстовая запись поля: строка "столбец строка метка" на каждую метку
+static bool SaveText(const std::string& path, const Board& board) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+    board.ForEach([&](int col, int row, Mark mark) { std::fprintf(file, "%d %d %d\n", col, row, static_cast<int>(mark)); });
+    bool ok = std::fclose(file) == 0;
+    return ok && SyncFile(path);
+}
+
+// Чтение текста разбором from_chars по отображенному файлу — самый быстрый текстовый путь
+static bool LoadText(const std::string& path, Board& board) {
+    MappedFile file;
+    if (!file.OpenRead(path.c_str())) return false;
+    board.ClearAll();
+    const char* pos = file.Data();
+    const char* end = pos + file.Size();
+    while (pos < end) {
+        int values[3];
+        for (int& value : values) {
+            auto [next, ec] = std::from_chars(pos, end, value);
+            if (ec != std::errc()) return false;
+            pos = next + 1;  // Пробел или перевод строки
+        }
+        board.Place(values[0], values[1], static_cast<Mark>(values[2]));
+    }
+    return true;
+}
+
+static bool SameBoard(const Board& a, const Board& b) {
+    if (a.Count(Mark::Circle) != b.Count(Mark::Circle) || a.Count(Mark::Cross) != b.Count(Mark::Cross)) return false;
+    bool same = true;
+    a.ForEach([&](int col, int row, Mark mark) { same = same && b.Get(col, row) == mark; });
+    return same;
+}
+
+static std::uint64_t FileBytes(const std::string& path) {
+    MappedFile file;
+    return file.OpenRead(path.c_str()) ? file.Size() : 0;
+}
+
+SnapshotBenchResult MeasureSnapshot(std::size_t marks, int runs, const std::string& workPath) {
+    SnapshotBenchResult result;
+    int side = std::max(1, static_cast<int>(std::sqrt(static_cast<double>(marks) * 4)));
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> coord(-side / 2, side - side / 2 - 1);
+    Board board;
+    while (board.Count(Mark::Circle) + board.Count(Mark::Cross) < marks) {
+        board.Place(coord(random), coord(random), random() % 2 ? Mark::Circle : Mark::Cross);
+    }
+    result.marks = marks;
+
+    std::string snapshotPath = workPath + ".bin";
+    std::string textPath = workPath + ".txt";
+    std::vector<double> snapshotSave, snapshotLoad, viewOpen, textSave, textLoad;
+    for (int run = 0; run < runs; ++run) {
+        Clock::time_point start = Clock::now();
+        SaveBoardSnapshot(snapshotPath.c_str(), board, 20);
+        snapshotSave.push_back(ElapsedMs(start));
+
+        Board loaded;
+        start = Clock::now();
+        result.match = LoadBoardSnapshot(snapshotPath.c_str(), loaded) && result.match;
+        snapshotLoad.push_back(ElapsedMs(start));
+        result.match = result.match && SameBoard(board, loaded);
+
+        BoardSnapshotView view;
+        start = Clock::now();
+        result.match = view.Open(snapshotPath.c_str()) && result.match;
+        viewOpen.push_back(ElapsedMs(start));
+        view.Close();
+
+        start = Clock::now();
+        SaveText(textPath, board);
+        textSave.push_back(ElapsedMs(start));
+
+        start = Clock::now();
+        result.match = LoadText(textPath, loaded) && result.match;
+        textLoad.push_back(ElapsedMs(start));
+        result.match = result.match && SameBoard(board, loaded);
+    }
+    result.snapshotBytes = FileBytes(snapshotPath);
+    result.textBytes = FileBytes(textPath);
+    result.snapshotSaveMs = Median(snapshotSave);
+    result.snapshotLoadMs = Median(snapshotLoad);
+    result.viewOpenMs = Median(viewOpen);
+    result.textSaveMs = Median(textSave);
+    result.textLoadMs = Median(textLoad);
+    std::remove(snapshotPath.c_str());
+    std::remove(textPath.c_str());
+    return result;
+}
+
+std::string FormatSnapshot(const SnapshotBenchResult& result) {
+    char line[200];
+    std::string text;
+    std::snprintf(line, sizeof(line), "%zu marks\nformat        bytes     save,ms   load,ms\n", result.marks);
+    text += line;
+    std::snprintf(line, sizeof(line), "snapshot %10llu %11.1f %9.1f   (mapped view opens in %.1f ms)\n",
+        static_cast<unsigned long long>(result.snapshotBytes), result.snapshotSaveMs, result.snapshotLoadMs, result.viewOpenMs);
+    text += line;
+    std::snprintf(line, sizeof(line), "text     %10llu %11.1f %9.1f\n",
+        static_cast<unsigned long long>(result.textBytes), result.textSaveMs, result.textLoadMs);
+    text += line;
+    std::snprintf(line, sizeof(line), "snapshot load is %.1fx faster; boards match: %s\n",
+        result.snapshotLoadMs > 0 ? result.textLoadMs / result.snapshotLoadMs : 0, result.match ? "yes" : "NO");
+    text += line;
+    return text;
+}
@@ -0,0 +1,23 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Снимок поля против текстовой записи «столбец строка метка» на строку
+struct SnapshotBenchResult {
+    std::size_t marks = 0;
+    std::uint64_t snapshotBytes = 0;
+    std::uint64_t textBytes = 0;
+    double snapshotSaveMs = 0;   // SaveBoardSnapshot (с fsync и подменой)
+    double snapshotLoadMs = 0;   // LoadBoardSnapshot в Board
+    double viewOpenMs = 0;       // BoardSnapshotView::Open: отображение и проверка суммы, без разбора
+    double textSaveMs = 0;       // Текст через буферизованный stdio (с fsync)
+    double textLoadMs = 0;       // Чтение текста и постановка меток
+    bool match = true;           // Оба способа вернули то же поле
+};
+
+// Поле из marks случайных меток в квадрате, занятом на четверть; файлы пишутся рядом с workPath
+// и удаляются. Каждое время — медиана runs запусков
+SnapshotBenchResult MeasureSnapshot(std::size_t marks, int runs, const std::string& workPath);
+
+std::string FormatSnapshot(const SnapshotBenchResult& result);
@@ -0,0 +1,186 @@
+﻿#include "SoftwareDevice.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+const int PatternRowPixels = 256;  // Строка узора в памяти не короче этого
+
+SoftwareDevice::SoftwareDevice(Framebuffer& target) : target(target) {
+    ResetClip();
+}
+
+void SoftwareDevice::SetClip(const Rect& rect) {
+    clip = { std::max(0, rect.left), std::max(0, rect.top),
+        std::min(target.Width(), rect.right), std::min(target.Height(), rect.bottom) };
+}
+
+void SoftwareDevice::ResetClip() {
+    clip = { 0, 0, target.Width(), target.Height() };
+}
+
+GfxObject SoftwareDevice::AddObject(Object object) {
+    // Занимаем первый свободный слот, чтобы таблица не росла при пересоздании перьев
+    object.alive = true;
+    for (std::size_t i = 0; i < objects.size(); ++i) {
+        if (!objects[i].alive) {
+            objects[i] = std::move(object);
+            return i + 1;
+        }
+    }
+    objects.push_back(std::move(object));
+    return objects.size();
+}
+
+GfxObject SoftwareDevice::CreatePenObject(Color color, int width) {
+    Object object;
+    object.pixel = Framebuffer::ToPixel(color);
+    object.width = std::max(1, width);
+    return AddObject(std::move(object));
+}
+
+GfxObject SoftwareDevice::CreateBrushObject(Color color) {
+    GfxObject brush = CreatePenObject(color, 0);
+    objects[brush - 1].width = 0;
+    return brush;
+}
+
+GfxObject SoftwareDevice::CreatePatternObject(const Color* pixels, int width, int height) {
+    Object object;
+    object.tileWidth = std::max(1, width);
+    object.tileHeight = std::max(1, height);
+    object.rowWidth = object.tileWidth * std::max(1, (PatternRowPixels + object.tileWidth - 1) / object.tileWidth);
+    object.pattern.resize(static_cast<std::size_t>(object.rowWidth) * object.tileHeight);
+    for (int y = 0; y < object.tileHeight; ++y) {
+        for (int x = 0; x < object.rowWidth; ++x) {
+            object.pattern[static_cast<std::size_t>(y) * object.rowWidth + x] = Framebuffer::ToPixel(pixels[y * width + x % width]);
+        }
+    }
+    return AddObject(std::move(object));
+}
+
+void SoftwareDevice::DestroyObject(GfxObject object) {
+    if (object != 0 && object <= objects.size()) {
+        objects[object - 1].alive = false;
+        std::vector<std::uint32_t>().swap(objects[object - 1].pattern);
+    }
+}
+
+void SoftwareDevice::SelectPenObject(GfxObject pen) {
+    const Object& object = objects[pen - 1];
+    penPixel = object.pixel;
+    penWidth = object.width;
+}
+
+Rect SoftwareDevice::Clipped(Rect rect) const {
+    rect.left = std::max(rect.left, clip.left);
+    rect.top = std::max(rect.top, clip.top);
+    rect.right = std::min(rect.right, clip.right);
+    rect.bottom = std::min(rect.bottom, clip.bottom);
+    return rect;
+}
+
+void SoftwareDevice::FillClipped(Rect rect, std::uint32_t pixel) {
+    rect = Clipped(rect);
+    if (rect.IsEmpty()) return;
+    pixelsWritten += target.Fill(rect, pixel);
+}
+
+void SoftwareDevice::FillRectangle(const Rect& rect, GfxObject brush) {
+    FillClipped(rect, objects[brush - 1].pixel);
+}
+
+// Строка кадра собирается из строки узора: хвост от нужной фазы, затем целые куски по rowWidth
+void SoftwareDevice::FillPattern(const Rect& rect, GfxObject pattern, int originX, int originY) {
+    Rect area = Clipped(rect);
+    if (area.IsEmpty()) return;
+    const Object& object = objects[pattern - 1];
+    auto wrap = [](int value, int size) { return ((value % size) + size) % size; };
+    int phase = wrap(area.left - originX, object.tileWidth);
+    int width = area.right - area.left;
+
+    for (int y = area.top; y < area.bottom; ++y) {
+        const std::uint32_t* source = &object.pattern[static_cast<std::size_t>(wrap(y - originY, object.tileHeight)) * object.rowWidth];
+        std::uint32_t* out = target.Row(y) + area.left;
+        int count = std::min(width, object.rowWidth - phase);
+        std::memcpy(out, source + phase, count * sizeof(std::uint32_t));
+        for (int done = count; done < width; done += count) {
+            count = std::min(width - done, object.rowWidth);
+            std::memcpy(out + done, source, count * sizeof(std::uint32_t));
+        }
+    }
+    pixelsWritten += static_cast<std::uint64_t>(width) * (area.bottom - area.top);
+}
+
+void SoftwareDevice::DrawPolyPolyline(const Point* points, const std::uint32_t* counts, std::size_t polylines) {
+    for (std::size_t i = 0; i < polylines; ++i) {
+        for (std::uint32_t j = 1; j < counts[i]; ++j) {
+            DrawLine(points[j - 1].x, points[j - 1].y, points[j].x, points[j].y);
+        }
+        points += counts[i];
+    }
+}
+
+// Линия толщиной penWidth без последней точки. Горизонтальные и вертикальные линии
+// (вся сетка) заливаются сплошными отрезками, наклонные (кресты) — по Брезенхэму
+void SoftwareDevice::DrawLine(int x0, int y0, int x1, int y1) {
+    int before = penWidth / 2;  // Перо центрируется на линии
+
+    if (y0 == y1 || x0 == x1) {
+        Rect rect;
+        if (y0 == y1) {
+            int from = x0 < x1 ? x0 : x1 + 1;
+            int to = x0 < x1 ? x1 : x0 + 1;
+            rect = { from, y0 - before, to, y0 - before + penWidth };
+        }
+        else {
+            int from = y0 < y1 ? y0 : y1 + 1;
+            int to = y0 < y1 ? y1 : y0 + 1;
+            rect = { x0 - before, from, x0 - before + penWidth, to };
+        }
+        FillClipped(rect, penPixel);
+        return;
+    }
+
+    int dx = std::abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int dy = -std::abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    while (x0 != x1 || y0 != y1) {
+        FillClipped({ x0 - before, y0 - before, x0 - before + penWidth, y0 - before + penWidth }, penPixel);
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+}
+
+// Контур эллипса, вписанного в [left, right) x [top, bottom), толщиной penWidth.
+// Кольцо рисуется построчно: в каждой строке не больше двух сплошных отрезков
+void SoftwareDevice::DrawEllipse(int left, int top, int right, int bottom) {
+    double a = (right - left) / 2.0;   // Полуось по X
+    double b = (bottom - top) / 2.0;   // Полуось по Y
+    if (a <= 0 || b <= 0) return;
+    double cx = left + a;
+    double cy = top + b;
+    double ai = a - penWidth;          // Полуоси внутреннего края кольца
+    double bi = b - penWidth;
+
+    int y0 = std::max(top, clip.top);
+    int y1 = std::min(bottom, clip.bottom);
+    for (int y = y0; y < y1; ++y) {
+        double dy = y + 0.5 - cy;
+        if (std::fabs(dy) >= b) continue;
+        int outer = static_cast<int>(std::lround(a * std::sqrt(1.0 - dy * dy / (b * b))));
+
+        if (ai > 0 && bi > 0 && std::fabs(dy) < bi) {
+            int inner = static_cast<int>(std::lround(ai * std::sqrt(1.0 - dy * dy / (bi * bi))));
+            int xc = static_cast<int>(std::lround(cx));
+            FillClipped({ xc - outer, y, xc - inner, y + 1 }, penPixel);
+            FillClipped({ xc + inner, y, xc + outer, y + 1 }, penPixel);
+        }
+        else {
+            int xc = static_cast<int>(std::lround(cx));
+            FillClipped({ xc - outer, y, xc + outer, y + 1 }, penPixel);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include "Framebuffer.h"
+#include "Graphics.h"
+
+// Программный растеризатор: рисует сцену в Framebuffer без окна и без GDI.
+// Повторяет то, что WM_PAINT выводит через GDI: заливки, линии заданной толщины
+// (без последней точки, как LineTo) и контуры эллипсов
+class SoftwareDevice : public GraphicsDevice {
+public:
+    explicit SoftwareDevice(Framebuffer& target);
+
+    // Ограничивает рисование прямоугольником (по умолчанию — весь кадр)
+    void SetClip(const Rect& clip);
+    void ResetClip();
+
+    GfxObject CreatePenObject(Color color, int width) override;
+    GfxObject CreateBrushObject(Color color) override;
+    GfxObject CreatePatternObject(const Color* pixels, int width, int height) override;
+    void DestroyObject(GfxObject object) override;
+    void SelectPenObject(GfxObject pen) override;
+
+    void FillRectangle(const Rect& rect, GfxObject brush) override;
+    void FillPattern(const Rect& rect, GfxObject pattern, int originX, int originY) override;
+    void DrawPolyPolyline(const Point* points, const std::uint32_t* counts, std::size_t polylines) override;
+    void DrawEllipse(int left, int top, int right, int bottom) override;
+
+    // Сколько пикселей записано с момента создания (для замера пикселей в секунду)
+    std::uint64_t PixelsWritten() const { return pixelsWritten; }
+
+private:
+    struct Object {
+        std::uint32_t pixel = 0;  // Цвет в формате кадра
+        int width = 0;            // Толщина пера (0 для кисти)
+        bool alive = false;
+        // Узор: строки, повторенные по горизонтали до rowWidth пикселей (кратно tileWidth),
+        // чтобы строка заливки копировалась длинными кусками
+        std::vector<std::uint32_t> pattern;
+        int tileWidth = 0;
+        int tileHeight = 0;
+        int rowWidth = 0;
+    };
+
+    GfxObject AddObject(Object object);
+    Rect Clipped(Rect rect) const;
+    void FillClipped(Rect rect, std::uint32_t pixel);
+    void DrawLine(int x0, int y0, int x1, int y1);
+
+    Framebuffer& target;
+    Rect clip;
+    std::vector<Object> objects;  // Дескриптор объекта — индекс + 1
+    std::uint32_t penPixel = 0;
+    int penWidth = 1;
+    std::uint64_t pixelsWritten = 0;
+};
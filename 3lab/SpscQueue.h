@@ -0,0 +1,55 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Кольцевая очередь без блокировок для одного писателя и одного читателя.
+// Писатель двигает только tail, читатель — только head, поэтому хватает пары атомиков
+// с acquire/release. Индексы растут без ограничения, ячейка — индекс по модулю Capacity.
+// Каждый индекс лежит на своей строке кэша, чтобы писатель и читатель не перетягивали ее
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "емкость должна быть степенью двойки");
+
+public:
+    SpscQueue() = default;
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Только писатель. Возвращает false, если очередь полна (value не тронут)
+    bool TryPush(T& value) {
+        std::size_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail - cachedHead == Capacity) {
+            cachedHead = head.load(std::memory_order_acquire);  // Читатель мог освободить место
+            if (tail - cachedHead == Capacity) return false;
+        }
+        slots[tail & (Capacity - 1)] = std::move(value);
+        this->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Только читатель. Возвращает false, если очередь пуста
+    bool TryPop(T& value) {
+        std::size_t head = this->head.load(std::memory_order_relaxed);
+        if (head == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);  // Писатель мог добавить элементы
+            if (head == cachedTail) return false;
+        }
+        value = std::move(slots[head & (Capacity - 1)]);
+        slots[head & (Capacity - 1)] = T();  // Ресурсы элемента освобождаются сразу, а не при перезаписи ячейки
+        this->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Пуста ли очередь (точно — только для читателя, остальным — как подсказка)
+    bool Empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<std::size_t> head{ 0 };  // Следующая ячейка читателя
+    std::size_t cachedTail = 0;                       // Последний увиденный читателем tail
+    alignas(64) std::atomic<std::size_t> tail{ 0 };  // Следующая ячейка писателя
+    std::size_t cachedHead = 0;                       // Последний увиденный писателем head
+    alignas(64) T slots[Capacity];
+};
@@ -0,0 +1,170 @@
+﻿#include "StartupBench.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include "Board.h"
+#include "BoardSnapshot.h"
+#include "Framebuffer.h"
+#include "FrameScheduler.h"
+#include "GameController.h"
+#include "MoveJournal.h"
+#include "Renderer.h"
+#include "SettingsCache.h"
+#include "SettingsStore.h"
+#include "SoftwareDevice.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+// Показания steady_clock в наносекундах. Часы общие для всех процессов машины
+// (CLOCK_MONOTONIC / QueryPerformanceCounter), поэтому отметки родителя и потомка можно вычитать
+static long long ClockNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+int RunStartupChild(const std::string& prefix, bool useCache) {
+    // Тот же порядок, что в wWinMain: настройки, снимок, журнал, контроллер, первый кадр
+    Settings settings = DefaultSettings();
+    std::unique_ptr<SettingsStore> store = CreateSettingsStore(static_cast<int>(SettingsMethod::MemoryMapping), prefix + ".ini");
+    long long settingsStart = ClockNs();
+    SettingsParseResult parsed = useCache ? LoadSettingsCached(*store, settings) : store->Load(settings);
+    long long settingsNs = ClockNs() - settingsStart;
+    if (!parsed.Ok()) return 1;
+
+    Board board;
+    LoadBoardSnapshot((prefix + ".board").c_str(), board);
+    MoveJournal::Replay(prefix + ".journal", board);
+
+    Framebuffer frame(settings.windowWidth, settings.windowHeight);
+    SoftwareDevice device(frame);
+    Renderer renderer(device);
+    FrameScheduler frames;
+    GameController controller(board, renderer, frames);
+    controller.ApplySettings(settings);
+    controller.ResyncRules();
+    Rect client = { 0, 0, frame.Width(), frame.Height() };
+    renderer.Paint(board, controller.View(), client, client);
+    long long frameNs = ClockNs();
+
+    FILE* out = std::fopen((prefix + ".out").c_str(), "w");
+    if (!out) return 1;
+    std::fprintf(out, "%lld %lld\n", frameNs, settingsNs);
+    return std::fclose(out) == 0 ? 0 : 1;
+}
+
+// Запускает программу с аргументами и ждет ее завершения. Возвращает код завершения или -1
+static int RunProcess(const std::vector<std::string>& args) {
+#ifdef _WIN32
+    std::string command;
+    for (const std::string& arg : args) command += "\"" + arg + "\" ";
+    STARTUPINFOA startup = {};
+    startup.cb = sizeof(startup);
+    PROCESS_INFORMATION process = {};
+    if (!CreateProcessA(NULL, command.data(), NULL, NULL, FALSE, 0, NULL, NULL, &startup, &process)) return -1;
+    WaitForSingleObject(process.hProcess, INFINITE);
+    DWORD code = 0;
+    GetExitCodeProcess(process.hProcess, &code);
+    CloseHandle(process.hThread);
+    CloseHandle(process.hProcess);
+    return static_cast<int>(code);
+#else
+    std::vector<char*> argv;
+    for (const std::string& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+    pid_t pid;
+    if (posix_spawn(&pid, argv[0], nullptr, nullptr, argv.data(), environ) != 0) return -1;
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) return -1;
+    return WEXITSTATUS(status);
+#endif
+}
+
+// Поле, сохраненное после долгой партии: несколько тысяч меток вокруг начала координат
+static void WriteStartupFiles(const std::string& prefix) {
+    Settings settings = DefaultSettings();
+    settings.windowWidth = 1280;
+    settings.windowHeight = 720;
+    CreateSettingsStore(static_cast<int>(SettingsMethod::MemoryMapping), prefix + ".ini")->Save(settings);
+    // Настройки записаны прошлым сеансом: свежая метка заставила бы каждый запуск сверять хэш текста
+    std::error_code error;
+    std::filesystem::last_write_time(prefix + ".ini", std::filesystem::last_write_time(prefix + ".ini", error) - std::chrono::hours(1), error);
+
+    Board board;
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> cell(-150, 150);
+    for (int i = 0; i < 5000; ++i) board.Place(cell(random), cell(random), i % 2 ? Mark::Cross : Mark::Circle);
+    SaveBoardSnapshot((prefix + ".board").c_str(), board, settings.gridSize);
+    std::remove((prefix + ".journal").c_str());
+    std::remove(SettingsCachePath(prefix + ".ini").c_str());
+}
+
+static void RemoveStartupFiles(const std::string& prefix) {
+    for (const char* suffix : { ".ini", ".board", ".journal", ".out" }) std::remove((prefix + suffix).c_str());
+    std::remove(SettingsCachePath(prefix + ".ini").c_str());
+}
+
+// Один запуск потомка: время до первого кадра в миллисекундах и загрузка настроек в микросекундах
+static bool MeasureChild(const std::string& program, const std::string& prefix, const char* mode, double& ms, double& settingsUs) {
+    std::remove((prefix + ".out").c_str());
+    long long start = ClockNs();
+    if (RunProcess({ program, "--first-frame", prefix, mode }) != 0) return false;
+
+    FILE* in = std::fopen((prefix + ".out").c_str(), "r");
+    if (!in) return false;
+    long long frameNs = 0, settingsNs = 0;
+    bool ok = std::fscanf(in, "%lld %lld", &frameNs, &settingsNs) == 2;
+    std::fclose(in);
+    ms = (frameNs - start) / 1e6;
+    settingsUs = settingsNs / 1e3;
+    return ok;
+}
+
+std::vector<StartupResult> MeasureStartup(const std::string& program, const std::string& prefix, int runs) {
+    WriteStartupFiles(prefix);
+    std::vector<StartupResult> results;
+    for (const char* mode : { "text", "cache" }) {
+        double ms = 0, settingsUs = 0;
+        // Первый запуск прогревает страничный кэш ОС и (для "cache") записывает кэш настроек
+        if (!MeasureChild(program, prefix, mode, ms, settingsUs)) break;
+
+        StartupResult result;
+        result.mode = mode;
+        result.minMs = 1e300;
+        for (int i = 0; i < runs; ++i) {
+            if (!MeasureChild(program, prefix, mode, ms, settingsUs)) break;
+            ++result.runs;
+            result.meanMs += ms;
+            result.minMs = std::min(result.minMs, ms);
+            result.maxMs = std::max(result.maxMs, ms);
+            result.settingsUs += settingsUs;
+        }
+        if (result.runs == 0) break;
+        result.meanMs /= result.runs;
+        result.settingsUs /= result.runs;
+        results.push_back(result);
+    }
+    RemoveStartupFiles(prefix);
+    return results;
+}
+
+std::string FormatStartup(const std::vector<StartupResult>& results) {
+    std::string text = "settings  runs  first frame ms (mean   min    max)  settings us\n";
+    char line[96];
+    for (const StartupResult& result : results) {
+        std::snprintf(line, sizeof(line), "%-8s %5d %20.2f %6.2f %6.2f %12.1f\n", result.mode, result.runs,
+            result.meanMs, result.minMs, result.maxMs, result.settingsUs);
+        text += line;
+    }
+    return text;
+}
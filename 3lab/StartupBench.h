@@ -0,0 +1,24 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+
+// Замер запуска от создания процесса до первого кадра. Каждый прогон — новый процесс
+// (program --first-frame ...), который повторяет путь wWinMain без окна: настройки, снимок поля,
+// журнал ходов, контроллер и первый кадр программным рендерером
+struct StartupResult {
+    const char* mode = "";   // "text" — разбор settings.ini, "cache" — теплый запуск из кэша
+    int runs = 0;
+    double meanMs = 0;       // От запуска процесса до готового первого кадра
+    double minMs = 0;
+    double maxMs = 0;
+    double settingsUs = 0;   // Загрузка настроек внутри процесса (в среднем)
+};
+
+// Тело дочернего процесса: файлы prefix.ini, prefix.board и prefix.journal, время кадра пишется в prefix.out.
+// Возвращает код завершения процесса
+int RunStartupChild(const std::string& prefix, bool useCache);
+
+// Готовит файлы prefix.* и запускает program runs раз для каждого способа чтения настроек
+std::vector<StartupResult> MeasureStartup(const std::string& program, const std::string& prefix, int runs);
+
+std::string FormatStartup(const std::vector<StartupResult>& results);
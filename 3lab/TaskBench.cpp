@@ -0,0 +1,92 @@
+﻿#include "TaskBench.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include "Replay.h"
+#include "TaskRuntime.h"
+
+UiLatencyWindow::UiLatencyWindow(const Settings& settings)
+    : frame(settings.windowWidth, settings.windowHeight), device(frame), renderer(device), controller(board, renderer, frames) {
+    controller.SetRandomSeed(1);
+    controller.ApplySettings(settings);
+}
+
+UiLatencyResult UiLatencyWindow::Run(const char* mode, const std::vector<InputEvent>& trace, int intervalUs,
+    const std::function<void(std::size_t)>& afterEvent) {
+    typedef std::chrono::steady_clock Clock;
+
+    UiLatencyResult result;
+    result.mode = mode;
+    std::vector<double> latencies;
+    latencies.reserve(trace.size());
+    Clock::time_point start = Clock::now();
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        Clock::time_point arrival = start + std::chrono::microseconds(static_cast<long long>(i) * intervalUs);
+        std::this_thread::sleep_until(arrival);  // Если поток окна занят, событие ждет в очереди, как в GetMessage
+
+        const InputEvent& event = trace[i];
+        controller.Handle(event);
+        if (event.kind == InputKind::Resize) {
+            frame.Resize(event.x, event.y);
+            controller.InvalidateAll();
+        }
+        // Кадр рисуется целиком: сравниваются режимы, важна не цена кадра, а ожидание в очереди
+        if (frames.TakeFrame(0, damage)) {
+            Rect client = { 0, 0, frame.Width(), frame.Height() };
+            device.ResetClip();
+            renderer.Paint(board, controller.View(), client, client);
+        }
+        latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - arrival).count());
+        if (afterEvent) afterEvent(i);
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    result.events = latencies.size();
+    if (!latencies.empty()) {
+        result.p50Us = latencies[latencies.size() / 2];
+        result.p99Us = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+        result.maxUs = latencies.back();
+    }
+    return result;
+}
+
+static UiLatencyResult RunUiLatency(bool background, int jobMs, const std::vector<InputEvent>& trace, int intervalUs, std::size_t jobEvery) {
+    UiLatencyWindow window;
+    TaskRuntime tasks;
+    tasks.Start(nullptr);  // Поток окна здесь сам разбирает продолжения после каждого события
+    auto slowJob = [jobMs] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(jobMs));
+        return TaskDone();
+    };
+
+    std::size_t jobs = 0;
+    UiLatencyResult result = window.Run(background ? "runtime" : "inline", trace, intervalUs, [&](std::size_t i) {
+        if (jobEvery > 0 && i % jobEvery == jobEvery - 1) {
+            ++jobs;
+            if (background) tasks.Post(slowJob);
+            else slowJob();
+        }
+        tasks.Drain();
+    });
+    tasks.Stop();
+    result.jobs = jobs;
+    return result;
+}
+
+std::vector<UiLatencyResult> MeasureUiLatency(int jobMs, std::size_t events, int intervalUs, std::size_t jobEvery) {
+    Settings settings = DefaultSettings();
+    std::vector<InputEvent> trace = GenerateInputTrace(events, 1, settings.windowWidth, settings.windowHeight);
+    return { RunUiLatency(false, jobMs, trace, intervalUs, jobEvery), RunUiLatency(true, jobMs, trace, intervalUs, jobEvery) };
+}
+
+std::string FormatUiLatency(const std::vector<UiLatencyResult>& results) {
+    std::string text = "mode            events   jobs   p50 us    p99 us    max us  board\n";
+    char line[112];
+    for (const UiLatencyResult& result : results) {
+        std::snprintf(line, sizeof(line), "%-14s %7zu %6zu %8.1f %9.1f %9.1f  %s\n", result.mode, result.events, result.jobs,
+            result.p50Us, result.p99Us, result.maxUs, result.match ? "ok" : "MISMATCH");
+        text += line;
+    }
+    return text;
+}
@@ -0,0 +1,55 @@
+﻿#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Board.h"
+#include "FrameScheduler.h"
+#include "Framebuffer.h"
+#include "GameController.h"
+#include "InputTrace.h"
+#include "Renderer.h"
+#include "Settings.h"
+#include "SoftwareDevice.h"
+
+// Отзывчивость ввода при медленной фоновой работе
+struct UiLatencyResult {
+    const char* mode = "";  // "inline" — работа в потоке окна, "runtime" — через TaskRuntime, "server-*" — партия на сервере
+    std::size_t events = 0;
+    std::size_t jobs = 0;   // Сколько раз запускалась медленная работа (в режимах сервера — задержка ответа)
+    double p50Us = 0;       // От прихода события до готового кадра (с ожиданием в очереди)
+    double p99Us = 0;
+    double maxUs = 0;
+    bool match = true;      // Поле окна сошлось с полем сервера (в режимах без сервера всегда true)
+};
+
+// Поток окна в замере: контроллер с программной отрисовкой, как в окне
+class UiLatencyWindow {
+public:
+    explicit UiLatencyWindow(const Settings& settings = DefaultSettings());
+
+    Board& GetBoard() { return board; }
+    GameController& Controller() { return controller; }
+
+    // События trace приходят раз в intervalUs. После кадра каждого события поток окна выполняет
+    // afterEvent(i) — остальную свою работу (медленную задачу, разбор ответов сервера): пока она
+    // идет, следующие события ждут в очереди. Повреждения из afterEvent рисуются со следующим событием
+    UiLatencyResult Run(const char* mode, const std::vector<InputEvent>& trace, int intervalUs,
+        const std::function<void(std::size_t)>& afterEvent);
+
+private:
+    Board board;
+    Framebuffer frame;
+    SoftwareDevice device;
+    Renderer renderer;
+    FrameScheduler frames;
+    FrameDamage damage;
+    GameController controller;
+};
+
+// События синтетической трассы приходят раз в intervalUs и обрабатываются контроллером
+// с программной отрисовкой, как в окне. Каждые jobEvery событий поток окна запускает работу
+// на jobMs (сон — как запись файла с fsync): сначала прямо в себе, потом через TaskRuntime
+std::vector<UiLatencyResult> MeasureUiLatency(int jobMs, std::size_t events, int intervalUs, std::size_t jobEvery);
+
+std::string FormatUiLatency(const std::vector<UiLatencyResult>& results);
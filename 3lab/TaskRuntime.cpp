@@ -0,0 +1,101 @@
+﻿#include "TaskRuntime.h"
+#include <utility>
+
+TaskRuntime::~TaskRuntime() {
+    Stop();
+}
+
+void TaskRuntime::Start(std::function<void()> notifyReady) {
+    if (worker.joinable()) return;
+    notify = std::move(notifyReady);
+    stopping = false;
+    finished = false;
+    worker = std::thread([this] { Run(); });
+}
+
+void TaskRuntime::Stop() {
+    if (!worker.joinable()) return;
+    // Хвост, который не влез в кольцо, докладываем по мере освобождения места. Продолжения
+    // разбираем сразу, иначе фоновому потоку некуда будет класть результаты
+    while (!overflow.empty()) {
+        Drain();
+        std::this_thread::yield();
+    }
+    stopping = true;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        condition.notify_one();
+    }
+    while (!finished.load(std::memory_order_acquire)) {
+        Drain();
+        std::this_thread::yield();
+    }
+    worker.join();
+    Drain();
+}
+
+void TaskRuntime::Post(TaskJob job) {
+    ++posted;
+    FlushOverflow();
+    if (!overflow.empty() || !commands.TryPush(job)) {
+        overflow.push_back(std::move(job));
+        return;
+    }
+    Wake();
+}
+
+void TaskRuntime::FlushOverflow() {
+    bool pushed = false;
+    while (!overflow.empty() && commands.TryPush(overflow.front())) {
+        overflow.pop_front();
+        pushed = true;
+    }
+    if (pushed) Wake();
+}
+
+void TaskRuntime::Wake() {
+    // Пара барьеров с Run: либо фоновый поток увидит новую задачу до сна, либо мы увидим sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        condition.notify_one();
+    }
+}
+
+std::size_t TaskRuntime::Drain() {
+    notified.store(false, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);  // Результаты, пришедшие после сброса флага, разбудят снова
+    std::size_t count = 0;
+    TaskDone done;
+    while (results.TryPop(done)) {
+        ++count;
+        if (done) done();
+    }
+    drained += count;
+    FlushOverflow();  // Место в кольце могло освободиться, пока окно было занято
+    return count;
+}
+
+void TaskRuntime::Run() {
+    TaskJob job;
+    for (;;) {
+        if (!commands.TryPop(job)) {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            condition.wait(lock, [this] { return !commands.Empty() || stopping.load(); });
+            sleeping.store(false, std::memory_order_relaxed);
+            if (commands.Empty() && stopping.load()) break;
+            continue;
+        }
+
+        TaskDone done = job();
+        job = nullptr;
+        // Кольцо результатов полно: поток окна занят. Фоновому потоку подождать можно
+        while (!results.TryPush(done)) std::this_thread::yield();
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!notified.exchange(true, std::memory_order_relaxed) && notify) notify();
+    }
+    finished.store(true, std::memory_order_release);
+}
@@ -0,0 +1,64 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "SpscQueue.h"
+
+// Продолжение задачи: выполняется в потоке окна, когда тот разбирает результаты
+typedef std::function<void()> TaskDone;
+// Задача: выполняется в фоновом потоке и возвращает продолжение (или пустую функцию)
+typedef std::function<TaskDone()> TaskJob;
+
+const std::size_t TaskQueueCapacity = 256;  // Ячеек в каждой из двух очередей
+
+// Фоновый поток для медленной работы (запись файлов, сброс на диск, расчеты).
+// Поток окна только кладет задачи (Post) и разбирает готовые продолжения (Drain) — он никогда
+// не ждет фоновый поток. Туда и обратно задачи идут по двум кольцам SPSC без блокировок.
+// Мьютекс нужен только засыпающему фоновому потоку: писатель будит его, лишь если тот спит
+class TaskRuntime {
+public:
+    TaskRuntime() = default;
+    ~TaskRuntime();
+
+    TaskRuntime(const TaskRuntime&) = delete;
+    TaskRuntime& operator=(const TaskRuntime&) = delete;
+
+    // Запускает фоновый поток. notify вызывается из него, когда появились готовые продолжения
+    // и поток окна еще не знает о них (например, PostMessage). Повторные уведомления до Drain не шлются
+    void Start(std::function<void()> notify);
+    // Доделывает все отправленные задачи, выполняет их продолжения и останавливает поток (только поток окна)
+    void Stop();
+    bool Running() const { return worker.joinable(); }
+
+    // Только поток окна. Не блокируется: если кольцо полно, задача ждет в локальном хвосте до следующего Post или Drain
+    void Post(TaskJob job);
+    // Только поток окна. Выполняет готовые продолжения и возвращает их число
+    std::size_t Drain();
+
+    // Задач отправлено, но продолжения еще не разобраны (только для потока окна)
+    std::size_t InFlight() const { return posted - drained; }
+
+private:
+    void Run();
+    void FlushOverflow();
+    void Wake();
+
+    SpscQueue<TaskJob, TaskQueueCapacity> commands;  // Поток окна -> фоновый поток
+    SpscQueue<TaskDone, TaskQueueCapacity> results;  // Фоновый поток -> поток окна
+    std::deque<TaskJob> overflow;  // Задачи, не поместившиеся в кольцо (только поток окна)
+    std::size_t posted = 0;
+    std::size_t drained = 0;
+
+    std::thread worker;
+    std::function<void()> notify;
+    std::atomic<bool> notified{ false };  // Поток окна уже разбудили и он еще не вызвал Drain
+    std::atomic<bool> sleeping{ false };  // Фоновый поток ждет на condition
+    std::atomic<bool> stopping{ false };
+    std::atomic<bool> finished{ false };  // Фоновый поток вышел из Run
+    std::mutex sleepMutex;
+    std::condition_variable condition;
+};
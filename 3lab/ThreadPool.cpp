@@ -0,0 +1,109 @@
+﻿#include "ThreadPool.h"
+
+// Одна пачка ParallelFor: функция и число еще не выполненных задач
+struct ThreadPool::Batch {
+    const std::function<void(std::size_t)>* f;
+    std::atomic<std::size_t> remaining;
+    std::mutex mutex;
+    std::condition_variable done;
+    bool finished = false;  // Последняя задача выполнена (под mutex, иначе пачку могут удалить раньше, чем ее отпустят)
+};
+
+unsigned ThreadPool::DefaultWorkers() {
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 0;
+}
+
+ThreadPool::ThreadPool(unsigned workers) {
+    for (unsigned i = 0; i <= workers; ++i) queues.push_back(std::make_unique<Queue>());
+    for (unsigned i = 0; i < workers; ++i) threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for (std::thread& thread : threads) thread.join();
+}
+
+bool ThreadPool::TryTake(std::size_t self, Task& task) {
+    // Сначала своя очередь с конца
+    {
+        Queue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    // Потом крадем с начала чужих, начиная с соседа, чтобы воры не толпились у одной очереди
+    for (std::size_t step = 1; step < queues.size(); ++step) {
+        Queue& victim = *queues[(self + step) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::Run(const Task& task) {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        --queued;
+    }
+    (*task.batch->f)(task.index);
+    if (task.batch->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(task.batch->mutex);
+        task.batch->finished = true;
+        task.batch->done.notify_all();
+    }
+}
+
+void ThreadPool::WorkerLoop(std::size_t self) {
+    for (;;) {
+        Task task;
+        if (TryTake(self, task)) {
+            Run(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeup.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping) return;
+    }
+}
+
+void ThreadPool::ParallelFor(std::size_t count, const std::function<void(std::size_t)>& f) {
+    if (count == 0) return;
+    std::lock_guard<std::mutex> caller(callerMutex);
+
+    Batch batch;
+    batch.f = &f;
+    batch.remaining.store(count, std::memory_order_relaxed);
+
+    // Раскладываем задачи по очередям по кругу: соседние индексы (соседние плитки) уходят разным потокам
+    for (std::size_t q = 0; q < queues.size(); ++q) {
+        std::lock_guard<std::mutex> lock(queues[q]->mutex);
+        for (std::size_t i = q; i < count; i += queues.size()) queues[q]->tasks.push_back({ &batch, i });
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        queued += count;
+    }
+    wakeup.notify_all();
+
+    // Вызывающий поток работает наравне с фоновыми, пока есть что брать
+    std::size_t self = queues.size() - 1;
+    Task task;
+    while (TryTake(self, task)) Run(task);
+
+    // Остались задачи, которые уже выполняются в других потоках
+    std::unique_lock<std::mutex> lock(batch.mutex);
+    batch.done.wait(lock, [&batch] { return batch.finished; });
+}
@@ -0,0 +1,61 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с кражей работы. У каждого потока своя очередь: владелец берет задачи
+// с конца (последние — еще горячие в кэше), а освободившийся поток крадет с начала
+// чужой очереди, поэтому неравные по стоимости задачи (плотные и пустые плитки)
+// сами распределяются между ядрами
+class ThreadPool {
+public:
+    // workers — число фоновых потоков. Вызывающий поток тоже работает в ParallelFor,
+    // так что пул из N-1 потоков загружает N ядер. 0 — по числу ядер
+    explicit ThreadPool(unsigned workers = DefaultWorkers());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    static unsigned DefaultWorkers();
+
+    // Число потоков, которые одновременно выполняют ParallelFor (фоновые + вызывающий)
+    unsigned Concurrency() const { return static_cast<unsigned>(queues.size()); }
+
+    // Выполняет f(i) для всех i из [0, count) и ждет завершения. Задачи раздаются
+    // по очередям по кругу, дальше балансирует кража
+    void ParallelFor(std::size_t count, const std::function<void(std::size_t)>& f);
+
+    std::uint64_t Steals() const { return steals.load(std::memory_order_relaxed); }  // Сколько задач украдено
+
+private:
+    struct Batch;
+    struct Task {
+        Batch* batch;
+        std::size_t index;
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void WorkerLoop(std::size_t self);
+    bool TryTake(std::size_t self, Task& task);
+    void Run(const Task& task);
+
+    std::vector<std::unique_ptr<Queue>> queues;  // Последняя очередь — вызывающего потока
+    std::vector<std::thread> threads;
+    std::mutex wakeMutex;
+    std::condition_variable wakeup;
+    std::size_t queued = 0;  // Задач в очередях (под wakeMutex)
+    bool stopping = false;
+    std::mutex callerMutex;  // ParallelFor из нескольких потоков выполняются по очереди
+    std::atomic<std::uint64_t> steals{ 0 };
+};
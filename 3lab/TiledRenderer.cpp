@@ -0,0 +1,46 @@
+﻿#include "TiledRenderer.h"
+#include <algorithm>
+#include "Profiler.h"
+
+TiledRenderer::TiledRenderer(ThreadPool& pool, int tileSize) : pool(pool), tileSize(tileSize > 0 ? tileSize : RenderTileSize) {
+}
+
+std::uint64_t TiledRenderer::PixelsWritten() const {
+    std::uint64_t pixels = 0;
+    for (const auto& tile : tiles) pixels += tile->device.PixelsWritten();
+    return pixels;
+}
+
+void TiledRenderer::Paint(const Board& board, const Viewport& view, const Rect& clip, Framebuffer& target) {
+    PROFILE_SCOPE("draw.tiled");
+    Rect client = { 0, 0, target.Width(), target.Height() };
+    Rect area = { std::max(clip.left, 0), std::max(clip.top, 0), std::min(clip.right, client.right), std::min(clip.bottom, client.bottom) };
+    if (area.IsEmpty()) return;
+
+    // Сетка плиток привязана к углу кадра, крайние плитки обрезаются по обновляемой области
+    rects.clear();
+    for (int top = area.top / tileSize * tileSize; top < area.bottom; top += tileSize) {
+        for (int left = area.left / tileSize * tileSize; left < area.right; left += tileSize) {
+            rects.push_back({ std::max(left, area.left), std::max(top, area.top),
+                std::min(left + tileSize, area.right), std::min(top + tileSize, area.bottom) });
+        }
+    }
+
+    if (boundTarget != &target) {
+        tiles.clear();  // Устройства пишут в конкретный кадр
+        boundTarget = &target;
+    }
+    while (tiles.size() < rects.size()) tiles.push_back(std::make_unique<Tile>(target));
+    for (std::size_t i = 0; i < rects.size(); ++i) {
+        tiles[i]->renderer.SetBackgroundColor(backgroundColor);  // Без смены цвета объекты не пересоздаются
+        tiles[i]->renderer.SetGridColor(gridColor);
+        tiles[i]->renderer.SetHeatmap(heatmap);
+    }
+
+    pool.ParallelFor(rects.size(), [&](std::size_t i) {
+        Tile& tile = *tiles[i];
+        tile.device.SetClip(rects[i]);
+        tile.renderer.Paint(board, view, client, rects[i]);
+    });
+    tilesPainted += rects.size();
+}
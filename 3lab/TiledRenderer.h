@@ -0,0 +1,57 @@
+﻿#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "Board.h"
+#include "Framebuffer.h"
+#include "Graphics.h"
+#include "Renderer.h"
+#include "SoftwareDevice.h"
+#include "ThreadPool.h"
+#include "Viewport.h"
+
+const int RenderTileSize = 256;                  // Сторона плитки в пикселях
+const int TiledPaintMinPixels = 1920 * 1080;     // С какой площади окна рисовать по плиткам, а не через GDI
+
+// Параллельная отрисовка в кадр в памяти. Обновляемая область делится на плитки
+// RenderTileSize x RenderTileSize, каждая плитка рисует только попавшие в нее линии
+// сетки и метки прямо в свой участок общего кадра. Плитки не пересекаются, поэтому
+// потоки пишут без блокировок, а готовый кадр выводится в окно одним копированием
+class TiledRenderer {
+public:
+    explicit TiledRenderer(ThreadPool& pool, int tileSize = RenderTileSize);
+
+    TiledRenderer(const TiledRenderer&) = delete;
+    TiledRenderer& operator=(const TiledRenderer&) = delete;
+
+    void SetBackgroundColor(Color color) { backgroundColor = color; }
+    void SetGridColor(Color color) { gridColor = color; }
+    // Тепловая карта во всех плитках (счетчик только читается, поэтому потоки делят его без блокировок)
+    void SetHeatmap(const RegionCounter* counter) { heatmap = counter; }
+
+    // Рисует clip в кадр target. Клиентская область совпадает с размером кадра
+    void Paint(const Board& board, const Viewport& view, const Rect& clip, Framebuffer& target);
+
+    std::size_t TilesPainted() const { return tilesPainted; }
+    std::uint64_t PixelsWritten() const;
+
+private:
+    // Устройство и рисовальщик плитки: у каждой свои перья, чтобы потоки не делили состояние
+    struct Tile {
+        SoftwareDevice device;
+        Renderer renderer;
+
+        explicit Tile(Framebuffer& target) : device(target), renderer(device) {}
+    };
+
+    ThreadPool& pool;
+    int tileSize;
+    Color backgroundColor = MakeColor(0, 0, 255);
+    Color gridColor = MakeColor(255, 0, 0);
+    const RegionCounter* heatmap = nullptr;
+    Framebuffer* boundTarget = nullptr;        // Кадр, к которому привязаны устройства плиток
+    std::vector<std::unique_ptr<Tile>> tiles;  // Рисовальщик на каждую плитку кадра
+    std::vector<Rect> rects;                   // Плитки текущей отрисовки
+    std::size_t tilesPainted = 0;
+};
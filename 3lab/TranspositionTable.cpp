@@ -0,0 +1,59 @@
+﻿#include "TranspositionTable.h"
+
+// Упаковка записи: оценка (32 бита), ход (16), глубина (8), граница (2), возраст поиска (6)
+static std::uint64_t Pack(const TtEntry& entry, std::uint8_t age) {
+    return static_cast<std::uint32_t>(entry.score)
+        | (static_cast<std::uint64_t>(entry.move) << 32)
+        | (static_cast<std::uint64_t>(static_cast<std::uint8_t>(entry.depth)) << 48)
+        | (static_cast<std::uint64_t>(entry.bound) << 56)
+        | (static_cast<std::uint64_t>(age) << 58);
+}
+
+static TtEntry Unpack(std::uint64_t data) {
+    TtEntry entry;
+    entry.score = static_cast<std::int32_t>(static_cast<std::uint32_t>(data));
+    entry.move = static_cast<std::uint16_t>(data >> 32);
+    entry.depth = static_cast<std::int8_t>(static_cast<std::uint8_t>(data >> 48));
+    entry.bound = static_cast<TtBound>((data >> 56) & 3);
+    return entry;
+}
+
+TranspositionTable::TranspositionTable(std::size_t megabytes) {
+    // Число ячеек — наибольшая степень двойки, помещающаяся в заданный объем
+    std::size_t count = 1;
+    while (count * 2 * sizeof(Slot) <= megabytes * 1024 * 1024) count *= 2;
+    slots.reset(new Slot[count]);
+    mask = count - 1;
+    Clear();
+}
+
+void TranspositionTable::Clear() {
+    for (std::size_t i = 0; i <= mask; ++i) {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool TranspositionTable::Probe(std::uint64_t key, TtEntry& entry) const {
+    const Slot& slot = slots[key & mask];
+    std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+    std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key || data == 0) return false;
+    entry = Unpack(data);
+    return entry.bound != TtBound::None;
+}
+
+void TranspositionTable::Store(std::uint64_t key, const TtEntry& entry) {
+    Slot& slot = slots[key & mask];
+    std::uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+    std::uint64_t oldCheck = slot.check.load(std::memory_order_relaxed);
+    // Запись прошлого хода заменяется всегда, запись этого хода — только не менее глубокой
+    // (или точной оценкой той же позиции)
+    bool samePosition = (oldCheck ^ oldData) == key;
+    bool stale = ((oldData >> 58) & 63) != age;
+    if (oldData != 0 && !stale && Unpack(oldData).depth > entry.depth && !(samePosition && entry.bound == TtBound::Exact)) return;
+
+    std::uint64_t data = Pack(entry, age);
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+}
@@ -0,0 +1,55 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+const std::size_t DefaultTranspositionMegabytes = 16;
+
+// Какую границу дает сохраненная оценка
+enum class TtBound : std::uint8_t {
+    None,
+    Exact,  // Точная оценка
+    Lower,  // Отсечение: позиция не хуже score
+    Upper,  // Ни один ход не поднял alpha: позиция не лучше score
+};
+
+// Результат прежнего поиска позиции
+struct TtEntry {
+    std::int32_t score = 0;
+    std::uint16_t move = 0;  // Лучший ход (клетка окна поиска)
+    std::int8_t depth = 0;
+    TtBound bound = TtBound::None;
+};
+
+// Таблица транспозиций, общая для всех потоков поиска, без блокировок. Запись — два атомарных
+// 64-битных слова: упакованные данные и ключ Зобриста, сложенный с ними по XOR. Если два потока
+// пишут в одну ячейку одновременно и слова перемешались, ключ при чтении не сойдется и запись
+// просто не найдется — испорченный ход из таблицы никогда не попадет в поиск
+class TranspositionTable {
+public:
+    explicit TranspositionTable(std::size_t megabytes = DefaultTranspositionMegabytes);
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Забывает все позиции (не потокобезопасно: между поисками)
+    void Clear();
+    // Начало нового хода: записи прошлых поисков вытесняются в первую очередь
+    void NewSearch() { age = static_cast<std::uint8_t>((age + 1) & 63); }
+
+    bool Probe(std::uint64_t key, TtEntry& entry) const;
+    void Store(std::uint64_t key, const TtEntry& entry);
+
+    std::size_t Size() const { return mask + 1; }  // Ячеек в таблице
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> check;  // key ^ data
+        std::atomic<std::uint64_t> data;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::size_t mask = 0;
+    std::uint8_t age = 0;
+};
@@ -0,0 +1,41 @@
+﻿#pragma once
+#include <cstdint>
+
+const int MinCellSize = 1;     // Самое мелкое приближение: клетка в пиксель
+const int MaxCellSize = 4096;  // Самое крупное (совпадает с пределом GridSize в settings.ini)
+
+// Деление с округлением вниз (для отрицательных координат поля)
+inline std::int64_t FloorDiv(std::int64_t a, std::int64_t b) {
+    std::int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+// Видимая часть бесконечного поля: сдвиг и масштаб.
+// (x, y) — координаты левого верхнего угла окна в пикселях поля при текущем размере клетки
+struct Viewport {
+    std::int64_t x = 0;
+    std::int64_t y = 0;
+    int cellSize = 50;  // Размер клетки на экране в пикселях
+
+    // Экранная координата левой/верхней границы клетки
+    int ScreenX(int col) const { return static_cast<int>(static_cast<std::int64_t>(col) * cellSize - x); }
+    int ScreenY(int row) const { return static_cast<int>(static_cast<std::int64_t>(row) * cellSize - y); }
+
+    // Клетка под точкой окна
+    int ColAt(int screenX) const { return static_cast<int>(FloorDiv(x + screenX, cellSize)); }
+    int RowAt(int screenY) const { return static_cast<int>(FloorDiv(y + screenY, cellSize)); }
+
+    // Сдвигает поле вслед за мышью на (dx, dy) пикселей
+    void Pan(int dx, int dy) {
+        x -= dx;
+        y -= dy;
+    }
+
+    // Меняет размер клетки так, чтобы точка поля под (screenX, screenY) осталась на месте
+    void ZoomAt(int screenX, int screenY, int newCellSize) {
+        newCellSize = newCellSize < MinCellSize ? MinCellSize : (newCellSize > MaxCellSize ? MaxCellSize : newCellSize);
+        x = FloorDiv((x + screenX) * newCellSize, cellSize) - screenX;
+        y = FloorDiv((y + screenY) * newCellSize, cellSize) - screenY;
+        cellSize = newCellSize;
+    }
+};